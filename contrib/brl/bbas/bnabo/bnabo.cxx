@@ -31,11 +31,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <limits>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <stdexcept>
 #include <sstream>
 #include "bnabo.h"
 #include "bnabo_private.h"
 #include "bnabo_index_heap.h"
+#include <vnl/vnl_thread_pool.h>
 //#include <boost/format.hpp>
 
 /*!        \file nabo.cpp
@@ -63,46 +66,56 @@ namespace Nabo
   template<typename T, typename CloudType>
   unsigned long NearestNeighbourSearch<T, CloudType>::knn(const Vector& query, IndexVector& indices, Vector& dists2, const Index k, const T epsilon, const unsigned optionFlags, const T maxRadius) const
   {
-#ifdef EIGEN3_API
-    const Eigen::Map<const Matrix> queryMatrix(&query.coeff(0,0), dim, 1);
-#else // EIGEN3_API
-    //const Eigen::Map<Matrix> queryMatrix(&query.coeff(0,0), dim, 1);
-    Matrix queryMatrix(dim,1);
-    queryMatrix.set_column(0,query);
-#endif // EIGEN3_API
-    // note: this is inefficient, because we copy memory, due to the template-
-    // based abstraction of Eigen. High-performance implementation should
-    // take care of knnM and then implement knn on top of it.
-    // C++0x should solve this with rvalue
-    IndexMatrix indexMatrix(k, 1);
-    Matrix dists2Matrix(k, 1);
-    const unsigned long stats = knn(queryMatrix, indexMatrix, dists2Matrix, k, epsilon, optionFlags, maxRadius);
-    indices = indexMatrix.get_column(0);
-    dists2 = dists2Matrix.get_column(0);
-    return stats;
+    // search directly into the result vectors, without going through matrices
+    if (static_cast<Index>(query.size()) < dim)
+      throw runtime_error("Query has less dimensions than requested for cloud");
+    indices.set_size(k);
+    dists2.set_size(k);
+    return knnBatch(query.data_block(), 1, indices.data_block(), dists2.data_block(), k, epsilon, optionFlags, maxRadius, 1);
+  }
+
+  template<typename T, typename CloudType>
+  unsigned long NearestNeighbourSearch<T, CloudType>::knnBatch(const T* query, const size_t queryCount, Index* indices, T* dists2, const Index k, const T epsilon, const unsigned optionFlags, const T maxRadius, const unsigned threadCount) const
+  {
+    // generic implementation, going through the matrix interface block by block
+    checkKnnParameters(k, optionFlags);
+    std::atomic<unsigned long> touchedCount(0);
+    runQueryBlocks(queryCount, threadCount, [&](const size_t begin, const size_t end)
+    {
+      const unsigned n(static_cast<unsigned>(end - begin));
+      Matrix queryMatrix(dim, n);
+      for (unsigned c = 0; c < n; ++c)
+        for (int d = 0; d < dim; ++d)
+          queryMatrix[d][c] = query[(begin + c) * dim + d];
+      IndexMatrix indexMatrix(k, n);
+      Matrix dists2Matrix(k, n);
+      touchedCount += knn(queryMatrix, indexMatrix, dists2Matrix, k, epsilon, optionFlags, maxRadius);
+      for (unsigned c = 0; c < n; ++c)
+        for (int j = 0; j < k; ++j)
+        {
+          indices[(begin + c) * k + j] = indexMatrix[j][c];
+          dists2[(begin + c) * k + j] = dists2Matrix[j][c];
+        }
+    });
+    return touchedCount;
+  }
+
+  void runQueryBlocks(const size_t queryCount, const unsigned threadCount, const std::function<void(size_t, size_t)>& task)
+  {
+    const size_t blockSize(256);
+    const size_t blockCount((queryCount + blockSize - 1) / blockSize);
+    const std::function<void(size_t)> blockTask([&](const size_t b)
+    {
+      task(b * blockSize, std::min(queryCount, (b + 1) * blockSize));
+    });
+    vnl_thread_pool::default_pool().parallel_for(blockCount, blockTask, threadCount);
   }
 
   template<typename T, typename CloudType>
   void NearestNeighbourSearch<T, CloudType>::checkSizesKnn(const Matrix& query, const IndexMatrix& indices, const Matrix& dists2, const Index k, const unsigned optionFlags, const Vector* maxRadii) const
   {
-    const bool allowSelfMatch(optionFlags & NearestNeighbourSearch<T, CloudType>::ALLOW_SELF_MATCH);
+    checkKnnParameters(k, optionFlags);
     stringstream ss;
-    if (allowSelfMatch)
-      {
-        if (k > static_cast<Index>(cloud.cols())){
-          ss << "Requesting more points " << k <<" than available in cloud " << cloud.cols()<< std::ends;
-          //throw runtime_error((boost::format("Requesting more points (%1%) than available in cloud (%2%)") % k % cloud.cols()).str());
-          throw runtime_error(ss.str().c_str());
-        }
-      }
-    else
-      {
-        if (k > static_cast<Index>(cloud.cols()-1)){
-          ss << "Requesting more points " << k << " than available in cloud minus 1 "<< cloud.cols()-1 << " (as self match is forbidden)" << std::ends;
-          //throw runtime_error((boost::format("Requesting more points (%1%) than available in cloud minus 1 (%2%) (as self match is forbidden)") % k % (cloud.cols()-1)).str());
-          throw runtime_error(ss.str().c_str());
-        }
-      }
     if (static_cast<Index>(query.rows()) < dim){
       ss << "Query has less dimensions "<< query.rows() <<  " than requested for cloud " << dim << std::ends;
         //throw runtime_error((boost::format("Query has less dimensions (%1%) than requested for cloud (%2%)") % query.rows() % dim).str());
@@ -133,6 +146,29 @@ namespace Nabo
       //throw runtime_error((boost::format("Maximum radii vector has not the same length (%1%) than query has columns (%2%)"p) % maxRadii->size() % k).str());
       throw runtime_error(ss.str().c_str());
     }
+  }
+
+  template<typename T, typename CloudType>
+  void NearestNeighbourSearch<T, CloudType>::checkKnnParameters(const Index k, const unsigned optionFlags) const
+  {
+    const bool allowSelfMatch(optionFlags & NearestNeighbourSearch<T, CloudType>::ALLOW_SELF_MATCH);
+    stringstream ss;
+    if (allowSelfMatch)
+      {
+        if (k > static_cast<Index>(cloud.cols())){
+          ss << "Requesting more points " << k <<" than available in cloud " << cloud.cols()<< std::ends;
+          //throw runtime_error((boost::format("Requesting more points (%1%) than available in cloud (%2%)") % k % cloud.cols()).str());
+          throw runtime_error(ss.str().c_str());
+        }
+      }
+    else
+      {
+        if (k > static_cast<Index>(cloud.cols()-1)){
+          ss << "Requesting more points " << k << " than available in cloud minus 1 "<< cloud.cols()-1 << " (as self match is forbidden)" << std::ends;
+          //throw runtime_error((boost::format("Requesting more points (%1%) than available in cloud minus 1 (%2%) (as self match is forbidden)") % k % (cloud.cols()-1)).str());
+          throw runtime_error(ss.str().c_str());
+        }
+      }
     const unsigned maxOptionFlagsValue(ALLOW_SELF_MATCH|SORT_RESULTS);
     if (optionFlags > maxOptionFlagsValue){
       ss << "OR-ed value of option flags " << optionFlags << " is larger than maximal valid value " << maxOptionFlagsValue << std::ends;
@@ -140,6 +176,7 @@ namespace Nabo
       throw runtime_error(ss.str().c_str());
     }
   }
+
   template<typename T, typename CloudType>
   NearestNeighbourSearch<T, CloudType>* NearestNeighbourSearch<T, CloudType>::create(const CloudType& cloud, const Index dim, const SearchType preferedType, const unsigned creationOptionFlags, const Parameters<unsigned>& additionalParameters)
   {
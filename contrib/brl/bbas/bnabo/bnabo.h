@@ -42,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //        #include "Eigen/Array"
 //#endif
 
+#include <cstddef>
 #include <vector>
 #include <map>
 #include <limits>
@@ -278,6 +279,25 @@ namespace Nabo
        */
       virtual unsigned long knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector& maxRadii, const Index k = 1, const T epsilon = 0, const unsigned optionFlags = 0) const = 0;
 
+      //! Find the k nearest neighbours for each of queryCount points, using several threads
+      /*!        The query points are stored contiguously, point i starting at query[i*dim], and the results are written to arrays allocated by the caller.
+       *        \The queries are shared among at most threadCount threads of the default vnl_thread_pool; the search object is only read, so it can also be shared by threads calling knnBatch() concurrently.
+       *        \With a finite maxRadius, this is a radius search returning at most k points.
+       *        \If the search finds less than k points for a query, the empty entries in dists2 will be filled with infinity and the indices with 0.
+       *        \param query queryCount points of dim coordinates
+       *        \param queryCount number of query points
+       *        \param indices indices of nearest neighbours, must hold k x queryCount entries; those of point i start at indices[i*k]
+       *        \param dists2 squared distances to nearest neighbours, must hold k x queryCount entries, laid out as indices
+       *        \param k number of nearest neighbour requested
+       *        \param epsilon maximal ratio of error for approximate search, 0 for exact search;
+       *        \has no effect if the number of neighbour found is smaller than the number requested
+       *        \param optionFlags search options, a bitwise OR of elements of SearchOptionFlags
+       *        \param maxRadius maximum radius in which to search, can be used to prune search, is not affected by epsilon
+       *        \param threadCount maximum number of threads of the default vnl_thread_pool to use, 0 for all of them
+       *        \return if creationOptionFlags contains TOUCH_STATISTICS, return the number of points touched, otherwise return 0
+       */
+      virtual unsigned long knnBatch(const T* query, const size_t queryCount, Index* indices, T* dists2, const Index k = 1, const T epsilon = 0, const unsigned optionFlags = 0, const T maxRadius = std::numeric_limits<T>::infinity(), const unsigned threadCount = 0) const;
+
       //! Create a nearest-neighbour search
       /*!        \param cloud data-point cloud in which to search
        *        \param dim number of dimensions to consider, must be lower or equal to cloud.rows()
@@ -365,6 +385,9 @@ namespace Nabo
        *        \param optionFlags the options passed to knn()
        \param maxRadii if non 0, maximum radii, must be of size k */
       void checkSizesKnn(const Matrix& query, const IndexMatrix& indices, const Matrix& dists2, const Index k, const unsigned optionFlags, const Vector* maxRadii = nullptr) const;
+
+      //! Make sure that k and the options are valid for this cloud. Throw an exception otherwise.
+      void checkKnnParameters(const Index k, const unsigned optionFlags) const;
  };
 
   // Convenience typedefs
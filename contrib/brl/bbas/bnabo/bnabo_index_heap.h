@@ -160,6 +160,25 @@ namespace Nabo
         }
     }
 
+    //! get the data from the heap into arrays of nbNeighbours entries
+    /** \param indices index array
+     *         \param values value array */
+    template<typename DI, typename DV>
+    inline void getData(DI* indices, DV* values) const
+    {
+      size_t i = 0;
+      for (; i < data.size(); ++i)
+        {
+          indices[i] = data[i].index;
+          values[i] = data[i].value;
+        }
+      for (; i < nbNeighbours; ++i)
+        {
+          indices[i] = 0;
+          values[i] = std::numeric_limits<VT>::infinity();
+        }
+    }
+
 #if 0
     //! get the data-point indices from the heap
     /** \return the indices */
@@ -370,6 +389,19 @@ namespace Nabo
            const_cast<vnl_vector<DV>&>(values)[static_cast<unsigned>(i)] = data[i].value;
         }
     }
+
+    //! get the data from the heap into arrays of data.size() entries
+    /** \param indices index array
+     *         \param values value array */
+    template<typename DI, typename DV>
+    inline void getData(DI* indices, DV* values) const
+    {
+      for (size_t i = 0; i < data.size(); ++i)
+        {
+          indices[i] = data[i].index;
+          values[i] = data[i].value;
+        }
+    }
 #if 0
     //! get the data-point indices from the heap
     /** \return the indices */
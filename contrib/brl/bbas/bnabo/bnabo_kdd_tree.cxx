@@ -43,9 +43,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#include <boost/numeric/conversion/bounds.hpp>
 //#include <boost/limits.hpp>
 //#include <boost/format.hpp>
-#ifdef HAVE_OPENMP
-#include <omp.h>
-#endif
+#include <atomic>
 
 /*!        \file kdtree_cpu.cpp
         \brief kd-tree search, cpu implementation
@@ -282,59 +280,77 @@ namespace Nabo
         unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Index k, const T epsilon, const unsigned optionFlags, const T maxRadius) const
         {
                 checkSizesKnn(query, indices, dists2, k, optionFlags);
+                return knnColumns(query, indices, dists2, nullptr, maxRadius, k, epsilon, optionFlags);
+        }
+        template<typename T, typename Heap, typename CloudType>
+        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector& maxRadii, const Index k, const T epsilon, const unsigned optionFlags) const
+        {
+                checkSizesKnn(query, indices, dists2, k, optionFlags, &maxRadii);
+                return knnColumns(query, indices, dists2, &maxRadii, T(0), k, epsilon, optionFlags);
+        }
+        template<typename T, typename Heap, typename CloudType>
+        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::knnColumns(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector* maxRadii, const T maxRadius, const Index k, const T epsilon, const unsigned optionFlags) const
+        {
                 const bool allowSelfMatch((optionFlags & NearestNeighbourSearch<T>::ALLOW_SELF_MATCH)!=0);
                 const bool sortResults((optionFlags & NearestNeighbourSearch<T>::SORT_RESULTS)!=0);
                 const bool collectStatistics((creationOptionFlags & NearestNeighbourSearch<T>::TOUCH_STATISTICS)!=0);
-                const T maxRadius2(maxRadius * maxRadius);
                 const T maxError2((1+epsilon)*(1+epsilon));
-                const int colCount(query.cols());
                 assert(nodes.size() > 0);
 
-                IndexMatrix result(k, query.cols());
-                unsigned long leafTouchedCount(0);
-
-#pragma omp parallel
+                // the coordinates of a query are a column of a row-major matrix,
+                // so each query is copied before the search
+                std::atomic<unsigned long> leafTouchedCount(0);
+                runQueryBlocks(query.cols(), 0, [&](const size_t begin, const size_t end)
                 {
-                Heap heap(k);
-                std::vector<T> off(dim, 0);
-
-#pragma omp for reduction(+:leafTouchedCount) schedule(guided,32)
-                for (int i = 0; i < colCount; ++i)
-                {
-                        leafTouchedCount += onePointKnn(query, indices, dists2, i, heap, off, maxError2, maxRadius2, allowSelfMatch, collectStatistics, sortResults);
-                }
-                }
+                        Heap heap(k);
+                        std::vector<T> off(dim, 0);
+                        std::vector<T> q(dim);
+                        std::vector<Index> indx(k);
+                        std::vector<T> dsts(k);
+                        unsigned long touched(0);
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                                const unsigned c(static_cast<unsigned>(i));
+                                for (int d = 0; d < dim; ++d)
+                                        q[d] = query[d][c];
+                                const T radius(maxRadii ? (*maxRadii)[c] : maxRadius);
+                                touched += onePointKnn(&q[0], &indx[0], &dsts[0], heap, off, maxError2, radius * radius, allowSelfMatch, collectStatistics, sortResults);
+                                for (int j = 0; j < k; ++j)
+                                {
+                                        indices[j][c] = indx[j];
+                                        dists2[j][c] = dsts[j];
+                                }
+                        }
+                        leafTouchedCount += touched;
+                });
                 return leafTouchedCount;
         }
         template<typename T, typename Heap, typename CloudType>
-        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector& maxRadii, const Index k, const T epsilon, const unsigned optionFlags) const
+        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::knnBatch(const T* query, const size_t queryCount, Index* indices, T* dists2, const Index k, const T epsilon, const unsigned optionFlags, const T maxRadius, const unsigned threadCount) const
         {
-                checkSizesKnn(query, indices, dists2, k, optionFlags, &maxRadii);
+                checkKnnParameters(k, optionFlags);
                 const bool allowSelfMatch((optionFlags & NearestNeighbourSearch<T>::ALLOW_SELF_MATCH)!=0);
                 const bool sortResults((optionFlags & NearestNeighbourSearch<T>::SORT_RESULTS)!=0);
                 const bool collectStatistics((creationOptionFlags & NearestNeighbourSearch<T>::TOUCH_STATISTICS)!=0);
+                const T maxRadius2(maxRadius * maxRadius);
                 const T maxError2((1+epsilon)*(1+epsilon));
-                const int colCount(query.cols());
                 assert(nodes.size() > 0);
-                IndexMatrix result(k, query.cols());
-                unsigned long leafTouchedCount(0);
 
-#pragma omp parallel
+                // the queries are contiguous and the results are written in place
+                std::atomic<unsigned long> leafTouchedCount(0);
+                runQueryBlocks(queryCount, threadCount, [&](const size_t begin, const size_t end)
                 {
-                Heap heap(k);
-                std::vector<T> off(dim, 0);
-#pragma omp for reduction(+:leafTouchedCount) schedule(guided,32)
-                for (int i = 0; i < colCount; ++i)
-                {
-                        const T maxRadius(maxRadii[i]);
-                        const T maxRadius2(maxRadius * maxRadius);
-                        leafTouchedCount += onePointKnn(query, indices, dists2, i, heap, off, maxError2, maxRadius2, allowSelfMatch, collectStatistics, sortResults);
-                }
-                }
+                        Heap heap(k);
+                        std::vector<T> off(dim, 0);
+                        unsigned long touched(0);
+                        for (size_t i = begin; i < end; ++i)
+                                touched += onePointKnn(query + i * dim, indices + i * k, dists2 + i * k, heap, off, maxError2, maxRadius2, allowSelfMatch, collectStatistics, sortResults);
+                        leafTouchedCount += touched;
+                });
                 return leafTouchedCount;
         }
         template<typename T, typename Heap, typename CloudType>
-        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::onePointKnn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, int i, Heap& heap, std::vector<T>& off, const T maxError2, const T maxRadius2, const bool allowSelfMatch, const bool collectStatistics, const bool sortResults) const
+        unsigned long KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt<T, Heap, CloudType>::onePointKnn(const T* query, Index* indices, T* dists2, Heap& heap, std::vector<T>& off, const T maxError2, const T maxRadius2, const bool allowSelfMatch, const bool collectStatistics, const bool sortResults) const
         {
                 fill(off.begin(), off.end(), 0);
                 heap.reset();
@@ -342,30 +358,21 @@ namespace Nabo
                 if (allowSelfMatch)
                 {
                         if (collectStatistics)
-                          //leafTouchedCount += recurseKnn<true, true>(&query.coeff(0, i), 0, 0, heap, off, maxError2, maxRadius2);
-                          leafTouchedCount += recurseKnn<true, true>(&query[0][i], 0, 0, heap, off, maxError2, maxRadius2);
+                                leafTouchedCount += recurseKnn<true, true>(query, 0, 0, heap, off, maxError2, maxRadius2);
                         else
-                          //recurseKnn<true, false>(&query.coeff(0, i), 0, 0, heap, off, maxError2, maxRadius2);
-                          recurseKnn<true, false>(&query[0][i], 0, 0, heap, off, maxError2, maxRadius2);
+                                recurseKnn<true, false>(query, 0, 0, heap, off, maxError2, maxRadius2);
                 }
                 else
                 {
-                  if (collectStatistics)
-                    //   leafTouchedCount += recurseKnn<false, true>(&query.coeff(0, i), 0, 0, heap, off, maxError2, maxRadius2);
-                    leafTouchedCount += recurseKnn<false, true>(&query[0][i], 0, 0, heap, off, maxError2, maxRadius2);
-                  else
-                    //recurseKnn<false, false>(&query.coeff(0, i), 0, 0, heap, off, maxError2, maxRadius2);
-                    recurseKnn<false, false>(&query[0][i], 0, 0, heap, off, maxError2, maxRadius2);
+                        if (collectStatistics)
+                                leafTouchedCount += recurseKnn<false, true>(query, 0, 0, heap, off, maxError2, maxRadius2);
+                        else
+                                recurseKnn<false, false>(query, 0, 0, heap, off, maxError2, maxRadius2);
                 }
                 // does nothing
                 if (sortResults)
                         heap.sort();
-                //heap.getData(indices.col(i), dists2.col(i));
-                // adapt to vnl interface
-                vnl_vector<Index> indx(indices.rows());
-                vnl_vector<T> dsts(dists2.rows());
-                heap.getData(indx, dsts);
-                indices.set_column(i,indx); dists2.set_column(i,dsts);
+                heap.getData(indices, dists2);
                 return leafTouchedCount;
         }
         template<typename T, typename Heap, typename CloudType> template<bool allowSelfMatch, bool collectStatistics>
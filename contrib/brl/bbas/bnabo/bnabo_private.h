@@ -54,6 +54,7 @@ using boost::uint32_t;
   \ingroup private
 */
 //removed dependency on Eigen, replaced with vnl - JLM
+#include <functional>
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_matrix.h>
 namespace Nabo
@@ -67,6 +68,8 @@ namespace Nabo
     //return (v0 - v1).squaredNorm();
          return (v0-v1).squared_magnitude();
   }
+  //! Call task(begin, end) for consecutive blocks of queries in [0, queryCount[, spread over threadCount threads of a vnl_thread_pool (0 for the default pool)
+  void runQueryBlocks(const size_t queryCount, const unsigned threadCount, const std::function<void(size_t, size_t)>& task);
   //! Brute-force nearest neighbour
   template<typename T, typename CloudType = vnl_matrix<T> >
     struct BruteForceSearch : public NearestNeighbourSearch<T, CloudType>
@@ -101,6 +104,7 @@ namespace Nabo
       using NearestNeighbourSearch<T, CloudType>::minBound;
       using NearestNeighbourSearch<T, CloudType>::maxBound;
       using NearestNeighbourSearch<T, CloudType>::checkSizesKnn;
+      using NearestNeighbourSearch<T, CloudType>::checkKnnParameters;
     protected:
       //! indices of points during kd-tree construction
       typedef std::vector<Index> BuildPoints;
@@ -164,10 +168,9 @@ namespace Nabo
       //! construct nodes for points [first..last[ inside the hyperrectangle [minValues..maxValues]
       unsigned buildNodes(const BuildPointsIt first, const BuildPointsIt last, const Vector minValues, const Vector maxValues);
       //! search one point, call recurseKnn with the correct template parameters
-      /** \param query pointer to query coordinates
-       *        \param indices indices of nearest neighbours, must be of size k x query.cols()
-       *        \param dists2 squared distances to nearest neighbours, must be of size k x query.cols()
-       *        \param i index of point to search
+      /** \param query pointer to query coordinates, which must be contiguous
+       *        \param indices indices of nearest neighbours, k entries
+       *        \param dists2 squared distances to nearest neighbours, k entries
        *         \param heap reference to heap
        *         \param off reference to array of offsets
        *        \param maxError error factor (1 + epsilon)
@@ -176,7 +179,7 @@ namespace Nabo
        *        \param collectStatistics whether to collect statistics
        *        \param sortResults wether to sort results
        */
-      unsigned long onePointKnn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, int i, Heap& heap, std::vector<T>& off, const T maxError, const T maxRadius2, const bool allowSelfMatch, const bool collectStatistics, const bool sortResults) const;
+      unsigned long onePointKnn(const T* query, Index* indices, T* dists2, Heap& heap, std::vector<T>& off, const T maxError, const T maxRadius2, const bool allowSelfMatch, const bool collectStatistics, const bool sortResults) const;
       //! recursive search, strongly inspired by ANN and [Arya & Mount, Algorithms for fast vector quantization, 1993]
       /**        \param query pointer to query coordinates
        *         \param n index of node to visit
@@ -188,11 +191,14 @@ namespace Nabo
        */
       template<bool allowSelfMatch, bool collectStatistics>
       unsigned long recurseKnn(const T* query, const unsigned n, T rd, Heap& heap, std::vector<T>& off, const T maxError, const T maxRadius2) const;
+      //! search the points of the columns of query, with maxRadii[i] or maxRadius for column i, spread over the default vnl_thread_pool
+      unsigned long knnColumns(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector* maxRadii, const T maxRadius, const Index k, const T epsilon, const unsigned optionFlags) const;
     public:
       //! constructor, calls NearestNeighbourSearch<T>(cloud)
       KDTreeUnbalancedPtInLeavesImplicitBoundsStackOpt(const CloudType& cloud, const Index dim, const unsigned creationOptionFlags, const Parameters<unsigned>& additionalParameters);
       unsigned long knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Index k, const T epsilon, const unsigned optionFlags, const T maxRadius) const override;
       unsigned long knn(const Matrix& query, IndexMatrix& indices, Matrix& dists2, const Vector& maxRadii, const Index k = 1, const T epsilon = 0, const unsigned optionFlags = 0) const override;
+      unsigned long knnBatch(const T* query, const size_t queryCount, Index* indices, T* dists2, const Index k = 1, const T epsilon = 0, const unsigned optionFlags = 0, const T maxRadius = std::numeric_limits<T>::infinity(), const unsigned threadCount = 0) const override;
     };
 #ifdef HAVE_OPENCL
   //! OpenCL support for nearest neighbour search
@@ -208,6 +214,7 @@ namespace Nabo
       using NearestNeighbourSearch<T, CloudType>::cloud;
       using NearestNeighbourSearch<T, CloudType>::creationOptionFlags;
       using NearestNeighbourSearch<T, CloudType>::checkSizesKnn;
+      using NearestNeighbourSearch<T, CloudType>::checkKnnParameters;
     protected:
       const cl_device_type deviceType; //!< the type of device to run CL code on (CL_DEVICE_TYPE_CPU or CL_DEVICE_TYPE_GPU)
       cl::Context& context; //!< the CL context
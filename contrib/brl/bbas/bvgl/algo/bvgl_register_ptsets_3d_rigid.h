@@ -178,6 +178,12 @@ public:
   bool valid_instance() const {return (fixed_.size()>0 && movable_.size()>0);}
 
  private:
+  //: the distances from the points of frac_trans_, translated by t, to their closest fixed points.
+  // If offsets is given, also the vectors from each translated point to its closest point.
+  // The queries are made all at once, spread over threads.
+  bool closest_distances(vgl_vector_3d<T> const& t, std::vector<T>& dists,
+                         std::vector<vgl_vector_3d<T> >* offsets = nullptr) const;
+
   vgl_vector_3d<T> t_range_ = vgl_vector_3d<T>(T(2.5), T(2.5), T(2.5));
   vgl_vector_3d<T> t_inc_ = vgl_vector_3d<T>(T(0.5), T(0.5), T(0.5));
   T outlier_thresh_ = T(5.0);
@@ -12,20 +12,40 @@
 #include <vnl/algo/vnl_svd.h>
 
 template <class T>
-T bvgl_register_ptsets_3d_rigid<T>::error(vgl_vector_3d<T> const& t)
+bool bvgl_register_ptsets_3d_rigid<T>::closest_distances(vgl_vector_3d<T> const& t, std::vector<T>& dists,
+                                                         std::vector<vgl_vector_3d<T> >* offsets) const
 {
   size_t n = frac_trans_.npts();
-  T error = T(0);
-  T cnt = T(0);
+  std::vector<vgl_point_3d<T> > tps, cps;
+  tps.reserve(n);
   for (size_t i = 0; i<n; ++i) {
     const vgl_point_3d<T>& p = frac_trans_.p(i);
-    vgl_point_3d<T> tp(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
-    vgl_point_3d<T> cp;
-    if (!knn_fixed_.closest_point(tp, cp)) {
-      std::cout << "KNN index failed to find neighbors" << std::endl;
-      return std::numeric_limits<T>::max();
-    }
-    T d = vgl_distance<T>(tp, cp);
+    tps.emplace_back(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
+  }
+  if (!knn_fixed_.closest_points(tps, cps)) {
+    std::cout << "KNN index failed to find neighbors" << std::endl;
+    return false;
+  }
+  dists.resize(n);
+  if (offsets)
+    offsets->resize(n);
+  for (size_t i = 0; i<n; ++i) {
+    dists[i] = vgl_distance<T>(tps[i], cps[i]);
+    if (offsets)
+      (*offsets)[i] = cps[i] - tps[i];
+  }
+  return true;
+}
+
+template <class T>
+T bvgl_register_ptsets_3d_rigid<T>::error(vgl_vector_3d<T> const& t)
+{
+  std::vector<T> dists;
+  if (!closest_distances(t, dists))
+    return std::numeric_limits<T>::max();
+  T error = T(0);
+  T cnt = T(0);
+  for (T d : dists) {
     if (d > outlier_thresh_)
       continue;
     cnt += T(1);
@@ -37,21 +57,16 @@ T bvgl_register_ptsets_3d_rigid<T>::error(vgl_vector_3d<T> const& t)
 template <class T>
 vgl_vector_3d<T>  bvgl_register_ptsets_3d_rigid<T>::mean_error(vgl_vector_3d<T> const& t)
 {
-  size_t n = frac_trans_.npts();
   vgl_vector_3d<T> ret(T(0),T(0),T(0));
+  std::vector<T> dists;
+  std::vector<vgl_vector_3d<T> > offsets;
+  if (!closest_distances(t, dists, &offsets))
+    return ret;
   T cnt = T(0);
-  for (size_t i = 0; i<n; ++i) {
-    const vgl_point_3d<T>& p = frac_trans_.p(i);
-    vgl_point_3d<T> tp(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
-    vgl_point_3d<T> cp;
-    if (!knn_fixed_.closest_point(tp, cp)) {
-      std::cout << "KNN index failed to find neighbors" << std::endl;
-      return ret;
-    }
-    T d = vgl_distance<T>(tp, cp);
-    if (d > outlier_thresh_)
+  for (size_t i = 0; i<dists.size(); ++i) {
+    if (dists[i] > outlier_thresh_)
       continue;
-    ret += (cp - tp);
+    ret += offsets[i];
     cnt += T(1);
   }
   ret /= cnt;
@@ -75,18 +90,8 @@ vgl_vector_3d<T>  bvgl_register_ptsets_3d_rigid<T>::mean_error(vgl_vector_3d<T>
 template <class T>
 T bvgl_register_ptsets_3d_rigid<T>::distr_error(vgl_vector_3d<T> const& t){
   std::vector<T> dists;
-  size_t n = frac_trans_.npts();
-  for (size_t i = 0; i<n; ++i) {
-    const vgl_point_3d<T>& p = frac_trans_.p(i);
-    vgl_point_3d<T> tp(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
-    vgl_point_3d<T> cp;
-    if (!knn_fixed_.closest_point(tp, cp)) {
-      std::cout << "KNN index failed to find neighbors" << std::endl;
-      return std::numeric_limits<T>::max();
-    }
-    T d = vgl_distance<T>(tp, cp);
-    dists.push_back(d);
-  }
+  if (!closest_distances(t, dists))
+    return std::numeric_limits<T>::max();
   size_t nd = dists.size();
   std::sort(dists.begin(), dists.end(), std::less<T>());
   return (dists[nd/2] + dists[nd/4] + dists[(3*nd)/4])/T(3);
@@ -95,20 +100,14 @@ T bvgl_register_ptsets_3d_rigid<T>::distr_error(vgl_vector_3d<T> const& t){
 template <class T>
 T  bvgl_register_ptsets_3d_rigid<T>::error_var(vgl_vector_3d<T> const& t)
 {
-  size_t n = frac_trans_.npts();
+  std::vector<T> dists;
+  if (!closest_distances(t, dists))
+    return std::numeric_limits<T>::max();
   T error = T(0);
   T cnt = T(0);
 
   // calculate mean error/distance
-  for (size_t i = 0; i<n; ++i) {
-    const vgl_point_3d<T>& p = frac_trans_.p(i);
-    vgl_point_3d<T> tp(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
-    vgl_point_3d<T> cp;
-    if (!knn_fixed_.closest_point(tp, cp)) {
-      std::cout << "KNN index failed to find neighbors" << std::endl;
-      return std::numeric_limits<T>::max();
-    }
-    T d = vgl_distance<T>(tp, cp);
+  for (T d : dists) {
     if (d > outlier_thresh_)
       continue;
     cnt += T(1);
@@ -118,16 +117,8 @@ T  bvgl_register_ptsets_3d_rigid<T>::error_var(vgl_vector_3d<T> const& t)
 
   T mean_error = error;
   T var = T(0);
-  
-  for (size_t i = 0; i<n; ++i) {
-    const vgl_point_3d<T>& p = frac_trans_.p(i);
-    vgl_point_3d<T> tp(p.x()+t.x(), p.y()+t.y(), p.z()+t.z());
-    vgl_point_3d<T> cp;
-    if (!knn_fixed_.closest_point(tp, cp)) {
-      std::cout << "KNN index failed to find neighbors" << std::endl;
-      return std::numeric_limits<T>::max();
-    }
-    T d = vgl_distance<T>(tp, cp);
+
+  for (T d : dists) {
     if (d > outlier_thresh_)
       continue;
 
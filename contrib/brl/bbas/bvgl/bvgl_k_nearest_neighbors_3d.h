@@ -10,6 +10,7 @@
 #include <iostream>
 #include <iosfwd>
 #include <limits>
+#include <vector>
 #include <algorithm>
 #include <utility>
 #include <vgl/vgl_pointset_3d.h>
@@ -67,6 +68,18 @@ class bvgl_k_nearest_neighbors_3d
   // useful if the source point set has normals that are to retrived for the closest point
   bool closest_index(vgl_point_3d<Type> const& p, unsigned& index) const;
 
+  //: query for the index of the closest point to each of pts, spreading the queries over n_threads threads
+  // (0 = the default vnl_thread_pool). Returns false if any query fails.
+  bool closest_indices(std::vector<vgl_point_3d<Type> > const& pts, std::vector<unsigned>& indices, unsigned n_threads = 0) const;
+
+  //: query for the closest point to each of pts, spreading the queries over n_threads threads
+  bool closest_points(std::vector<vgl_point_3d<Type> > const& pts, std::vector<vgl_point_3d<Type> >& cps, unsigned n_threads = 0) const;
+
+  //: find the indices of the k closest neighbors of each of pts, those of pts[i] starting at indices[i*k].
+  // If max_dist is given, only neighbors closer than max_dist are found, and missing ones have index -1.
+  bool knn_indices(std::vector<vgl_point_3d<Type> > const& pts, unsigned k, std::vector<int>& indices,
+                   unsigned n_threads = 0, Type max_dist = std::numeric_limits<Type>::infinity()) const;
+
   //: find k nearest neighbors. if the source pointset has normals they are included in the returned pointset
   bool knn(vgl_point_3d<Type> const& p, unsigned k, vgl_pointset_3d<Type>& neighbors) const;
 
@@ -153,6 +166,55 @@ bool bvgl_k_nearest_neighbors_3d<Type>::knn_indices(vgl_point_3d<Type> const& p,
   return true;
 }
 
+template <class Type>
+bool bvgl_k_nearest_neighbors_3d<Type>::knn_indices(std::vector<vgl_point_3d<Type> > const& pts, unsigned k,
+                                                   std::vector<int>& indices, unsigned n_threads, Type max_dist) const
+{
+  if(k == 0 || !search_tree_)
+    return false;
+  size_t n = pts.size();
+  std::vector<Type> q(3*n), dists2(k*n);
+  for(size_t i = 0; i<n; ++i){
+    q[3*i]=pts[i].x();  q[3*i+1]=pts[i].y();  q[3*i+2]=pts[i].z();
+  }
+  indices.resize(k*n);
+  if(n == 0)
+    return true;
+  search_tree_->knnBatch(q.data(), n, indices.data(), dists2.data(), k, tolerance_, flags_, max_dist, n_threads);
+  bool limited = max_dist < std::numeric_limits<Type>::infinity();
+  for(size_t i = 0; i<k*n; ++i)
+    if(dists2[i] == std::numeric_limits<Type>::infinity()||indices[i]<0){
+      if(!limited)
+        return false;
+      indices[i] = -1;
+    }
+  return true;
+}
+
+template <class Type>
+bool bvgl_k_nearest_neighbors_3d<Type>::closest_indices(std::vector<vgl_point_3d<Type> > const& pts, std::vector<unsigned>& indices,
+                                                       unsigned n_threads) const
+{
+  std::vector<int> nn;
+  if(!this->knn_indices(pts, 1, nn, n_threads))
+    return false;
+  indices.assign(nn.begin(), nn.end());
+  return true;
+}
+
+template <class Type>
+bool bvgl_k_nearest_neighbors_3d<Type>::closest_points(std::vector<vgl_point_3d<Type> > const& pts, std::vector<vgl_point_3d<Type> >& cps,
+                                                      unsigned n_threads) const
+{
+  std::vector<unsigned> indices;
+  if(!this->closest_indices(pts, indices, n_threads))
+    return false;
+  cps.resize(indices.size());
+  for(size_t i = 0; i<indices.size(); ++i)
+    cps[i] = ptset_.p(indices[i]);
+  return true;
+}
+
 template <class Type>
 bool bvgl_k_nearest_neighbors_3d<Type>::closest_index(vgl_point_3d<Type> const& p, unsigned& index) const{
   unsigned k = 1;
@@ -0,0 +1,78 @@
+//:
+// \file
+// \brief Tool to compare single and batched nearest neighbour queries of bnabo.
+//
+// Usage: bvgl_knn_timings [n_points ...]
+// For each number of points (default 1e5 to 1e8, which needs several GB of
+// memory), builds a kd-tree of random float points and times 100000 closest
+// point queries made one at a time through bvgl_k_nearest_neighbors_3d, and
+// in one knnBatch() call with one thread and with all the default threads.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <bnabo/bnabo.h>
+#include <bvgl/bvgl_k_nearest_neighbors_3d.h>
+#include "vgl/vgl_point_3d.h"
+#include "vgl/vgl_pointset_3d.h"
+#include "vnl/vnl_random.h"
+#include "vnl/vnl_thread_pool.h"
+
+//: Wall clock time of f() in seconds
+template <class F>
+static double
+time_of(F f)
+{
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void
+time_queries(std::size_t n_points)
+{
+  const std::size_t n_queries = 100000;
+  vnl_random rng(9667566);
+  vgl_pointset_3d<float> ptset;
+  std::vector<vgl_point_3d<float> > pts(n_points);
+  for (auto & p : pts)
+    p.set(float(rng.drand32(0, 1000)), float(rng.drand32(0, 1000)), float(rng.drand32(0, 100)));
+  ptset.set_points(pts);
+  pts.clear();
+  pts.shrink_to_fit();
+
+  std::vector<vgl_point_3d<float> > qs(n_queries);
+  for (auto & q : qs)
+    q.set(float(rng.drand32(0, 1000)), float(rng.drand32(0, 1000)), float(rng.drand32(0, 100)));
+
+  bvgl_k_nearest_neighbors_3d<float> knn;
+  const double t_build = time_of([&]() { knn.set_pointset(ptset); });
+
+  std::vector<unsigned> single(n_queries), batch;
+  const double t_single = time_of([&]() {
+    for (std::size_t i = 0; i < n_queries; ++i)
+      knn.closest_index(qs[i], single[i]);
+  });
+  const double t_batch1 = time_of([&]() { knn.closest_indices(qs, batch, 1); });
+  const double t_batch = time_of([&]() { knn.closest_indices(qs, batch, 0); });
+  const bool same = batch == single;
+
+  std::cout << "n=" << n_points << ":  build " << t_build << " s,  queries/s: single " << n_queries / t_single
+            << ",  batch 1 thread " << n_queries / t_batch1 << ",  batch " << vnl_thread_pool::default_pool().n_threads()
+            << " threads " << n_queries / t_batch << "  (" << t_single / t_batch << "x)" << (same ? "" : "  MISMATCH")
+            << std::endl;
+}
+
+int
+main(int argc, char * argv[])
+{
+  std::vector<std::size_t> sizes;
+  for (int i = 1; i < argc; ++i)
+    sizes.push_back(std::size_t(std::atof(argv[i])));
+  if (sizes.empty())
+    sizes = { 100000, 1000000, 10000000, 100000000 };
+  for (std::size_t n : sizes)
+    time_queries(n);
+  return 0;
+}
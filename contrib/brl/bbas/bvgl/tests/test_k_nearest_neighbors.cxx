@@ -3,6 +3,10 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include "testlib/testlib_test.h"
 #include <bvgl/bvgl_k_nearest_neighbors_3d.h>
 #include <bvgl/bvgl_k_nearest_neighbors_2d.h>
@@ -12,6 +16,7 @@
 #include "vgl/vgl_point_3d.h"
 #include "vgl/vgl_pointset_3d.h"
 #include <bnabo/bnabo.h>
+#include "vnl/vnl_random.h"
 #define TEST_K_NEAREST_NEIGHBORS 1
 //: Test changes
 static void test_k_nearest_neighbors_3d()
@@ -149,10 +154,92 @@ static void test_k_nearest_neighbors_2d()
   TEST("knn correct neighbors", correct, true);
 }
 
+//: Test batched queries against single ones and brute force
+static void test_k_nearest_neighbors_batch()
+{
+  vnl_random rng(4711);
+  vgl_pointset_3d<double> ptset;
+  for (unsigned i = 0; i < 2000; ++i)
+    ptset.add_point(vgl_point_3d<double>(rng.drand64(0, 10), rng.drand64(0, 10), rng.drand64(0, 1)));
+  std::vector<vgl_point_3d<double> > qs;
+  for (unsigned i = 0; i < 700; ++i)
+    qs.emplace_back(rng.drand64(-1, 11), rng.drand64(-1, 11), rng.drand64(-1, 2));
+
+  bvgl_k_nearest_neighbors_3d<double> knn3d(ptset);
+  std::vector<unsigned> indices;
+  bool good = knn3d.closest_indices(qs, indices, 3);
+  TEST("closest_indices success", good && indices.size() == qs.size(), true);
+  bool same = true, nearest = true;
+  for (size_t i = 0; i < qs.size(); ++i) {
+    unsigned index = 0;
+    knn3d.closest_index(qs[i], index);
+    same &= index == indices[i];
+    double dmin = 1e30;
+    for (unsigned j = 0; j < ptset.npts(); ++j)
+      dmin = std::min(dmin, (ptset.p(j) - qs[i]).length());
+    nearest &= std::fabs((ptset.p(indices[i]) - qs[i]).length() - dmin) < 1e-12;
+  }
+  TEST("closest_indices same as closest_index", same, true);
+  TEST("closest_indices are nearest", nearest, true);
+
+  std::vector<vgl_point_3d<double> > cps;
+  good = knn3d.closest_points(qs, cps, 1);
+  TEST("closest_points", good && cps.size() == qs.size() && cps[5] == ptset.p(indices[5]), true);
+
+  unsigned k = 4;
+  std::vector<int> kindices;
+  good = knn3d.knn_indices(qs, k, kindices, 2);
+  same = good && kindices.size() == k * qs.size();
+  for (size_t i = 0; i < qs.size() && same; ++i) {
+    vnl_vector<int> single(k);
+    knn3d.knn_indices(qs[i], k, single);
+    for (unsigned j = 0; j < k; ++j)
+      same &= single[j] == kindices[i * k + j];
+  }
+  TEST("batched knn_indices same as single", same, true);
+
+  // radius limited: points further than max_dist are reported as -1
+  good = knn3d.knn_indices(qs, k, kindices, 0, 0.25);
+  bool in_radius = good;
+  for (size_t i = 0; i < qs.size(); ++i)
+    for (unsigned j = 0; j < k; ++j) {
+      int index = kindices[i * k + j];
+      in_radius &= index < 0 || (ptset.p(index) - qs[i]).length() <= 0.25;
+    }
+  TEST("radius limited knn_indices", in_radius, true);
+
+  // matrix interface with several query columns
+  vnl_matrix<double> M(3, ptset.npts()), Q(3, 50);
+  for (unsigned i = 0; i < ptset.npts(); ++i) {
+    M[0][i] = ptset.p(i).x(); M[1][i] = ptset.p(i).y(); M[2][i] = ptset.p(i).z();
+  }
+  for (unsigned i = 0; i < 50; ++i) {
+    Q[0][i] = qs[i].x(); Q[1][i] = qs[i].y(); Q[2][i] = qs[i].z();
+  }
+  Nabo::NNSearchD* search = Nabo::NNSearchD::createKDTreeTreeHeap(M, 3);
+  Nabo::NNSearchD* brute = Nabo::NNSearchD::createBruteForce(M, 3);
+  vnl_matrix<int> ind(2, 50), bind(2, 50);
+  vnl_matrix<double> d2(2, 50), bd2(2, 50);
+  unsigned flags = Nabo::NNSearchD::ALLOW_SELF_MATCH | Nabo::NNSearchD::SORT_RESULTS;
+  search->knn(Q, ind, d2, 2, 0.0, flags);
+  brute->knn(Q, bind, bd2, 2, 0.0, flags);
+  TEST_NEAR("matrix knn matches brute force", (d2 - bd2).absolute_value_max(), 0.0, 1e-12);
+  std::vector<int> bi(2 * 50);
+  std::vector<double> bd(2 * 50);
+  brute->knnBatch(Q.transpose().data_block(), 50, bi.data(), bd.data(), 2, 0.0, flags, std::numeric_limits<double>::infinity(), 2);
+  same = true;
+  for (unsigned i = 0; i < 50; ++i)
+    same &= bi[2 * i] == bind[0][i] && bd[2 * i + 1] == bd2[1][i];
+  TEST("brute force knnBatch", same, true);
+  delete search;
+  delete brute;
+}
+
 void test_k_nearest_neighbors()
 {
   test_k_nearest_neighbors_2d();
   test_k_nearest_neighbors_3d();
+  test_k_nearest_neighbors_batch();
 }
 
 TESTMAIN( test_k_nearest_neighbors );
@@ -1,6 +1,7 @@
 //:
 // \file
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <list>
@@ -55,85 +56,110 @@ boct_bit_tree &boct_bit_tree::operator=(boct_bit_tree that) {
   return *this;
 }
 
-int boct_bit_tree::traverse(const vgl_point_3d<double> p, int deepest, bool full) {
-  // deepest level to traverse is either
-  deepest = std::max(deepest - 1, num_levels_ - 1);
+//: The tree bits as one 80-bit string, bit j being bit j%8 of byte j/8
+// (the 73 structure bits are the first 80, bits_[0] holding only the root)
+static inline std::uint64_t boct_low_bits(const unsigned char *bits) {
+  std::uint64_t lo = 0;
+  for (int i = 7; i >= 0; --i)
+    lo = (lo << 8) | bits[i];
+  return lo;
+}
 
-  // force 1 register: curr = (bit, child_offset, depth, c_offset)
-  int curr_bit = (int)(bits_[0]);
-  int child_offset = 0;
-  int depth = 0;
+static inline int boct_popcount(std::uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return int((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
 
-  // bit index to be returned
-  int bit_index = 0;
+//: floor(x) for x in the range of int, without a call to std::floor
+static inline int boct_floor(double x) {
+  const int i = (int)x;
+  return i - (x < i);
+}
 
-  // clamp point
-  double pointx = p.x(); // clamp(p.x(), 0.0001f, 0.9999f);
-  double pointy = p.y(); // clamp(p.y(), 0.0001f, 0.9999f);
-  double pointz = p.z(); // clamp(p.z(), 0.0001f, 0.9999f);
+int boct_bit_tree::count_bits_before(int n) const {
+  const std::uint64_t lo = boct_low_bits(bits_);
+  n = std::min(n, 80);
+  if (n < 64)
+    return boct_popcount(lo & ((std::uint64_t(1) << n) - 1));
+  const unsigned hi = bits_[8] | (unsigned(bits_[9]) << 8);
+  return boct_popcount(lo) + boct_popcount(hi & ((1u << (n - 64)) - 1));
+}
+
+int boct_bit_tree::locate(const vgl_point_3d<double> &p, int deepest,
+                          bool full) const {
+  int curr_bit = (int)(bits_[0]);
+  if (!(curr_bit || full) || deepest <= 0)
+    return 0;
 
-  // while the curr node has children
-  while ((curr_bit || full) && (depth < deepest)) {
-    // determine child offset and bit index for given point
-    pointx += pointx; // point = point*2
-    pointy += pointy;
-    pointz += pointz;
-    int codex = ((int)std::floor(pointx)) & 1;
-    int codey = ((int)std::floor(pointy)) & 1;
-    int codez = ((int)std::floor(pointz)) & 1;
+  // The child code at depth d is bit deepest-d of the integer coordinates of
+  // the cell of the deepest level containing p; scaling by 2^deepest is exact.
+  const double scale = double(1 << deepest);
+  const int codex = boct_floor(p.x() * scale);
+  const int codey = boct_floor(p.y() * scale);
+  const int codez = boct_floor(p.z() * scale);
 
-    int c_index = codex + (codey << 1) + (codez << 2); // c_index = binary(zyx)
-    bit_index = (8 * bit_index + 1) + c_index;         // i = 8i + 1 + c_index
+  int child_offset = 0;
+  int bit_index = 0;
+  for (int depth = 0; (curr_bit || full) && depth < deepest; ++depth) {
+    const int shift = deepest - 1 - depth;
+    // c_index = binary(zyx)
+    const int c_index = ((codex >> shift) & 1) | (((codey >> shift) & 1) << 1) |
+                        (((codez >> shift) & 1) << 2);
+    bit_index = (8 * bit_index + 1) + c_index; // i = 8i + 1 + c_index
 
     // update value of curr_bit and level
-    curr_bit = (1 << c_index) &
-               bits_[(depth + 1 +
-                      child_offset)]; // int curr_byte = (curr.z + 1) + curr.y;
+    curr_bit = (1 << c_index) & bits_[(depth + 1 + child_offset)];
     child_offset = c_index;
-    depth++;
   }
   return bit_index;
 }
 
-int boct_bit_tree::traverse_to_level(const vgl_point_3d<double> p,
-                                     int deepest) {
+int boct_bit_tree::traverse(const vgl_point_3d<double> p, int deepest,
+                            bool full) const {
   // deepest level to traverse is either
-  deepest = std::min(deepest - 1, num_levels_ - 1);
-
-  // force 1 register: curr = (bit, child_offset, depth, c_offset)
-  int curr_bit = (int)(bits_[0]);
-  int child_offset = 0;
-  int depth = 0;
-
-  // bit index to be returned
-  int bit_index = 0;
-
-  // clamp point
-  double pointx = p.x(); // clamp(p.x(), 0.0001f, 0.9999f);
-  double pointy = p.y(); // clamp(p.y(), 0.0001f, 0.9999f);
-  double pointz = p.z(); // clamp(p.z(), 0.0001f, 0.9999f);
-
-  // while the curr node has children
-  while (curr_bit && depth < deepest) {
-    // determine child offset and bit index for given point
-    pointx += pointx; // point = point*2
-    pointy += pointy;
-    pointz += pointz;
-    int codex = ((int)std::floor(pointx)) & 1;
-    int codey = ((int)std::floor(pointy)) & 1;
-    int codez = ((int)std::floor(pointz)) & 1;
+  return locate(p, std::max(deepest - 1, num_levels_ - 1), full);
+}
 
-    int c_index = codex + (codey << 1) + (codez << 2); // c_index = binary(zyx)
-    bit_index = (8 * bit_index + 1) + c_index;         // i = 8i + 1 + c_index
+void boct_bit_tree::traverse(const vgl_point_3d<double> *points,
+                             std::size_t n, int *bit_indices,
+                             int *data_indices, int deepest, bool full,
+                             bool is_random) const {
+  deepest = std::max(deepest - 1, num_levels_ - 1);
+  for (std::size_t k = 0; k < n; ++k)
+    bit_indices[k] = locate(points[k], deepest, full);
+  if (!data_indices)
+    return;
 
-    // update value of curr_bit and level
-    curr_bit = (1 << c_index) &
-               bits_[(depth + 1 +
-                      child_offset)]; // int curr_byte = (curr.z + 1) + curr.y;
-    child_offset = c_index;
-    depth++;
+  // set bits before each byte of the tree, shared by all the points
+  int byte_counts[10];
+  byte_counts[0] = 0;
+  for (int i = 1; i < 10; ++i)
+    byte_counts[i] = byte_counts[i - 1] + bit_lookup[bits_[i - 1]];
+  const int data_ptr = is_random ? (int)bits_[10] * 256 + (int)bits_[11]
+                                 : get_data_index(0, false);
+  for (std::size_t k = 0; k < n; ++k) {
+    const int bit_index = bit_indices[k];
+    if (bit_index < 9 || bit_index > 584) {
+      data_indices[k] = data_ptr + get_relative_index(bit_index);
+      continue;
+    }
+    const int pos = ((bit_index - 1) >> 3) + 7; // position of the parent bit
+    const int count = byte_counts[pos >> 3] +
+                      bit_lookup[bits_[pos >> 3] & ((1 << (pos & 7)) - 1)];
+    data_indices[k] = data_ptr + 8 * count + 1 + ((bit_index - 1) & 7);
   }
-  return bit_index;
+}
+
+int boct_bit_tree::traverse_to_level(const vgl_point_3d<double> p,
+                                     int deepest) const {
+  // deepest level to traverse is either
+  return locate(p, std::min(deepest - 1, num_levels_ - 1), false);
 }
 vgl_point_3d<double> boct_bit_tree::cell_center(int bit_index) {
   // Indexes into precomputed cell_center matrix
@@ -287,39 +313,18 @@ int boct_bit_tree::get_relative_index(int bit_index) const {
   if (bit_index < 9)
     return bit_index;
 
-  // otherwise get parent index, parent byte index and relative bit index
-  unsigned char oneuplevel = (bit_index - 1) >> 3; // bit index of parent
-  unsigned char byte_index =
-      ((oneuplevel - 1) >> 3) + 1; // byte where parent is found
-
-  // count pre parent bits
-  int count = 0;
-  for (int i = 0; i < byte_index; ++i)
-    count += bit_lookup[bits_[i]];
-
-  // dont forget parent bits occurring the parent BYTE
-  unsigned char sub_bit_index = 8 - ((oneuplevel - 1) & (8 - 1));
-  unsigned char temp = bits_[byte_index] << sub_bit_index;
-
-  count = count + bit_lookup[temp];
-  unsigned char finestleveloffset = (bit_index - 1) & (8 - 1);
-  count = 8 * count + 1 + finestleveloffset;
-
-  return count;
+  // Cells are stored in breadth first order, so the cells before the
+  // children of the parent are the root and the children of every refined
+  // cell before the parent, i.e. of the set bits before the parent bit,
+  // which is at position parent+7 in the tree bits.
+  int parent = (bit_index - 1) >> 3;
+  int count = this->count_bits_before(parent + 7);
+  return 8 * count + 1 + ((bit_index - 1) & (8 - 1));
 }
 
 //: return number of cells in this tree (size of data chunk)
 int boct_bit_tree::num_cells() const {
-  // count bits for each byte
-  int count = 0;
-  for (int i = 0; i < 10; i++) {
-    unsigned char n = bits_[i];
-    while (n) {
-      ++count;
-      n &= (n - 1);
-    }
-  }
-  return 8 * count + 1;
+  return 8 * this->count_bits_before(80) + 1;
 }
 
 // returns the number of leaf cells
@@ -327,21 +332,13 @@ int boct_bit_tree::num_leaves() const { return get_leaf_bits(0).size(); }
 
 //----BIT MANIP Methods -----------------------------------------------
 unsigned char boct_bit_tree::bit_at(int index) const {
-  // make sure it's in bounds - all higher cells are leaves and thus 0
-  if (index > 72)
-    return 0;
+  // bit index>0 is at position index+7 in the tree bits; all higher cells are
+  // leaves and thus 0
+  if (unsigned(index - 1) < 72u)
+    return (bits_[(index + 7) >> 3] >> ((index + 7) & 7)) & 1;
 
   // root is special case
-  if (index == 0)
-    return bits_[0];
-
-  // second generation is sort of a special case
-  if (index < 9)
-    return (1 << (index - 1) & bits_[1]) ? 1 : 0;
-
-  int i = (index - 9) / 8 + 2; // byte index i
-  int bi = (index - 9) % 8;
-  return (1 << bi & bits_[i]) ? 1 : 0;
+  return index == 0 ? bits_[0] : 0;
 }
 
 void boct_bit_tree::set_bit_at(int index, bool val) {
@@ -400,7 +397,11 @@ int boct_bit_tree::max_num_inner_cells() {
   return int((int_pow8(num_levels_) - 1.0) / 7.0);
 }
 
-int boct_bit_tree::depth_at(int index) const { return int_log8(7 * index + 1); }
+int boct_bit_tree::depth_at(int index) const {
+  if (unsigned(index) < 585u)
+    return (index > 0) + (index > 8) + (index > 72);
+  return int_log8(7 * index + 1);
+}
 
 int boct_bit_tree::depth() {
 
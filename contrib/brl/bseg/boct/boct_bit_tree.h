@@ -16,6 +16,8 @@
 
 #include <bitset>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iosfwd>
 #include <iostream>
 #include <vector>
@@ -69,10 +71,22 @@ public:
   // down to the lowest level.
   int traverse(const vgl_point_3d<double> p,
                int deepest = 4,
-               bool full = false);
+               bool full = false) const;
+
+  //: traverse tree for each of n points, as traverse(points[k],deepest,full) would.
+  //  bit_indices[k] is set to the leaf index of points[k] and, if data_indices
+  //  is not null, data_indices[k] to get_data_index() of that leaf.  The bit
+  //  counts needed for the data indices are computed once for all the points.
+  void traverse(const vgl_point_3d<double> * points,
+                std::size_t n,
+                int * bit_indices,
+                int * data_indices = nullptr,
+                int deepest = 4,
+                bool full = false,
+                bool is_random = false) const;
 
   //: traverse tree to get leaf index that contains point
-  int traverse_to_level(const vgl_point_3d<double> p, int deepest = 4);
+  int traverse_to_level(const vgl_point_3d<double> p, int deepest = 4) const;
 
   //: gets the cell center (octree is assumed to be [0,1]x[0,1]x[0,1]
   vgl_point_3d<double> cell_center(int bit_index);
@@ -160,6 +174,12 @@ public:
   static float centerZ[585];
 
 private:
+  //: Leaf index of p, descending at most deepest levels
+  int locate(const vgl_point_3d<double> & p, int deepest, bool full) const;
+
+  //: Number of set bits among the first n (at most 80) bits of the tree
+  int count_bits_before(int n) const;
+
   // Whether this tree owns the underlying buffer and should delete it on
   // destruction.
   bool is_owning_;
@@ -0,0 +1,134 @@
+//:
+// \file
+// \brief Tool to time boct_bit_tree point location and data indexing.
+//
+// Usage: boct_bit_tree_timings [n_lookups]
+// Locates n_lookups (default 1e7) random points in random trees and looks up
+// the data index of the leaf found, as ray marching does for every cell, with
+// the bit by bit versions of traverse() and get_relative_index() that
+// boct_bit_tree used to have, with the current boct_bit_tree, and with its
+// batched traverse().
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <boct/boct_bit_tree.h>
+#include "vnl/vnl_random.h"
+
+//: Wall clock time of f() in seconds
+template <class F>
+static double
+time_of(F f)
+{
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//: traverse() as it was, with a floor() per level and coordinate
+static int
+reference_traverse(const unsigned char * bits, const vgl_point_3d<double> & p)
+{
+  const int deepest = 3;
+  int curr_bit = (int)(bits[0]);
+  int child_offset = 0;
+  int depth = 0;
+  int bit_index = 0;
+  double pointx = p.x(), pointy = p.y(), pointz = p.z();
+  while (curr_bit && depth < deepest)
+  {
+    pointx += pointx;
+    pointy += pointy;
+    pointz += pointz;
+    int codex = ((int)std::floor(pointx)) & 1;
+    int codey = ((int)std::floor(pointy)) & 1;
+    int codez = ((int)std::floor(pointz)) & 1;
+    int c_index = codex + (codey << 1) + (codez << 2);
+    bit_index = (8 * bit_index + 1) + c_index;
+    curr_bit = (1 << c_index) & bits[(depth + 1 + child_offset)];
+    child_offset = c_index;
+    depth++;
+  }
+  return bit_index;
+}
+
+//: get_data_index() as it was, counting bits byte by byte
+static int
+reference_data_index(const unsigned char * bits, int bit_index)
+{
+  int count_offset = (int)(bits[13] << 24) | (bits[12] << 16) | (bits[11] << 8) | (bits[10]);
+  if (bit_index < 9)
+    return count_offset + bit_index;
+  unsigned char oneuplevel = (bit_index - 1) >> 3;
+  unsigned char byte_index = ((oneuplevel - 1) >> 3) + 1;
+  int count = 0;
+  for (int i = 0; i < byte_index; ++i)
+    count += boct_bit_tree::bit_lookup[bits[i]];
+  unsigned char sub_bit_index = 8 - ((oneuplevel - 1) & (8 - 1));
+  unsigned char temp = bits[byte_index] << sub_bit_index;
+  count = count + boct_bit_tree::bit_lookup[temp];
+  unsigned char finestleveloffset = (bit_index - 1) & (8 - 1);
+  return count_offset + 8 * count + 1 + finestleveloffset;
+}
+
+int
+main(int argc, char * argv[])
+{
+  const std::size_t n_lookups = argc > 1 ? std::size_t(std::atof(argv[1])) : 10000000;
+  const unsigned n_trees = 1024;
+  const std::size_t n_per_tree = (n_lookups + n_trees - 1) / n_trees;
+  vnl_random rng(8212);
+
+  // densely refined trees, so that most points go down to the deepest level
+  std::vector<unsigned char> trees(16 * n_trees, 0);
+  for (unsigned t = 0; t < n_trees; ++t)
+  {
+    unsigned char * bits = &trees[16 * t];
+    bits[0] = 1;
+    bits[1] = 255;
+    for (int i = 2; i < 10; ++i)
+      bits[i] = (unsigned char)(rng.lrand32(0, 255) | rng.lrand32(0, 255));
+    bits[10] = (unsigned char)t;
+  }
+  std::vector<vgl_point_3d<double>> points(n_per_tree);
+  for (auto & p : points)
+    p.set(rng.drand64(0, 1), rng.drand64(0, 1), rng.drand64(0, 1));
+
+  long check_ref = 0, check_single = 0, check_batch = 0;
+  const double t_ref = time_of([&]() {
+    for (unsigned t = 0; t < n_trees; ++t)
+      for (const auto & p : points)
+        check_ref += reference_data_index(&trees[16 * t], reference_traverse(&trees[16 * t], p));
+  });
+  const double t_single = time_of([&]() {
+    for (unsigned t = 0; t < n_trees; ++t)
+    {
+      boct_bit_tree tree(&trees[16 * t], false, 4);
+      for (const auto & p : points)
+        check_single += tree.get_data_index(tree.traverse(p));
+    }
+  });
+  std::vector<int> bit_indices(points.size()), data_indices(points.size());
+  const double t_batch = time_of([&]() {
+    for (unsigned t = 0; t < n_trees; ++t)
+    {
+      boct_bit_tree tree(&trees[16 * t], false, 4);
+      tree.traverse(points.data(), points.size(), bit_indices.data(), data_indices.data());
+      for (int d : data_indices)
+        check_batch += d;
+    }
+  });
+
+  const double n = double(n_trees) * double(n_per_tree);
+  std::cout << n << " lookups, million lookups/s:  bit by bit " << n / t_ref * 1e-6 << ",  popcount "
+            << n / t_single * 1e-6 << " (" << t_ref / t_single << "x),  batched " << n / t_batch * 1e-6 << " ("
+            << t_ref / t_batch << "x)" << std::endl;
+  if (check_ref != check_single || check_ref != check_batch)
+  {
+    std::cout << "MISMATCH" << std::endl;
+    return 1;
+  }
+  return 0;
+}
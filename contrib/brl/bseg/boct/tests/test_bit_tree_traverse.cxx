@@ -0,0 +1,100 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vnl/vnl_random.h"
+
+#include <boct/boct_bit_tree.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: A random, valid tree: only the children of refined cells may be refined.
+static void random_tree_bits(vnl_random & rng, unsigned char bits[16])
+{
+  for (int i=0; i<16; ++i)
+    bits[i] = 0;
+  bits[0] = 1;
+  bits[1] = (unsigned char)rng.lrand32(0, 255);
+  for (int c=0; c<8; ++c)
+    if (bits[1] & (1<<c))
+      bits[2+c] = (unsigned char)rng.lrand32(0, 255);
+  for (int i=10; i<14; ++i)
+    bits[i] = (unsigned char)rng.lrand32(0, 255);
+  bits[13] &= 0x7f; // keep the data pointer positive
+}
+
+static void test_bit_tree_traverse()
+{
+  vnl_random rng(1963);
+  bool bits_ok = true, depth_ok = true, cells_ok = true, index_ok = true;
+  bool leaf_ok = true, level_ok = true, batch_ok = true;
+
+  for (int i=0; i<700 && depth_ok; ++i) {
+    int depth = 0;
+    for (unsigned a = 7*i+1; a >= 8; a >>= 3)
+      ++depth;
+    depth_ok = boct_bit_tree().depth_at(i) == depth;
+  }
+  TEST("depth_at", depth_ok, true);
+
+  // a tree with no refinement at all
+  unsigned char root_only[16] = { 0 };
+  boct_bit_tree leaf_tree(root_only, 4);
+  TEST("unrefined tree", leaf_tree.num_cells() == 1 &&
+       leaf_tree.traverse(vgl_point_3d<double>(0.3, 0.6, 0.9)) == 0 &&
+       leaf_tree.get_data_index(0) == 0, true);
+
+  for (int t=0; t<200; ++t) {
+    unsigned char bits[16];
+    random_tree_bits(rng, bits);
+    boct_bit_tree tree(bits, 4);
+
+    for (int i=1; i<73; ++i)
+      bits_ok = bits_ok && tree.bit_at(i) == ((bits[(i-1)/8+1] >> ((i-1)%8)) & 1);
+    bits_ok = bits_ok && tree.bit_at(0) == 1 && tree.bit_at(73) == 0 && tree.bit_at(584) == 0;
+
+    // the data of the cells is stored in breadth first order
+    std::vector<int> cells = tree.get_cell_bits();
+    cells_ok = cells_ok && tree.num_cells() == (int)cells.size();
+    for (unsigned k=0; k<cells.size(); ++k)
+      index_ok = index_ok && tree.get_relative_index(cells[k]) == (int)k &&
+                 tree.get_data_index(cells[k]) == tree.get_data_ptr() + (int)k;
+
+    // point location, single and batched
+    std::vector<vgl_point_3d<double> > points;
+    for (int k=0; k<100; ++k)
+      points.emplace_back(rng.drand64(0.0, 1.0), rng.drand64(0.0, 1.0), rng.drand64(0.0, 1.0));
+    points.emplace_back(0.0, 0.0, 0.0);
+    points.emplace_back(0.5, 0.25, 0.125);
+    std::vector<int> bit_indices(points.size()), data_indices(points.size());
+    tree.traverse(points.data(), points.size(), bit_indices.data(), data_indices.data());
+    for (unsigned k=0; k<points.size(); ++k) {
+      const vgl_point_3d<double>& p = points[k];
+      int leaf = tree.traverse(p);
+      vgl_box_3d<double> box = tree.cell_box(leaf);
+      leaf_ok = leaf_ok && tree.is_leaf(leaf) && box.contains(p) &&
+                tree.cell_len(leaf) == std::ldexp(1.0, -tree.depth_at(leaf));
+      batch_ok = batch_ok && bit_indices[k] == leaf && data_indices[k] == tree.get_data_index(leaf);
+      int cell = tree.traverse_to_level(p, 2);
+      level_ok = level_ok && tree.depth_at(cell) <= 1 && tree.cell_box(cell).contains(p);
+    }
+  }
+  TEST("bit_at", bits_ok, true);
+  TEST("num_cells", cells_ok, true);
+  TEST("get_relative_index and get_data_index", index_ok, true);
+  TEST("traverse finds the leaf containing the point", leaf_ok, true);
+  TEST("traverse_to_level", level_ok, true);
+  TEST("batched traverse", batch_ok, true);
+
+  // random access trees keep a 16 bit data pointer in bytes 10 and 11
+  unsigned char bits[16];
+  random_tree_bits(rng, bits);
+  boct_bit_tree tree(bits, 4);
+  vgl_point_3d<double> p(0.7, 0.2, 0.4);
+  int bit_index, data_index;
+  tree.traverse(&p, 1, &bit_index, &data_index, 4, false, true);
+  TEST("batched traverse, random access data pointer", data_index, tree.get_data_index(bit_index, true));
+}
+
+TESTMAIN(test_bit_tree_traverse);
@@ -8,6 +8,7 @@ DECLARE( test_binary_io );
 DECLARE( test_clone_tree );
 DECLARE( test_tree_cell_reader );
 DECLARE( test_bit_tree );
+DECLARE( test_bit_tree_traverse );
 
 void register_tests()
 {
@@ -19,6 +20,7 @@ void register_tests()
   REGISTER( test_clone_tree );
   REGISTER( test_tree_cell_reader );
   REGISTER( test_bit_tree );
+  REGISTER( test_bit_tree_traverse );
 }
 
 
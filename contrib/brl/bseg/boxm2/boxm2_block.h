@@ -151,6 +151,10 @@ class boxm2_block : public vbl_ref_count
   ////
   std::vector<vgl_point_3d<int> >  sub_blocks_intersect_box(vgl_box_3d<double> const& box) const;
   ////
+ protected:
+  //: gives up the ownership of the byte buffer, for blocks whose buffer is not allocated with new[]
+  char* release_buffer() { char* buff = buffer_; buffer_ = nullptr; return buff; }
+
  private:
   unsigned recompute_num_cells();
   //: unique block id (currently 3D address)
@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <functional>
 #include <vgl/vgl_ray_3d.h>
 
 #include <cassert>
@@ -20,6 +21,9 @@
 #  include <vcl_msvc_warnings.h>
 #endif
 #include <vpgl/vpgl_generic_camera.h>
+#include <vpgl/vpgl_perspective_camera.h>
+#include <vnl/vnl_thread_pool.h>
+#include <vpl/vpl_atomic_add.h>
 
 #define BLOCK_EPSILON .006125f
 #define TREE_EPSILON  .005f
@@ -207,5 +211,61 @@ bool cast_ray_per_block(functor_type functor,
   return false;
 }
 
+//: Multi-threaded version of cast_ray_per_block().
+//  The region of interest is cut into square tiles of tile_size pixels; each
+//  tile is one task of the default vnl_thread_pool, run by at most n_threads
+//  of its threads (0 = all of them), and casts its rays with its own copy of
+//  the functor, so that the rays of one thread are neighbours and step
+//  through the same cells.
+//  The functor may only change the state of pixel (i,j) in step_cell(),
+//  and must accumulate into cell data with vpl_atomic_add(); all the
+//  render functors and the update pass functors qualify.
+template <class functor_type>
+bool cast_ray_per_block_parallel(const functor_type& functor,
+                                 boxm2_scene_info * linfo,
+                                 boxm2_block * blk_sptr,
+                                 const vpgl_camera_double_sptr& cam,
+                                 unsigned int roi_ni,
+                                 unsigned int roi_nj,
+                                 unsigned int roi_ni0=0,
+                                 unsigned int roi_nj0=0,
+                                 unsigned int n_threads=0,
+                                 unsigned int tile_size=16)
+{
+  auto* gcam = dynamic_cast<vpgl_generic_camera<double>*>(cam.ptr());
+  auto* pcam = dynamic_cast<vpgl_perspective_camera<double>*>(cam.ptr());
+  if (!gcam && !pcam) {
+    std::cout<<"boxm2_cast_ray_function cannot dynamic cast camera"<<std::endl;
+    return false;
+  }
+  if (roi_ni <= roi_ni0 || roi_nj <= roi_nj0)
+    return true;
+  // backproject() computes the camera svd on first use; do it before the threads start
+  if (pcam)
+    pcam->svd();
+
+  tile_size = std::max(tile_size, 1u);
+  const unsigned n_ti = (roi_ni - roi_ni0 + tile_size - 1) / tile_size;
+  const unsigned n_tj = (roi_nj - roi_nj0 + tile_size - 1) / tile_size;
+  std::function<void(std::size_t)> cast_tile = [&](std::size_t t)
+  {
+    functor_type tile_functor(functor);
+    const unsigned i0 = roi_ni0 + unsigned(t % n_ti) * tile_size;
+    const unsigned j0 = roi_nj0 + unsigned(t / n_ti) * tile_size;
+    const unsigned i1 = std::min(roi_ni, i0 + tile_size);
+    const unsigned j1 = std::min(roi_nj, j0 + tile_size);
+    for (unsigned i=i0;i<i1;++i)
+    {
+      for (unsigned j=j0;j<j1;++j)
+      {
+        vgl_ray_3d<double> ray_ij = gcam ? gcam->ray(i,j) : vgl_ray_3d<double>(pcam->backproject(i,j));
+        boxm2_cast_ray_function<functor_type>(ray_ij,linfo,blk_sptr,i,j,tile_functor);
+      }
+    }
+  };
+
+  vnl_thread_pool::default_pool().parallel_for(std::size_t(n_ti) * n_tj, cast_tile, n_threads);
+  return true;
+}
 
 #endif // boxm2_cast_ray_function_h_
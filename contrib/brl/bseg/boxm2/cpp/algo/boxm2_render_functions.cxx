@@ -20,14 +20,14 @@ void boxm2_render_expected_image( boxm2_scene_info * linfo,
   {
     boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render_functor;
     render_functor.init_data(datas,expected,vis);
-    cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> >
+    cast_ray_per_block_parallel<boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
   else if (data_type.find(boxm2_data_traits<BOXM2_GAUSS_GREY>::prefix()) != std::string::npos )
   {
     boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> render_functor;
     render_functor.init_data(datas,expected,vis);
-    cast_ray_per_block<boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> >
+    cast_ray_per_block_parallel<boxm2_render_exp_image_functor<BOXM2_GAUSS_GREY> >
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
   }
 }
@@ -65,7 +65,7 @@ void boxm2_render_expected_depth( boxm2_scene_info * linfo,
 {
   boxm2_render_exp_depth_functor render_functor;
   render_functor.init_data(data,expected,vis,len_img);
-  cast_ray_per_block<boxm2_render_exp_depth_functor>
+  cast_ray_per_block_parallel<boxm2_render_exp_depth_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
 void boxm2_render_silhouette( boxm2_scene_info * linfo,
@@ -81,7 +81,7 @@ void boxm2_render_silhouette( boxm2_scene_info * linfo,
 {
   boxm2_render_silhouette_functor render_functor;
   render_functor.init_data(alpha,silhouette,vis);
-  cast_ray_per_block<boxm2_render_silhouette_functor>
+  cast_ray_per_block_parallel<boxm2_render_silhouette_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
 
@@ -99,6 +99,6 @@ void boxm2_render_depth_of_max_prob( boxm2_scene_info * linfo,
 {
   boxm2_render_depth_of_max_prob_functor render_functor;
   render_functor.init_data(data,expected,vis,prob_img);
-  cast_ray_per_block<boxm2_render_depth_of_max_prob_functor>
+  cast_ray_per_block_parallel<boxm2_render_depth_of_max_prob_functor>
       (render_functor,linfo,blk_sptr,cam,roi_ni,roi_nj,roi_ni0,roi_nj0);
 }
@@ -5,6 +5,7 @@
 #include <boxm2/cpp/algo/boxm2_update_image_functor.h>
 #include <boxm2/cpp/algo/boxm2_update_with_shadow_functor.h>
 #include <boxm2/cpp/algo/boxm2_update_using_quality_functor.h>
+#include <boxm2/io/boxm2_prefetch_cache.h>
 #include "vil/vil_math.h"
 #include "vil/vil_save.h"
 #include "vpgl/vpgl_perspective_camera.h"
@@ -173,6 +174,16 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
         std::cout<<" None of the blocks are visible from this viewpoint"<<std::endl;
         return true;
     }
+    // a prefetch cache reads the next blocks while the current one is updated
+    if (auto* prefetch = dynamic_cast<boxm2_prefetch_cache*>(cache.ptr()))
+    {
+        std::vector<std::string> types;
+        types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+        types.push_back(data_type);
+        types.push_back(num_obs_type);
+        types.push_back(boxm2_data_traits<BOXM2_AUX>::prefix());
+        prefetch->set_visibility_order(scene, vis_order, types);
+    }
 
     unsigned int num_passes=3;
 
@@ -199,7 +210,7 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
             boxm2_data_base *  mog  = cache->get_data_base(scene,*id,data_type,alph->buffer_length()/alphaTypeSize*appTypeSize,false);
             boxm2_data_base *  nobs  = cache->get_data_base(scene,*id,num_obs_type,alph->buffer_length()/alphaTypeSize*nobsTypeSize,false);
             int auxTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_AUX>::prefix());
-            boxm2_data_base *  aux  = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_AUX>::prefix(),alph->buffer_length()/alphaTypeSize*auxTypeSize);
+            boxm2_data_base *  aux  = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_AUX>::prefix(),alph->buffer_length()/alphaTypeSize*auxTypeSize,false);
 
             std::vector<boxm2_data_base*> datas;
             datas.push_back(aux);
@@ -213,7 +224,7 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
             {
                 boxm2_update_pass0_functor pass0;
                 pass0.init_data(datas,input_image);
-                success=success && cast_ray_per_block<boxm2_update_pass0_functor>
+                success=success && cast_ray_per_block_parallel<boxm2_update_pass0_functor>
                                        (pass0,
                                         scene_info_wrapper->info,
                                         blk,
@@ -228,14 +239,14 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
               {
                 boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> pass1;
                 pass1.init_data(datas,&pre_img,&vis_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass1_functor<BOXM2_GAUSS_GREY> >
                   (pass1,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
               else if (data_type.find(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()) != std::string::npos)
               {
                 boxm2_update_pass1_functor<BOXM2_MOG3_GREY> pass1;
                 pass1.init_data(datas,&pre_img,&vis_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass1_functor<BOXM2_MOG3_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass1_functor<BOXM2_MOG3_GREY> >
                   (pass1,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
             }
@@ -246,14 +257,14 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
               {
                 boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> pass2;
                 pass2.init_data(datas,&pre_img,&vis_img, & proc_norm_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass2_functor<BOXM2_GAUSS_GREY> >
                   (pass2,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
               else if (data_type.find(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()) != std::string::npos)
               {
                 boxm2_update_pass2_functor<BOXM2_MOG3_GREY> pass2;
                 pass2.init_data(datas,&pre_img,&vis_img, & proc_norm_img);
-                success=success&&cast_ray_per_block<boxm2_update_pass2_functor<BOXM2_MOG3_GREY> >
+                success=success&&cast_ray_per_block_parallel<boxm2_update_pass2_functor<BOXM2_MOG3_GREY> >
                   (pass2,scene_info_wrapper->info,blk,cam,input_image->ni(),input_image->nj());
               }
             }
@@ -279,7 +290,7 @@ bool boxm2_update_image(boxm2_scene_sptr & scene,
         boxm2_data_base *  nobs  = cache->get_data_base(scene,*id,num_obs_type,0,false);
         int alphaTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_ALPHA>::prefix());
         int auxTypeSize = (int)boxm2_data_info::datasize(boxm2_data_traits<BOXM2_AUX>::prefix());
-        boxm2_data_base *  aux  = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_AUX>::prefix(),alph->buffer_length()/alphaTypeSize*auxTypeSize);
+        boxm2_data_base *  aux  = cache->get_data_base(scene,*id,boxm2_data_traits<BOXM2_AUX>::prefix(),alph->buffer_length()/alphaTypeSize*auxTypeSize,false);
         std::vector<boxm2_data_base*> datas;
         datas.push_back(aux);
         datas.push_back(alph);
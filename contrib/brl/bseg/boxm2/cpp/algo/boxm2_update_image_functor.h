@@ -30,8 +30,9 @@ class boxm2_update_pass0_functor
   inline bool step_cell(float seg_len,int index,unsigned i,unsigned j, float abs_depth=0.0f)
   {
     boxm2_data<BOXM2_AUX>::datatype & aux=aux_data_->data()[index];
-    aux[0]+=seg_len;
-    aux[1]+=seg_len*(*input_img_)(i,j);
+    // other rays may reach the same cell concurrently
+    vpl_atomic_add(aux[0],seg_len);
+    vpl_atomic_add(aux[1],seg_len*(*input_img_)(i,j));
 
     return true;
   }
@@ -117,8 +118,8 @@ class boxm2_update_pass2_functor
     float omega=(1-std::exp(-seg_len*alpha));
     if ((*norm_img_)(i,j)>1e-10f)
     {
-        aux[2]+=((pre+vis*PI)/((*norm_img_)(i,j))*seg_len);
-        aux[3]+=vis*seg_len;
+        vpl_atomic_add(aux[2],(pre+vis*PI)/((*norm_img_)(i,j))*seg_len);
+        vpl_atomic_add(aux[3],vis*seg_len);
     }
     pre+=vis*omega*PI;
     vis=vis*(1-omega);
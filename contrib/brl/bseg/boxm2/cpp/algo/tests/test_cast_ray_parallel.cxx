@@ -0,0 +1,132 @@
+//:
+// \file
+// \brief Compare the tiled multi-threaded ray caster with the single-threaded one
+
+#include <cmath>
+#include "testlib/testlib_test.h"
+#include "vgl/vgl_point_3d.h"
+#include "vnl/vnl_random.h"
+#include "vpgl/vpgl_perspective_camera.h"
+#include "vil/vil_image_view.h"
+
+#include <boct/boct_bit_tree.h>
+
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/cpp/algo/boxm2_cast_ray_function.h>
+#include <boxm2/cpp/algo/boxm2_render_exp_image_functor.h>
+#include <boxm2/cpp/algo/boxm2_update_image_functor.h>
+
+static vpgl_camera_double_sptr
+parallel_test_camera()
+{
+  vnl_matrix_fixed<double, 3, 3> mk(0.0);
+  mk[0][0]=3000.0; mk[0][2]=16.0;
+  mk[1][1]=3000.0; mk[1][2]=16.0; mk[2][2]=1.0;
+  vpgl_calibration_matrix<double> K(mk);
+  vnl_matrix_fixed<double, 3, 3> mr(0.0);
+  mr[0][0]=1.0; mr[1][1]=-1.0; mr[2][2]=-1.0;
+  vgl_rotation_3d<double> R(mr);
+  vgl_point_3d<double> t(0.45,0.55,100);
+  return new vpgl_perspective_camera<double>(K,t,R);
+}
+
+static void test_cast_ray_parallel()
+{
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin( vgl_point_3d<double>(0,0,0) );
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks;
+  boxm2_block_id id(0,0,0);
+  blocks[id] = boxm2_block_metadata(id,
+                                    vgl_point_3d<double>(0,0,0),
+                                    vgl_vector_3d<double>(1.0/8.0, 1.0/8.0, 1.0/8.0),
+                                    vgl_vector_3d<unsigned>(8,8,2),
+                                    1, 1, 100, 0.0);
+  scene->set_blocks(blocks);
+  std::vector<std::string> appearances;
+  appearances.push_back(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix());
+  scene->set_appearances(appearances);
+  boxm2_scene_info* info = scene->get_blk_metadata(id);
+
+  boxm2_lru_cache::create(scene);
+  boxm2_block* blk = boxm2_cache::instance()->get_block(scene,id);
+  // the sizes replace any data of another test left in the working directory
+  typedef boxm2_data_traits<BOXM2_AUX>::datatype aux_type;
+  const std::size_t n = blk->num_cells();
+  boxm2_data_base * alph = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_ALPHA>::prefix(),
+                                                                  n*boxm2_data_info::datasize(boxm2_data_traits<BOXM2_ALPHA>::prefix()));
+  boxm2_data_base * mog  = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_MOG3_GREY>::prefix(),
+                                                                  n*boxm2_data_info::datasize(boxm2_data_traits<BOXM2_MOG3_GREY>::prefix()));
+  boxm2_data_base * aux  = boxm2_cache::instance()->get_data_base(scene,id,boxm2_data_traits<BOXM2_AUX>::prefix(),
+                                                                  n*sizeof(aux_type));
+  // (a boxm2_data would take ownership of the cached buffers)
+  auto* alpha_data = reinterpret_cast<boxm2_data_traits<BOXM2_ALPHA>::datatype*>(alph->data_buffer());
+  auto* mog3_data = reinterpret_cast<boxm2_data_traits<BOXM2_MOG3_GREY>::datatype*>(mog->data_buffer());
+  auto* aux_data = reinterpret_cast<aux_type*>(aux->data_buffer());
+
+  // random, partly transparent cells
+  vnl_random rng(77);
+  typedef vnl_vector_fixed<vxl_byte, 16> uchar16;
+  for (int x=0; x<8; ++x)
+    for (int y=0; y<8; ++y)
+      for (int z=0; z<2; ++z) {
+        uchar16 tree = blk->trees()(x,y,z);
+        boct_bit_tree bit_tree( (unsigned char*)tree.data_block(), info->root_level+1);
+        int data_ptr = bit_tree.get_data_ptr();
+        alpha_data[data_ptr] = float(rng.drand32(0.0, 5.0));
+        mog3_data[data_ptr] = boxm2_data_traits<BOXM2_MOG3_GREY>::datatype( (vxl_byte) rng.lrand32(0, 255) );
+      }
+
+  std::vector<boxm2_data_base*> datas;
+  datas.push_back(alph); datas.push_back(mog);
+  vpgl_camera_double_sptr cam = parallel_test_camera();
+  const unsigned ni=32, nj=32;
+
+  // Rendering writes pixel (i,j) only, so the images must be identical
+  vil_image_view<float> expected(ni,nj), vis(ni,nj), par_expected(ni,nj), par_vis(ni,nj);
+  expected.fill(0.0f); vis.fill(1.0f);
+  par_expected.fill(0.0f); par_vis.fill(1.0f);
+  boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> render;
+  render.init_data(datas,&expected,&vis);
+  cast_ray_per_block(render,info,blk,cam,ni,nj);
+  boxm2_render_exp_image_functor<BOXM2_MOG3_GREY> par_render;
+  par_render.init_data(datas,&par_expected,&par_vis);
+  TEST("parallel render succeeds", cast_ray_per_block_parallel(par_render,info,blk,cam,ni,nj,0,0,3,5), true);
+
+  bool same = true, hit = false;
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i) {
+      same = same && expected(i,j) == par_expected(i,j) && vis(i,j) == par_vis(i,j);
+      hit = hit || vis(i,j) < 1.0f;
+    }
+  TEST("rays reach the block", hit, true);
+  TEST("parallel render equals serial render", same, true);
+
+  // Update pass 0 accumulates into cells shared by many rays
+  vil_image_view<float> input(ni,nj);
+  for (unsigned j=0; j<nj; ++j)
+    for (unsigned i=0; i<ni; ++i)
+      input(i,j) = float(rng.drand32(0.0, 1.0));
+  std::vector<boxm2_data_base*> aux_datas(1, aux);
+  const std::size_t n_cells = aux->buffer_length() / sizeof(aux_type);
+  for (std::size_t c=0; c<n_cells; ++c)
+    aux_data[c].fill(0.0f);
+  boxm2_update_pass0_functor pass0;
+  pass0.init_data(aux_datas,&input);
+  cast_ray_per_block(pass0,info,blk,cam,ni,nj);
+  std::vector<aux_type> serial_aux(aux_data, aux_data+n_cells);
+  for (std::size_t c=0; c<n_cells; ++c)
+    aux_data[c].fill(0.0f);
+  cast_ray_per_block_parallel(pass0,info,blk,cam,ni,nj,0,0,4,4);
+
+  bool close = true;
+  for (std::size_t c=0; c<n_cells; ++c)
+    for (unsigned k=0; k<2; ++k)
+      close = close && std::fabs(aux_data[c][k] - serial_aux[c][k]) <= 1e-4f * (1.0f + std::fabs(serial_aux[c][k]));
+  TEST("parallel update pass 0 accumulates the same aux data", close, true);
+}
+
+TESTMAIN(test_cast_ray_parallel);
@@ -4,6 +4,7 @@ DECLARE( test_merge_mixtures );
 DECLARE( test_cone_ray_trace );
 DECLARE( test_cone_update );
 DECLARE( test_merge_function );
+DECLARE( test_cast_ray_parallel );
 
 void register_tests()
 {
@@ -11,6 +12,7 @@ void register_tests()
   REGISTER( test_cone_ray_trace );
   REGISTER( test_cone_update );
   REGISTER( test_merge_function );
+  REGISTER( test_cast_ray_parallel );
 }
 
 
@@ -13,6 +13,7 @@
 #  include "vcl_msvc_warnings.h"
 #endif
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/io/boxm2_prefetch_cache.h>
 #include <boxm2/boxm2_scene.h>
 #include <boxm2/boxm2_block.h>
 #include <boxm2/boxm2_data_base.h>
@@ -119,6 +120,14 @@ bool boxm2_cpp_render_expected_image_process(bprb_func_process& pro)
   {
     vis_order=scene->get_vis_blocks(reinterpret_cast<vpgl_generic_camera<double>*>(cam.ptr()));
   }
+  // a prefetch cache reads the next blocks while the current one is rendered
+  if (auto* prefetch = dynamic_cast<boxm2_prefetch_cache*>(cache.ptr()))
+  {
+    std::vector<std::string> types;
+    types.push_back(boxm2_data_traits<BOXM2_ALPHA>::prefix());
+    types.push_back(data_type);
+    prefetch->set_visibility_order(scene, vis_order, types);
+  }
   std::vector<boxm2_block_id>::iterator id;
   for (id = vis_order.begin(); id != vis_order.end(); ++id)
   {
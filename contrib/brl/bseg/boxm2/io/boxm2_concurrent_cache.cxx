@@ -0,0 +1,519 @@
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include "boxm2_concurrent_cache.h"
+//:
+// \file
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/boxm2_data_traits.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: The caches in whose requested_ a thread is, from which it is removed when the thread ends.
+//  Only the caches which still exist then are touched.
+struct boxm2_concurrent_cache::thread_requests
+{
+  std::thread::id thread;
+  std::vector<boxm2_concurrent_cache*> caches;
+
+  // never destroyed, as the boxm2_cache singleton may outlive any static made after it
+  static std::mutex& live_mutex() { static auto* m = new std::mutex; return *m; }
+  static std::set<boxm2_concurrent_cache*>& live() { static auto* s = new std::set<boxm2_concurrent_cache*>; return *s; }
+
+  void add(boxm2_concurrent_cache* cache)
+  {
+    thread = std::this_thread::get_id();
+    if (std::find(caches.begin(), caches.end(), cache) == caches.end())
+      caches.push_back(cache);
+  }
+
+  ~thread_requests()
+  {
+    std::lock_guard<std::mutex> live_lock(live_mutex());
+    for (auto* cache : caches)
+      if (live().count(cache)) {
+        std::lock_guard<std::mutex> lock(cache->scenes_mutex_);
+        cache->requested_.erase(thread);
+      }
+  }
+};
+
+//: PUBLIC create method, for creating singleton instance of boxm2_cache
+void boxm2_concurrent_cache::create(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                                    std::size_t max_bytes, unsigned n_shards)
+{
+  if (!boxm2_cache::exists())
+    instance_ = new boxm2_concurrent_cache(scene, fs_type, max_bytes, n_shards);
+}
+
+//: constructor
+boxm2_concurrent_cache::boxm2_concurrent_cache(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                                               std::size_t max_bytes, unsigned n_shards)
+: boxm2_cache(fs_type), max_bytes_(max_bytes)
+{
+  if (n_shards == 0)
+    n_shards = 1;
+  for (unsigned s = 0; s < n_shards; ++s)
+    shards_.emplace_back(new shard);
+  if (scene)
+    this->register_scene(scene);
+  std::lock_guard<std::mutex> lock(thread_requests::live_mutex());
+  thread_requests::live().insert(this);
+}
+
+//: destructor deletes the memory
+boxm2_concurrent_cache::~boxm2_concurrent_cache()
+{
+  {
+    std::lock_guard<std::mutex> lock(thread_requests::live_mutex());
+    thread_requests::live().erase(this);
+  }
+  this->clear_cache();
+}
+
+bool boxm2_concurrent_cache::key::operator<(const key& k) const
+{
+  if (scene != k.scene)
+    return scene < k.scene;
+  if (id != k.id)
+    return id < k.id;
+  return type < k.type;
+}
+
+boxm2_concurrent_cache::shard& boxm2_concurrent_cache::shard_for(const key& k) const
+{
+  // the scene is left out, so that the shards of a scene do not change from run to run
+  unsigned long long h = std::hash<std::string>()(k.type);
+  h = h * 31 + (unsigned)k.id.i();
+  h = h * 31 + (unsigned)k.id.j();
+  h = h * 31 + (unsigned)k.id.k();
+  // Mix the bits so that neighbouring blocks land in different shards.
+  h *= 0x9E3779B97F4A7C15ull;
+  return *shards_[(h >> 32) % shards_.size()];
+}
+
+void boxm2_concurrent_cache::register_scene(const boxm2_scene_sptr& scene)
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+}
+
+void boxm2_concurrent_cache::note_request(const boxm2_scene_sptr& scene, const boxm2_block_id& id)
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+  auto r = requested_.find(std::this_thread::get_id());
+  if (r == requested_.end()) {
+    requested_.emplace(std::this_thread::get_id(), key(scene.ptr(), "", id));
+    thread_local thread_requests requests;
+    requests.add(this);
+  }
+  else
+    r->second = key(scene.ptr(), "", id);
+}
+
+template <class LOAD>
+boxm2_concurrent_cache::entry& boxm2_concurrent_cache::acquire(const key& k, LOAD load)
+{
+  shard& s = this->shard_for(k);
+  std::unique_lock<std::mutex> lock(s.mutex_);
+  auto f = s.entries_.find(k);
+  if (f != s.entries_.end()) {
+    ++hits_;
+    entry& e = f->second;
+    ++e.pins;
+    s.loaded_.wait(lock, [&e] { return !e.loading; });
+    s.lru_.splice(s.lru_.end(), s.lru_, e.lru_pos);
+    return e;
+  }
+
+  // missing: read it here, pinned so that it stays in the map meanwhile
+  ++misses_;
+  entry& e = s.entries_[k];
+  e.pins = 1;
+  lock.unlock();
+  load(e);
+  lock.lock();
+  e.bytes = e.block ? std::size_t(e.block->byte_count()) : e.data ? e.data->buffer_length() : 0;
+  this->insert(s, k, e);
+  s.loaded_.notify_all();
+  lock.unlock();
+  this->evict();
+  return e;
+}
+
+boxm2_concurrent_cache::entry& boxm2_concurrent_cache::acquire_block(boxm2_scene_sptr & scene, const boxm2_block_id& id)
+{
+  this->register_scene(scene);
+  const std::string dir = scene->data_path();
+  const BOXM2_IO_FS_TYPE fs_type = filesystem_;
+  return this->acquire(key(scene.ptr(), "", id), [&](entry& loaded) {
+    const boxm2_block_metadata mdata = scene->get_block_metadata(id);
+    loaded.block = boxm2_sio_mgr::load_block(dir, id, mdata, fs_type);
+    // if the block is null then initialize an empty one
+    if (!loaded.block && scene->block_exists(id)) {
+      std::cout<<"boxm2_concurrent_cache::initializing empty block "<<id<<std::endl;
+      loaded.block = new boxm2_block(mdata);
+      loaded.created = true;
+    }
+  });
+}
+
+boxm2_concurrent_cache::entry& boxm2_concurrent_cache::acquire_data(boxm2_scene_sptr & scene, const boxm2_block_id& id,
+                                                                    const std::string& type, std::size_t num_bytes,
+                                                                    bool read_only)
+{
+  entry& b = this->acquire_block(scene, id);
+  const std::size_t byte_length = b.block ? b.block->num_cells() * boxm2_data_info::datasize(type) : 0;
+  this->unpin(key(scene.ptr(), "", id));
+
+  // if num_bytes is greater than zero, then you're guaranteed to return a data size with that many bytes
+  if (num_bytes > 0 && num_bytes != byte_length) {
+    std::stringstream ss;
+    ss<<"Attempting to retrieve "<<num_bytes<<" bytes for datatype " << type <<" when actual buffer size should be "<<byte_length;
+    throw std::runtime_error(ss.str());
+  }
+
+  const std::string dir = scene->data_path();
+  const BOXM2_IO_FS_TYPE fs_type = filesystem_;
+  const key k(scene.ptr(), type, id);
+  entry& e = this->acquire(k, [&](entry& loaded) {
+    loaded.data = boxm2_sio_mgr::load_block_data_generic(dir, id, type, fs_type);
+    if (!loaded.data || (num_bytes > 0 && loaded.data->buffer_length() != byte_length)) {
+      std::cout<<"boxm2_concurrent_cache::initializing empty data "<<id<<" type: "<<type<<std::endl;
+      delete loaded.data;
+      loaded.data = new boxm2_data_base(new char[byte_length], byte_length, id, read_only);
+      loaded.data->set_default_value(type, scene->get_block_metadata(id));
+      loaded.created = true;
+    }
+  });
+  if (!read_only) { // write-enable is enforced
+    std::lock_guard<std::mutex> lock(this->shard_for(k).mutex_);
+    e.data->enable_write();
+  }
+  return e;
+}
+
+void boxm2_concurrent_cache::unpin(const key& k)
+{
+  shard& s = this->shard_for(k);
+  {
+    std::lock_guard<std::mutex> lock(s.mutex_);
+    auto f = s.entries_.find(k);
+    if (f == s.entries_.end() || f->second.pins == 0)
+      return;
+    --f->second.pins;
+  }
+  this->evict();
+}
+
+boxm2_concurrent_cache::entry* boxm2_concurrent_cache::settle(shard& s, const key& k, std::unique_lock<std::mutex>& lock)
+{
+  auto f = s.entries_.find(k);
+  if (f == s.entries_.end())
+    return nullptr;
+  entry& e = f->second;
+  ++e.pins;
+  s.loaded_.wait(lock, [&e] { return !e.loading; });
+  --e.pins;
+  return &e;
+}
+
+void boxm2_concurrent_cache::insert(shard& s, const key& k, entry& e)
+{
+  e.loading = false;
+  e.lru_pos = s.lru_.insert(s.lru_.end(), k);
+  bytes_ += e.bytes;
+}
+
+void boxm2_concurrent_cache::evict()
+{
+  if (bytes_ <= max_bytes_)
+    return;
+
+  // the blocks the threads are working on through the boxm2_cache interface
+  std::vector<key> protect;
+  {
+    std::lock_guard<std::mutex> lock(scenes_mutex_);
+    for (const auto & r : requested_)
+      protect.push_back(r.second);
+  }
+  auto is_protected = [&protect](const key& k) {
+    for (const auto & p : protect)
+      if (p.scene == k.scene && p.id == k.id)
+        return true;
+    return false;
+  };
+
+  // the shards take turns, until none of them has anything left to evict
+  const unsigned n_shards = unsigned(shards_.size());
+  unsigned n_idle = 0;
+  while (bytes_ > max_bytes_ && n_idle < n_shards)
+  {
+    shard& s = *shards_[next_victim_shard_++ % n_shards];
+    std::lock_guard<std::mutex> lock(s.mutex_);
+    auto v = s.lru_.begin();
+    for (; v != s.lru_.end(); ++v) {
+      const entry& e = s.entries_.find(*v)->second;
+      if (e.pins == 0 && e.bytes > 0 && !is_protected(*v))
+        break;
+    }
+    if (v == s.lru_.end()) {
+      ++n_idle;
+      continue;
+    }
+    n_idle = 0;
+    const key victim = *v;
+    this->release(s, victim, true);
+    ++evictions_;
+  }
+}
+
+void boxm2_concurrent_cache::release(shard& s, const key& k, bool write_out)
+{
+  auto f = s.entries_.find(k);
+  if (f == s.entries_.end())
+    return;
+  entry& e = f->second;
+  const std::string dir = k.scene->data_path();
+  if (e.block) {
+    if (write_out && !e.block->read_only())
+      boxm2_sio_mgr::save_block(dir, e.block);
+    delete e.block;
+  }
+  if (e.data) {
+    if (write_out && (!e.data->read_only_ || e.created))
+      boxm2_sio_mgr::save_block_data_base(dir, k.id, e.data, k.type);
+    delete e.data;
+  }
+  bytes_ -= e.bytes;
+  s.lru_.erase(e.lru_pos);
+  s.entries_.erase(f);
+}
+
+//: realization of abstract "get_block(block_id)"
+boxm2_block* boxm2_concurrent_cache::get_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  this->note_request(scene, id);
+  boxm2_block* blk = this->acquire_block(scene, id).block;
+  this->unpin(key(scene.ptr(), "", id));
+  return blk;
+}
+
+//: get data by type and id
+boxm2_data_base* boxm2_concurrent_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  if (!scene->block_exists(id))
+    return nullptr;
+  this->note_request(scene, id);
+  boxm2_data_base* data = this->acquire_data(scene, id, type, num_bytes, read_only).data;
+  this->unpin(key(scene.ptr(), type, id));
+  return data;
+}
+
+boxm2_block* boxm2_concurrent_cache::pin_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  return this->acquire_block(scene, id).block;
+}
+
+boxm2_data_base* boxm2_concurrent_cache::pin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type,
+                                                       std::size_t num_bytes, bool read_only)
+{
+  if (!scene->block_exists(id))
+    return nullptr;
+  return this->acquire_data(scene, id, type, num_bytes, read_only).data;
+}
+
+void boxm2_concurrent_cache::unpin_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  this->unpin(key(scene.ptr(), "", id));
+}
+
+void boxm2_concurrent_cache::unpin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type)
+{
+  this->unpin(key(scene.ptr(), type, id));
+}
+
+//: returns a data_base pointer which is initialized to the default value of the type.
+//  If a block for this type exists on the cache, it is removed and replaced with the new one.
+//  This method does not check whether a block of this type already exists on the disk nor writes it to the disk
+boxm2_data_base* boxm2_concurrent_cache::get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  boxm2_block_metadata data = scene->get_block_metadata(id);
+  boxm2_data_base* block_data;
+  if (num_bytes > 0) {
+    block_data = new boxm2_data_base(new char[num_bytes], num_bytes, id, read_only);
+    block_data->set_default_value(type, data);
+  }
+  else {
+    // the following constructor also sets the default values
+    block_data = new boxm2_data_base(data, type, read_only);
+  }
+
+  this->note_request(scene, id);
+  const key k(scene.ptr(), type, id);
+  shard& s = this->shard_for(k);
+  {
+    std::unique_lock<std::mutex> lock(s.mutex_);
+    if (this->settle(s, k, lock))
+      this->release(s, k, false);
+    entry& e = s.entries_[k];
+    e.data = block_data;
+    e.created = true;
+    e.bytes = block_data->buffer_length();
+    this->insert(s, k, e);
+  }
+  this->evict();
+  return block_data;
+}
+
+//: removes data from this cache (may or may not write to disk first)
+void boxm2_concurrent_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out)
+{
+  const key k(scene.ptr(), type, id);
+  shard& s = this->shard_for(k);
+  std::unique_lock<std::mutex> lock(s.mutex_);
+  entry* e = this->settle(s, k, lock);
+  if (!e)
+    return;
+  if (write_out && e->data)
+    boxm2_sio_mgr::save_block_data_base(scene->data_path(), id, e->data, type);
+  this->release(s, k, false);
+}
+
+//: replaces data in the cache with one here
+void boxm2_concurrent_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement)
+{
+  this->note_request(scene, id);
+  const key k(scene.ptr(), type, id);
+  shard& s = this->shard_for(k);
+  {
+    std::unique_lock<std::mutex> lock(s.mutex_);
+    // copy the read_only/write status of the old data base
+    if (entry* old = this->settle(s, k, lock)) {
+      if (old->data)
+        replacement->read_only_ = old->data->read_only_;
+      this->release(s, k, false);
+    }
+    entry& e = s.entries_[k];
+    e.data = replacement;
+    e.created = true;
+    e.bytes = replacement->buffer_length();
+    this->insert(s, k, e);
+  }
+  this->evict();
+}
+
+void boxm2_concurrent_cache::save_entries(boxm2_scene* scene)
+{
+  for (auto & s : shards_)
+  {
+    std::lock_guard<std::mutex> lock(s->mutex_);
+    for (auto & f : s->entries_)
+    {
+      const key& k = f.first;
+      const entry& e = f.second;
+      if (e.loading || (scene && k.scene != scene))
+        continue;
+      if (e.data)
+        boxm2_sio_mgr::save_block_data_base(k.scene->data_path(), k.id, e.data, k.type);
+      if (e.block)
+        boxm2_sio_mgr::save_block(k.scene->data_path(), e.block);
+    }
+  }
+}
+
+//: dumps all data onto disk
+void boxm2_concurrent_cache::write_to_disk()
+{
+  this->save_entries(nullptr);
+}
+
+//: dumps all data of the scene onto disk
+void boxm2_concurrent_cache::write_to_disk(boxm2_scene_sptr & scene)
+{
+  this->save_entries(scene.ptr());
+}
+
+//: delete all the memory
+//  Caution: make sure to call write to disk methods not to loose writable data
+void boxm2_concurrent_cache::clear_cache()
+{
+  for (auto & s : shards_)
+  {
+    std::unique_lock<std::mutex> lock(s->mutex_);
+    s->loaded_.wait(lock, [&s] {
+      for (const auto & f : s->entries_)
+        if (f.second.loading)
+          return false;
+      return true;
+    });
+    while (!s->entries_.empty())
+      this->release(*s, s->entries_.begin()->first, false);
+  }
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  scenes_.clear();
+  requested_.clear();
+}
+
+//: add a new scene to the cache
+bool boxm2_concurrent_cache::add_scene(boxm2_scene_sptr & scene)
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  if (scenes_.find(scene.ptr()) != scenes_.end()) {
+    std::cout<<"The scene Already exists "<<std::endl;
+    return false;
+  }
+  scenes_[scene.ptr()] = scene;
+  return true;
+}
+
+//: remove a scene from the cache
+bool boxm2_concurrent_cache::remove_scene(boxm2_scene_sptr &  /*scene*/)
+{
+  // not allowed / implemented; return false
+  return false;
+}
+
+//: return list of scenes with data in the cache
+std::vector<boxm2_scene_sptr> boxm2_concurrent_cache::get_scenes()
+{
+  std::lock_guard<std::mutex> lock(scenes_mutex_);
+  std::vector<boxm2_scene_sptr> scenes;
+  for (const auto & s : scenes_)
+    scenes.push_back(s.second);
+  return scenes;
+}
+
+std::size_t boxm2_concurrent_cache::bytes_in_memory() const
+{
+  return bytes_;
+}
+
+//: Summarizes this cache's data
+std::string boxm2_concurrent_cache::to_string()
+{
+  std::stringstream stream;
+  stream << "boxm2_concurrent_cache:: "<<this->bytes_in_memory()<<" of "<<max_bytes_<<" bytes in "
+         << shards_.size()<<" shards, "<<hits_<<" hits, "<<misses_<<" misses, "<<evictions_<<" evictions";
+  for (std::size_t i = 0; i < shards_.size(); ++i)
+  {
+    std::lock_guard<std::mutex> lock(shards_[i]->mutex_);
+    for (const auto & f : shards_[i]->entries_)
+      stream << "\n  shard "<<i<<": ("<<f.first.id<<") "<<(f.first.type.empty() ? "block" : f.first.type)
+             << " of scene dir="<<f.first.scene->data_path()
+             << (f.second.loading ? " (loading)" : "") << (f.second.pins ? " (pinned)" : "");
+  }
+  return stream.str();
+}
+
+//: shows elements in cache
+std::ostream& operator<<(std::ostream &s, boxm2_concurrent_cache& cache)
+{
+  return s << cache.to_string();
+}
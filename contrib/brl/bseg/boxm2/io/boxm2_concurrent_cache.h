@@ -0,0 +1,226 @@
+#ifndef boxm2_concurrent_cache_h_
+#define boxm2_concurrent_cache_h_
+//:
+// \file
+// \brief boxm2_concurrent_cache is a boxm2_cache which several threads may use at once
+//
+// boxm2_lru_cache keeps its blocks and data in plain maps, and may only be
+// used by one thread.  boxm2_concurrent_cache spreads them over a number of
+// shards, each with its own lock and map, keyed by scene, block id and data
+// type (empty for the block itself), so that threads working on different
+// blocks rarely contend.  A block or data missing from the cache is
+// read from disk by the first thread requesting it, without holding the lock
+// of its shard; the other threads requesting it meanwhile wait for it.
+//
+// The blocks and data held take at most max_bytes, when they fit: the shards
+// take turns evicting their least recently used entry until the budget is met,
+// each locking only itself.
+// Evicted data which was opened for writing or created in memory, and evicted
+// blocks which are not read only, are saved to disk first.  A thread using a
+// block or data may pin it, with pin_block() or pin_data_base(), so that it
+// cannot be evicted by another thread, and unpin it when done; every pin must
+// be matched by an unpin.  The pointers returned by the boxm2_cache interface
+// are not pinned; instead, the block and data of the block each thread
+// requested last through that interface are not evicted, so that they stay
+// valid until the thread requests another block or ends, as with a single
+// threaded cache.
+//
+// remove_data_base(), replace_data_base() and clear_cache() must not be used
+// on entries pinned by other threads.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boxm2/io/boxm2_cache.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+class boxm2_concurrent_cache : public boxm2_cache
+{
+ public:
+
+  //: create function used instead of constructor
+  //  At most max_bytes are held in memory, in n_shards shards.
+  static void create(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type=LOCAL,
+                     std::size_t max_bytes=std::size_t(1)<<30, unsigned n_shards=16);
+
+  //: returns block pointer to block specified by ID
+  boxm2_block* get_block(boxm2_scene_sptr & scene, boxm2_block_id id) override;
+
+  //: returns data_base pointer (THIS IS NECESSARY BECAUSE TEMPLATED FUNCTIONS CANNOT BE VIRTUAL)
+  boxm2_data_base* get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: returns a data_base pointer which is initialized to the default value of the type.
+  //  If a block for this type exists on the cache, it is removed and replaced with the new one.
+  //  This method does not check whether a block of this type already exists on the disc nor writes it to the disc
+  boxm2_data_base* get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: removes data from this cache (may or may not write to disk first)
+  void remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out=true) override;
+
+  //: replaces a database in the cache, deletes it
+  void replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement) override;
+
+  //: returns the block, which cannot be evicted until unpin_block() is called as many times as pin_block()
+  boxm2_block* pin_block(boxm2_scene_sptr & scene, boxm2_block_id id);
+
+  //: returns the data as get_data_base() does, which cannot be evicted until unpin_data_base()
+  boxm2_data_base* pin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type,
+                                 std::size_t num_bytes=0, bool read_only = true);
+
+  void unpin_block(boxm2_scene_sptr & scene, boxm2_block_id id);
+  void unpin_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, const std::string& type);
+
+  //: dumps writeable data to disk
+  void write_to_disk() override;
+
+  //: dumps writeable data for specified scene to disk
+  void write_to_disk(boxm2_scene_sptr & scene) override;
+
+  //: add a new scene to the cache
+  bool add_scene(boxm2_scene_sptr & scene) override;
+
+  //: remove an existing scene from the cache (not implemented, as for boxm2_lru_cache)
+  bool remove_scene(boxm2_scene_sptr & scene) override;
+
+  //: delete all the memory, caution: make sure to call write to disc methods not to loose writable data
+  void clear_cache() override;
+
+  //: return the list of scenes with any data in the cache
+  std::vector<boxm2_scene_sptr> get_scenes() override;
+
+  //: to string method returns a string describing the cache's current state
+  std::string to_string();
+
+  //: bytes of the blocks and data held in memory
+  std::size_t bytes_in_memory() const;
+  std::size_t max_bytes() const { return max_bytes_; }
+  unsigned n_shards() const { return unsigned(shards_.size()); }
+
+  //: number of requests found in the cache, loaded or being loaded
+  unsigned long n_hits() const { return hits_; }
+  //: number of requests which had to be read from disk (or initialized)
+  unsigned long n_misses() const { return misses_; }
+  //: number of blocks and data evicted to meet the budget
+  unsigned long n_evictions() const { return evictions_; }
+
+ private:
+
+  //: hidden constructor (private so it cannot be called -- forces the class to be singleton)
+  boxm2_concurrent_cache(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                         std::size_t max_bytes, unsigned n_shards);
+
+  //: hidden destructor (private so it cannot be called -- forces the class to be singleton)
+  ~boxm2_concurrent_cache() override;
+
+  //: a block (empty type) or the data of one type of a block
+  struct key
+  {
+    key(boxm2_scene* s, const std::string& t, const boxm2_block_id& i) : scene(s), type(t), id(i) {}
+    boxm2_scene* scene;
+    std::string type;
+    boxm2_block_id id;
+    bool operator<(const key& k) const;
+  };
+
+  struct entry
+  {
+    entry() : block(nullptr), data(nullptr), bytes(0), created(false), loading(true), pins(0) {}
+    boxm2_block* block;
+    boxm2_data_base* data;
+    std::size_t bytes;
+    //: created in memory rather than read from disk
+    bool created;
+    //: being read from disk by a thread, without the lock of the shard
+    bool loading;
+    //: pins of the callers, and of the threads waiting for the entry
+    unsigned pins;
+    //: position in the lru_ list of the shard, once loaded
+    std::list<key>::iterator lru_pos;
+  };
+
+  //: One independently locked partition of the cache.
+  struct shard
+  {
+    std::mutex mutex_;
+    //: signals entries loaded
+    std::condition_variable loaded_;
+    std::map<key, entry> entries_;
+    //: keys of the loaded entries, least recently used first
+    std::list<key> lru_;
+  };
+
+  //: forgets the block each thread requested last when the thread ends
+  struct thread_requests;
+
+  std::vector<std::unique_ptr<shard> > shards_;
+  std::size_t max_bytes_;
+  //: bytes of the entries of all the shards
+  std::atomic<std::size_t> bytes_{0};
+  //: the shard to evict from next
+  std::atomic<unsigned> next_victim_shard_{0};
+
+  mutable std::mutex scenes_mutex_;
+  std::map<boxm2_scene*, boxm2_scene_sptr> scenes_;
+  //: the block each thread requested last through the boxm2_cache interface (scenes_mutex_)
+  std::map<std::thread::id, key> requested_;
+
+  std::atomic<unsigned long> hits_{0};
+  std::atomic<unsigned long> misses_{0};
+  std::atomic<unsigned long> evictions_{0};
+
+  // ---------Helper Methods --------------------------------------------------
+
+  shard& shard_for(const key& k) const;
+
+  //: keep a reference to the scene, whose pointer the keys hold
+  void register_scene(const boxm2_scene_sptr& scene);
+
+  //: register the scene, and protect block id of it as the one the calling thread requested last
+  void note_request(const boxm2_scene_sptr& scene, const boxm2_block_id& id);
+
+  //: the block of the scene, pinned once more
+  entry& acquire_block(boxm2_scene_sptr & scene, const boxm2_block_id& id);
+
+  //: the data of the scene, pinned once more
+  entry& acquire_data(boxm2_scene_sptr & scene, const boxm2_block_id& id, const std::string& type,
+                      std::size_t num_bytes, bool read_only);
+
+  //: the entry for k pinned once more, read by load(entry&) without the lock if missing
+  template <class LOAD>
+  entry& acquire(const key& k, LOAD load);
+
+  //: undo a pin, and evict what the pin kept
+  void unpin(const key& k);
+
+  //: wait until the entry for k is no longer being loaded (shard locked)
+  //  Returns the entry, or null if there is none.
+  entry* settle(shard& s, const key& k, std::unique_lock<std::mutex>& lock);
+
+  //: count the loaded entry for k in the budget, as just used (shard locked)
+  void insert(shard& s, const key& k, entry& e);
+
+  //: evict the least recently used entries of the shards in turn, which are neither pinned nor protected,
+  //  until the budget is met (no shard locked)
+  void evict();
+
+  //: save the entry if it would be lost, delete it and remove it from the shard (shard locked)
+  void release(shard& s, const key& k, bool write_out);
+
+  //: save all entries of scene, or of all scenes if null
+  void save_entries(boxm2_scene* scene);
+};
+
+//: shows elements in cache
+std::ostream& operator<<(std::ostream &s, boxm2_concurrent_cache& cache);
+
+#endif // boxm2_concurrent_cache_h_
@@ -101,7 +101,7 @@ boxm2_block* boxm2_lru_cache::get_block(boxm2_scene_sptr & scene, boxm2_block_id
   //: add a block
   if ( cached_blocks_[scene].find(id) == cached_blocks_[scene].end() )
   {
-      boxm2_block* loaded = boxm2_sio_mgr::load_block(scene->data_path(), id, mdata );
+      boxm2_block* loaded = boxm2_sio_mgr::load_block(scene->data_path(), id, mdata, filesystem_);
 
       // if the block is null then initialize an empty one
       if (!loaded && scene->block_exists(id)) {
@@ -172,6 +172,8 @@ boxm2_data_base* boxm2_lru_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_
       loaded = new boxm2_data_base(new char[byte_length], byte_length, id, read_only);
       loaded->set_default_value(type, data);
     }
+    else if (loaded && !read_only)  // write-enable is enforced
+      loaded->enable_write();
   }
 
   // update data map
@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include "boxm2_mmap_mgr.h"
+#include "boxm2_sio_mgr.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+#if !defined(_WIN32)
+#  define BOXM2_MMAP_MGR_POSIX 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+//:
+// \file
+
+boxm2_mapped_file::boxm2_mapped_file(const std::string& filepath, BOXM2_IO_MAP_MODE mode)
+  : filepath_(filepath), mode_(mode), data_(nullptr), size_(0)
+{
+#ifdef BOXM2_MMAP_MGR_POSIX
+  int fd = ::open(filepath.c_str(), mode == BOXM2_MAP_SHARED ? O_RDWR : O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return;
+  }
+  const std::size_t size = std::size_t(st.st_size);
+  // a private mapping of a file opened for reading may still be written
+  const int prot  = mode == BOXM2_MAP_READ ? PROT_READ : PROT_READ | PROT_WRITE;
+  const int flags = mode == BOXM2_MAP_SHARED ? MAP_SHARED : MAP_PRIVATE;
+  void* p = ::mmap(nullptr, size, prot, flags, fd, 0);
+  ::close(fd); // the mapping keeps its own reference to the file
+  if (p == MAP_FAILED)
+    return;
+  data_ = static_cast<char*>(p);
+  size_ = size;
+#endif
+}
+
+boxm2_mapped_file::~boxm2_mapped_file()
+{
+#ifdef BOXM2_MMAP_MGR_POSIX
+  if (data_)
+    ::munmap(data_, size_);
+#endif
+}
+
+bool boxm2_mapped_file::flush()
+{
+  if (!data_)
+    return false;
+  switch (mode_)
+  {
+    case BOXM2_MAP_READ:
+      return true;
+    case BOXM2_MAP_SHARED:
+#ifdef BOXM2_MMAP_MGR_POSIX
+      return ::msync(data_, size_, MS_SYNC) == 0;
+#else
+      return false;
+#endif
+    default:
+    {
+      // Truncating the mapped file would take away its pages which were not
+      // written yet, so write a new file and move it over the old one.
+      // The mapping keeps the old file, whose pages equal the new one's.
+      std::string tmppath = filepath_ + ".tmp";
+      std::ofstream myFile(tmppath.c_str(), std::ios::out | std::ios::binary);
+      myFile.write(data_, size_);
+      myFile.close();
+      if (!myFile || std::rename(tmppath.c_str(), filepath_.c_str()) != 0) {
+        std::cerr << "boxm2_mapped_file::flush cannot write " << filepath_ << '\n';
+        std::remove(tmppath.c_str());
+        return false;
+      }
+      return true;
+    }
+  }
+}
+
+boxm2_mapped_block::boxm2_mapped_block(boxm2_block_id const& id, boxm2_block_metadata const& data,
+                                       boxm2_mapped_file* file)
+  : boxm2_block(id, data, file->data()), file_(file)
+{}
+
+boxm2_mapped_block::boxm2_mapped_block(boxm2_block_id const& id, boxm2_mapped_file* file)
+  : boxm2_block(id, file->data()), file_(file)
+{}
+
+boxm2_mapped_block::~boxm2_mapped_block()
+{
+  // the buffer is unmapped rather than deleted
+  this->release_buffer();
+  delete file_;
+}
+
+bool boxm2_mapped_block::flush()
+{
+  if (file_->mode() != BOXM2_MAP_READ)
+    this->b_write(file_->data());
+  return file_->flush();
+}
+
+boxm2_mapped_data_base::boxm2_mapped_data_base(boxm2_block_id const& id, boxm2_mapped_file* file)
+  : boxm2_data_base(file->data(), file->size(), id), file_(file)
+{}
+
+boxm2_mapped_data_base::~boxm2_mapped_data_base()
+{
+  // the buffer is unmapped rather than deleted
+  data_buffer_ = nullptr;
+  delete file_;
+}
+
+boxm2_block* boxm2_mmap_mgr::load_block(const std::string& dir, const boxm2_block_id& block_id, BOXM2_IO_MAP_MODE mode)
+{
+  auto* file = new boxm2_mapped_file(dir + block_id.to_string() + ".bin", mode);
+  if (!file->is_mapped()) {
+    delete file;
+    return boxm2_sio_mgr::load_block(dir, block_id);
+  }
+  return new boxm2_mapped_block(block_id, file);
+}
+
+boxm2_block* boxm2_mmap_mgr::load_block(const std::string& dir, const boxm2_block_id& block_id,
+                                        const boxm2_block_metadata& data, BOXM2_IO_MAP_MODE mode)
+{
+  auto* file = new boxm2_mapped_file(dir + block_id.to_string() + ".bin", mode);
+  if (!file->is_mapped()) {
+    delete file;
+    return boxm2_sio_mgr::load_block(dir, block_id, data);
+  }
+  return new boxm2_mapped_block(block_id, data, file);
+}
+
+boxm2_data_base* boxm2_mmap_mgr::load_block_data_generic(const std::string& dir, const boxm2_block_id& id,
+                                                         const std::string& data_type, BOXM2_IO_MAP_MODE mode)
+{
+  auto* file = new boxm2_mapped_file(dir + data_type + "_" + id.to_string() + ".bin", mode);
+  if (!file->is_mapped()) {
+    delete file;
+    return boxm2_sio_mgr::load_block_data_generic(dir, id, data_type);
+  }
+  return new boxm2_mapped_data_base(id, file);
+}
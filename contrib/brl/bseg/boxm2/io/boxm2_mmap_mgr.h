@@ -0,0 +1,127 @@
+#ifndef boxm2_mmap_mgr_h_
+#define boxm2_mmap_mgr_h_
+//:
+// \file
+// \brief Loads blocks and data by mapping their files into memory instead of reading them.
+//
+// boxm2_sio_mgr reads a whole block or data file into a new char buffer.
+// boxm2_mmap_mgr maps the file instead: nothing is read until a page is
+// touched, and the pages of a scene on disk are shared through the page cache
+// by all the processes which map it, e.g. many workers rendering one scene.
+// Three modes are available:
+//  - BOXM2_MAP_READ: read only, for rendering.  The buffer must not be written.
+//  - BOXM2_MAP_COPY_ON_WRITE: pages are shared until written, and changes stay
+//    private until flush() writes the whole buffer to a new file, which then
+//    replaces the old one, so that other processes keep the version they mapped.
+//  - BOXM2_MAP_SHARED: changes are written to the file itself, and are seen by
+//    the other processes mapping it; flush() waits until they are on disk.
+//
+// The blocks and data returned are boxm2_mapped_block and boxm2_mapped_data_base
+// which unmap their file when deleted.  boxm2_sio_mgr::save_block() and
+// save_block_data_base() flush them when they are saved to the file they map,
+// unless they are still read only (see enable_write()), so the caches handle
+// them like any other block or data, and only rewrite what they may have changed.  A cache created
+// with the LOCAL_MMAP file system type loads everything copy on write.
+//
+// Mapping is only available on POSIX systems; elsewhere, and for empty files,
+// the loaders fall back to reading the file with boxm2_sio_mgr.
+
+#include <cstddef>
+#include <string>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: how a block or data file is mapped
+typedef enum {BOXM2_MAP_READ=0, BOXM2_MAP_COPY_ON_WRITE, BOXM2_MAP_SHARED} BOXM2_IO_MAP_MODE;
+
+//: a whole file mapped into memory
+class boxm2_mapped_file
+{
+ public:
+  //: maps filepath; is_mapped() tells whether it succeeded
+  boxm2_mapped_file(const std::string& filepath, BOXM2_IO_MAP_MODE mode);
+
+  //: unmaps the file, without writing copy on write changes
+  ~boxm2_mapped_file();
+
+  bool is_mapped() const { return data_ != nullptr; }
+  char* data() { return data_; }
+  std::size_t size() const { return size_; }
+  const std::string& filepath() const { return filepath_; }
+  BOXM2_IO_MAP_MODE mode() const { return mode_; }
+
+  //: makes the changes to the buffer persistent (nothing to do for BOXM2_MAP_READ)
+  bool flush();
+
+ private:
+  boxm2_mapped_file(const boxm2_mapped_file&);
+  boxm2_mapped_file& operator=(const boxm2_mapped_file&);
+
+  std::string filepath_;
+  BOXM2_IO_MAP_MODE mode_;
+  char* data_;
+  std::size_t size_;
+};
+
+//: a block whose buffer is a mapped file
+class boxm2_mapped_block : public boxm2_block
+{
+ public:
+  //: takes the ownership of file, which must be mapped
+  boxm2_mapped_block(boxm2_block_id const& id, boxm2_block_metadata const& data, boxm2_mapped_file* file);
+  boxm2_mapped_block(boxm2_block_id const& id, boxm2_mapped_file* file);
+
+  ~boxm2_mapped_block() override;
+
+  boxm2_mapped_file& file() { return *file_; }
+
+  //: writes the block meta data to the buffer, and flushes it
+  bool flush();
+
+ private:
+  boxm2_mapped_file* file_;
+};
+
+//: data whose buffer is a mapped file
+class boxm2_mapped_data_base : public boxm2_data_base
+{
+ public:
+  //: takes the ownership of file, which must be mapped
+  boxm2_mapped_data_base(boxm2_block_id const& id, boxm2_mapped_file* file);
+
+  ~boxm2_mapped_data_base() override;
+
+  boxm2_mapped_file& file() { return *file_; }
+
+  bool flush() { return file_->flush(); }
+
+ private:
+  boxm2_mapped_file* file_;
+};
+
+//: disk level storage class mapping the files of blocks and data.
+//  Returns null if the file is not available, as boxm2_sio_mgr does.
+class boxm2_mmap_mgr
+{
+ public:
+  //: maps a block
+  static boxm2_block* load_block(const std::string& dir, const boxm2_block_id& block_id,
+                                 BOXM2_IO_MAP_MODE mode=BOXM2_MAP_READ);
+
+  static boxm2_block* load_block(const std::string& dir, const boxm2_block_id& block_id,
+                                 const boxm2_block_metadata& data, BOXM2_IO_MAP_MODE mode=BOXM2_MAP_READ);
+
+  //: maps the data of a block (given data_type string prefix)
+  //  As for boxm2_sio_mgr, the data is marked read only until enable_write(),
+  //  which the caches call for the data requested for writing.
+  static boxm2_data_base* load_block_data_generic(const std::string& dir, const boxm2_block_id& id,
+                                                  const std::string& data_type,
+                                                  BOXM2_IO_MAP_MODE mode=BOXM2_MAP_READ);
+};
+
+#endif // boxm2_mmap_mgr_h_
@@ -0,0 +1,537 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "boxm2_prefetch_cache.h"
+//:
+// \file
+#include <boxm2/boxm2_block_metadata.h>
+#include <boxm2/boxm2_data_traits.h>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: PUBLIC create method, for creating singleton instance of boxm2_cache
+void boxm2_prefetch_cache::create(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                                  std::size_t max_bytes, unsigned lookahead, unsigned n_io_threads)
+{
+  if (!boxm2_cache::exists())
+    instance_ = new boxm2_prefetch_cache(scene, fs_type, max_bytes, lookahead, n_io_threads);
+}
+
+//: constructor, starts the I/O threads
+boxm2_prefetch_cache::boxm2_prefetch_cache(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                                           std::size_t max_bytes, unsigned lookahead, unsigned n_io_threads)
+: boxm2_cache(fs_type), max_bytes_(max_bytes), lookahead_(lookahead)
+{
+  if (scene)
+    scenes_[scene.ptr()] = scene;
+  if (n_io_threads == 0)
+    n_io_threads = 1;
+  for (unsigned t = 0; t < n_io_threads; ++t)
+    io_threads_.emplace_back(&boxm2_prefetch_cache::io_loop, this);
+}
+
+//: destructor stops the I/O threads and deletes the memory
+boxm2_prefetch_cache::~boxm2_prefetch_cache()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto & t : io_threads_)
+    t.join();
+  this->clear_cache();
+}
+
+bool boxm2_prefetch_cache::key::operator<(const key& k) const
+{
+  if (scene != k.scene)
+    return scene < k.scene;
+  if (id != k.id)
+    return id < k.id;
+  return type < k.type;
+}
+
+void boxm2_prefetch_cache::io_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_)
+      return;
+    key k = queue_.front();
+    queue_.pop_front();
+    auto f = items_.find(k);
+    if (f == items_.end() || f->second.state != QUEUED) {
+      done_cv_.notify_all();
+      continue;
+    }
+    // the budget may have been reached since the prefetch was queued
+    if (bytes_ >= max_bytes_) {
+      items_.erase(f);
+      done_cv_.notify_all();
+      continue;
+    }
+    f->second.state = LOADING;
+    this->load(k, f->second, lock);
+  }
+}
+
+void boxm2_prefetch_cache::load(const key& k, item& it, std::unique_lock<std::mutex>& lock)
+{
+  const std::string dir = k.scene->data_path();
+  const boxm2_block_metadata mdata = k.scene->get_block_metadata(k.id);
+  const bool exists = k.scene->block_exists(k.id);
+  lock.unlock();
+
+  boxm2_block* blk = nullptr;
+  boxm2_data_base* data = nullptr;
+  bool created = false;
+  if (k.type.empty()) {
+    blk = boxm2_sio_mgr::load_block(dir, k.id, mdata, filesystem_);
+    // if the block is null then initialize an empty one
+    if (!blk && exists) {
+      std::cout<<"boxm2_prefetch_cache::initializing empty block "<<k.id<<std::endl;
+      blk = new boxm2_block(mdata);
+      created = true;
+    }
+  }
+  else {
+    // data missing on disk is initialized by get_data_base(), which knows its size
+    data = boxm2_sio_mgr::load_block_data_generic(dir, k.id, k.type, filesystem_);
+  }
+
+  lock.lock();
+  it.block = blk;
+  it.data = data;
+  it.created = created;
+  it.bytes = blk ? std::size_t(blk->byte_count()) : data ? data->buffer_length() : 0;
+  it.state = READY;
+  bytes_ += it.bytes;
+  done_cv_.notify_all();
+  this->evict();
+}
+
+boxm2_prefetch_cache::item& boxm2_prefetch_cache::fetch(const key& k, std::unique_lock<std::mutex>& lock)
+{
+  ++n_requests_;
+  item& it = items_[k];
+  if (it.state == QUEUED) {
+    // not started by an I/O thread (or not requested at all): read it here
+    auto q = std::find_if(queue_.begin(), queue_.end(),
+                          [&k](const key& x) { return !(x < k) && !(k < x); });
+    if (q != queue_.end())
+      queue_.erase(q);
+    ++misses_;
+    it.state = LOADING;
+    ++it.waiting;
+    this->load(k, it, lock);
+  }
+  else {
+    if (it.prefetched)
+      ++prefetch_hits_;
+    ++it.waiting;
+    done_cv_.wait(lock, [&it] { return it.state == READY; });
+  }
+  --it.waiting;
+  it.prefetched = false;
+  it.last_use = n_requests_;
+  return it;
+}
+
+boxm2_prefetch_cache::item* boxm2_prefetch_cache::settle(const key& k, std::unique_lock<std::mutex>& lock)
+{
+  auto f = items_.find(k);
+  if (f == items_.end())
+    return nullptr;
+  if (f->second.state == QUEUED) {
+    auto q = std::find_if(queue_.begin(), queue_.end(),
+                          [&k](const key& x) { return !(x < k) && !(k < x); });
+    if (q != queue_.end())
+      queue_.erase(q);
+    items_.erase(f);
+    return nullptr;
+  }
+  item& it = f->second;
+  ++it.waiting;
+  done_cv_.wait(lock, [&it] { return it.state == READY; });
+  --it.waiting;
+  return &it;
+}
+
+void boxm2_prefetch_cache::advance(boxm2_scene* scene, const boxm2_block_id& id)
+{
+  current_ = key(scene, "", id);
+  if (scene != order_scene_)
+    return;
+  auto p = order_pos_.find(id);
+  if (p == order_pos_.end())
+    return;
+  const std::size_t window_begin = p->second + 1;
+  if (window_begin == window_begin_ && window_end_ > 0)
+    return; // data of the current block
+  window_begin_ = window_begin;
+  window_end_ = std::min(order_.size(), window_begin + lookahead_);
+  this->queue_window();
+}
+
+void boxm2_prefetch_cache::queue_window()
+{
+  // make room, mostly from the blocks already traversed
+  this->evict();
+  for (std::size_t i = window_begin_; i < window_end_ && bytes_ < max_bytes_; ++i)
+  {
+    std::vector<key> keys(1, key(order_scene_, "", order_[i]));
+    for (const auto & type : order_types_)
+      keys.emplace_back(order_scene_, type, order_[i]);
+    for (const auto & k : keys)
+      if (items_.find(k) == items_.end()) {
+        item& it = items_[k];
+        it.prefetched = true;
+        it.last_use = n_requests_;
+        queue_.push_back(k);
+      }
+  }
+  work_cv_.notify_all();
+}
+
+bool boxm2_prefetch_cache::is_protected(const key& k) const
+{
+  auto f = items_.find(k);
+  if (f != items_.end() && (f->second.state != READY || f->second.waiting > 0))
+    return true;
+  if (k.scene == current_.scene && k.id == current_.id)
+    return true;
+  if (k.scene != order_scene_)
+    return false;
+  auto p = order_pos_.find(k.id);
+  return p != order_pos_.end() && p->second >= window_begin_ && p->second < window_end_;
+}
+
+void boxm2_prefetch_cache::evict()
+{
+  while (bytes_ > max_bytes_)
+  {
+    auto victim = items_.end();
+    for (auto f = items_.begin(); f != items_.end(); ++f)
+      if (f->second.bytes > 0 && (victim == items_.end() || f->second.last_use < victim->second.last_use) &&
+          !this->is_protected(f->first))
+        victim = f;
+    if (victim == items_.end())
+      return;
+    this->release(victim->first, victim->second, true);
+    items_.erase(victim);
+  }
+}
+
+void boxm2_prefetch_cache::release(const key& k, item& it, bool write_out)
+{
+  const std::string dir = k.scene->data_path();
+  if (it.block) {
+    if (write_out && !it.block->read_only())
+      boxm2_sio_mgr::save_block(dir, it.block);
+    delete it.block;
+  }
+  if (it.data) {
+    if (write_out && (!it.data->read_only_ || it.created))
+      boxm2_sio_mgr::save_block_data_base(dir, k.id, it.data, k.type);
+    delete it.data;
+  }
+  bytes_ -= it.bytes;
+  it.block = nullptr;
+  it.data = nullptr;
+  it.bytes = 0;
+}
+
+void boxm2_prefetch_cache::set_visibility_order(boxm2_scene_sptr & scene, const std::vector<boxm2_block_id>& order,
+                                                const std::vector<std::string>& data_types)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+
+  // drop the prefetches of the previous order which have not started
+  for (const auto & k : queue_)
+    items_.erase(k);
+  queue_.clear();
+
+  order_scene_ = scene.ptr();
+  order_ = order;
+  order_types_ = data_types;
+  order_pos_.clear();
+  for (std::size_t i = 0; i < order_.size(); ++i)
+    order_pos_.insert(std::make_pair(order_[i], i));
+  window_begin_ = 0;
+  window_end_ = std::min(order_.size(), std::size_t(lookahead_));
+  this->queue_window();
+}
+
+void boxm2_prefetch_cache::set_visibility_order(boxm2_scene_sptr & scene, vpgl_camera_double_sptr & cam,
+                                                const std::vector<std::string>& data_types)
+{
+  this->set_visibility_order(scene, scene->get_vis_blocks(cam), data_types);
+}
+
+//: realization of abstract "get_block(block_id)"
+boxm2_block* boxm2_prefetch_cache::get_block(boxm2_scene_sptr & scene, boxm2_block_id id)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+  this->advance(scene.ptr(), id);
+  return this->fetch(key(scene.ptr(), "", id), lock).block;
+}
+
+//: get data by type and id
+boxm2_data_base* boxm2_prefetch_cache::get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  if (!scene->block_exists(id))
+    return nullptr;
+  boxm2_block* blk = this->get_block(scene, id);
+  const std::size_t byte_length = blk->num_cells() * boxm2_data_info::datasize(type);
+
+  // if num_bytes is greater than zero, then you're guaranteed to return a data size with that many bytes
+  if (num_bytes > 0 && num_bytes != byte_length) {
+    std::stringstream ss;
+    ss<<"Attempting to retrieve "<<num_bytes<<" bytes for datatype " << type <<" when actual buffer size should be "<<byte_length;
+    throw std::runtime_error(ss.str());
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  item& it = this->fetch(key(scene.ptr(), type, id), lock);
+  if (!it.data || (num_bytes > 0 && it.data->buffer_length() != byte_length))
+  {
+    std::cout<<"boxm2_prefetch_cache::initializing empty data "<<id<<" type: "<<type<<std::endl;
+    delete it.data;
+    bytes_ -= it.bytes;
+    it.data = new boxm2_data_base(new char[byte_length], byte_length, id, read_only);
+    it.data->set_default_value(type, scene->get_block_metadata(id));
+    it.created = true;
+    it.bytes = byte_length;
+    bytes_ += it.bytes;
+    this->evict();
+  }
+  if (!read_only)  // write-enable is enforced
+    it.data->enable_write();
+  return it.data;
+}
+
+//: returns a data_base pointer which is initialized to the default value of the type.
+//  If a block for this type exists on the cache, it is removed and replaced with the new one.
+//  This method does not check whether a block of this type already exists on the disk nor writes it to the disk
+boxm2_data_base* boxm2_prefetch_cache::get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes, bool read_only)
+{
+  boxm2_block_metadata data = scene->get_block_metadata(id);
+  boxm2_data_base* block_data;
+  if (num_bytes > 0) {
+    block_data = new boxm2_data_base(new char[num_bytes], num_bytes, id, read_only);
+    block_data->set_default_value(type, data);
+  }
+  else {
+    // the following constructor also sets the default values
+    block_data = new boxm2_data_base(data, type, read_only);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+  const key k(scene.ptr(), type, id);
+  if (item* old = this->settle(k, lock))
+    this->release(k, *old, false);
+  item& it = items_[k];
+  it.state = READY;
+  it.data = block_data;
+  it.created = true;
+  it.prefetched = false;
+  it.last_use = ++n_requests_;
+  it.bytes = block_data->buffer_length();
+  bytes_ += it.bytes;
+  this->evict();
+  return block_data;
+}
+
+//: removes data from this cache (may or may not write to disk first)
+void boxm2_prefetch_cache::remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  const key k(scene.ptr(), type, id);
+  item* it = this->settle(k, lock);
+  if (!it)
+    return;
+  if (write_out && it->data)
+    boxm2_sio_mgr::save_block_data_base(scene->data_path(), id, it->data, type);
+  this->release(k, *it, false);
+  items_.erase(k);
+}
+
+//: replaces data in the cache with one here
+void boxm2_prefetch_cache::replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (scenes_.find(scene.ptr()) == scenes_.end())
+    scenes_[scene.ptr()] = scene;
+  const key k(scene.ptr(), type, id);
+  // copy the read_only/write status of the old data base
+  if (item* old = this->settle(k, lock)) {
+    if (old->data)
+      replacement->read_only_ = old->data->read_only_;
+    this->release(k, *old, false);
+  }
+  item& it = items_[k];
+  it.state = READY;
+  it.data = replacement;
+  it.created = true;
+  it.prefetched = false;
+  it.last_use = ++n_requests_;
+  it.bytes = replacement->buffer_length();
+  bytes_ += it.bytes;
+  this->evict();
+}
+
+void boxm2_prefetch_cache::save_items(boxm2_scene* scene)
+{
+  for (auto & f : items_)
+  {
+    const key& k = f.first;
+    const item& it = f.second;
+    if (it.state != READY || (scene && k.scene != scene))
+      continue;
+    if (it.data)
+      boxm2_sio_mgr::save_block_data_base(k.scene->data_path(), k.id, it.data, k.type);
+    if (it.block)
+      boxm2_sio_mgr::save_block(k.scene->data_path(), it.block);
+  }
+}
+
+//: dumps all data onto disk
+void boxm2_prefetch_cache::write_to_disk()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  this->save_items(nullptr);
+}
+
+//: dumps all data of the scene onto disk
+void boxm2_prefetch_cache::write_to_disk(boxm2_scene_sptr & scene)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  this->save_items(scene.ptr());
+}
+
+void boxm2_prefetch_cache::wait_for_prefetches()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] {
+    if (!queue_.empty())
+      return false;
+    for (const auto & f : items_)
+      if (f.second.state != READY)
+        return false;
+    return true;
+  });
+}
+
+void boxm2_prefetch_cache::drain(std::unique_lock<std::mutex>& lock)
+{
+  for (const auto & k : queue_)
+    items_.erase(k);
+  queue_.clear();
+  done_cv_.wait(lock, [this] {
+    for (const auto & f : items_)
+      if (f.second.state != READY)
+        return false;
+    return true;
+  });
+}
+
+//: delete all the memory
+//  Caution: make sure to call write to disk methods not to loose writable data
+void boxm2_prefetch_cache::clear_cache()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  this->drain(lock);
+  for (auto & f : items_)
+    this->release(f.first, f.second, false);
+  items_.clear();
+  scenes_.clear();
+  order_scene_ = nullptr;
+  order_.clear();
+  order_pos_.clear();
+  order_types_.clear();
+  window_begin_ = window_end_ = 0;
+  current_ = key();
+}
+
+//: add a new scene to the cache
+bool boxm2_prefetch_cache::add_scene(boxm2_scene_sptr & scene)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (scenes_.find(scene.ptr()) != scenes_.end()) {
+    std::cout<<"The scene Already exists "<<std::endl;
+    return false;
+  }
+  scenes_[scene.ptr()] = scene;
+  return true;
+}
+
+//: remove a scene from the cache
+bool boxm2_prefetch_cache::remove_scene(boxm2_scene_sptr &  /*scene*/)
+{
+  // not allowed / implemented; return false
+  return false;
+}
+
+//: return list of scenes with data in the cache
+std::vector<boxm2_scene_sptr> boxm2_prefetch_cache::get_scenes()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<boxm2_scene_sptr> scenes;
+  for (const auto & s : scenes_)
+    scenes.push_back(s.second);
+  return scenes;
+}
+
+std::size_t boxm2_prefetch_cache::bytes_in_memory() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+unsigned boxm2_prefetch_cache::prefetch_hits() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return prefetch_hits_;
+}
+
+unsigned boxm2_prefetch_cache::misses() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+//: Summarizes this cache's data
+std::string boxm2_prefetch_cache::to_string()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::stringstream stream;
+  stream << "boxm2_prefetch_cache:: "<<bytes_<<" of "<<max_bytes_<<" bytes, "
+         << prefetch_hits_<<" prefetch hits, "<<misses_<<" misses";
+  boxm2_scene* scene = nullptr;
+  for (const auto & f : items_)
+  {
+    if (f.first.scene != scene) {
+      scene = f.first.scene;
+      stream << "\n  scene dir="<<scene->data_path();
+    }
+    stream << "\n    ("<<f.first.id<<") "<<(f.first.type.empty() ? "block" : f.first.type)
+           << (f.second.state == READY ? "" : " (loading)");
+  }
+  return stream.str();
+}
+
+//: shows elements in cache
+std::ostream& operator<<(std::ostream &s, boxm2_prefetch_cache& cache)
+{
+  return s << cache.to_string();
+}
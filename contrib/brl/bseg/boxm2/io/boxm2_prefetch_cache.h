@@ -0,0 +1,221 @@
+#ifndef boxm2_prefetch_cache_h_
+#define boxm2_prefetch_cache_h_
+//:
+// \file
+// \brief boxm2_prefetch_cache loads the blocks about to be traversed on I/O threads, within a memory budget
+//
+// Renders and updates request the blocks of a scene one after the other in
+// visibility order, and boxm2_lru_cache reads each block and its data from
+// disk only when it is first requested.  boxm2_prefetch_cache is told that
+// order with set_visibility_order(); whenever a block of the order is
+// requested, the next lookahead blocks and their data of the given types are
+// read by a few I/O threads while the caller works on the current block.
+//
+// The blocks and data held take at most max_bytes, when they fit: once the
+// budget is reached, the least recently used blocks and data outside the
+// current block and the look-ahead window, i.e. mostly blocks already
+// traversed, are evicted, and no further block is prefetched.  Evicted data
+// which was opened for writing or created in memory, and evicted blocks which
+// are not read only, are saved to disk first, so that they are reloaded as
+// they were.  A pointer returned by the cache is therefore only valid until
+// the blocks after its own have been requested.
+//
+// Without a visibility order, the cache behaves as a least recently used
+// cache with a memory budget.  All the methods may be called from any thread.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boxm2/io/boxm2_cache.h>
+#include <vpgl/vpgl_camera_double_sptr.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+class boxm2_prefetch_cache : public boxm2_cache
+{
+ public:
+
+  //: create function used instead of constructor
+  //  At most max_bytes are held in memory, lookahead blocks are prefetched
+  //  after the current one, by n_io_threads threads.
+  static void create(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type=LOCAL,
+                     std::size_t max_bytes=std::size_t(1)<<30,
+                     unsigned lookahead=4, unsigned n_io_threads=2);
+
+  //: The blocks of scene will be requested in this order, with data of the given types.
+  //  The first blocks of the order are prefetched right away.
+  void set_visibility_order(boxm2_scene_sptr & scene, const std::vector<boxm2_block_id>& order,
+                            const std::vector<std::string>& data_types);
+
+  //: The blocks of scene will be requested in visibility order from cam, with data of the given types.
+  void set_visibility_order(boxm2_scene_sptr & scene, vpgl_camera_double_sptr & cam,
+                            const std::vector<std::string>& data_types);
+
+  //: returns block pointer to block specified by ID
+  boxm2_block* get_block(boxm2_scene_sptr & scene, boxm2_block_id id) override;
+
+  //: returns data_base pointer (THIS IS NECESSARY BECAUSE TEMPLATED FUNCTIONS CANNOT BE VIRTUAL)
+  boxm2_data_base* get_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: returns a data_base pointer which is initialized to the default value of the type.
+  //  If a block for this type exists on the cache, it is removed and replaced with the new one.
+  //  This method does not check whether a block of this type already exists on the disc nor writes it to the disc
+  boxm2_data_base* get_data_base_new(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, std::size_t num_bytes=0, bool read_only = true) override;
+
+  //: removes data from this cache (may or may not write to disk first)
+  void remove_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, bool write_out=true) override;
+
+  //: replaces a database in the cache, deletes it
+  void replace_data_base(boxm2_scene_sptr & scene, boxm2_block_id id, std::string type, boxm2_data_base* replacement) override;
+
+  //: dumps writeable data to disk
+  void write_to_disk() override;
+
+  //: dumps writeable data for specified scene to disk
+  void write_to_disk(boxm2_scene_sptr & scene) override;
+
+  //: add a new scene to the cache
+  bool add_scene(boxm2_scene_sptr & scene) override;
+
+  //: remove an existing scene from the cache (not implemented, as for boxm2_lru_cache)
+  bool remove_scene(boxm2_scene_sptr & scene) override;
+
+  //: delete all the memory, caution: make sure to call write to disc methods not to loose writable data
+  void clear_cache() override;
+
+  //: return the list of scenes with any data in the cache
+  std::vector<boxm2_scene_sptr> get_scenes() override;
+
+  //: to string method returns a string describing the cache's current state
+  std::string to_string();
+
+  //: bytes of the blocks and data held in memory
+  std::size_t bytes_in_memory() const;
+  std::size_t max_bytes() const { return max_bytes_; }
+  unsigned lookahead() const { return lookahead_; }
+
+  //: wait until the I/O threads have loaded, or dropped, every queued prefetch
+  void wait_for_prefetches();
+
+  //: number of requests answered by a prefetch, finished or not
+  unsigned prefetch_hits() const;
+  //: number of requests which had to be read from disk (or initialized) by the caller
+  unsigned misses() const;
+
+ private:
+
+  //: hidden constructor (private so it cannot be called -- forces the class to be singleton)
+  boxm2_prefetch_cache(const boxm2_scene_sptr& scene, BOXM2_IO_FS_TYPE fs_type,
+                       std::size_t max_bytes, unsigned lookahead, unsigned n_io_threads);
+
+  //: hidden destructor (private so it cannot be called -- forces the class to be singleton)
+  ~boxm2_prefetch_cache() override;
+
+  //: a block (empty type) or the data of one type of a block
+  struct key
+  {
+    key() : scene(nullptr) {}
+    key(boxm2_scene* s, const std::string& t, const boxm2_block_id& i) : scene(s), type(t), id(i) {}
+    boxm2_scene* scene;
+    std::string type;
+    boxm2_block_id id;
+    bool operator<(const key& k) const;
+  };
+
+  enum item_state { QUEUED, LOADING, READY };
+
+  struct item
+  {
+    item_state state{QUEUED};
+    boxm2_block* block{nullptr};
+    boxm2_data_base* data{nullptr};
+    std::size_t bytes{0};
+    //: created in memory rather than read from disk
+    bool created{false};
+    //: request count at the last request, for eviction
+    unsigned long last_use{0};
+    bool prefetched{false};
+    //: callers waiting for the item to be loaded
+    unsigned waiting{0};
+  };
+
+  //: blocks and data, loaded or being loaded
+  std::map<key, item> items_;
+  //: prefetches not started yet
+  std::deque<key> queue_;
+  std::map<boxm2_scene*, boxm2_scene_sptr> scenes_;
+
+  //: the visibility order, and the position of each block in it
+  boxm2_scene* order_scene_{nullptr};
+  std::vector<boxm2_block_id> order_;
+  std::map<boxm2_block_id, std::size_t> order_pos_;
+  std::vector<std::string> order_types_;
+  //: positions in order_ of the blocks to prefetch
+  std::size_t window_begin_{0};
+  std::size_t window_end_{0};
+  //: block requested last
+  key current_;
+
+  std::size_t max_bytes_;
+  unsigned lookahead_;
+  std::size_t bytes_{0};
+  unsigned long n_requests_{0};
+  unsigned prefetch_hits_{0};
+  unsigned misses_{0};
+
+  mutable std::mutex mutex_;
+  //: signals queued prefetches to the I/O threads
+  std::condition_variable work_cv_;
+  //: signals finished loads
+  std::condition_variable done_cv_;
+  bool stop_{false};
+  std::vector<std::thread> io_threads_;
+
+  // ---------Helper Methods --------------------------------------------------
+
+  //: body of the I/O threads
+  void io_loop();
+
+  //: the item for k, read from disk by the caller if no I/O thread has started it (mutex_ locked)
+  item& fetch(const key& k, std::unique_lock<std::mutex>& lock);
+
+  //: read the item for k, in state LOADING, from disk; mutex_ is released meanwhile
+  void load(const key& k, item& it, std::unique_lock<std::mutex>& lock);
+
+  //: wait until the item for k is no longer being loaded, and cancel it if queued (mutex_ locked)
+  //  Returns the item, or null if there is none.
+  item* settle(const key& k, std::unique_lock<std::mutex>& lock);
+
+  //: move the cursor to block id of scene and queue the prefetches that follow (mutex_ locked)
+  void advance(boxm2_scene* scene, const boxm2_block_id& id);
+
+  //: queue the prefetches of the look-ahead window (mutex_ locked)
+  void queue_window();
+
+  //: true if the item for k may not be evicted now (mutex_ locked)
+  bool is_protected(const key& k) const;
+
+  //: evict least recently used items until the budget is met (mutex_ locked)
+  void evict();
+
+  //: save the item if it would be lost, then delete it (mutex_ locked)
+  void release(const key& k, item& it, bool write_out);
+
+  //: save all items of scene, or of all scenes if null (mutex_ locked)
+  void save_items(boxm2_scene* scene);
+
+  //: wait for the loads in progress and drop the queued ones (mutex_ locked)
+  void drain(std::unique_lock<std::mutex>& lock);
+};
+
+//: shows elements in cache
+std::ostream& operator<<(std::ostream &s, boxm2_prefetch_cache& cache);
+
+#endif // boxm2_prefetch_cache_h_
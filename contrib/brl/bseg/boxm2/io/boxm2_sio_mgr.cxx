@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include "boxm2_sio_mgr.h"
+#include "boxm2_mmap_mgr.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -17,6 +18,8 @@ boxm2_block* boxm2_sio_mgr::load_block(const std::string& dir, const boxm2_block
   unsigned long numBytes = 0;
   char* bytes=nullptr;
 
+  if (fs_type == LOCAL_MMAP)
+    return boxm2_mmap_mgr::load_block(dir, block_id, BOXM2_MAP_COPY_ON_WRITE);
   if (fs_type == LOCAL) {
     //get file size
     numBytes = vul_file::size(filepath);
@@ -58,6 +61,8 @@ boxm2_block* boxm2_sio_mgr::load_block(const std::string& dir, const boxm2_block
   unsigned long numBytes = 0;
   char* bytes=nullptr;
 
+  if (fs_type == LOCAL_MMAP)
+    return boxm2_mmap_mgr::load_block(dir, block_id, data, BOXM2_MAP_COPY_ON_WRITE);
   if (fs_type == LOCAL) {
     //get file size
     numBytes = vul_file::size(filepath);
@@ -97,8 +102,15 @@ void boxm2_sio_mgr::save_block(const std::string& dir, boxm2_block* block)
 {
   std::string filepath = dir + block->block_id().to_string() + ".bin";
   //std::cout<<"boxm2_sio_mgr::write save to file: "<<filepath<<std::endl;
+  auto* mapped = dynamic_cast<boxm2_mapped_block*>(block);
+  if (mapped && mapped->file().filepath() == filepath) {
+    if (!mapped->read_only()) // else never made writable, so the file is up to date
+      mapped->flush();
+    return;
+  }
   char * bytes = block->buffer();
-  block->b_write(bytes);
+  if (!mapped || mapped->file().mode() != BOXM2_MAP_READ) // else unchanged and not writable
+    block->b_write(bytes);
 
   // synchronously write to disk
   std::ofstream myFile (filepath.c_str(), std::ios::out | std::ios::binary);
@@ -113,6 +125,8 @@ boxm2_data_base* boxm2_sio_mgr::load_block_data_generic(const std::string& dir,
   std::string filename = dir + data_type + "_" + id.to_string() + ".bin";
   unsigned long numBytes = 0;
   char* bytes=nullptr;
+  if (fs_type == LOCAL_MMAP)
+    return boxm2_mmap_mgr::load_block_data_generic(dir, id, data_type, BOXM2_MAP_COPY_ON_WRITE);
   if (fs_type == LOCAL) {
     //get file size
     numBytes=vul_file::size(filename);
@@ -151,6 +165,12 @@ boxm2_data_base* boxm2_sio_mgr::load_block_data_generic(const std::string& dir,
 void boxm2_sio_mgr::save_block_data_base(const std::string& dir, const boxm2_block_id& block_id, boxm2_data_base* data, const std::string& prefix)
 {
   std::string filename = dir + prefix + "_" + block_id.to_string() + ".bin";
+  auto* mapped = dynamic_cast<boxm2_mapped_data_base*>(data);
+  if (mapped && mapped->file().filepath() == filename) {
+    if (!mapped->read_only_) // else never made writable, so the file is up to date
+      mapped->flush();
+    return;
+  }
 
   char * bytes = data->data_buffer();
   std::ofstream myFile (filename.c_str(), std::ios::out | std::ios::binary);
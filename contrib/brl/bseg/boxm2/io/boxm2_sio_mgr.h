@@ -15,7 +15,8 @@
 #endif
 
 //: enabling to allow different filesystems to load blocks
-typedef enum {LOCAL=0, HDFS} BOXM2_IO_FS_TYPE;
+//  LOCAL_MMAP maps the local files copy on write with boxm2_mmap_mgr instead of reading them
+typedef enum {LOCAL=0, HDFS, LOCAL_MMAP} BOXM2_IO_FS_TYPE;
 
 //: disk level storage class.
 //  handles all of the synchronous IO read and write requests
@@ -30,6 +31,7 @@ class boxm2_sio_mgr
                                    const boxm2_block_metadata& data, BOXM2_IO_FS_TYPE fs_type=LOCAL);
 
     //: saves block to disk
+    //  A block mapped from this file by boxm2_mmap_mgr is flushed instead.
     static void save_block(const std::string& dir, boxm2_block* block);
 
     //: load data from disk
@@ -47,6 +49,7 @@ class boxm2_sio_mgr
 
     //: saves data generically
     // generically saves data_base * to disk (given prefix)
+    // Data mapped from this file by boxm2_mmap_mgr is flushed instead.
     static void save_block_data_base(const std::string& dir, const boxm2_block_id& block_id, boxm2_data_base* data, const std::string& prefix);
 
   private:
@@ -1,8 +1,11 @@
 #include <boxm2/io/boxm2_asio_mgr.h>
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/io/boxm2_concurrent_cache.h>
 #include <boxm2/io/boxm2_dumb_cache.h>
 #include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_mmap_mgr.h>
 #include <boxm2/io/boxm2_nn_cache.h>
+#include <boxm2/io/boxm2_prefetch_cache.h>
 #include <boxm2/io/boxm2_sio_mgr.h>
 #include <boxm2/io/boxm2_stream_block_cache.h>
 #include <boxm2/io/boxm2_stream_cache.h>
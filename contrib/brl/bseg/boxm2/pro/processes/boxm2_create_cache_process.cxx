@@ -82,7 +82,9 @@ bool boxm2_create_cache1_process(bprb_func_process& pro)
 }
 
 #include <boxm2/io/boxm2_cache.h>
+#include <boxm2/io/boxm2_concurrent_cache.h>
 #include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_prefetch_cache.h>
 
 namespace boxm2_create_cache_process_globals
 {
@@ -129,6 +131,24 @@ bool boxm2_create_cache_process(bprb_func_process& pro)
           boxm2_lru_cache::create(scene,LOCAL);
 
   }
+  else if (cache_type=="prefetch")
+  {
+      // loads the blocks ahead of the visibility order set by the cpp processes
+      std::cout<<"Create Prefetch Cache"<<std::endl;
+      boxm2_prefetch_cache::create(scene, islocal ? LOCAL : HDFS);
+  }
+  else if (cache_type=="concurrent")
+  {
+      // may be shared by several threads running cpp processes on the scene
+      std::cout<<"Create Concurrent Cache"<<std::endl;
+      boxm2_concurrent_cache::create(scene, islocal ? LOCAL : HDFS);
+  }
+  else if (cache_type=="mmap")
+  {
+      // maps the block and data files, so that processes rendering the scene share their pages
+      std::cout<<"Create Cache of mapped files"<<std::endl;
+      boxm2_lru_cache::create(scene, islocal ? LOCAL_MMAP : HDFS);
+  }
   else if (cache_type=="nn")
   {
      // boxm2_nn_cache::create(scene);
@@ -0,0 +1,149 @@
+//:
+// \file
+// \brief Test the concurrent cache, shared by several threads
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/io/boxm2_concurrent_cache.h>
+#include <boxm2/io/boxm2_sio_mgr.h>
+#include "testlib/testlib_test.h"
+#include "test_utils.h"
+#include "vul/vul_file.h"
+#include "vpl/vpl.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+static void test_concurrent_cache()
+{
+  const std::string dir = "concurrent_cache_test_scene";
+
+  // eight blocks in a row, each with alpha = its index + 1
+  const int n_blocks = 8;
+  std::vector<boxm2_block_id> ids;
+  std::size_t block_bytes = 0;
+  boxm2_scene_sptr scene = boxm2_test_utils::save_test_row_scene(dir, n_blocks, 4, ids, block_bytes);
+  const std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // room for about half of the blocks with their alpha
+  const std::size_t budget = block_bytes * 4;
+  boxm2_concurrent_cache::create(scene, LOCAL, budget, 2);
+  auto* cache = dynamic_cast<boxm2_concurrent_cache*>(boxm2_cache::instance().ptr());
+  TEST("concurrent cache created", cache != nullptr, true);
+  if (!cache)
+    return;
+
+  // threads pinning blocks and data at random, as cpp processes on several images would
+  std::atomic<unsigned> n_wrong(0);
+  std::vector<std::thread> threads;
+  for (unsigned t=0; t<8; ++t)
+    threads.emplace_back([&, t] {
+      unsigned r = 1234567u * (t + 1);
+      for (int n=0; n<200; ++n) {
+        r = r * 1103515245u + 12345u;
+        const int i = int((r >> 16) % n_blocks);
+        boxm2_block* blk = cache->pin_block(scene, ids[i]);
+        boxm2_data_base* data = cache->pin_data_base(scene, ids[i], alpha);
+        const auto* a = reinterpret_cast<const float*>(data->data_buffer());
+        float sum = 0.0f;
+        for (unsigned c=0; c<blk->num_cells(); ++c)
+          sum += a[c];
+        if (!(blk->block_id() == ids[i]) || data->buffer_length() != blk->num_cells()*sizeof(float) ||
+            sum != float(i+1)*float(blk->num_cells()))
+          ++n_wrong;
+        std::this_thread::yield();
+        cache->unpin_data_base(scene, ids[i], alpha);
+        cache->unpin_block(scene, ids[i]);
+      }
+    });
+  for (auto & t : threads)
+    t.join();
+  TEST("threads see their blocks and data", n_wrong, 0u);
+  TEST("blocks and data were evicted", cache->n_evictions() > 0, true);
+  TEST("memory budget", cache->bytes_in_memory() <= budget, true);
+  std::cout << cache->n_hits() << " hits, " << cache->n_misses() << " misses, "
+            << cache->n_evictions() << " evictions" << std::endl;
+
+  // threads requesting a block which is not in memory read it once
+  cache->clear_cache();
+  const unsigned long misses = cache->n_misses();
+  std::vector<boxm2_block*> got(8, nullptr);
+  threads.clear();
+  for (unsigned t=0; t<8; ++t)
+    threads.emplace_back([&, t] { got[t] = cache->pin_block(scene, ids[5]); });
+  for (auto & t : threads)
+    t.join();
+  bool same = true;
+  for (auto* blk : got)
+    same = same && blk && blk == got[0];
+  TEST("concurrent requests share one read", same && cache->n_misses() == misses + 1, true);
+  for (unsigned t=0; t<8; ++t)
+    cache->unpin_block(scene, ids[5]);
+
+  // a pinned block and data are not evicted by the requests of the other threads
+  boxm2_block* blk0 = cache->pin_block(scene, ids[0]);
+  boxm2_data_base* data0 = cache->pin_data_base(scene, ids[0], alpha, 0, false);
+  reinterpret_cast<float*>(data0->data_buffer())[0] = 42.0f;
+  std::thread other([&] {
+    for (int i=1; i<n_blocks; ++i)
+      cache->get_data_base(scene, ids[i], alpha);
+  });
+  other.join();
+  const unsigned long misses0 = cache->n_misses();
+  TEST("pinned block and data kept", cache->get_block(scene, ids[0]) == blk0 &&
+       cache->get_data_base(scene, ids[0], alpha) == data0 && cache->n_misses() == misses0, true);
+  cache->unpin_data_base(scene, ids[0], alpha);
+  cache->unpin_block(scene, ids[0]);
+
+  // once unpinned, it is evicted, and saved as it was opened for writing
+  for (int i=1; i<n_blocks; ++i)
+    cache->get_data_base(scene, ids[i], alpha);
+  boxm2_data_base* on_disk = boxm2_sio_mgr::load_block_data_generic(scene->data_path(), ids[0], alpha);
+  TEST("evicted writable data is saved", on_disk && reinterpret_cast<float*>(on_disk->data_buffer())[0] == 42.0f, true);
+  delete on_disk;
+  std::cout << *cache << std::endl;
+
+  // data the size of the budget, requested without pins, stays valid while it
+  // is of the block this thread requested last, whatever the other threads request
+  cache->clear_cache();
+  const std::string gamma = boxm2_data_traits<BOXM2_GAMMA>::prefix();
+  boxm2_data_base* big_alpha = cache->get_data_base_new(scene, ids[1], alpha, budget, false);
+  big_alpha->data_buffer()[0] = 7;
+  boxm2_data_base* big_gamma = cache->get_data_base_new(scene, ids[1], gamma, budget, false);
+  big_gamma->data_buffer()[0] = 9;
+  std::thread requests([&] {
+    for (int i=2; i<n_blocks; ++i)
+      cache->get_data_base(scene, ids[i], alpha);
+  });
+  requests.join();
+  TEST("data of the last requested block kept", cache->get_data_base(scene, ids[1], alpha) == big_alpha &&
+       big_alpha->data_buffer()[0] == 7 && big_gamma->data_buffer()[0] == 9, true);
+  const unsigned long evictions = cache->n_evictions();
+  cache->get_data_base(scene, ids[2], alpha);
+  TEST("evicted once another block is requested", cache->n_evictions() > evictions &&
+       cache->bytes_in_memory() <= budget, true);
+
+  // the block a thread requested last is no longer kept once the thread has ended
+  cache->clear_cache();
+  std::thread ended([&] {
+    cache->get_data_base_new(scene, ids[3], alpha, budget, false);
+  });
+  ended.join();
+  const unsigned long evictions_before = cache->n_evictions();
+  cache->get_data_base(scene, ids[4], alpha);
+  TEST("data of an ended thread evicted", cache->n_evictions() > evictions_before &&
+       cache->bytes_in_memory() <= budget, true);
+
+  cache->clear_cache();
+  TEST("cleared", cache->bytes_in_memory(), 0u);
+  vul_file::delete_file_glob(dir + "/*");
+  vpl_rmdir(dir.c_str());
+}
+
+TESTMAIN(test_concurrent_cache);
@@ -3,6 +3,9 @@
 DECLARE( test_scene );
 DECLARE( test_cache );
 DECLARE( test_cache2 );
+DECLARE( test_prefetch_cache );
+DECLARE( test_mmap_mgr );
+DECLARE( test_concurrent_cache );
 DECLARE( test_io );
 DECLARE( test_wrappers );
 DECLARE( test_data );
@@ -16,6 +19,9 @@ void register_tests()
   REGISTER( test_scene );
   REGISTER( test_cache );
   REGISTER( test_cache2 );
+  REGISTER( test_prefetch_cache );
+  REGISTER( test_mmap_mgr );
+  REGISTER( test_concurrent_cache );
   REGISTER( test_io );
   REGISTER( test_wrappers );
   REGISTER( test_data );
@@ -0,0 +1,118 @@
+//:
+// \file
+// \brief Test loading blocks and data by mapping their files
+#include <iostream>
+#include <string>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/io/boxm2_lru_cache.h>
+#include <boxm2/io/boxm2_mmap_mgr.h>
+#include <boxm2/io/boxm2_sio_mgr.h>
+#include "testlib/testlib_test.h"
+#include "vul/vul_file.h"
+#include "vpl/vpl.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: the first float of the alpha file of id, as read from disk
+static float alpha_on_disk(const std::string& dir, const boxm2_block_id& id)
+{
+  boxm2_data_base* data = boxm2_sio_mgr::load_block_data_generic(dir, id, boxm2_data_traits<BOXM2_ALPHA>::prefix());
+  float a = data ? reinterpret_cast<float*>(data->data_buffer())[0] : -1.0f;
+  delete data;
+  return a;
+}
+
+static void test_mmap_mgr()
+{
+  const std::string dir = "mmap_mgr_test_scene/";
+  vul_file::make_directory(dir);
+
+  boxm2_block_id id(0,0,0);
+  boxm2_block_metadata mdata(id, vgl_point_3d<double>(0,0,0), vgl_vector_3d<double>(1,1,1),
+                             vgl_vector_3d<unsigned>(2,2,2), 1, 4, 100, 0.001, 2);
+  const std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+  std::size_t n_cells = 0;
+  {
+    boxm2_block blk(mdata);
+    n_cells = blk.num_cells();
+    boxm2_sio_mgr::save_block(dir, &blk);
+    boxm2_data_base data(mdata, alpha);
+    auto* a = reinterpret_cast<float*>(data.data_buffer());
+    for (std::size_t c=0; c<n_cells; ++c)
+      a[c] = float(c);
+    boxm2_sio_mgr::save_block_data_base(dir, id, &data, alpha);
+  }
+
+  // read only, for rendering
+  boxm2_block* blk = boxm2_mmap_mgr::load_block(dir, id, mdata);
+  boxm2_data_base* data = boxm2_mmap_mgr::load_block_data_generic(dir, id, alpha);
+  TEST("block is mapped", dynamic_cast<boxm2_mapped_block*>(blk) != nullptr, true);
+  TEST("data is mapped", dynamic_cast<boxm2_mapped_data_base*>(data) != nullptr, true);
+  TEST("mapped block", blk && blk->num_cells() == n_cells && blk->sub_block_num() == mdata.sub_block_num_, true);
+  TEST("mapped data", data && data->buffer_length() == n_cells*sizeof(float) &&
+       reinterpret_cast<float*>(data->data_buffer())[n_cells-1] == float(n_cells-1), true);
+  TEST("mapped data is read only", data && data->read_only_, true);
+  TEST("missing file", boxm2_mmap_mgr::load_block_data_generic(dir, id, "nonexistent") == nullptr, true);
+
+  // copy on write: changes are private until saved
+  boxm2_data_base* cow = boxm2_mmap_mgr::load_block_data_generic(dir, id, alpha, BOXM2_MAP_COPY_ON_WRITE);
+  reinterpret_cast<float*>(cow->data_buffer())[0] = 42.0f;
+  TEST("copy on write, not saved", alpha_on_disk(dir, id), 0.0f);
+  TEST("copy on write, other mapping unchanged", reinterpret_cast<float*>(data->data_buffer())[0], 0.0f);
+  boxm2_sio_mgr::save_block_data_base(dir, id, cow, alpha);
+  TEST("copy on write, read only, not saved", alpha_on_disk(dir, id), 0.0f);
+  cow->enable_write();
+  boxm2_sio_mgr::save_block_data_base(dir, id, cow, alpha);
+  TEST("copy on write, saved", alpha_on_disk(dir, id), 42.0f);
+  TEST("copy on write, saved, other mapping keeps the version it mapped",
+       reinterpret_cast<float*>(data->data_buffer())[0], 0.0f);
+  delete cow;
+  delete data;
+
+  // shared: changes go to the file, and are seen by every mapping
+  data = boxm2_mmap_mgr::load_block_data_generic(dir, id, alpha);
+  boxm2_data_base* shared = boxm2_mmap_mgr::load_block_data_generic(dir, id, alpha, BOXM2_MAP_SHARED);
+  reinterpret_cast<float*>(shared->data_buffer())[0] = 7.0f;
+  TEST("shared, other mapping", reinterpret_cast<float*>(data->data_buffer())[0], 7.0f);
+  TEST("shared, flushed", dynamic_cast<boxm2_mapped_data_base*>(shared)->flush() && alpha_on_disk(dir, id) == 7.0f, true);
+  delete shared;
+  delete data;
+
+  // the block is written back through its mapping too
+  boxm2_block* shared_blk = boxm2_mmap_mgr::load_block(dir, id, mdata, BOXM2_MAP_SHARED);
+  const long last = shared_blk->byte_count() - 1; // unused last byte of the last tree
+  shared_blk->buffer()[last] = 5;
+  shared_blk->enable_write();
+  boxm2_sio_mgr::save_block(dir, shared_blk);
+  delete shared_blk;
+  boxm2_block* reread = boxm2_sio_mgr::load_block(dir, id, mdata);
+  TEST("shared block saved", reread && reread->buffer()[last] == 5 && reread->num_cells() == n_cells, true);
+  delete reread;
+  delete blk;
+
+  // a cache of mapped files
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin(vgl_point_3d<double>(0,0,0));
+  scene->set_data_path(dir);
+  std::map<boxm2_block_id, boxm2_block_metadata> blocks;
+  blocks[id] = mdata;
+  scene->set_blocks(blocks);
+  boxm2_lru_cache::create(scene, LOCAL_MMAP);
+  boxm2_cache_sptr cache = boxm2_cache::instance();
+  TEST("cached block is mapped", dynamic_cast<boxm2_mapped_block*>(cache->get_block(scene, id)) != nullptr, true);
+  boxm2_data_base* cached = cache->get_data_base(scene, id, alpha, 0, false);
+  TEST("cached data is mapped", dynamic_cast<boxm2_mapped_data_base*>(cached) != nullptr, true);
+  reinterpret_cast<float*>(cached->data_buffer())[0] = 3.0f;
+  cache->write_to_disk();
+  TEST("cached data written", alpha_on_disk(dir, id), 3.0f);
+  cache->clear_cache();
+
+  vul_file::delete_file_glob(dir + "*");
+  vpl_rmdir(dir.c_str());
+}
+
+TESTMAIN(test_mmap_mgr);
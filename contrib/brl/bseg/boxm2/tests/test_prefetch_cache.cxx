@@ -0,0 +1,76 @@
+//:
+// \file
+// \brief Test the prefetching cache on a small scene written to disk
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_block.h>
+#include <boxm2/boxm2_data_base.h>
+#include <boxm2/basic/boxm2_block_id.h>
+#include <boxm2/io/boxm2_prefetch_cache.h>
+#include "testlib/testlib_test.h"
+#include "test_utils.h"
+#include "vul/vul_file.h"
+#include "vpl/vpl.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+static void test_prefetch_cache()
+{
+  const std::string dir = "prefetch_cache_test_scene";
+
+  // four blocks in a row, each with alpha = its index + 1
+  std::vector<boxm2_block_id> order;
+  std::size_t block_bytes = 0;
+  boxm2_scene_sptr scene = boxm2_test_utils::save_test_row_scene(dir, 4, 2, order, block_bytes);
+  const std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+
+  // room for two and a half blocks with their alpha, and one block of look-ahead
+  const std::size_t budget = block_bytes * 5 / 2;
+  boxm2_prefetch_cache::create(scene, LOCAL, budget, 1, 2);
+  auto* cache = dynamic_cast<boxm2_prefetch_cache*>(boxm2_cache::instance().ptr());
+  TEST("prefetch cache created", cache != nullptr, true);
+  if (!cache)
+    return;
+  cache->set_visibility_order(scene, order, std::vector<std::string>(1, alpha));
+
+  bool values_ok = true, budget_ok = true;
+  for (int i=0; i<4; ++i) {
+    // let the I/O threads finish, as if the previous block took long to render
+    cache->wait_for_prefetches();
+    boxm2_block* blk = cache->get_block(scene, order[i]);
+    // block 0 is opened for writing and changed
+    boxm2_data_base* data = cache->get_data_base(scene, order[i], alpha, 0, i != 0);
+    values_ok = values_ok && blk && data && blk->block_id() == order[i] &&
+                data->buffer_length() == blk->num_cells()*sizeof(float) &&
+                reinterpret_cast<float*>(data->data_buffer())[1] == float(i+1);
+    if (i == 0)
+      reinterpret_cast<float*>(data->data_buffer())[0] = 42.0f;
+    budget_ok = budget_ok && cache->bytes_in_memory() <= budget;
+  }
+  TEST("blocks and data in visibility order", values_ok, true);
+  TEST("memory budget", budget_ok, true);
+  TEST("all requests prefetched", cache->prefetch_hits(), 8u);
+  TEST("no misses", cache->misses(), 0u);
+  std::cout << *cache << std::endl;
+
+  // block 0 was evicted, and its changes saved
+  boxm2_data_base* data0 = cache->get_data_base(scene, order[0], alpha);
+  TEST("evicted writable data is saved", reinterpret_cast<float*>(data0->data_buffer())[0], 42.0f);
+  TEST("memory budget after revisiting", cache->bytes_in_memory() <= budget, true);
+
+  // data which is not on disk is initialized
+  const std::string nobs = boxm2_data_traits<BOXM2_NUM_OBS>::prefix();
+  boxm2_block* blk3 = cache->get_block(scene, order[3]);
+  boxm2_data_base* nobs3 = cache->get_data_base(scene, order[3], nobs);
+  TEST("missing data initialized", nobs3 && nobs3->buffer_length() == blk3->num_cells()*boxm2_data_info::datasize(nobs), true);
+
+  cache->clear_cache();
+  TEST("cleared", cache->bytes_in_memory(), 0u);
+  vul_file::delete_file_glob(dir + "/*");
+  vpl_rmdir(dir.c_str());
+}
+
+TESTMAIN(test_prefetch_cache);
@@ -4,6 +4,7 @@
 #include <boxm2/io/boxm2_sio_mgr.h>
 #include "vul/vul_file.h"
 #include <boxm2/boxm2_scene.h>
+#include <boxm2/boxm2_data_base.h>
 #include "testlib/testlib_test.h"
 #include "testlib/testlib_root_dir.h"
 const int boxm2_test_utils::nums_[] = {64,64,64,0};
@@ -290,6 +291,38 @@ bool boxm2_test_utils::create_test_simple_scene(boxm2_scene_sptr & scene)
   return true;
 }
 
+boxm2_scene_sptr boxm2_test_utils::save_test_row_scene(const std::string& dir, int n_blocks, unsigned n_sub,
+                                                       std::vector<boxm2_block_id>& ids, std::size_t& block_bytes)
+{
+  vul_file::make_directory(dir);
+  std::map<boxm2_block_id, boxm2_block_metadata> mdata;
+  ids.clear();
+  for (int i=0; i<n_blocks; ++i) {
+    boxm2_block_id id(i,0,0);
+    mdata[id] = boxm2_block_metadata(id, vgl_point_3d<double>(double(n_sub)*i,0,0), vgl_vector_3d<double>(1,1,1),
+                                     vgl_vector_3d<unsigned>(n_sub,n_sub,n_sub), 1, 4, 100, 0.001, 2);
+    ids.push_back(id);
+  }
+  boxm2_scene_sptr scene = new boxm2_scene();
+  scene->set_local_origin(vgl_point_3d<double>(0,0,0));
+  scene->set_data_path(dir);
+  scene->set_blocks(mdata);
+
+  const std::string alpha = boxm2_data_traits<BOXM2_ALPHA>::prefix();
+  block_bytes = 0;
+  for (int i=0; i<n_blocks; ++i) {
+    boxm2_block blk(mdata[ids[i]]);
+    boxm2_sio_mgr::save_block(scene->data_path(), &blk);
+    boxm2_data_base data(mdata[ids[i]], alpha);
+    auto* a = reinterpret_cast<float*>(data.data_buffer());
+    for (std::size_t c=0; c<data.buffer_length()/sizeof(float); ++c)
+      a[c] = float(i+1);
+    boxm2_sio_mgr::save_block_data_base(scene->data_path(), ids[i], &data, alpha);
+    block_bytes = std::size_t(blk.byte_count()) + data.buffer_length();
+  }
+  return scene;
+}
+
 vpgl_camera_double_sptr boxm2_test_utils::test_camera()
 {
   vnl_matrix_fixed<double, 3, 3> mk(0.0);
@@ -32,6 +32,10 @@ class boxm2_test_utils
     static   std::map<boxm2_block_id,boxm2_block_metadata> generate_simple_metadata();
     static std::string   save_test_empty_scene();
     static bool create_test_simple_scene(boxm2_scene_sptr & scene);
+    //: writes n_blocks blocks in a row, of n_sub x n_sub x n_sub trees, with alpha = block index + 1, to dir.
+    //  Returns their ids in order, and the bytes of a block with its alpha.
+    static boxm2_scene_sptr save_test_row_scene(const std::string& dir, int n_blocks, unsigned n_sub,
+                                                std::vector<boxm2_block_id>& ids, std::size_t& block_bytes);
     static void  test_block_equivalence(boxm2_block& a, boxm2_block& b);
 
     template <boxm2_data_type data_type>
@@ -22,6 +22,7 @@
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_double_2x3.h"
 #include <vnl/algo/vnl_fft_prime_factors.h>
+#include <vnl/algo/vnl_fft_2d.h>
 #include <vnl/algo/vnl_svd.h>
 
 #include "vil/vil_pixel_format.h"
@@ -2336,49 +2337,17 @@ bool brip_vil_float_ops::fft_1d(int dir, int m, double* x, double* y)
 //
 bool brip_vil_float_ops::fft_2d(vnl_matrix<std::complex<double> >& c,int nx,int ny,int dir)
 {
-  int i,j;
-  int mx, my;
-  double *real,*imag;
   vnl_fft_prime_factors<double> pfx (nx);
   vnl_fft_prime_factors<double> pfy (ny);
-  mx = (int)pfx.pqr()[0];
-  my = (int)pfy.pqr()[0];
-  // Transform the rows
-  real = new double[nx];
-  imag = new double[nx];
-  if (real == nullptr || imag == nullptr)
+  if (!pfx || !pfy || c.rows() != (unsigned)ny || c.cols() != (unsigned)nx)
     return false;
-  for (j=0;j<ny;j++) {
-    for (i=0;i<nx;i++) {
-      real[i] = c[j][i].real();
-      imag[i] = c[j][i].imag();
-    }
-    brip_vil_float_ops::fft_1d(dir,mx,real,imag);
-    for (i=0;i<nx;i++) {
-      std::complex<double> v(real[i], imag[i]);
-      c[j][i] = v;
-    }
-  }
-  delete [] real;
-  delete [] imag;
-  // Transform the columns
-  real = new double[ny];
-  imag = new double[ny];
-  if (real == nullptr || imag == nullptr)
-    return false;
-  for (i=0;i<nx;i++) {
-    for (j=0;j<ny;j++) {
-      real[j] = c[j][i].real();
-      imag[j] = c[j][i].imag();
-    }
-    fft_1d(dir,my,real,imag);
-    for (j=0;j<ny;j++) {
-      std::complex<double> v(real[j], imag[j]);
-      c[j][i] =  v;
-    }
-  }
-  delete [] real;
-  delete [] imag;
+  // The forward transform here has the kernel exp(-j ...), which is the
+  // backward transform of vnl_fft_2d, and is scaled by 1/(nx*ny).
+  vnl_fft_2d<double> fft(ny, nx);
+  fft.set_num_threads(0); // the threads of the default vnl_thread_pool
+  fft.transform(c, -dir);
+  if (dir == 1)
+    c /= std::complex<double>(double(nx) * ny);
   return true;
 }
 
@@ -2421,24 +2390,25 @@ fourier_transform(vil_image_view<float> const& input,
   vnl_fft_prime_factors<float> pfy (h);
   if (!pfx.pqr()[0]||!pfy.pqr()[0])
     return false;
-  // fill the fft matrix
-  vnl_matrix<std::complex<double> > fft_matrix(h, w), fourier_matrix(h,w);
+  vnl_matrix<double> signal(h, w);
   for (unsigned y = 0; y<h; y++)
     for (unsigned x =0; x<w; x++)
-    {
-      std::complex<double> cv(input(x,y), 0.0);
-      fft_matrix.put(y, x, cv);
-    }
-#ifdef DEBUG
+      signal(y, x) = input(x,y);
+
+  // The image is real, so only the left half of its transform is computed.
+  // The forward transform of fft_2d is the complex conjugate of that of
+  // vnl_fft_2d for a real signal, scaled by 1/(w*h); the right half follows
+  // from the symmetry F(r, c) = conj(F((h-r)%h, w-c)).
+  vnl_fft_2d<double> fft(h, w);
+  fft.set_num_threads(0); // the threads of the default vnl_thread_pool
+  vnl_matrix<std::complex<double> > half;
+  fft.fwd_transform_real(signal, half);
+  const double scale = 1.0/(double(w)*h);
+  vnl_matrix<std::complex<double> > fft_matrix(h, w), fourier_matrix(h,w);
   for (unsigned r = 0; r<h; r++)
-    for (unsigned c =0; c<w; c++)
-    {
-      std::complex<double> res = fft_matrix[r][c];
-      std::cout << res << '\n';
-    }
-#endif
+    for (unsigned c = 0; c<w; c++)
+      fft_matrix(r, c) = c <= w/2 ? scale*std::conj(half(r, c)) : scale*half((h-r)%h, w-c);
 
-  brip_vil_float_ops::fft_2d(fft_matrix, w, h, 1);
   brip_vil_float_ops::ftt_fourier_2d_reorder(fft_matrix, fourier_matrix);
   mag.set_size(w,h);
   phase.set_size(w,h);
@@ -11,19 +11,22 @@ size_t bsgm_align_pointsets_3d<T>::consensus(T tx, T ty, T tz, T c_tol)
   size_t n_skip = n/params_.min_n_pts_;
   if(n_skip == 0)
 	  n_skip = 1;
+  // translate the sampled points from ptset_0
+  std::vector<vgl_point_3d<T> > tps, cps;
+  tps.reserve(n/n_skip + 1);
   for(size_t i = 0; i<n; i+=n_skip){
     const vgl_point_3d<T>& p = ptset_0_.p(i);
-    // translate a point from ptset_0
-    vgl_point_3d<T> tp(p.x()+tx, p.y()+ty, p.z()+tz), cp;
-    // find the closest point from ptset_1
-    if(!knn_.closest_point(tp, cp)){
-      std::cout << "KNN index failed to find neighbors - fatal" << std::endl;
-      return -1;
-    }
-    // is the closest point within c_tol?
-    if(vgl_distance(tp, cp)<= c_tol)
-      ncon++;
+    tps.emplace_back(p.x()+tx, p.y()+ty, p.z()+tz);
   }
+  // find the closest points from ptset_1, all at once
+  if(!knn_.closest_points(tps, cps)){
+    std::cout << "KNN index failed to find neighbors - fatal" << std::endl;
+    return -1;
+  }
+  // is the closest point within c_tol?
+  for(size_t i = 0; i<tps.size(); ++i)
+    if(vgl_distance(tps[i], cps[i])<= c_tol)
+      ncon++;
   return ncon;
 }
 
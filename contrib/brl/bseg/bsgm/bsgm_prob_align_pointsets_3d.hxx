@@ -35,20 +35,25 @@ T bsgm_prob_align_pointsets_3d<T>::total_prob(T tx, T ty, T tz, T c_tol)
 {
   float total_prob = 0;
   size_t n = ptset_0_.size();
+  // translate the points from ptset_0
+  std::vector<vgl_point_3d<T> > tps;
+  tps.reserve(n);
   for(size_t i = 0; i<n; ++i){
     const vgl_point_3d<T>& p = ptset_0_.p(i);
-    // translate a point from ptset_0
-    vgl_point_3d<T> tp(p.x()+tx, p.y()+ty, p.z()+tz);
-    // find the closest point from ptset_1
-    unsigned int indx = 0;
-    if(!knn_.closest_index(tp, indx)){
-      std::cout << "KNN index failed to find neighbors - fatal" << std::endl;
-      return -1;
-    }
+    tps.emplace_back(p.x()+tx, p.y()+ty, p.z()+tz);
+  }
+  // find the closest points from ptset_1, all at once
+  std::vector<unsigned> indices;
+  if(!knn_.closest_indices(tps, indices)){
+    std::cout << "KNN index failed to find neighbors - fatal" << std::endl;
+    return -1;
+  }
+  for(size_t i = 0; i<n; ++i){
+    unsigned int indx = indices[i];
     const vgl_point_3d<T>& cp = ptset_1_.p(indx);
     T prob_nbr = ptset_1_.sc(indx);
     // is the closest point within c_tol?
-    if(vgl_distance(tp, cp)<= c_tol){
+    if(vgl_distance(tps[i], cp)<= c_tol){
       total_prob += prob_nbr;
     }
   }
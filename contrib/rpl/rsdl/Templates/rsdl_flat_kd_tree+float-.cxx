@@ -0,0 +1,3 @@
+#include <rsdl/rsdl_flat_kd_tree.hxx>
+
+INSTANTIATE_RSDL_FLAT_KD_TREE( float );
@@ -0,0 +1,124 @@
+#ifndef rsdl_flat_kd_tree_h_
+#define rsdl_flat_kd_tree_h_
+//:
+// \file
+// \brief Static k-d tree over contiguous coordinates, for batches of queries
+//
+// rsdl_flat_kd_tree is built once from n points of the same dimension,
+// stored as one contiguous array, and answers k-nearest-neighbour and
+// fixed-radius queries, one at a time or in batches spread over threads.
+//
+// Unlike rsdl_kd_tree, there are no node objects and no pointers.  Each
+// internal node splits its range of points in two halves at the median of
+// the coordinate of greatest spread, so the shape of the tree depends only
+// on the number of points: node k has children 2k+1 and 2k+2, all leaves
+// are at the same depth, and a node stores nothing but its splitting
+// dimension and value.  The points are copied in tree order, so that the
+// points of a leaf are contiguous in memory.  The tree is built level by
+// level, with the nodes of each level partitioned in parallel.
+//
+// Only cartesian (Euclidean) coordinates are handled; rsdl_kd_tree uses
+// this tree for its queries when its points have no angular part.
+
+#include <cstddef>
+#include <vector>
+#include <vnl/vnl_vector.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+template <class T>
+class rsdl_flat_kd_tree
+{
+ public:
+  //: The type of each coordinate
+  typedef T coord_type;
+
+  //: Build the tree from n points of dim coordinates, point i being at coords[i*dim].
+  //  The coordinates are copied.  The tree is built on at most n_threads
+  //  threads of the default vnl_thread_pool (0 = all of them).
+  rsdl_flat_kd_tree( const T* coords,
+                     std::size_t n,
+                     unsigned dim,
+                     unsigned points_per_leaf = 8,
+                     unsigned n_threads = 0 );
+
+  //: Build the tree from points of the same size.
+  rsdl_flat_kd_tree( const std::vector< vnl_vector< T > >& points,
+                     unsigned points_per_leaf = 8,
+                     unsigned n_threads = 0 );
+
+  //: Number of points
+  std::size_t size() const { return index_.size(); }
+
+  //: Number of coordinates of each point
+  unsigned dim() const { return dim_; }
+
+  //: Depth of the leaves (0 if the root is a leaf)
+  unsigned depth() const { return depth_; }
+
+  //: Find the k points nearest to query (dim() coordinates).
+  //  On return, indices and sq_dists hold the indices of min(k,size())
+  //  points and their squared distances, in increasing order of distance.
+  void n_nearest( const T* query,
+                  unsigned k,
+                  std::vector< int >& indices,
+                  std::vector< T >& sq_dists ) const;
+
+  //: Find the k nearest points of each of n_queries queries, stored contiguously.
+  //  With k' = min(k,size()), the results for query q are at
+  //  indices[q*k'] ... indices[q*k'+k'-1], and similarly for sq_dists.
+  //  The queries are spread over at most n_threads threads of the default
+  //  vnl_thread_pool (0 = all of them).
+  void n_nearest( const T* queries,
+                  std::size_t n_queries,
+                  unsigned k,
+                  std::vector< int >& indices,
+                  std::vector< T >& sq_dists,
+                  unsigned n_threads = 0 ) const;
+
+  //: Find all the points at a distance less than radius from query.
+  //  The points are returned in no particular order.
+  void points_in_radius( const T* query,
+                         T radius,
+                         std::vector< int >& indices,
+                         std::vector< T >& sq_dists ) const;
+
+  //: Find all the points at a distance less than radius from each of n_queries queries.
+  //  The queries are spread over at most n_threads threads of the default
+  //  vnl_thread_pool (0 = all of them).
+  void points_in_radius( const T* queries,
+                         std::size_t n_queries,
+                         T radius,
+                         std::vector< std::vector< int > >& indices,
+                         unsigned n_threads = 0 ) const;
+
+ private:
+  void build( const T* coords, unsigned points_per_leaf, unsigned n_threads );
+
+  //: Range [begin,end) of the points below the node at position pos in its level
+  void node_range( unsigned level, std::size_t pos,
+                   std::size_t& begin, std::size_t& end ) const;
+
+  struct knn_state;
+  void search_knn( std::size_t node, unsigned level,
+                   std::size_t begin, std::size_t end,
+                   T rd, knn_state& s ) const;
+  void search_radius( std::size_t node, unsigned level,
+                      std::size_t begin, std::size_t end,
+                      T rd, T sq_radius, const T* query, T* off,
+                      std::vector< int >& indices,
+                      std::vector< T >& sq_dists ) const;
+
+  unsigned dim_;
+  unsigned depth_;
+  //: Coordinates of the points, in tree order
+  std::vector< T > coords_;
+  //: Original index of each point, in tree order
+  std::vector< int > index_;
+  //: Splitting dimension and value of each internal node
+  std::vector< unsigned > split_dim_;
+  std::vector< T > split_value_;
+};
+
+#endif // rsdl_flat_kd_tree_h_
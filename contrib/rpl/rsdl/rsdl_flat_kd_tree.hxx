@@ -0,0 +1,354 @@
+#ifndef rsdl_flat_kd_tree_txx_
+#define rsdl_flat_kd_tree_txx_
+//:
+// \file
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "rsdl_flat_kd_tree.h"
+
+#include <cassert>
+#include <vnl/vnl_thread_pool.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Number of queries handled by one task of a batch
+static const std::size_t rsdl_flat_kd_tree_block = 64;
+
+//:
+// Working state of one k-nearest-neighbour query.  The candidates are
+// kept in a max-heap on squared distance, with the positions of the
+// points in tree order.  off[d] is the distance along dimension d from the
+// query to the cell being searched, as in Arya and Mount's incremental
+// distance calculation.
+//
+template <class T>
+struct rsdl_flat_kd_tree<T>::knn_state
+{
+  const T* query;
+  unsigned k;
+  T* off;
+  std::vector< std::pair< T, std::size_t > > heap;
+
+  T worst() const
+  {
+    return heap.size() < k ? std::numeric_limits<T>::max() : heap.front().first;
+  }
+};
+
+
+template <class T>
+rsdl_flat_kd_tree<T>::rsdl_flat_kd_tree( const T* coords,
+                                         std::size_t n,
+                                         unsigned dim,
+                                         unsigned points_per_leaf,
+                                         unsigned n_threads )
+  : dim_( dim ), depth_( 0 ), index_( n )
+{
+  build( coords, points_per_leaf, n_threads );
+}
+
+
+template <class T>
+rsdl_flat_kd_tree<T>::rsdl_flat_kd_tree( const std::vector< vnl_vector< T > >& points,
+                                         unsigned points_per_leaf,
+                                         unsigned n_threads )
+  : dim_( points.empty() ? 0 : points[0].size() ), depth_( 0 ), index_( points.size() )
+{
+  std::vector< T > coords( points.size() * dim_ );
+  for ( std::size_t i = 0; i < points.size(); ++i ) {
+    assert( points[i].size() == dim_ );
+    std::copy( points[i].begin(), points[i].end(), coords.begin() + i * dim_ );
+  }
+  build( coords.data(), points_per_leaf, n_threads );
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::node_range( unsigned level, std::size_t pos,
+                                  std::size_t& begin, std::size_t& end ) const
+{
+  // Walk down from the root, following the bits of pos from the top
+  begin = 0;
+  end = index_.size();
+  for ( unsigned l = level; l > 0; --l ) {
+    const std::size_t mid = begin + ( end - begin ) / 2;
+    if ( ( pos >> ( l - 1 ) ) & 1 )
+      begin = mid;
+    else
+      end = mid;
+  }
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::build( const T* coords, unsigned points_per_leaf, unsigned n_threads )
+{
+  const std::size_t n = index_.size();
+  for ( std::size_t i = 0; i < n; ++i )
+    index_[i] = int( i );
+
+  // The largest leaf at depth d holds ceil(n/2^d) points
+  if ( points_per_leaf < 1 )
+    points_per_leaf = 1;
+  depth_ = 0;
+  while ( ( ( n + ( std::size_t( 1 ) << depth_ ) - 1 ) >> depth_ ) > points_per_leaf )
+    ++depth_;
+
+  const std::size_t n_internal = ( std::size_t( 1 ) << depth_ ) - 1;
+  split_dim_.assign( n_internal, 0 );
+  split_value_.assign( n_internal, T( 0 ) );
+
+  // The nodes of one level cover disjoint ranges of index_, so they are
+  // partitioned in parallel, one level after the other.
+  const unsigned dim = dim_;
+  for ( unsigned level = 0; level < depth_; ++level ) {
+    const std::size_t first = ( std::size_t( 1 ) << level ) - 1;
+    vnl_thread_pool::default_pool().parallel_for( std::size_t( 1 ) << level, [&]( std::size_t pos ) {
+      std::size_t begin, end;
+      node_range( level, pos, begin, end );
+
+      // Split along the dimension of greatest spread
+      unsigned best_d = 0;
+      T best_spread = T( -1 );
+      for ( unsigned d = 0; d < dim; ++d ) {
+        T lo = coords[ std::size_t( index_[begin] ) * dim + d ];
+        T hi = lo;
+        for ( std::size_t i = begin + 1; i < end; ++i ) {
+          const T c = coords[ std::size_t( index_[i] ) * dim + d ];
+          if ( c < lo ) lo = c;
+          else if ( c > hi ) hi = c;
+        }
+        if ( hi - lo > best_spread ) {
+          best_spread = hi - lo;
+          best_d = d;
+        }
+      }
+
+      const std::size_t mid = begin + ( end - begin ) / 2;
+      std::nth_element( index_.begin() + begin, index_.begin() + mid, index_.begin() + end,
+                        [coords, dim, best_d]( int a, int b ) {
+                          return coords[ std::size_t( a ) * dim + best_d ] <
+                                 coords[ std::size_t( b ) * dim + best_d ];
+                        } );
+      split_dim_[first + pos] = best_d;
+      split_value_[first + pos] = coords[ std::size_t( index_[mid] ) * dim + best_d ];
+    }, n_threads );
+  }
+
+  // Copy the points in tree order, so that each leaf is contiguous
+  coords_.resize( n * dim );
+  const std::size_t n_blocks = ( n + 1023 ) / 1024;
+  vnl_thread_pool::default_pool().parallel_for( n_blocks, [&]( std::size_t b ) {
+    const std::size_t end = std::min( n, ( b + 1 ) * 1024 );
+    for ( std::size_t i = b * 1024; i < end; ++i )
+      std::copy( coords + std::size_t( index_[i] ) * dim,
+                 coords + std::size_t( index_[i] ) * dim + dim,
+                 coords_.begin() + i * dim );
+  }, n_threads );
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::search_knn( std::size_t node, unsigned level,
+                                  std::size_t begin, std::size_t end,
+                                  T rd, knn_state& s ) const
+{
+  if ( level == depth_ ) {
+    const T* p = coords_.data() + begin * dim_;
+    for ( std::size_t i = begin; i < end; ++i, p += dim_ ) {
+      T sq_dist = 0;
+      for ( unsigned d = 0; d < dim_; ++d ) {
+        const T diff = s.query[d] - p[d];
+        sq_dist += diff * diff;
+      }
+      if ( s.heap.size() < s.k ) {
+        s.heap.emplace_back( sq_dist, i );
+        std::push_heap( s.heap.begin(), s.heap.end() );
+      }
+      else if ( sq_dist < s.heap.front().first ) {
+        std::pop_heap( s.heap.begin(), s.heap.end() );
+        s.heap.back() = std::make_pair( sq_dist, i );
+        std::push_heap( s.heap.begin(), s.heap.end() );
+      }
+    }
+    return;
+  }
+
+  const unsigned d = split_dim_[node];
+  const T diff = s.query[d] - split_value_[node];
+  const std::size_t mid = begin + ( end - begin ) / 2;
+
+  // Nearer child first, then the other one if it can still hold a closer point
+  if ( diff <= 0 )
+    search_knn( 2 * node + 1, level + 1, begin, mid, rd, s );
+  else
+    search_knn( 2 * node + 2, level + 1, mid, end, rd, s );
+
+  const T old_off = s.off[d];
+  const T far_rd = rd - old_off * old_off + diff * diff;
+  if ( far_rd < s.worst() ) {
+    s.off[d] = diff;
+    if ( diff <= 0 )
+      search_knn( 2 * node + 2, level + 1, mid, end, far_rd, s );
+    else
+      search_knn( 2 * node + 1, level + 1, begin, mid, far_rd, s );
+    s.off[d] = old_off;
+  }
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::n_nearest( const T* query,
+                                 unsigned k,
+                                 std::vector< int >& indices,
+                                 std::vector< T >& sq_dists ) const
+{
+  std::vector< T > off( dim_, T( 0 ) );
+  knn_state s;
+  s.query = query;
+  s.k = unsigned( std::min< std::size_t >( k, size() ) );
+  s.off = off.data();
+  s.heap.reserve( s.k );
+  if ( s.k > 0 )
+    search_knn( 0, 0, 0, size(), T( 0 ), s );
+
+  std::sort_heap( s.heap.begin(), s.heap.end() );
+  indices.resize( s.heap.size() );
+  sq_dists.resize( s.heap.size() );
+  for ( std::size_t j = 0; j < s.heap.size(); ++j ) {
+    sq_dists[j] = s.heap[j].first;
+    indices[j] = index_[ s.heap[j].second ];
+  }
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::n_nearest( const T* queries,
+                                 std::size_t n_queries,
+                                 unsigned k,
+                                 std::vector< int >& indices,
+                                 std::vector< T >& sq_dists,
+                                 unsigned n_threads ) const
+{
+  const std::size_t kk = std::min< std::size_t >( k, size() );
+  indices.resize( n_queries * kk );
+  sq_dists.resize( n_queries * kk );
+  if ( kk == 0 )
+    return;
+
+  const std::size_t n_blocks = ( n_queries + rsdl_flat_kd_tree_block - 1 ) / rsdl_flat_kd_tree_block;
+  vnl_thread_pool::default_pool().parallel_for( n_blocks, [&]( std::size_t b ) {
+    std::vector< T > off( dim_, T( 0 ) );
+    knn_state s;
+    s.k = unsigned( kk );
+    s.off = off.data();
+    s.heap.reserve( kk );
+    const std::size_t end = std::min( n_queries, ( b + 1 ) * rsdl_flat_kd_tree_block );
+    for ( std::size_t q = b * rsdl_flat_kd_tree_block; q < end; ++q ) {
+      s.query = queries + q * dim_;
+      s.heap.clear();
+      search_knn( 0, 0, 0, size(), T( 0 ), s );
+      std::sort_heap( s.heap.begin(), s.heap.end() );
+      for ( std::size_t j = 0; j < kk; ++j ) {
+        sq_dists[q * kk + j] = s.heap[j].first;
+        indices[q * kk + j] = index_[ s.heap[j].second ];
+      }
+    }
+  }, n_threads );
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::search_radius( std::size_t node, unsigned level,
+                                     std::size_t begin, std::size_t end,
+                                     T rd, T sq_radius, const T* query, T* off,
+                                     std::vector< int >& indices,
+                                     std::vector< T >& sq_dists ) const
+{
+  if ( level == depth_ ) {
+    const T* p = coords_.data() + begin * dim_;
+    for ( std::size_t i = begin; i < end; ++i, p += dim_ ) {
+      T sq_dist = 0;
+      for ( unsigned d = 0; d < dim_; ++d ) {
+        const T diff = query[d] - p[d];
+        sq_dist += diff * diff;
+      }
+      if ( sq_dist < sq_radius ) {
+        indices.push_back( index_[i] );
+        sq_dists.push_back( sq_dist );
+      }
+    }
+    return;
+  }
+
+  const unsigned d = split_dim_[node];
+  const T diff = query[d] - split_value_[node];
+  const std::size_t mid = begin + ( end - begin ) / 2;
+
+  if ( diff <= 0 )
+    search_radius( 2 * node + 1, level + 1, begin, mid, rd, sq_radius, query, off, indices, sq_dists );
+  else
+    search_radius( 2 * node + 2, level + 1, mid, end, rd, sq_radius, query, off, indices, sq_dists );
+
+  const T old_off = off[d];
+  const T far_rd = rd - old_off * old_off + diff * diff;
+  if ( far_rd < sq_radius ) {
+    off[d] = diff;
+    if ( diff <= 0 )
+      search_radius( 2 * node + 2, level + 1, mid, end, far_rd, sq_radius, query, off, indices, sq_dists );
+    else
+      search_radius( 2 * node + 1, level + 1, begin, mid, far_rd, sq_radius, query, off, indices, sq_dists );
+    off[d] = old_off;
+  }
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::points_in_radius( const T* query,
+                                        T radius,
+                                        std::vector< int >& indices,
+                                        std::vector< T >& sq_dists ) const
+{
+  indices.clear();
+  sq_dists.clear();
+  if ( size() == 0 )
+    return;
+  std::vector< T > off( dim_, T( 0 ) );
+  search_radius( 0, 0, 0, size(), T( 0 ), radius * radius, query, off.data(), indices, sq_dists );
+}
+
+
+template <class T>
+void
+rsdl_flat_kd_tree<T>::points_in_radius( const T* queries,
+                                        std::size_t n_queries,
+                                        T radius,
+                                        std::vector< std::vector< int > >& indices,
+                                        unsigned n_threads ) const
+{
+  indices.resize( n_queries );
+  const std::size_t n_blocks = ( n_queries + rsdl_flat_kd_tree_block - 1 ) / rsdl_flat_kd_tree_block;
+  vnl_thread_pool::default_pool().parallel_for( n_blocks, [&]( std::size_t b ) {
+    std::vector< T > sq_dists;
+    const std::size_t end = std::min( n_queries, ( b + 1 ) * rsdl_flat_kd_tree_block );
+    for ( std::size_t q = b * rsdl_flat_kd_tree_block; q < end; ++q )
+      points_in_radius( queries + q * dim_, radius, indices[q], sq_dists );
+  }, n_threads );
+}
+
+#define INSTANTIATE_RSDL_FLAT_KD_TREE( T ) \
+  template class rsdl_flat_kd_tree< T >
+
+#endif // rsdl_flat_kd_tree_txx_
@@ -19,7 +19,8 @@
 rsdl_kd_tree::rsdl_kd_tree( std::vector< rsdl_point >  points,
                             double min_angle,
                             int points_per_leaf )
-  : points_(std::move(points)), min_angle_(min_angle)
+  : root_(nullptr), flat_tree_(nullptr), points_(std::move(points)),
+    min_angle_(min_angle), points_per_leaf_(points_per_leaf)
 {
   assert(points_per_leaf > 0);
 
@@ -33,6 +34,28 @@ rsdl_kd_tree::rsdl_kd_tree( std::vector< rsdl_point >  points,
     assert( Na_ == points_[i].num_angular() );
   }
 
+  leaf_count_ = internal_count_ = 0;
+
+  // 1.  Without angular values, the queries are mostly answered by a
+  //     flat tree, and the node tree is only built when needed.
+  if ( Na_ == 0 && Nc_ > 0 ) {
+    std::vector< double > coords( points_.size() * Nc_ );
+    for ( unsigned int i=0; i<points_.size(); ++i )
+      for ( unsigned int j=0; j<Nc_; ++j )
+        coords[ i*Nc_ + j ] = points_[i].cartesian(j);
+    flat_tree_ = new rsdl_flat_kd_tree< double >( coords.data(), points_.size(), Nc_, points_per_leaf );
+  }
+  else
+    this->root();
+}
+
+
+rsdl_kd_node*
+rsdl_kd_tree::root()
+{
+  if ( root_ )
+    return root_;
+
   // 1.  Build the initial bounding box.
 
   rsdl_point low(Nc_, Na_), high(Nc_, Na_);
@@ -48,8 +71,8 @@ rsdl_kd_tree::rsdl_kd_tree( std::vector< rsdl_point >  points,
   // 1b. initialize the angular upper and lower limits
   if ( Na_ > 0 ) {
     for ( unsigned int i=0; i<Na_; ++i ) {
-      low.angular(i) = min_angle;
-      high.angular(i) = min_angle + vnl_math::twopi;
+      low.angular(i) = min_angle_;
+      high.angular(i) = min_angle_ + vnl_math::twopi;
     }
   }
 
@@ -62,10 +85,9 @@ rsdl_kd_tree::rsdl_kd_tree( std::vector< rsdl_point >  points,
   std::vector< int > indices( points_.size() );
   for ( unsigned int i=0; i<indices.size(); ++i ) indices[ i ] = i;
 
-  leaf_count_ = internal_count_ = 0;
-
   // 3. call recursive function to do the real work
-  root_ = build_kd_tree( points_per_leaf, box, 0, indices );
+  root_ = build_kd_tree( points_per_leaf_, box, 0, indices );
+  return root_;
 }
 
 
@@ -253,6 +275,7 @@ rsdl_kd_tree::greatest_variation( const std::vector<int>& indices,
 rsdl_kd_tree::~rsdl_kd_tree( )
 {
   destroy_tree( root_ );
+  delete flat_tree_;
 }
 
 void
@@ -282,6 +305,16 @@ rsdl_kd_tree::n_nearest( const rsdl_point& query_point,
   //if we are using approx query, then we must use heap
   assert(max_leaves == -1 || (max_leaves > 0 && use_heap));
 
+  if ( flat_tree_ && max_leaves == -1 ) {
+    std::vector< double > sq_distances;
+    flat_tree_->n_nearest( query_point.cartesian_begin(), n, closest_indices, sq_distances );
+    closest_points.resize( closest_indices.size() );
+    for ( unsigned int i=0; i<closest_indices.size(); ++i )
+      closest_points[i] = points_[ closest_indices[i] ];
+    closest_indices.resize( n );
+    return;
+  }
+
   if ( closest_indices.size() != (unsigned int)n )
     closest_indices.resize( n );
   std::vector< double > sq_distances( n, 1e+10 );  // could cache for (slight) efficiency gain
@@ -290,9 +323,9 @@ rsdl_kd_tree::n_nearest( const rsdl_point& query_point,
   leaves_examined_ = internal_examined_ = 0;
 
   if ( use_heap )
-    this->n_nearest_with_heap( query_point, n, root_, closest_indices, sq_distances, num_found, max_leaves );
+    this->n_nearest_with_heap( query_point, n, this->root(), closest_indices, sq_distances, num_found, max_leaves );
   else
-    this->n_nearest_with_stack( query_point, n, root_, closest_indices, sq_distances, num_found );
+    this->n_nearest_with_stack( query_point, n, this->root(), closest_indices, sq_distances, num_found );
 #ifdef DEBUG
   std::cout << "\nAfter n_nearest, leaves_examined_ = " << leaves_examined_
            << ", fraction = " << float(leaves_examined_) / leaf_count_
@@ -309,6 +342,41 @@ rsdl_kd_tree::n_nearest( const rsdl_point& query_point,
 }
 
 
+void
+rsdl_kd_tree::n_nearest_batch( const std::vector< rsdl_point >& query_points,
+                               int n,
+                               std::vector< std::vector< int > >& indices,
+                               unsigned n_threads )
+{
+  assert(n>0);
+  indices.resize( query_points.size() );
+
+  if ( !flat_tree_ ) {
+    std::vector< rsdl_point > closest_points;
+    for ( unsigned int q=0; q<query_points.size(); ++q ) {
+      this->n_nearest( query_points[q], n, closest_points, indices[q] );
+      indices[q].resize( closest_points.size() );
+    }
+    return;
+  }
+
+  // Gather the queries in one array and search them all at once
+  std::vector< double > coords( query_points.size() * Nc_ );
+  for ( unsigned int q=0; q<query_points.size(); ++q ) {
+    assert( query_points[q].num_cartesian() == Nc_ && query_points[q].num_angular() == 0 );
+    std::copy( query_points[q].cartesian_begin(), query_points[q].cartesian_begin() + Nc_,
+               coords.begin() + q*Nc_ );
+  }
+  std::vector< int > all_indices;
+  std::vector< double > sq_distances;
+  flat_tree_->n_nearest( coords.data(), query_points.size(), n, all_indices, sq_distances, n_threads );
+
+  const unsigned int k = (unsigned int)std::min< std::size_t >( n, flat_tree_->size() );
+  for ( unsigned int q=0; q<query_points.size(); ++q )
+    indices[q].assign( all_indices.begin() + q*k, all_indices.begin() + (q+1)*k );
+}
+
+
 void
 rsdl_kd_tree::n_nearest_with_stack( const rsdl_point& query_point,
                                     int n,
@@ -648,7 +716,7 @@ rsdl_kd_tree :: points_in_bounding_box( const rsdl_bounding_box& box,
 {
   points_in_box.clear();
   indices_in_box.clear();
-  this -> points_in_bounding_box( root_, box, indices_in_box );
+  this -> points_in_bounding_box( this -> root(), box, indices_in_box );
   for (int i : indices_in_box)
     points_in_box.push_back( this -> points_[ i ] );
 }
@@ -660,6 +728,16 @@ rsdl_kd_tree :: points_in_radius( const rsdl_point& query_point,
                                   std::vector< rsdl_point >& points_within_radius,
                                   std::vector< int >& indices_within_radius )
 {
+  if ( this -> flat_tree_ ) {
+    std::vector< double > sq_distances;
+    this -> flat_tree_ -> points_in_radius( query_point.cartesian_begin(), radius,
+                                            indices_within_radius, sq_distances );
+    points_within_radius.clear();
+    for (int index : indices_within_radius)
+      points_within_radius.push_back( this -> points_[ index ] );
+    return;
+  }
+
   //  Form a bounding box of width 2*radius, centered at the point.
   //  Start by creating the corner points of this box.
   rsdl_point min_point( query_point.num_cartesian(), query_point.num_angular() );
@@ -699,7 +777,7 @@ rsdl_kd_tree :: points_in_radius( const rsdl_point& query_point,
   std::vector< int > indices_in_box;
 
   //  Gather the points in the bounding box:
-  this -> points_in_bounding_box( this -> root_, box, indices_in_box );
+  this -> points_in_bounding_box( this -> root(), box, indices_in_box );
 
   //  Clear out the result vectors in preparation
   points_within_radius.clear();
@@ -2,11 +2,16 @@
 #define rsdl_kd_tree_h_
 //:
 // \file
+//
+// When the points have no angular part, the exact nearest neighbour and
+// radius queries are answered by an rsdl_flat_kd_tree built from the same
+// points, and the node tree below is only built for the other queries.
 
 #include <iostream>
 #include <utility>
 #include <vector>
 #include <rsdl/rsdl_bounding_box.h>
+#include <rsdl/rsdl_flat_kd_tree.h>
 #include <rsdl/rsdl_point.h>
 #include <vbl/vbl_ref_count.h>
 #ifdef _MSC_VER
@@ -88,6 +93,16 @@ class rsdl_kd_tree : public vbl_ref_count
                   bool use_heap = false,
                   int max_leaves = -1 );
 
+  //: find the n points nearest to each of the query points.
+  // On return, indices[q] holds the indices of the points nearest to
+  // query_points[q], closest first.  When the points have no angular part
+  // the queries are spread over at most n_threads threads of the default
+  // vnl_thread_pool (0 = all of them).
+  void n_nearest_batch( const std::vector< rsdl_point >& query_points,
+                        int n,
+                        std::vector< std::vector< int > >& indices,
+                        unsigned n_threads = 0 );
+
   //: find all points within a query's bounding box
   void points_in_bounding_box( const rsdl_bounding_box& box,
                                std::vector< rsdl_point >& closest_points,
@@ -100,12 +115,17 @@ class rsdl_kd_tree : public vbl_ref_count
                          std::vector< int >& indices );
 
  private:
+  //: the node tree, built on first use if flat_tree_ is set
   rsdl_kd_node* root_;
 
+  //: the points, if they have no angular part
+  rsdl_flat_kd_tree< double >* flat_tree_;
+
   std::vector< rsdl_point > points_;
 
   unsigned int Nc_, Na_; // number of cartesian and angular dimensions
   double min_angle_;
+  int points_per_leaf_;
 
   int leaf_count_;
   int leaves_examined_;
@@ -115,6 +135,9 @@ class rsdl_kd_tree : public vbl_ref_count
  private:
   void destroy_tree( rsdl_kd_node*& p );
 
+  //: the root of the node tree, which is built if needed
+  rsdl_kd_node* root();
+
   rsdl_kd_node* build_kd_tree( int points_per_leaf,
                                const rsdl_bounding_box& outer_box,
                                int depth,
@@ -84,6 +84,9 @@ class rsdl_point
   //: Mutable access to the indexed cartesian coordinate.
   inline double& cartesian( unsigned int i ) { return data_[i]; }
 
+  //: Pointer to the cartesian coordinates, which are followed by the angular ones.
+  inline const double* cartesian_begin() const { return data_; }
+
   //: Constant access to the indexed angular coordinate.
   inline double angular( unsigned int i ) const { return data_[Nc_+i]; }
 
@@ -5,6 +5,7 @@ DECLARE( test_bins_2d );
 DECLARE( test_borgefors );
 DECLARE( test_bounding_box );
 DECLARE( test_dist );
+DECLARE( test_flat_kd_tree );
 DECLARE( test_kd_tree );
 DECLARE( test_point );
 DECLARE( test_bins );
@@ -16,6 +17,7 @@ register_tests()
   REGISTER( test_borgefors );
   REGISTER( test_bounding_box );
   REGISTER( test_dist );
+  REGISTER( test_flat_kd_tree );
   REGISTER( test_kd_tree );
   REGISTER( test_point );
   REGISTER( test_bins );
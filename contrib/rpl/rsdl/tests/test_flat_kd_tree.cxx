@@ -0,0 +1,154 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vnl/vnl_random.h"
+#include "testlib/testlib_test.h"
+
+#include <rsdl/rsdl_flat_kd_tree.h>
+#include <rsdl/rsdl_kd_tree.h>
+
+//  Squared distances from query to all points, sorted.
+static std::vector< std::pair<double,int> >
+brute_force( const std::vector<double>& coords, unsigned dim, const double* query )
+{
+  std::vector< std::pair<double,int> > dists;
+  for ( unsigned i=0; i*dim<coords.size(); ++i ) {
+    double sq_dist = 0;
+    for ( unsigned d=0; d<dim; ++d )
+      sq_dist += (query[d]-coords[i*dim+d]) * (query[d]-coords[i*dim+d]);
+    dists.emplace_back( sq_dist, int(i) );
+  }
+  std::sort( dists.begin(), dists.end() );
+  return dists;
+}
+
+static void test_flat_kd_tree()
+{
+  const unsigned dim = 3;
+  const unsigned num_points = 1000;
+  const unsigned num_queries = 200;
+  vnl_random mz_rand(1234);
+
+  std::vector<double> coords( num_points*dim );
+  for ( double & c : coords )
+    c = mz_rand.drand32( -10, 10 );
+  // a few duplicated points
+  for ( unsigned d=0; d<dim; ++d )
+    coords[10*dim+d] = coords[11*dim+d] = coords[12*dim+d];
+
+  std::vector<double> queries( num_queries*dim );
+  for ( double & c : queries )
+    c = mz_rand.drand32( -12, 12 );
+
+  rsdl_flat_kd_tree<double> tree( coords.data(), num_points, dim, 8, 2 );
+  TEST( "size", tree.size(), num_points );
+  TEST( "dim", tree.dim(), dim );
+  TEST( "depth", tree.depth(), 7u );   // ceil(1000/2^7) = 8
+
+  //  Single and batched k nearest neighbours, against brute force
+  const unsigned k = 7;
+  std::vector<int> indices, batch_indices;
+  std::vector<double> sq_dists, batch_sq_dists;
+  tree.n_nearest( queries.data(), num_queries, k, batch_indices, batch_sq_dists, 3 );
+  TEST( "batch n_nearest size", batch_indices.size() == num_queries*k && batch_sq_dists.size() == num_queries*k, true );
+
+  bool knn_ok = true, batch_ok = true;
+  for ( unsigned q=0; q<num_queries; ++q ) {
+    const double* query = queries.data() + q*dim;
+    std::vector< std::pair<double,int> > dists = brute_force( coords, dim, query );
+    tree.n_nearest( query, k, indices, sq_dists );
+    if ( indices.size() != k )
+      knn_ok = false;
+    for ( unsigned j=0; j<k && knn_ok; ++j ) {
+      if ( sq_dists[j] != dists[j].first )
+        knn_ok = false;
+      if ( batch_indices[q*k+j] != indices[j] || batch_sq_dists[q*k+j] != sq_dists[j] )
+        batch_ok = false;
+    }
+  }
+  TEST( "n_nearest matches brute force", knn_ok, true );
+  TEST( "batch n_nearest matches single queries", batch_ok, true );
+
+  //  Asking for more points than there are
+  tree.n_nearest( queries.data(), num_points+5, indices, sq_dists );
+  TEST( "n_nearest clamps k", indices.size(), num_points );
+  TEST( "n_nearest sorted", std::is_sorted( sq_dists.begin(), sq_dists.end() ), true );
+
+  //  Radius queries
+  const double radius = 2.5;
+  std::vector< std::vector<int> > batch_radius;
+  tree.points_in_radius( queries.data(), num_queries, radius, batch_radius, 2 );
+  bool radius_ok = batch_radius.size() == num_queries;
+  for ( unsigned q=0; q<num_queries && radius_ok; ++q ) {
+    const double* query = queries.data() + q*dim;
+    std::vector< std::pair<double,int> > dists = brute_force( coords, dim, query );
+    std::vector<int> expected;
+    for ( const std::pair<double,int> & d : dists )
+      if ( d.first < radius*radius )
+        expected.push_back( d.second );
+    tree.points_in_radius( query, radius, indices, sq_dists );
+    std::vector<int> found = indices;
+    std::sort( expected.begin(), expected.end() );
+    std::sort( found.begin(), found.end() );
+    std::vector<int> batch_found = batch_radius[q];
+    std::sort( batch_found.begin(), batch_found.end() );
+    radius_ok = found == expected && batch_found == expected;
+  }
+  TEST( "points_in_radius matches brute force", radius_ok, true );
+
+  //  Empty tree and a tree with a single leaf
+  rsdl_flat_kd_tree<float> empty( static_cast<const float*>(nullptr), 0, 2 );
+  std::vector<float> fsq_dists;
+  float fquery[2] = { 0, 0 };
+  empty.n_nearest( fquery, 3, indices, fsq_dists );
+  TEST( "empty tree n_nearest", indices.empty(), true );
+  empty.points_in_radius( fquery, 1.0f, indices, fsq_dists );
+  TEST( "empty tree points_in_radius", indices.empty(), true );
+
+  std::vector< vnl_vector<float> > few;
+  for ( unsigned i=0; i<3; ++i )
+    few.push_back( vnl_vector<float>( 2, float(i) ) );
+  rsdl_flat_kd_tree<float> small( few );
+  TEST( "single leaf depth", small.depth(), 0u );
+  small.n_nearest( fquery, 2, indices, fsq_dists );
+  TEST( "single leaf n_nearest", indices.size() == 2 && indices[0] == 0 && indices[1] == 1, true );
+
+  //  rsdl_kd_tree on cartesian points uses the flat tree; the node tree
+  //  is built for the bounding box queries, and both must agree.
+  std::vector< rsdl_point > points;
+  for ( unsigned i=0; i<num_points; ++i ) {
+    rsdl_point pt( dim );
+    for ( unsigned d=0; d<dim; ++d )
+      pt.cartesian(d) = coords[i*dim+d];
+    points.push_back( pt );
+  }
+  rsdl_kd_tree kd_tree( points );
+  std::vector< rsdl_point > query_points, closest_points;
+  for ( unsigned q=0; q<num_queries; ++q ) {
+    rsdl_point pt( dim );
+    for ( unsigned d=0; d<dim; ++d )
+      pt.cartesian(d) = queries[q*dim+d];
+    query_points.push_back( pt );
+  }
+  std::vector< std::vector<int> > kd_batch;
+  kd_tree.n_nearest_batch( query_points, k, kd_batch );
+  bool kd_ok = kd_batch.size() == num_queries;
+  for ( unsigned q=0; q<num_queries && kd_ok; ++q ) {
+    std::vector<int> stack_indices, heap_indices;
+    kd_tree.n_nearest( query_points[q], k, closest_points, stack_indices );
+    kd_tree.n_nearest( query_points[q], k, closest_points, heap_indices, true );
+    kd_ok = stack_indices == kd_batch[q] && heap_indices == kd_batch[q]
+         && closest_points.size() == k;
+  }
+  TEST( "rsdl_kd_tree n_nearest and n_nearest_batch agree", kd_ok, true );
+
+  std::vector<int> approx_indices;
+  kd_tree.n_nearest( query_points[0], k, closest_points, approx_indices, true, 4 );
+  TEST( "rsdl_kd_tree approximate n_nearest", closest_points.size(), k );
+}
+
+TESTMAIN(test_flat_kd_tree);
@@ -2,6 +2,7 @@
 #include <rsdl/rsdl_borgefors.h>
 #include <rsdl/rsdl_bounding_box.h>
 #include <rsdl/rsdl_dist.h>
+#include <rsdl/rsdl_flat_kd_tree.h>
 #include <rsdl/rsdl_fwd.h>
 #include <rsdl/rsdl_kd_tree.h>
 #include <rsdl/rsdl_point.h>
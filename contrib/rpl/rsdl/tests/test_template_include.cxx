@@ -1,5 +1,6 @@
 #include <rsdl/rsdl_bins_2d.hxx>
 #include <rsdl/rsdl_bins.hxx>
 #include <rsdl/rsdl_borgefors.hxx>
+#include <rsdl/rsdl_flat_kd_tree.hxx>
 
 int main() { return 0; }
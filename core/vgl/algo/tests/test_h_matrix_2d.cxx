@@ -263,6 +263,10 @@ test_compute_linear_points()
   std::cout << "The optimized transform\n" << h_opt << '\n';
   vnl_matrix_fixed<double, 3, 3> Mop = h_opt.get_matrix();
   TEST_NEAR("Optimized Scale Factor", Mop[0][0] / Mop[2][2], 2.0, 5e-03);
+  lmq.set_normal_equations(true);
+  lmq.optimize(points1, points2, h_opt);
+  Mop = h_opt.get_matrix();
+  TEST_NEAR("Optimized Scale Factor with the normal equations", Mop[0][0] / Mop[2][2], 2.0, 5e-03);
 }
 
 static void
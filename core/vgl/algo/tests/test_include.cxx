@@ -36,6 +36,7 @@
 #include <vgl/algo/vgl_rotation_3d.h>
 #include <vgl/algo/vgl_rtree.h>
 #include <vgl/algo/vgl_rtree_c.h>
+#include <vgl/algo/vgl_packed_rtree.h>
 
 int
 main()
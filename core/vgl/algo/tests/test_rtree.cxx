@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
@@ -7,6 +8,7 @@
 #include "vgl/vgl_polygon.h"
 #include <vgl/algo/vgl_rtree.h>
 #include <vgl/algo/vgl_rtree_c.h>
+#include <vgl/algo/vgl_packed_rtree.h>
 #include "vnl/vnl_random.h"
 #include "testlib/testlib_test.h"
 
@@ -181,11 +183,134 @@ test_box_box()
   TEST("number found by poly box probe", n, 3);
 }
 
+static void
+test_packed_point_box()
+{
+  using C_ = vgl_rtree_point_box_2d<float>;
+  using V_ = C_::v_type;
+  using B_ = C_::b_type;
+  std::cout << "\n<<<<<<<   test packed point_box tree >>>>>>>>>>>>>>\n";
+
+  vgl_packed_rtree<V_, B_, C_> empty_tr;
+  std::vector<V_> found;
+  empty_tr.get(B_(0.0f, 1.0f, 0.0f, 1.0f), found);
+  TEST("empty packed tree", empty_tr.empty() && found.empty() && !empty_tr.contains(V_(0.0f, 0.0f)), true);
+
+  vnl_random r(4711);
+  const unsigned ni = 5000;
+  std::vector<V_> pts;
+  for (unsigned i = 0; i < ni; ++i)
+    pts.emplace_back(static_cast<float>(r.drand32(0.0, 1.0)), static_cast<float>(r.drand32(0.0, 1.0)));
+  vgl_packed_rtree<V_, B_, C_> tr(pts);
+  std::cout << "Packed rtree num nodes = " << tr.nodes() << ", levels = " << tr.levels() << '\n';
+  TEST("packed tree size", tr.size(), ni);
+  // 625 leaves, 79 nodes above them, then 10, 2 and the root
+  TEST("packed tree nodes", tr.nodes(), 717);
+  TEST("packed tree levels", tr.levels(), 5);
+  TEST("packed tree contains", tr.contains(pts[1234]) && !tr.contains(V_(2.0f, 2.0f)), true);
+
+  // region queries, single and batched, against a linear search
+  std::vector<B_> regions;
+  for (unsigned q = 0; q < 100; ++q)
+  {
+    const auto x = static_cast<float>(r.drand32(0.0, 0.9));
+    const auto y = static_cast<float>(r.drand32(0.0, 0.9));
+    regions.emplace_back(x, x + 0.1f, y, y + 0.1f);
+  }
+  std::vector<std::vector<V_>> batch;
+  tr.get(regions, batch, 3);
+  bool single_ok = true, batch_ok = batch.size() == regions.size();
+  for (unsigned q = 0; q < regions.size(); ++q)
+  {
+    std::vector<V_> expected;
+    for (const V_ & p : pts)
+      if (C_::meet(regions[q], p))
+        expected.push_back(p);
+    found.clear();
+    tr.get(regions[q], found);
+    if (batch_ok)
+      batch_ok = batch[q] == found;
+    auto less = [](const V_ & a, const V_ & b) { return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y()); };
+    std::sort(expected.begin(), expected.end(), less);
+    std::sort(found.begin(), found.end(), less);
+    single_ok = single_ok && found == expected;
+  }
+  TEST("packed tree region queries", single_ok, true);
+  TEST("packed tree batched region queries", batch_ok, true);
+
+  // the same polygon probe as the dynamic tree
+  vgl_polygon<float> poly(1);
+  poly.push_back(vgl_point_2d<float>(0.3f, 0.7f));
+  poly.push_back(vgl_point_2d<float>(0.7f, 0.3f));
+  poly.push_back(vgl_point_2d<float>(0.5f, 0.9f));
+  poly.push_back(vgl_point_2d<float>(0.9f, 0.5f));
+  vgl_rtree_polygon_probe<V_, B_, C_> probe(poly);
+  vgl_rtree<V_, B_, C_> dyn_tr;
+  for (const V_ & p : pts)
+    dyn_tr.add(p);
+  std::vector<V_> dyn_found;
+  dyn_tr.get(probe, dyn_found);
+  found.clear();
+  tr.get(probe, found);
+  std::vector<const vgl_rtree_probe<V_, B_, C_> *> probes(4, &probe);
+  tr.get(probes, batch, 2);
+  TEST("packed tree probe", found.size() == dyn_found.size() && found.size() > 0, true);
+  TEST("packed tree batched probes", batch.size() == 4 && batch[3] == found, true);
+}
+
+static void
+test_packed_box_box()
+{
+  using C_ = vgl_rtree_box_box_2d<float>;
+  using V_ = C_::v_type;
+  using B_ = C_::b_type;
+  std::cout << "\n<<<<<<<   test packed box_box tree >>>>>>>>>>>>>>\n";
+
+  vnl_random r(1742);
+  std::vector<V_> boxes;
+  for (unsigned i = 0; i < 2000; ++i)
+  {
+    const auto x = static_cast<float>(r.drand32(0.0, 10.0));
+    const auto y = static_cast<float>(r.drand32(0.0, 10.0));
+    boxes.emplace_back(x, x + static_cast<float>(r.drand32(0.0, 0.5)), y, y + static_cast<float>(r.drand32(0.0, 0.5)));
+  }
+  vgl_packed_rtree<V_, B_, C_> tr(boxes, 16);
+  TEST("packed box tree size", tr.size(), 2000);
+  TEST("packed box tree bounds", tr.bounds().min_x() >= 0.0f && tr.bounds().max_x() <= 10.5f, true);
+
+  // point queries: the boxes containing each point
+  std::vector<B_> points;
+  for (unsigned q = 0; q < 200; ++q)
+  {
+    const vgl_point_2d<float> p(static_cast<float>(r.drand32(0.0, 10.0)), static_cast<float>(r.drand32(0.0, 10.0)));
+    points.emplace_back(p, p);
+  }
+  std::vector<std::vector<V_>> batch;
+  tr.get(points, batch, 0);
+  bool ok = batch.size() == points.size();
+  unsigned n_found = 0;
+  for (unsigned q = 0; q < points.size() && ok; ++q)
+  {
+    unsigned n_expected = 0;
+    for (const V_ & b : boxes)
+      if (b.contains(points[q].min_point()))
+        ++n_expected;
+    for (const V_ & b : batch[q])
+      ok = ok && b.contains(points[q].min_point());
+    ok = ok && batch[q].size() == n_expected;
+    n_found += n_expected;
+  }
+  std::cout << "Point queries found " << n_found << " boxes\n";
+  TEST("packed box tree point queries", ok, true);
+}
+
 static void
 test_rtree()
 {
   test_point_box();
   test_box_box();
+  test_packed_point_box();
+  test_packed_box_box();
 }
 
 TESTMAIN(test_rtree);
@@ -56,5 +56,7 @@ template <class V, class B, class C>
 class vgl_rtree_const_iterator;
 template <class V, class B, class C>
 class vgl_rtree;
+template <class V, class B, class C>
+class vgl_packed_rtree;
 
 #endif // vgl_algo_fwd_h_
@@ -12,6 +12,7 @@
 // \verbatim
 //  Modifications
 // \endverbatim
+#include <algorithm>
 #include <vector>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
@@ -34,8 +35,9 @@ class projection_lsqf : public vnl_least_squares_function
 public:
   projection_lsqf(const std::vector<vgl_homg_point_2d<double>> & from_points,
                   const std::vector<vgl_homg_point_2d<double>> & to_points)
-    : vnl_least_squares_function(9, 2 * from_points.size() + 1, no_gradient)
+    : vnl_least_squares_function(9, 2 * from_points.size() + 1, use_gradient)
   {
+    set_residual_rows(true);
     n_ = from_points.size();
     assert(n_ == to_points.size());
     for (unsigned i = 0; i < n_; ++i)
@@ -70,6 +72,55 @@ public:
     }
     proj_err[2 * n_] = 1.0 - hv.magnitude();
   }
+
+  //: compute the residuals of f, and their derivatives, for rows first to last-1.
+  // Rows 2i and 2i+1 are the x and y errors of point i, and the last
+  // row holds the deviation of |h| from one.
+  void
+  f_and_gradf_rows(const vnl_vector<double> & hv,
+                   unsigned first,
+                   unsigned last,
+                   vnl_vector<double> & proj_err,
+                   vnl_matrix<double> & jacobian) override
+  {
+    assert(hv.size() == 9);
+    const double * h = hv.data_block();
+    for (unsigned k = first; k < last; ++k)
+    {
+      double * J = jacobian[k];
+      if (k == 2 * n_)
+      {
+        const double mag = hv.magnitude();
+        proj_err[k] = 1.0 - mag;
+        for (unsigned j = 0; j < 9; ++j)
+          J[j] = -h[j] / mag;
+        continue;
+      }
+      // row c of h, applied to the from point, over row 2 of h
+      const vgl_homg_point_2d<double> & p = from_points_[k / 2];
+      const unsigned c = 3 * (k % 2);
+      const double num = h[c] * p.x() + h[c + 1] * p.y() + h[c + 2] * p.w();
+      const double den = h[6] * p.x() + h[7] * p.y() + h[8] * p.w();
+      const double to = (k % 2) ? to_points_[k / 2].y() : to_points_[k / 2].x();
+      proj_err[k] = to - num / den;
+      std::fill(J, J + 9, 0.0);
+      J[c] = -p.x() / den;
+      J[c + 1] = -p.y() / den;
+      J[c + 2] = -p.w() / den;
+      const double s = num / (den * den);
+      J[6] = p.x() * s;
+      J[7] = p.y() * s;
+      J[8] = p.w() * s;
+    }
+  }
+
+  //: the Jacobian of f
+  void
+  gradf(const vnl_vector<double> & hv, vnl_matrix<double> & jacobian) override
+  {
+    vnl_vector<double> proj_err(2 * n_ + 1);
+    f_and_gradf_rows(hv, 0, 2 * n_ + 1, proj_err, jacobian);
+  }
 };
 
 
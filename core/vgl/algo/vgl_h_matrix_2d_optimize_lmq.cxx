@@ -33,6 +33,7 @@ vgl_h_matrix_2d_optimize_lmq::optimize_h(const std::vector<vgl_homg_point_2d<dou
     for (unsigned c = 0; c < 3; ++c, ++i)
       hv[i] = m[r][c];
   vnl_levenberg_marquardt lm(lsq);
+  lm.set_normal_equations(normal_equations_);
   lm.set_verbose(verbose_);
   lm.set_trace(trace_);
   lm.set_x_tolerance(htol_);
@@ -28,7 +28,18 @@ public:
     return 5;
   }
 
+  //: Solve each step from the normal equations instead of with MINPACK.
+  //  This is faster for many correspondences, as there are many more
+  //  residuals than the 9 unknowns.  Default is false.
+  void
+  set_normal_equations(bool b)
+  {
+    normal_equations_ = b;
+  }
+
 protected: // -- internal utilities --
+  bool normal_equations_{ false };
+
   //: the main routine for carrying out the optimization. (used by the others)
   bool
   optimize_h(const std::vector<vgl_homg_point_2d<double>> & points1,
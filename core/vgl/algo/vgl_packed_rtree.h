@@ -0,0 +1,150 @@
+// This is core/vgl/algo/vgl_packed_rtree.h
+#ifndef vgl_packed_rtree_h_
+#define vgl_packed_rtree_h_
+//:
+// \file
+// \brief Static rtree bulk loaded with Sort-Tile-Recursive, stored in flat arrays
+//
+// vgl_packed_rtree holds the same kind of elements as vgl_rtree, with the
+// same V, B and C template arguments, and answers the same region and
+// vgl_rtree_probe queries.  It is built once from all its elements instead
+// of by successive insertions:  the elements are ordered by Sort-Tile-Recursive
+// (sorted on the x centre of their bounds, cut into vertical slices, and each
+// slice sorted on the y centre) and packed into full leaves, and each upper
+// level is built the same way from the nodes below, up to a single root.
+//
+// The elements are stored contiguously in leaf order, and the nodes in one
+// array, level by level, each node referring to a range of
+// consecutive entries of the level below.  There is no pointer and no
+// allocation per node, and an element found by a query is near the other
+// elements found by the same query.  Batches of queries can be spread over
+// the threads of a vnl_thread_pool.
+//
+// In addition to the requirements of vgl_rtree, B must have centroid_x()
+// and centroid_y(), as vgl_box_2d has.
+
+#include <cstddef>
+#include <vector>
+#include "vgl_rtree.h"
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+template <class V, class B, class C>
+class vgl_packed_rtree
+{
+public:
+  typedef vgl_rtree_probe<V, B, C> probe;
+
+  //: Empty tree
+  vgl_packed_rtree() = default;
+
+  //: Build the tree from the given elements, with at most max_children entries per node.
+  vgl_packed_rtree(const std::vector<V> & vs, unsigned max_children = vgl_rtree_MAX_CHILDREN)
+  {
+    build(vs, max_children);
+  }
+
+  //: Replace the contents of the tree by the given elements.
+  void
+  build(const std::vector<V> & vs, unsigned max_children = vgl_rtree_MAX_CHILDREN);
+
+  //: get elements in the given region.
+  void
+  get(const B & region, std::vector<V> & vs) const;
+
+  //: get elements which meet the given probe.
+  void
+  get(const probe & region, std::vector<V> & vs) const;
+
+  //: get the elements in each of the given regions.
+  //  On return, vs[i] holds the elements in regions[i], in the order get()
+  //  would return them.  A point query is a region query with a degenerate
+  //  region.  The queries are spread over at most n_threads threads of the default
+  //  vnl_thread_pool (0 = all of them).
+  void
+  get(const std::vector<B> & regions, std::vector<std::vector<V>> & vs, unsigned n_threads = 0) const;
+
+  //: get the elements which meet each of the given probes.
+  //  The probes are called concurrently, so their meets() must be thread safe.
+  void
+  get(const std::vector<const probe *> & probes, std::vector<std::vector<V>> & vs, unsigned n_threads = 0) const;
+
+  //: get all elements in the tree, in leaf order.
+  void
+  get_all(std::vector<V> & vs) const
+  {
+    vs.insert(vs.end(), vts_.begin(), vts_.end());
+  }
+
+  //: return true iff the tree contains an element equal to v.
+  bool
+  contains(const V & v) const;
+
+  //: return true iff the tree has no elements.
+  bool
+  empty() const
+  {
+    return vts_.empty();
+  }
+
+  //: return number of elements stored in the tree.
+  unsigned
+  size() const
+  {
+    return unsigned(vts_.size());
+  }
+
+  //: return number of nodes used by the tree.
+  unsigned
+  nodes() const
+  {
+    return unsigned(nodes_.size());
+  }
+
+  //: return number of levels of nodes, 1 if the root is a leaf.
+  unsigned
+  levels() const
+  {
+    return unsigned(level_begin_.size());
+  }
+
+  //: bounds of all the elements; undefined if the tree is empty.
+  const B &
+  bounds() const
+  {
+    return nodes_.back().bounds;
+  }
+
+private:
+  struct node
+  {
+    B bounds;
+    //: first entry below this node, in nodes_ or, for a leaf, in vts_
+    unsigned first;
+    //: number of entries below this node
+    unsigned count;
+  };
+
+  //: Call f(i) on the index i in vts_ of each element of the leaves which meet_node accepts.
+  //  Only the nodes meet_node accepts are descended into.  The search stops
+  //  as soon as f returns false.
+  template <class F, class G>
+  void
+  search(const F & meet_node, const G & f) const;
+
+  //: Order in which to pack entries with the given bounds into nodes
+  static std::vector<unsigned>
+  str_order(const std::vector<B> & bounds, unsigned max_children);
+
+  //: The elements, in leaf order
+  std::vector<V> vts_;
+  //: All nodes, the leaves first and the root last
+  std::vector<node> nodes_;
+  //: Position in nodes_ of the first node of each level, leaves first
+  std::vector<std::size_t> level_begin_;
+};
+
+#define VGL_PACKED_RTREE_INSTANTIATE(V, B, C) extern "you must include vgl_packed_rtree.hxx first"
+
+#endif // vgl_packed_rtree_h_
@@ -0,0 +1,203 @@
+// This is core/vgl/algo/vgl_packed_rtree.hxx
+#ifndef vgl_packed_rtree_hxx_
+#define vgl_packed_rtree_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <cmath>
+#include "vgl_packed_rtree.h"
+#include <vnl/vnl_thread_pool.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+// Sort-Tile-Recursive: the n entries go into ceil(n/m) nodes of m entries,
+// arranged in about sqrt(n/m) vertical slices of sqrt(n/m) nodes each.
+template <class V, class B, class C>
+std::vector<unsigned>
+vgl_packed_rtree<V, B, C>::str_order(const std::vector<B> & bounds, unsigned max_children)
+{
+  const std::size_t n = bounds.size();
+  std::vector<double> cx(n), cy(n);
+  std::vector<unsigned> order(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    cx[i] = double(bounds[i].centroid_x());
+    cy[i] = double(bounds[i].centroid_y());
+    order[i] = unsigned(i);
+  }
+  std::sort(order.begin(), order.end(), [&cx](unsigned a, unsigned b) { return cx[a] < cx[b]; });
+
+  const std::size_t n_nodes = (n + max_children - 1) / max_children;
+  const auto n_slices = std::size_t(std::ceil(std::sqrt(double(n_nodes))));
+  const std::size_t slice_size = ((n_nodes + n_slices - 1) / n_slices) * max_children;
+  vnl_thread_pool::default_pool().parallel_for((n + slice_size - 1) / slice_size, [&](std::size_t s) {
+    const auto first = order.begin() + s * slice_size;
+    const auto last = order.begin() + std::min(n, (s + 1) * slice_size);
+    std::sort(first, last, [&cy](unsigned a, unsigned b) { return cy[a] < cy[b]; });
+  });
+  return order;
+}
+
+template <class V, class B, class C>
+void
+vgl_packed_rtree<V, B, C>::build(const std::vector<V> & vs, unsigned max_children)
+{
+  if (max_children < 2)
+    max_children = 2;
+  vts_.clear();
+  nodes_.clear();
+  level_begin_.clear();
+  if (vs.empty())
+    return;
+
+  // The leaves, each taking max_children consecutive elements in STR order
+  std::vector<B> bounds(vs.size());
+  for (std::size_t i = 0; i < vs.size(); ++i)
+    C::init(bounds[i], vs[i]);
+  std::vector<unsigned> order = str_order(bounds, max_children);
+  vts_.reserve(vs.size());
+  for (unsigned i : order)
+    vts_.push_back(vs[i]);
+
+  std::vector<B> entry_bounds;
+  entry_bounds.reserve(vs.size());
+  for (unsigned i : order)
+    entry_bounds.push_back(bounds[i]);
+  bounds.clear();
+  bounds.shrink_to_fit();
+
+  std::size_t n_entries = vts_.size();
+  std::size_t first_entry = 0;
+  while (true)
+  {
+    // Pack the entries, already in STR order, into the nodes of one level
+    level_begin_.push_back(nodes_.size());
+    for (std::size_t b = 0; b < n_entries; b += max_children)
+    {
+      const std::size_t e = std::min(n_entries, b + max_children);
+      node nd;
+      nd.bounds = entry_bounds[b];
+      for (std::size_t j = b + 1; j < e; ++j)
+        C::update(nd.bounds, entry_bounds[j]);
+      nd.first = unsigned(first_entry + b);
+      nd.count = unsigned(e - b);
+      nodes_.push_back(nd);
+    }
+    const std::size_t level_begin = level_begin_.back();
+    n_entries = nodes_.size() - level_begin;
+    if (n_entries == 1)
+      break;
+
+    // Put the nodes of this level in STR order, to be the entries of the next
+    entry_bounds.resize(n_entries);
+    for (std::size_t i = 0; i < n_entries; ++i)
+      entry_bounds[i] = nodes_[level_begin + i].bounds;
+    order = str_order(entry_bounds, max_children);
+    std::vector<node> level(nodes_.begin() + level_begin, nodes_.end());
+    for (std::size_t i = 0; i < n_entries; ++i)
+    {
+      nodes_[level_begin + i] = level[order[i]];
+      entry_bounds[i] = level[order[i]].bounds;
+    }
+    first_entry = level_begin;
+  }
+}
+
+template <class V, class B, class C>
+template <class F, class G>
+void
+vgl_packed_rtree<V, B, C>::search(const F & meet_node, const G & f) const
+{
+  if (nodes_.empty())
+    return;
+  const std::size_t n_leaves = level_begin_.size() > 1 ? level_begin_[1] : nodes_.size();
+  std::vector<std::size_t> stack(1, nodes_.size() - 1);
+  while (!stack.empty())
+  {
+    const node & nd = nodes_[stack.back()];
+    const bool leaf = stack.back() < n_leaves;
+    stack.pop_back();
+    if (!meet_node(nd.bounds))
+      continue;
+    if (leaf)
+    {
+      for (std::size_t i = nd.first; i < nd.first + nd.count; ++i)
+        if (!f(i))
+          return;
+    }
+    else
+    {
+      // pushed backwards, so that the children are visited in order
+      for (std::size_t j = nd.first + nd.count; j-- > nd.first;)
+        stack.push_back(j);
+    }
+  }
+}
+
+template <class V, class B, class C>
+void
+vgl_packed_rtree<V, B, C>::get(const B & region, std::vector<V> & vs) const
+{
+  search([&region](const B & b) { return C::meet(region, b); },
+         [&](std::size_t i) {
+           if (C::meet(region, vts_[i]))
+             vs.push_back(vts_[i]);
+           return true;
+         });
+}
+
+template <class V, class B, class C>
+void
+vgl_packed_rtree<V, B, C>::get(const probe & region, std::vector<V> & vs) const
+{
+  search([&region](const B & b) { return region.meets(b); },
+         [&](std::size_t i) {
+           if (region.meets(vts_[i]))
+             vs.push_back(vts_[i]);
+           return true;
+         });
+}
+
+template <class V, class B, class C>
+void
+vgl_packed_rtree<V, B, C>::get(const std::vector<B> & regions,
+                               std::vector<std::vector<V>> & vs,
+                               unsigned n_threads) const
+{
+  vs.assign(regions.size(), std::vector<V>());
+  vnl_thread_pool::default_pool().parallel_for(
+    regions.size(), [&](std::size_t q) { get(regions[q], vs[q]); }, n_threads);
+}
+
+template <class V, class B, class C>
+void
+vgl_packed_rtree<V, B, C>::get(const std::vector<const probe *> & probes,
+                               std::vector<std::vector<V>> & vs,
+                               unsigned n_threads) const
+{
+  vs.assign(probes.size(), std::vector<V>());
+  vnl_thread_pool::default_pool().parallel_for(
+    probes.size(), [&](std::size_t q) { get(*probes[q], vs[q]); }, n_threads);
+}
+
+template <class V, class B, class C>
+bool
+vgl_packed_rtree<V, B, C>::contains(const V & v) const
+{
+  B tmp;
+  C::init(tmp, v);
+  bool found = false;
+  search([&tmp](const B & b) { return C::meet(tmp, b); },
+         [&](std::size_t i) {
+           found = vts_[i] == v;
+           return !found;
+         });
+  return found;
+}
+
+#undef VGL_PACKED_RTREE_INSTANTIATE
+#define VGL_PACKED_RTREE_INSTANTIATE(V, B, C) template class vgl_packed_rtree<V, B, C>
+
+#endif // vgl_packed_rtree_hxx_
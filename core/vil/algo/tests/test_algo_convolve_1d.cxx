@@ -8,6 +8,7 @@
 #include "vxl_config.h" // for vxl_byte
 #include "vil/vil_new.h"
 #include "vil/vil_crop.h"
+#include "vil/vil_cpu_features.h"
 #include <vil/algo/vil_convolve_1d.h>
 
 
@@ -433,10 +434,39 @@ test_algo_convolve_1d_double()
        true);
 }
 
+//: Vectorised versions must give exactly the same answer as the generic code
+template <class srcT>
+static void
+test_algo_convolve_1d_simd(const char * type_name)
+{
+  vil_image_view<srcT> src(203, 5);
+  for (unsigned j = 0; j < src.nj(); ++j)
+    for (unsigned i = 0; i < src.ni(); ++i)
+      src(i, j) = srcT((i * 37 + j * 11) % 251);
+  const float kernel[7] = { 0.0625f, 0.125f, 0.2f, 0.3f, 0.2f, 0.125f, 0.0625f };
+
+  const vil_simd_level detected = vil_simd_detected_level();
+  vil_simd_set_max_level(vil_simd_none);
+  vil_image_view<float> generic;
+  vil_convolve_1d(src, generic, kernel + 3, -3, 3, float(), vil_convolve_constant_extend, vil_convolve_zero_extend);
+  for (int level = vil_simd_sse41; level <= detected; ++level)
+  {
+    vil_simd_set_max_level(vil_simd_level(level));
+    vil_image_view<float> fast;
+    vil_convolve_1d(src, fast, kernel + 3, -3, 3, float(), vil_convolve_constant_extend, vil_convolve_zero_extend);
+    std::cout << type_name << " at SIMD level " << level << ": ";
+    TEST("Identical to generic convolution", vil_image_view_deep_equality(generic, fast), true);
+  }
+  vil_simd_set_max_level(vil_simd_avx2);
+}
+
 static void
 test_algo_convolve_1d()
 {
   test_algo_convolve_1d_double();
+  test_algo_convolve_1d_simd<vxl_byte>("byte");
+  test_algo_convolve_1d_simd<vxl_uint_16>("uint_16");
+  test_algo_convolve_1d_simd<float>("float");
 }
 
 TESTMAIN(test_algo_convolve_1d);
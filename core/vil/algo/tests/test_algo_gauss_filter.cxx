@@ -10,6 +10,7 @@
 
 #include "vil/vil_image_view.h"
 #include "vil/vil_print.h"
+#include "vil/vil_cpu_features.h"
 #include <vil/algo/vil_gauss_filter.h>
 #include "vxl_config.h"
 #include "testlib/testlib_test.h"
@@ -278,6 +279,47 @@ test_algo_gauss_filter_2d()
   TEST_NEAR("Value at centre of filter", dest_im(nx, ny), 100 * f_c * f_c, 1e-6);
   TEST_NEAR("Value at corner", dest_im(nx + half_width, ny + half_width), 100 * f_0 * f_0, 1e-6);
   TEST_NEAR("Value at corner", dest_im(nx - half_width, ny - half_width), 100 * f_0 * f_0, 1e-6);
+
+  // Tile-parallel version must reproduce the serial result exactly,
+  // including across tile seams and at the image border.
+  vil_image_view<vxl_byte> big_im(301, 203, 2);
+  for (unsigned p = 0; p < big_im.nplanes(); ++p)
+    for (unsigned j = 0; j < big_im.nj(); ++j)
+      for (unsigned i = 0; i < big_im.ni(); ++i)
+        big_im(i, j, p) = vxl_byte((i * 7 + j * 13 + p * 31) % 251);
+  vil_image_view<float> serial_im, parallel_im;
+  vil_gauss_filter_2d(big_im, serial_im, sd, half_width, vil_convolve_constant_extend);
+  vnl_thread_pool pool(4);
+  vil_gauss_filter_2d(big_im, parallel_im, sd, half_width, vil_convolve_constant_extend, pool);
+  TEST("Parallel output size", parallel_im.ni() == serial_im.ni() && parallel_im.nj() == serial_im.nj(), true);
+  TEST("Parallel result identical to serial", vil_image_view_deep_equality(serial_im, parallel_im), true);
+}
+
+//: Vectorised versions must give exactly the same answer as the generic code
+template <class srcT, class destT>
+static void
+test_algo_gauss_filter_5tap_simd(const char * type_name)
+{
+  vil_image_view<srcT> src(77, 31, 2);
+  for (unsigned p = 0; p < src.nplanes(); ++p)
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        src(i, j, p) = srcT((i * 29 + j * 17 + p * 101) % 256);
+  const vil_gauss_filter_5tap_params params(1.2);
+
+  const vil_simd_level detected = vil_simd_detected_level();
+  vil_simd_set_max_level(vil_simd_none);
+  vil_image_view<destT> generic, work;
+  vil_gauss_filter_5tap(src, generic, params, work);
+  for (int level = vil_simd_sse41; level <= detected; ++level)
+  {
+    vil_simd_set_max_level(vil_simd_level(level));
+    vil_image_view<destT> fast;
+    vil_gauss_filter_5tap(src, fast, params, work);
+    std::cout << type_name << " at SIMD level " << level << ": ";
+    TEST("Identical to generic 5 tap filter", vil_image_view_deep_equality(generic, fast), true);
+  }
+  vil_simd_set_max_level(vil_simd_avx2);
 }
 
 static void
@@ -287,6 +329,9 @@ test_algo_gauss_filter()
   test_algo_gaussian_filter_5tap_byte_float();
   test_algo_gauss_filter_1d();
   test_algo_gauss_filter_2d();
+  test_algo_gauss_filter_5tap_simd<vxl_byte, vxl_byte>("byte to byte");
+  test_algo_gauss_filter_5tap_simd<vxl_byte, float>("byte to float");
+  test_algo_gauss_filter_5tap_simd<float, float>("float to float");
 }
 
 TESTMAIN(test_algo_gauss_filter);
@@ -23,6 +23,7 @@
 #include <vil/algo/vil_find_peaks.h>
 #include <vil/algo/vil_find_plateaus.h>
 #include <vil/algo/vil_flood_fill.h>
+#include <vil/algo/vil_filter_simd.h>
 #include <vil/algo/vil_gauss_filter.h>
 #include <vil/algo/vil_gauss_reduce.h>
 #include <vil/algo/vil_greyscale_closing.h>
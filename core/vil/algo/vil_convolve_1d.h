@@ -24,6 +24,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/vil_image_resource.h>
 #include <vil/vil_property.h>
+#include <vil/algo/vil_filter_simd.h>
 
 
 //: Available options for boundary behavior
@@ -210,6 +211,8 @@ vil_convolve_edge_1d(const srcT * src,
 //: Convolve kernel[x] (x in [k_lo,k_hi]) with srcT
 // Assumes dest and src same size (nx)
 // Kernel must not be larger than nx;
+// Contiguous byte, uint16 or float rows convolved with a float kernel into
+// float use SIMD instructions where available (see vil_filter_simd.h).
 template <class srcT, class destT, class kernelT, class accumT>
 inline void
 vil_convolve_1d(const srcT * src0,
@@ -234,15 +237,18 @@ vil_convolve_1d(const srcT * src0,
   assert(k_rbegin >= k_rend);
   const srcT * src = src0;
 
-  for (destT *dest = dest0 + d_step * k_hi, *const end_dest = dest0 + d_step * (int(nx) + k_lo); dest != end_dest;
-       dest += d_step, src += s_step)
-  {
-    accumT sum = 0;
-    const srcT * s = src;
-    for (const kernelT * k = k_rbegin; k != k_rend; --k, s += s_step)
-      sum += (accumT)((*k) * (*s));
-    *dest = destT(sum);
-  }
+  // Use a vectorised loop for contiguous rows where there is one for these types
+  const std::size_t n_interior = std::size_t(int(nx) + k_lo - k_hi);
+  if (s_step != 1 || d_step != 1 || !vil_convolve_1d_simd(src0, dest0 + k_hi, n_interior, kernel, k_lo, k_hi, ac))
+    for (destT *dest = dest0 + d_step * k_hi, *const end_dest = dest0 + d_step * (int(nx) + k_lo); dest != end_dest;
+         dest += d_step, src += s_step)
+    {
+      accumT sum = 0;
+      const srcT * s = src;
+      for (const kernelT * k = k_rbegin; k != k_rend; --k, s += s_step)
+        sum += (accumT)((*k) * (*s));
+      *dest = destT(sum);
+    }
 
   // Deal with end  (reflect data and kernel!)
   vil_convolve_edge_1d(src0 + (nx - 1) * s_step,
@@ -30,20 +30,19 @@ vil_fft_2d_base(std::complex<T> * data,
   vnl_fft_1d<T> fft_1d(n0);
   T factor = dir < 0 ? T(1) : T(1) / static_cast<T>(n0);
 
-  if (1 == step0) // use contiguous data memory directly
+  if (step0 > 0 && step1 > 0) // transform all the rows (or columns) of a plane together
   {
-    // FFT every pixel row (or column) in every colour band:
-    for (unsigned i1 = 0; i1 < n1; i1++)
-      for (unsigned i2 = 0; i2 < n2; i2++)
-      {
-        std::complex<T> * d = data + i1 * step1 + i2 * step2;
-        fft_1d.transform(d, dir);
-        if (dir >= 0)
+    for (unsigned i2 = 0; i2 < n2; i2++)
+    {
+      std::complex<T> * d = data + i2 * step2;
+      fft_1d.transform(d, step0, step1, n1, dir);
+      if (dir >= 0)
+        for (unsigned i1 = 0; i1 < n1; i1++)
           for (unsigned i0 = 0; i0 < n0; ++i0)
-            d[i0] *= factor; // proper scaling for forward FFT
-      }
+            d[i1 * step1 + i0 * step0] *= factor; // proper scaling for forward FFT
+    }
   }
-  else // must copy non-contiguous data memory to a std::vector
+  else // must copy the data of views with negative steps to a std::vector
   {
     std::vector<std::complex<T>> v(n0);
     for (unsigned i1 = 0; i1 < n1; i1++)
@@ -0,0 +1,406 @@
+// This is core/vil/algo/vil_filter_simd.cxx
+//:
+// \file
+// \brief SSE4.1 and AVX2 versions of the vil_convolve_1d and vil_gauss_filter_5tap inner loops
+//
+// Every function here is compiled for its own instruction set with
+// VIL_SIMD_TARGET, so the library itself can be built for a baseline
+// processor.  The public entry points pick a version with
+// vil_simd_active_level().
+
+#include <cstring>
+#include "vil_filter_simd.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include <vil/vil_cpu_features.h>
+
+#ifdef VIL_SIMD_X86
+#  include <immintrin.h>
+
+//=======================================================================
+// vil_convolve_1d
+
+//: Load 8 pixels as floats
+VIL_SIMD_TARGET("avx2") static inline __m256 vil_simd_load8_ps(const vxl_byte * p)
+{
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+VIL_SIMD_TARGET("avx2") static inline __m256 vil_simd_load8_ps(const vxl_uint_16 * p)
+{
+  return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+VIL_SIMD_TARGET("avx2") static inline __m256 vil_simd_load8_ps(const float * p)
+{
+  return _mm256_loadu_ps(p);
+}
+
+//: Load 4 pixels as floats
+VIL_SIMD_TARGET("sse4.1") static inline __m128 vil_simd_load4_ps(const vxl_byte * p)
+{
+  int v;
+  std::memcpy(&v, p, 4);
+  return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+}
+VIL_SIMD_TARGET("sse4.1") static inline __m128 vil_simd_load4_ps(const vxl_uint_16 * p)
+{
+  return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+VIL_SIMD_TARGET("sse4.1") static inline __m128 vil_simd_load4_ps(const float * p)
+{
+  return _mm_loadu_ps(p);
+}
+
+//: The generic loop of vil_convolve_1d, for the pixels left over at the end of a row
+template <class srcT>
+static inline void
+vil_convolve_1d_tail(const srcT * src,
+                     float * dest,
+                     std::size_t x,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi)
+{
+  for (; x < n; ++x)
+  {
+    float sum = 0;
+    const srcT * s = src + x;
+    for (std::ptrdiff_t k = k_hi; k >= k_lo; --k, ++s)
+      sum += kernel[k] * float(*s);
+    dest[x] = sum;
+  }
+}
+
+template <class srcT>
+VIL_SIMD_TARGET("avx2") static void
+vil_convolve_1d_avx2(const srcT * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi)
+{
+  std::size_t x = 0;
+  for (; x + 8 <= n; x += 8)
+  {
+    __m256 sum = _mm256_setzero_ps();
+    const srcT * s = src + x;
+    for (std::ptrdiff_t k = k_hi; k >= k_lo; --k, ++s)
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[k]), vil_simd_load8_ps(s)));
+    _mm256_storeu_ps(dest + x, sum);
+  }
+  vil_convolve_1d_tail(src, dest, x, n, kernel, k_lo, k_hi);
+}
+
+template <class srcT>
+VIL_SIMD_TARGET("sse4.1") static void
+vil_convolve_1d_sse41(const srcT * src,
+                      float * dest,
+                      std::size_t n,
+                      const float * kernel,
+                      std::ptrdiff_t k_lo,
+                      std::ptrdiff_t k_hi)
+{
+  std::size_t x = 0;
+  for (; x + 4 <= n; x += 4)
+  {
+    __m128 sum = _mm_setzero_ps();
+    const srcT * s = src + x;
+    for (std::ptrdiff_t k = k_hi; k >= k_lo; --k, ++s)
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel[k]), vil_simd_load4_ps(s)));
+    _mm_storeu_ps(dest + x, sum);
+  }
+  vil_convolve_1d_tail(src, dest, x, n, kernel, k_lo, k_hi);
+}
+
+//=======================================================================
+// vil_gauss_filter_5tap
+
+//: Load 4 pixels as doubles
+VIL_SIMD_TARGET("avx2") static inline __m256d vil_simd_load4_pd(const vxl_byte * p)
+{
+  int v;
+  std::memcpy(&v, p, 4);
+  return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+}
+VIL_SIMD_TARGET("avx2") static inline __m256d vil_simd_load4_pd(const float * p)
+{
+  return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+//: Store 4 doubles, converted as vl_round() does
+VIL_SIMD_TARGET("avx2") static inline void vil_simd_store4_pd(float * p, __m256d v)
+{
+  _mm_storeu_ps(p, _mm256_cvtpd_ps(v));
+}
+VIL_SIMD_TARGET("avx2") static inline void vil_simd_store4_pd(vxl_byte * p, __m256d v)
+{
+  // The smoothed values are never negative, so rounding is add 0.5 and truncate.
+  __m128i i32 = _mm256_cvttpd_epi32(_mm256_add_pd(v, _mm256_set1_pd(0.5)));
+  __m128i i8 = _mm_packus_epi16(_mm_packus_epi32(i32, i32), i32);
+  int r = _mm_cvtsi128_si32(i8);
+  std::memcpy(p, &r, 4);
+}
+
+//: Load 2 pixels as doubles
+VIL_SIMD_TARGET("sse4.1") static inline __m128d vil_simd_load2_pd(const vxl_byte * p)
+{
+  return _mm_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(int(p[0]) | (int(p[1]) << 8))));
+}
+VIL_SIMD_TARGET("sse4.1") static inline __m128d vil_simd_load2_pd(const float * p)
+{
+  return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+
+//: Store 2 doubles, converted as vl_round() does
+VIL_SIMD_TARGET("sse4.1") static inline void vil_simd_store2_pd(float * p, __m128d v)
+{
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_castps_si128(_mm_cvtpd_ps(v)));
+}
+VIL_SIMD_TARGET("sse4.1") static inline void vil_simd_store2_pd(vxl_byte * p, __m128d v)
+{
+  __m128i i32 = _mm_cvttpd_epi32(_mm_add_pd(v, _mm_set1_pd(0.5)));
+  int r = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(i32, i32), i32));
+  p[0] = vxl_byte(r & 0xff);
+  p[1] = vxl_byte((r >> 8) & 0xff);
+}
+
+//: The generic expression of vil_gauss_filter_5tap, for the pixels left over at the end of a row
+static inline float
+vil_gauss_filter_5tap_round(double x, float)
+{
+  return float(x);
+}
+static inline vxl_byte
+vil_gauss_filter_5tap_round(double x, vxl_byte)
+{
+  return vxl_byte(x + 0.5);
+}
+
+template <class srcT, class destT>
+static inline void
+vil_gauss_filter_5tap_tail(const srcT * s1,
+                           const srcT * s2,
+                           const srcT * s3,
+                           const srcT * s4,
+                           const srcT * s5,
+                           destT * dest,
+                           std::size_t x,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2)
+{
+  for (; x < n; ++x)
+    dest[x] = vil_gauss_filter_5tap_round(f2 * s1[x] + f1 * s2[x] + f0 * s3[x] + f1 * s4[x] + f2 * s5[x], destT());
+}
+
+template <class srcT, class destT>
+VIL_SIMD_TARGET("avx2") static void
+vil_gauss_filter_5tap_avx2(const srcT * s1,
+                           const srcT * s2,
+                           const srcT * s3,
+                           const srcT * s4,
+                           const srcT * s5,
+                           destT * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2)
+{
+  const __m256d k0 = _mm256_set1_pd(f0), k1 = _mm256_set1_pd(f1), k2 = _mm256_set1_pd(f2);
+  std::size_t x = 0;
+  for (; x + 4 <= n; x += 4)
+  {
+    __m256d sum = _mm256_add_pd(_mm256_mul_pd(k2, vil_simd_load4_pd(s1 + x)), _mm256_mul_pd(k1, vil_simd_load4_pd(s2 + x)));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(k0, vil_simd_load4_pd(s3 + x)));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(k1, vil_simd_load4_pd(s4 + x)));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(k2, vil_simd_load4_pd(s5 + x)));
+    vil_simd_store4_pd(dest + x, sum);
+  }
+  vil_gauss_filter_5tap_tail(s1, s2, s3, s4, s5, dest, x, n, f0, f1, f2);
+}
+
+template <class srcT, class destT>
+VIL_SIMD_TARGET("sse4.1") static void
+vil_gauss_filter_5tap_sse41(const srcT * s1,
+                            const srcT * s2,
+                            const srcT * s3,
+                            const srcT * s4,
+                            const srcT * s5,
+                            destT * dest,
+                            std::size_t n,
+                            double f0,
+                            double f1,
+                            double f2)
+{
+  const __m128d k0 = _mm_set1_pd(f0), k1 = _mm_set1_pd(f1), k2 = _mm_set1_pd(f2);
+  std::size_t x = 0;
+  for (; x + 2 <= n; x += 2)
+  {
+    __m128d sum = _mm_add_pd(_mm_mul_pd(k2, vil_simd_load2_pd(s1 + x)), _mm_mul_pd(k1, vil_simd_load2_pd(s2 + x)));
+    sum = _mm_add_pd(sum, _mm_mul_pd(k0, vil_simd_load2_pd(s3 + x)));
+    sum = _mm_add_pd(sum, _mm_mul_pd(k1, vil_simd_load2_pd(s4 + x)));
+    sum = _mm_add_pd(sum, _mm_mul_pd(k2, vil_simd_load2_pd(s5 + x)));
+    vil_simd_store2_pd(dest + x, sum);
+  }
+  vil_gauss_filter_5tap_tail(s1, s2, s3, s4, s5, dest, x, n, f0, f1, f2);
+}
+#endif // VIL_SIMD_X86
+
+//=======================================================================
+// Dispatch
+
+template <class srcT>
+static bool
+vil_convolve_1d_simd_dispatch(const srcT * src,
+                              float * dest,
+                              std::size_t n,
+                              const float * kernel,
+                              std::ptrdiff_t k_lo,
+                              std::ptrdiff_t k_hi)
+{
+#ifdef VIL_SIMD_X86
+  switch (vil_simd_active_level())
+  {
+    case vil_simd_avx2:
+      vil_convolve_1d_avx2(src, dest, n, kernel, k_lo, k_hi);
+      return true;
+    case vil_simd_sse41:
+      vil_convolve_1d_sse41(src, dest, n, kernel, k_lo, k_hi);
+      return true;
+    default:
+      break;
+  }
+#else
+  (void)src;
+  (void)dest;
+  (void)n;
+  (void)kernel;
+  (void)k_lo;
+  (void)k_hi;
+#endif
+  return false;
+}
+
+bool
+vil_convolve_1d_simd(const vxl_byte * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float)
+{
+  return vil_convolve_1d_simd_dispatch(src, dest, n, kernel, k_lo, k_hi);
+}
+
+bool
+vil_convolve_1d_simd(const vxl_uint_16 * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float)
+{
+  return vil_convolve_1d_simd_dispatch(src, dest, n, kernel, k_lo, k_hi);
+}
+
+bool
+vil_convolve_1d_simd(const float * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float)
+{
+  return vil_convolve_1d_simd_dispatch(src, dest, n, kernel, k_lo, k_hi);
+}
+
+template <class srcT, class destT>
+static bool
+vil_gauss_filter_5tap_simd_dispatch(const srcT * s1,
+                                    const srcT * s2,
+                                    const srcT * s3,
+                                    const srcT * s4,
+                                    const srcT * s5,
+                                    destT * dest,
+                                    std::size_t n,
+                                    double f0,
+                                    double f1,
+                                    double f2)
+{
+#ifdef VIL_SIMD_X86
+  switch (vil_simd_active_level())
+  {
+    case vil_simd_avx2:
+      vil_gauss_filter_5tap_avx2(s1, s2, s3, s4, s5, dest, n, f0, f1, f2);
+      return true;
+    case vil_simd_sse41:
+      vil_gauss_filter_5tap_sse41(s1, s2, s3, s4, s5, dest, n, f0, f1, f2);
+      return true;
+    default:
+      break;
+  }
+#else
+  (void)s1;
+  (void)s2;
+  (void)s3;
+  (void)s4;
+  (void)s5;
+  (void)dest;
+  (void)n;
+  (void)f0;
+  (void)f1;
+  (void)f2;
+#endif
+  return false;
+}
+
+bool
+vil_gauss_filter_5tap_simd(const vxl_byte * s1,
+                           const vxl_byte * s2,
+                           const vxl_byte * s3,
+                           const vxl_byte * s4,
+                           const vxl_byte * s5,
+                           vxl_byte * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2)
+{
+  return vil_gauss_filter_5tap_simd_dispatch(s1, s2, s3, s4, s5, dest, n, f0, f1, f2);
+}
+
+bool
+vil_gauss_filter_5tap_simd(const vxl_byte * s1,
+                           const vxl_byte * s2,
+                           const vxl_byte * s3,
+                           const vxl_byte * s4,
+                           const vxl_byte * s5,
+                           float * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2)
+{
+  return vil_gauss_filter_5tap_simd_dispatch(s1, s2, s3, s4, s5, dest, n, f0, f1, f2);
+}
+
+bool
+vil_gauss_filter_5tap_simd(const float * s1,
+                           const float * s2,
+                           const float * s3,
+                           const float * s4,
+                           const float * s5,
+                           float * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2)
+{
+  return vil_gauss_filter_5tap_simd_dispatch(s1, s2, s3, s4, s5, dest, n, f0, f1, f2);
+}
@@ -0,0 +1,123 @@
+// This is core/vil/algo/vil_filter_simd.h
+#ifndef vil_filter_simd_h_
+#define vil_filter_simd_h_
+//:
+// \file
+// \brief Vectorised inner loops for vil_convolve_1d and vil_gauss_filter_5tap
+//
+// Each function handles the interior of one contiguous row for a particular
+// combination of pixel types, using the best instruction set reported by
+// vil_simd_active_level().  They return false if they did nothing (no suitable
+// instruction set, or no fast version for these types), in which case the
+// caller runs its generic loop.  The generic templates below always return
+// false; overload resolution picks the vectorised versions where they exist.
+//
+// The results are bitwise identical to the generic code: each vector lane
+// computes one output pixel, applying the same taps in the same order with
+// separate multiplies and adds (no fused multiply-add).  This assumes the
+// generic code is compiled to use SSE rather than x87 arithmetic, which is
+// the default on x86-64.
+
+#include <cstddef>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vxl_config.h>
+
+//: Compute dest[x] = sum_{k=k_hi..k_lo} kernel[k]*src[x+k_hi-k] for x in [0,n)
+//  Generic version, which does nothing.
+template <class srcT, class destT, class kernelT, class accumT>
+inline bool
+vil_convolve_1d_simd(const srcT *, destT *, std::size_t, const kernelT *, std::ptrdiff_t, std::ptrdiff_t, accumT)
+{
+  return false;
+}
+
+//: Vectorised vil_convolve_1d interior, byte to float
+bool
+vil_convolve_1d_simd(const vxl_byte * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float);
+
+//: Vectorised vil_convolve_1d interior, uint16 to float
+bool
+vil_convolve_1d_simd(const vxl_uint_16 * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float);
+
+//: Vectorised vil_convolve_1d interior, float to float
+bool
+vil_convolve_1d_simd(const float * src,
+                     float * dest,
+                     std::size_t n,
+                     const float * kernel,
+                     std::ptrdiff_t k_lo,
+                     std::ptrdiff_t k_hi,
+                     float);
+
+//: Compute dest[x] = f2*s1[x] + f1*s2[x] + f0*s3[x] + f1*s4[x] + f2*s5[x], for x in [0,n)
+//  Used for both passes of vil_gauss_filter_5tap.  Generic version, which does nothing.
+template <class srcT, class destT>
+inline bool
+vil_gauss_filter_5tap_simd(const srcT *,
+                           const srcT *,
+                           const srcT *,
+                           const srcT *,
+                           const srcT *,
+                           destT *,
+                           std::size_t,
+                           double,
+                           double,
+                           double)
+{
+  return false;
+}
+
+//: Vectorised vil_gauss_filter_5tap row, byte to byte (rounded to nearest)
+bool
+vil_gauss_filter_5tap_simd(const vxl_byte * s1,
+                           const vxl_byte * s2,
+                           const vxl_byte * s3,
+                           const vxl_byte * s4,
+                           const vxl_byte * s5,
+                           vxl_byte * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2);
+
+//: Vectorised vil_gauss_filter_5tap row, byte to float
+bool
+vil_gauss_filter_5tap_simd(const vxl_byte * s1,
+                           const vxl_byte * s2,
+                           const vxl_byte * s3,
+                           const vxl_byte * s4,
+                           const vxl_byte * s5,
+                           float * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2);
+
+//: Vectorised vil_gauss_filter_5tap row, float to float
+bool
+vil_gauss_filter_5tap_simd(const float * s1,
+                           const float * s2,
+                           const float * s3,
+                           const float * s4,
+                           const float * s5,
+                           float * dest,
+                           std::size_t n,
+                           double f0,
+                           double f1,
+                           double f2);
+
+#endif // vil_filter_simd_h_
@@ -13,6 +13,7 @@
 #include <vil/vil_image_view.h>
 #include <vil/algo/vil_convolve_1d.h>
 #include <vil/vil_transpose.h>
+#include <vil/vil_parallel_blocks.h>
 
 class vil_gauss_filter_5tap_params
 {
@@ -129,6 +130,8 @@ vil_gauss_filter_5tap(const srcT * src_im,
 
 //: Smooth a src_im to produce dest_im
 //  Applies 5 element FIR filter in x and y.
+//  byte to byte, byte to float and float to float filtering use SIMD
+//  instructions where available (see vil_filter_simd.h).
 template <class srcT, class destT>
 void
 vil_gauss_filter_5tap(const vil_image_view<srcT> & src_im,
@@ -256,4 +259,27 @@ vil_gauss_filter_2d(const vil_image_view<srcT> & src_im,
 }
 
 
+//: Smooth a src_im to produce dest_im with gaussian of width sd, using a thread pool
+//  The image is split into tiles which are smoothed concurrently by
+//  vil_parallel_apply_tiled.  Each tile carries a half_width border, so
+//  the result is identical to that of the serial vil_gauss_filter_2d.
+template <class srcT, class destT>
+inline void
+vil_gauss_filter_2d(const vil_image_view<srcT> & src_im,
+                    vil_image_view<destT> & dest_im,
+                    double sd,
+                    unsigned half_width,
+                    vil_convolve_boundary_option boundary,
+                    vnl_thread_pool & pool)
+{
+  vil_parallel_apply_tiled(
+    src_im,
+    dest_im,
+    half_width,
+    [=](const vil_image_view<srcT> & src_tile, vil_image_view<destT> & dest_tile) {
+      vil_gauss_filter_2d(src_tile, dest_tile, sd, half_width, boundary);
+    },
+    pool);
+}
+
 #endif // vil_gauss_filter_h_
@@ -10,6 +10,7 @@
 #include "vil_gauss_filter.h"
 #include <vil/vil_transpose.h>
 #include <vil/algo/vil_convolve_1d.h>
+#include <vil/algo/vil_filter_simd.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -104,11 +105,21 @@ vil_gauss_filter_5tap(const srcT * src_im,
 
     int x;
     int nx2 = nx - 2;
-    for (x = 2; x < nx2; x++)
-      work_row[x] = vl_round(params.filt2() * src_col1[x * src_istep] + params.filt1() * src_col2[x * src_istep] +
-                               params.filt0() * src_col3[x * src_istep] + params.filt1() * src_col4[x * src_istep] +
-                               params.filt2() * src_col5[x * src_istep],
-                             (destT)0);
+    if (src_istep != 1 || !vil_gauss_filter_5tap_simd(src_col1 + 2,
+                                                      src_col2 + 2,
+                                                      src_col3 + 2,
+                                                      src_col4 + 2,
+                                                      src_col5 + 2,
+                                                      work_row + 2,
+                                                      std::size_t(nx - 4),
+                                                      params.filt0(),
+                                                      params.filt1(),
+                                                      params.filt2()))
+      for (x = 2; x < nx2; x++)
+        work_row[x] = vl_round(params.filt2() * src_col1[x * src_istep] + params.filt1() * src_col2[x * src_istep] +
+                                 params.filt0() * src_col3[x * src_istep] + params.filt1() * src_col4[x * src_istep] +
+                                 params.filt2() * src_col5[x * src_istep],
+                               (destT)0);
 
     // Now deal with edge effects :
     work_row[0] = vl_round(params.filt_edge0() * src_col3[0] + params.filt_edge1() * src_col4[0] +
@@ -144,11 +155,21 @@ vil_gauss_filter_5tap(const srcT * src_im,
     const destT * work_row4 = work_row3 + work_jstep;
     const destT * work_row5 = work_row3 + 2 * work_jstep;
 
-    for (unsigned int x = 0; x < nx; x++)
-      dest_row[x * dest_istep] =
-        vl_round(params.filt2() * work_row1[x] + params.filt1() * work_row2[x] + params.filt0() * work_row3[x] +
-                   params.filt1() * work_row4[x] + params.filt2() * work_row5[x],
-                 (destT)0);
+    if (dest_istep != 1 || !vil_gauss_filter_5tap_simd(work_row1,
+                                                       work_row2,
+                                                       work_row3,
+                                                       work_row4,
+                                                       work_row5,
+                                                       dest_row,
+                                                       std::size_t(nx),
+                                                       params.filt0(),
+                                                       params.filt1(),
+                                                       params.filt2()))
+      for (unsigned int x = 0; x < nx; x++)
+        dest_row[x * dest_istep] =
+          vl_round(params.filt2() * work_row1[x] + params.filt1() * work_row2[x] + params.filt0() * work_row3[x] +
+                     params.filt1() * work_row4[x] + params.filt2() * work_row5[x],
+                   (destT)0);
   }
 
   // Now deal with edge effects :
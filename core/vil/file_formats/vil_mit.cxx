@@ -19,6 +19,7 @@ static const char * vil_mit_format_tag = "mit";
 
 #include "vil/vil_stream.h"
 #include "vil/vil_image_resource.h"
+#include "vil/vil_property.h"
 #include "vil/vil_image_view.h"
 #include "vil/vil_stream_read.h"
 #include "vil/vil_stream_write.h"
@@ -143,9 +144,25 @@ vil_mit_image::vil_mit_image(vil_stream * is,
 vil_mit_image::~vil_mit_image() { is_->unref(); }
 
 bool
-vil_mit_image::get_property(const char * /*tag*/, void * /*prop*/) const
+vil_mit_image::get_property(const char * tag, void * prop) const
 {
-  // This is not an in-memory image type, nor is it read-only:
+  // This is not an in-memory image type, nor is it read-only.
+  // Pixels follow the 8-byte header, interleaved and little-endian.
+  if (std::strcmp(vil_property_raw_layout, tag) == 0)
+  {
+    if ((VXL_BIG_ENDIAN && bytes_per_pixel() > 1) || format_ == VIL_PIXEL_FORMAT_BOOL ||
+        format_ == VIL_PIXEL_FORMAT_UNKNOWN)
+      return false;
+    if (prop)
+    {
+      auto * layout = static_cast<std::ptrdiff_t *>(prop);
+      layout[0] = 8;
+      layout[1] = components_;
+      layout[2] = std::ptrdiff_t(components_) * ni_;
+      layout[3] = 1;
+    }
+    return true;
+  }
   return false;
 }
 
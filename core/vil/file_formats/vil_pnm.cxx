@@ -90,6 +90,23 @@ vil_pnm_image::get_property(const char * tag, void * value) const
     return true;
   }
 
+  // Raw pgm/ppm samples are interleaved and big-endian, so they can be
+  // used in place when they are bytes or the machine is big-endian.
+  if (std::strcmp(vil_property_raw_layout, tag) == 0)
+  {
+    if ((magic_ != 5 && magic_ != 6) || !(bits_per_component_ == 8 || (VXL_BIG_ENDIAN && bits_per_component_ == 16)))
+      return false;
+    if (value)
+    {
+      auto * layout = static_cast<std::ptrdiff_t *>(value);
+      layout[0] = std::ptrdiff_t(start_of_data_);
+      layout[1] = ncomponents_;
+      layout[2] = std::ptrdiff_t(ncomponents_) * ni_;
+      layout[3] = 1;
+    }
+    return true;
+  }
+
   return false;
 }
 
@@ -122,15 +122,15 @@ vil_pyramid_image_list_format::make_pyramid_image_from_base(const char * directo
     if (!blk_base)
       return nullptr;
   }
-  // Create the other pyramid levels
+  // Create the other pyramid levels, all in one pass over the base
   { // program scope to close resource files
-    vil_image_resource_sptr image = blk_base.ptr();
+    std::vector<std::string> level_files;
     for (unsigned int L = 1; L < nlevels; ++L)
-    {
-      std::cout << "Decimating Level " << L << std::endl;
-      full_filename = level_filename(d, fn, float(L)) + '.' + level_file_format;
-      image = vil_pyramid_image_resource::decimate(image, full_filename.c_str());
-    }
+      level_files.push_back(level_filename(d, fn, float(L)) + '.' + level_file_format);
+    std::cout << "Decimating Levels 1 to " << nlevels - 1 << std::endl;
+    if (vil_pyramid_image_resource::decimate_levels(blk_base.ptr(), level_files, level_file_format).size() !=
+        level_files.size())
+      return nullptr;
   } // end program scope to close resource files
   vil_image_list il(directory);
   std::vector<vil_image_resource_sptr> rescs = il.resources();
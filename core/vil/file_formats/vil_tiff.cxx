@@ -2,7 +2,11 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <fcntl.h>
 #include "vil_tiff.h"
 //:
 // \file
@@ -29,6 +33,7 @@
 #include "vil/vil_image_list.h"
 #include "vil_tiff_header.h"
 #include "vil/vil_exception.h"
+#include "vnl/vnl_thread_pool.h"
 // #define DEBUG
 
 // Constants
@@ -292,17 +297,16 @@ vil_tiff_file_format::make_pyramid_image_from_base(const char * file,
   { // scope for writing the resources
     vil_pyramid_image_resource_sptr pyr = make_pyramid_output_image(file);
     pyr->put_resource(base_image);
-    // Create the other pyramid levels
+    // Create the other pyramid levels, all in one pass over the base
     { // scope for resource files
       std::string d = temp_dir;
       std::string fn = "tempR";
-      vil_image_resource_sptr image = base_image;
+      std::vector<std::string> level_files;
       for (unsigned L = 1; L < nlevels; ++L)
-      {
-        std::cout << "Decimating Level " << L << std::endl;
-        std::string full_filename = level_filename(d, fn, L) + ".tif";
-        image = vil_pyramid_image_resource::decimate(image, full_filename.c_str());
-      }
+        level_files.push_back(level_filename(d, fn, L) + ".tif");
+      std::cout << "Decimating Levels 1 to " << nlevels - 1 << std::endl;
+      if (vil_pyramid_image_resource::decimate_levels(base_image, level_files).size() != level_files.size())
+        return nullptr;
     } // end program scope to close resource files
 
     // reopen them for reading
@@ -488,8 +492,6 @@ vil_tiff_image::pixel_format() const
   return h_->pix_fmt;
 }
 
-vil_tiff_image::~vil_tiff_image() { delete h_; }
-
 //////
 // Lifted from nitf2.  Maybe generalize to support other file formats
 //////
@@ -771,29 +773,45 @@ vil_tiff_image::view_from_buffer(vil_pixel_format & fmt,
   return view;
 }
 
-// this internal block accessor is used for both tiled and
-// striped encodings
-vil_image_view_base_sptr
-vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
+//
+// If there are multiple images in the file it is
+// necessary to set the TIFF directory and file header corresponding to
+// this resource according to the index
+//
+bool
+vil_tiff_image::select_directory() const
 {
-  // the only two possibilities
-  assert(h_->is_tiled() || h_->is_striped());
-  //
-  // If there are multiple images in the file it is
-  // necessary to set the TIFF directory and file header corresponding to
-  // this resource according to the index
-  //
   if (nimages_ > 1)
   {
     if (TIFFSetDirectory(t_.tif(), index_) <= 0)
-      return nullptr;
+      return false;
     auto * h = new vil_tiff_header(t_.tif());
     // Cast away const
     auto * ti = (vil_tiff_image *)this;
     delete h_;
     ti->h_ = h;
   }
+  return true;
+}
+
+// this internal block accessor is used for both tiled and
+// striped encodings
+vil_image_view_base_sptr
+vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
+{
+  // the only two possibilities
+  assert(h_->is_tiled() || h_->is_striped());
+  if (!this->select_directory())
+    return nullptr;
+  return this->decode_block(t_.tif(), block_index_i, block_index_j);
+}
 
+// Read the encoded block through tif, which is either the main handle or one
+// of the decoding handles, and unpack it.  Only reads the header, so this can
+// run concurrently on different handles.
+vil_image_view_base_sptr
+vil_tiff_image::decode_block(TIFF * tif, unsigned block_index_i, unsigned block_index_j) const
+{
   vil_image_view_base_sptr view = nullptr;
 
   // allocate input memory
@@ -816,7 +834,7 @@ vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
   if (h_->is_tiled())
   {
     auto * data = new vxl_byte[encoded_block_size];
-    if (TIFFReadEncodedTile(t_.tif(), blk_indx, data, (tsize_t)-1) <= 0)
+    if (TIFFReadEncodedTile(tif, blk_indx, data, (tsize_t)-1) <= 0)
     {
       delete[] data;
       return view;
@@ -831,7 +849,7 @@ vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
   if (h_->is_striped() && h_->planar_config.val == 1)
   {
     auto * data = new vxl_byte[encoded_block_size];
-    if (TIFFReadEncodedStrip(t_.tif(), blk_indx, data, (tsize_t)-1) <= 0)
+    if (TIFFReadEncodedStrip(tif, blk_indx, data, (tsize_t)-1) <= 0)
     {
       delete[] data;
       return view;
@@ -874,7 +892,7 @@ vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
     {
       strip_plane_data[s] = new vxl_byte[strip_data_size];
       size_t strip_indx = blk_indx + s * strips_per_plane;
-      size_t strip_size = TIFFReadEncodedStrip(t_.tif(), strip_indx, strip_plane_data[s], (tsize_t)-1);
+      size_t strip_size = TIFFReadEncodedStrip(tif, strip_indx, strip_plane_data[s], (tsize_t)-1);
       if (strip_size <= 0) // if the read fails, bail--
       {
         for (size_t d = 0; d <= s; ++d)
@@ -924,6 +942,213 @@ vil_tiff_image::get_block(unsigned block_index_i, unsigned block_index_j) const
   return view;
 }
 
+//================ concurrent block decoding =================
+//
+// Each decoding thread uses its own TIFF handle, opened on the stream of the
+// main handle.  The handles keep their own file position, and the stream is
+// only touched under a mutex, so the (short) reads of encoded data are
+// serialised while libtiff decompresses in parallel.
+
+//: The client data of a decoding handle
+struct vil_tiff_decoder_stream
+{
+  vil_stream * vs;
+  vil_streampos pos;
+  std::mutex * mutex;
+};
+
+static tsize_t
+vil_tiff_decoder_readproc(thandle_t h, tdata_t buf, tsize_t n)
+{
+  auto * p = (vil_tiff_decoder_stream *)h;
+  std::lock_guard<std::mutex> lock(*p->mutex);
+  p->vs->seek(p->pos);
+  auto ret = (tsize_t)p->vs->read(buf, n);
+  p->pos += ret;
+  return ret;
+}
+
+static tsize_t
+vil_tiff_decoder_writeproc(thandle_t, tdata_t, tsize_t)
+{
+  return 0; // decoding handles are read only
+}
+
+static toff_t
+vil_tiff_decoder_seekproc(thandle_t h, toff_t offset, int whence)
+{
+  auto * p = (vil_tiff_decoder_stream *)h;
+  if (whence == SEEK_SET)
+    p->pos = offset;
+  else if (whence == SEEK_CUR)
+    p->pos += offset;
+  else if (whence == SEEK_END)
+  {
+    std::lock_guard<std::mutex> lock(*p->mutex);
+    p->pos = p->vs->file_size() + offset;
+  }
+  return (toff_t)p->pos;
+}
+
+static int
+vil_tiff_decoder_closeproc(thandle_t h)
+{
+  auto * p = (vil_tiff_decoder_stream *)h;
+  p->vs->unref();
+  delete p;
+  return 0;
+}
+
+static toff_t
+vil_tiff_decoder_sizeproc(thandle_t h)
+{
+  auto * p = (vil_tiff_decoder_stream *)h;
+  std::lock_guard<std::mutex> lock(*p->mutex);
+  return (toff_t)p->vs->file_size();
+}
+
+//: The set of decoding handles belonging to one vil_tiff_image
+struct vil_tiff_decoders
+{
+  struct handle
+  {
+    TIFF * tif;
+    unsigned int directory;
+  };
+
+  ~vil_tiff_decoders()
+  {
+    for (auto & h : all)
+#if HAS_GEOTIFF
+      XTIFFClose(h.tif);
+#else
+      TIFFClose(h.tif);
+#endif
+  }
+
+  //: Take an idle handle, opening a new one if there is none.
+  //  The handle is set to the given directory.  Returns null on failure.
+  handle *
+  acquire(vil_stream * vs, unsigned int directory)
+  {
+    handle * h = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(free_mutex);
+      if (!idle.empty())
+      {
+        h = idle.back();
+        idle.pop_back();
+      }
+      else
+      {
+        auto * p = new vil_tiff_decoder_stream;
+        p->vs = vs;
+        p->pos = 0;
+        p->mutex = &stream_mutex;
+        vs->ref();
+#if HAS_GEOTIFF
+        TIFF * tif = XTIFFClientOpen(
+#else
+        TIFF * tif = TIFFClientOpen(
+#endif
+          "unknown filename",
+          "rC",
+          (thandle_t)p,
+          vil_tiff_decoder_readproc,
+          vil_tiff_decoder_writeproc,
+          vil_tiff_decoder_seekproc,
+          vil_tiff_decoder_closeproc,
+          vil_tiff_decoder_sizeproc,
+          vil_tiff_mapfileproc,
+          vil_tiff_unmapfileproc);
+        if (!tif)
+        {
+          vs->unref();
+          delete p;
+          return nullptr;
+        }
+        all.push_back(handle{ tif, 0 });
+        // the deque never moves its elements, so h stays valid
+        h = &all.back();
+      }
+    }
+    if (h->directory != directory)
+    {
+      if (TIFFSetDirectory(h->tif, directory) <= 0)
+      {
+        release(h);
+        return nullptr;
+      }
+      h->directory = directory;
+    }
+    return h;
+  }
+
+  void
+  release(handle * h)
+  {
+    std::lock_guard<std::mutex> lock(free_mutex);
+    idle.push_back(h);
+  }
+
+  //: Serialises all access to the shared stream
+  std::mutex stream_mutex;
+  std::mutex free_mutex;
+  std::deque<handle> all;
+  std::vector<handle *> idle;
+};
+
+vil_tiff_image::~vil_tiff_image()
+{
+  delete decoders_;
+  delete h_;
+}
+
+bool
+vil_tiff_image::get_blocks(unsigned start_block_i,
+                           unsigned end_block_i,
+                           unsigned start_block_j,
+                           unsigned end_block_j,
+                           std::vector<std::vector<vil_image_view_base_sptr>> & blocks) const
+{
+  const std::size_t nbi = end_block_i - start_block_i + 1, nbj = end_block_j - start_block_j + 1;
+  if (!decode_pool_ || decode_pool_->n_threads() < 2 || nbi * nbj < 2 || TIFFGetMode(t_.tif()) != O_RDONLY)
+    return vil_blocked_image_resource::get_blocks(start_block_i, end_block_i, start_block_j, end_block_j, blocks);
+
+  if (!this->select_directory())
+    return false;
+  auto * tss = (tif_stream_structures *)TIFFClientdata(t_.tif());
+  std::call_once(decoders_once_, [this] { decoders_ = new vil_tiff_decoders; });
+  const unsigned int directory = nimages_ > 1 ? index_ : 0;
+
+  std::vector<vil_image_view_base_sptr> decoded(nbi * nbj);
+  std::atomic<bool> ok(true);
+  decode_pool_->parallel_for(nbi * nbj, [&](std::size_t k) {
+    vil_tiff_decoders::handle * h = decoders_->acquire(tss->vs, directory);
+    if (!h)
+    {
+      ok = false;
+      return;
+    }
+    decoded[k] = this->decode_block(h->tif, start_block_i + unsigned(k % nbi), start_block_j + unsigned(k / nbi));
+    decoders_->release(h);
+    if (!decoded[k])
+      ok = false;
+  });
+  if (!ok)
+    return false;
+
+  // the blocks are in col row order, i.e. blocks[i][j]
+  for (std::size_t bi = 0; bi < nbi; ++bi)
+  {
+    std::vector<vil_image_view_base_sptr> jblocks(nbj);
+    for (std::size_t bj = 0; bj < nbj; ++bj)
+      jblocks[bj] = decoded[bj * nbi + bi];
+    blocks.push_back(jblocks);
+  }
+  return true;
+}
+
 // decode tiles: the tile is a contiguous raster scan of potentially
 // interleaved samples. This is an easy case since the tile is a
 // contiguous raster scan.
@@ -18,12 +18,15 @@
 //       compression schemes. Tiff files with separate color bands are not handled
 //   24 Mar 2007 J.L. Mundy - added smart pointer on TIFF handle to support
 //       multiple resources from a single tiff file; required for pyramid
+//   Optional concurrent decoding of the blocks of a multi-block read,
+//       see vil_tiff_image::set_decode_pool()
 //   KNOWN BUG - 24bit samples for both nplanes = 1 and nplanes = 3
 //   KNOWN BUG - bool pixel format write - crashes due to incorrect block size
 // \endverbatim
 
 #include <vector>
 #include <iostream>
+#include <mutex>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -35,6 +38,7 @@
 #include <vil/vil_blocked_image_resource.h>
 #include <vil/vil_pyramid_image_resource.h>
 #include <vil/file_formats/vil_tiff_header.h>
+#include <vnl/vnl_thread_pool.h>
 #include <tiffio.h>
 #if HAS_GEOTIFF
 #  include <xtiffio.h>
@@ -86,6 +90,7 @@ public:
 };
 
 struct tif_stream_structures;
+struct vil_tiff_decoders;
 class vil_tiff_header;
 // Need to create a smartpointer mechanism for the tiff
 // file in order to handle multiple images, e.g. for pyramid
@@ -249,9 +254,30 @@ public:
   vil_image_view_base_sptr
   get_block(unsigned block_index_i, unsigned block_index_j) const override;
 
+  //: Get a range of blocks, decoding them concurrently if a decode pool is set.
+  //  Used by get_copy_view().
+  bool
+  get_blocks(unsigned start_block_i,
+             unsigned end_block_i,
+             unsigned start_block_j,
+             unsigned end_block_j,
+             std::vector<std::vector<vil_image_view_base_sptr>> & blocks) const override;
+
   bool
   put_block(unsigned block_index_i, unsigned block_index_j, const vil_image_view_base & blk) override;
 
+  //: Decode the blocks of multi-block reads concurrently on pool.
+  //  Each thread gets its own TIFF handle on the underlying stream.  Reading
+  //  the compressed bytes is serialised; decompression (deflate, LZW, JPEG,
+  //  ...) and unpacking run in parallel.  Only used for files opened for
+  //  reading.  The pool must outlive its use here; pass null (the default)
+  //  to decode on the calling thread.
+  void
+  set_decode_pool(vnl_thread_pool * pool)
+  {
+    decode_pool_ = pool;
+  }
+
   //: Put the data in this view back into the image source.
   bool
   put_view(const vil_image_view_base & im, unsigned i0, unsigned j0) override;
@@ -322,6 +348,20 @@ private:
   unsigned int index_;
   //: number of images in the file
   unsigned int nimages_;
+  //: pool for concurrent block decoding, if any
+  vnl_thread_pool * decode_pool_{ nullptr };
+  //: the extra TIFF handles used for concurrent decoding, created on demand
+  mutable vil_tiff_decoders * decoders_{ nullptr };
+  //: guards the creation of decoders_ by concurrent get_copy_view calls
+  mutable std::once_flag decoders_once_;
+
+  //: make the header match the current directory when there are multiple images
+  bool
+  select_directory() const;
+
+  //: read and decode one block using the given TIFF handle
+  vil_image_view_base_sptr
+  decode_block(TIFF * tif, unsigned block_index_i, unsigned block_index_j) const;
 #if 0
   //to keep the tiff file open during reuse of multiple tiff resources
   //in a single file otherwise the resource destructor would close the file
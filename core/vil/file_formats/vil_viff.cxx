@@ -13,6 +13,7 @@ static const char * vil_viff_format_tag = "viff";
 
 #include "vil/vil_stream.h"
 #include "vil/vil_image_resource.h"
+#include "vil/vil_property.h"
 #include "vil/vil_image_view.h"
 #include "vil/vil_exception.h"
 
@@ -138,9 +139,26 @@ vil_viff_image::vil_viff_image(vil_stream * is,
 vil_viff_image::~vil_viff_image() { is_->unref(); }
 
 bool
-vil_viff_image::get_property(const char * /*tag*/, void * /*prop*/) const
+vil_viff_image::get_property(const char * tag, void * prop) const
 {
-  // This is not an in-memory image type, nor is it read-only:
+  // This is not an in-memory image type, nor is it read-only.
+  // Planes are stored one after another; the data can be used in place
+  // unless it must be byte-swapped or is packed bits.
+  if (std::strcmp(vil_property_raw_layout, tag) == 0)
+  {
+    if (!endian_consistent_ || format_ == VIL_PIXEL_FORMAT_BOOL || format_ == VIL_PIXEL_FORMAT_UNKNOWN ||
+        vil_pixel_format_num_components(format_) != 1)
+      return false;
+    if (prop)
+    {
+      auto * layout = static_cast<std::ptrdiff_t *>(prop);
+      layout[0] = std::ptrdiff_t(start_of_data_);
+      layout[1] = 1;
+      layout[2] = ni_;
+      layout[3] = std::ptrdiff_t(ni_) * nj_;
+    }
+    return true;
+  }
   return false;
 }
 
@@ -9,10 +9,12 @@
 #include "vxl_config.h"
 #include "vpl/vpl.h" // vpl_unlink()
 #include "vil/vil_image_view.h"
+#include "vil/vil_mapped_memory_chunk.h"
 #include <vil/io/vil_io_image_view.h>
 #include "vil/vil_plane.h"
 #include "vil/vil_view_as.h"
 #include "vsl/vsl_stream.h"
+#include "vsl/vsl_mapped_fstream.h"
 
 
 #ifndef LEAVE_FILES_BEHIND
@@ -144,6 +146,47 @@ test_image_view_io_as(T value1, T value2)
   TEST("Smart ptr", &image2p(0, 0), &image2(0, 0, 1));
 }
 
+static void
+test_image_view_io_in_place()
+{
+  vil_image_view<vxl_byte> byte_out(17, 9, 3);
+  vil_image_view<vxl_int_32> int_out(5, 4);
+  for (unsigned p = 0; p < byte_out.nplanes(); ++p)
+    for (unsigned j = 0; j < byte_out.nj(); ++j)
+      for (unsigned i = 0; i < byte_out.ni(); ++i)
+        byte_out(i, j, p) = vxl_byte(i + 3 * j + 7 * p);
+  int_out.fill(-12345);
+  {
+    vsl_b_ofstream f("vil_image_view_test_io_in_place.bvl.tmp");
+    vsl_b_write(f, byte_out);
+    vsl_b_write(f, int_out);
+  }
+
+  vil_image_view<vxl_byte> byte_in;
+  vil_image_view<vxl_int_32> int_in;
+  {
+    vsl_b_imapped_fstream f("vil_image_view_test_io_in_place.bvl.tmp");
+    TEST("Opened vil_image_view_test_io_in_place.bvl.tmp for reading", (!f), false);
+    vsl_b_read(f, byte_in);
+    vsl_b_read(f, int_in);
+    TEST("Finished reading mapped file successfully", (!f), false);
+    const char * begin = f.mapping().get();
+    const auto * p = reinterpret_cast<const char *>(byte_in.top_left_ptr());
+    TEST("Bytes loaded in place", p > begin && p < begin + 1000, true);
+  }
+  auto * chunk = dynamic_cast<vil_mapped_memory_chunk *>(byte_in.memory_chunk().ptr());
+  TEST("Byte image uses a mapped chunk", chunk != nullptr && chunk->is_mapped(), true);
+  TEST("Byte image as expected after closing the stream", vil_image_view_deep_equality(byte_in, byte_out), true);
+  TEST("Int image copied", dynamic_cast<vil_mapped_memory_chunk *>(int_in.memory_chunk().ptr()), nullptr);
+  TEST("Int image as expected", vil_image_view_deep_equality(int_in, int_out), true);
+  byte_in(0, 0) = 200; // the mapping is copy on write
+  TEST("Mapped pixel writable", byte_in(0, 0), 200);
+
+#if !LEAVE_FILES_BEHIND
+  vpl_unlink("vil_image_view_test_io_in_place.bvl.tmp");
+#endif
+}
+
 static void
 test_image_view_io()
 {
@@ -167,6 +210,7 @@ test_image_view_io()
   test_image_view_io_as(double(12.1), double(123.456));
   test_image_view_io_as(bool(false), bool(true));
   test_image_view_io_as_null();
+  test_image_view_io_in_place();
 }
 
 TESTMAIN(test_image_view_io);
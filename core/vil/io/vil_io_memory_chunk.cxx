@@ -9,8 +9,11 @@
 //   23 Oct.2003 - Peter Vanroose - Added support for 64-bit int pixels
 // \endverbatim
 
+#include <memory>
 #include "vsl/vsl_block_binary.h"
 #include "vsl/vsl_complex_io.h"
+#include "vsl/vsl_mapped_fstream.h"
+#include "vil/vil_mapped_memory_chunk.h"
 
 #define write_case_macro(T)                            \
   vsl_b_write(os, unsigned(chunk.size() / sizeof(T))); \
@@ -290,7 +293,60 @@ vsl_b_write(vsl_b_ostream & os, const vil_memory_chunk * chunk_ptr)
     vsl_b_write(os, *chunk_ptr);
 }
 
+#define in_place_case_macro(T)                               \
+  data = vsl_block_binary_read_in_place<T>(is, n, owner); \
+  size = n * sizeof(T)
+
+//: Load a chunk saved with version 3 from a mapped stream, referring to the pixels in the mapping.
+//  Returns nullptr, with is unchanged, if it has to be copied.
+static vil_memory_chunk *
+vil_io_memory_chunk_read_in_place(vsl_b_istream & is)
+{
+  if (!is || dynamic_cast<vsl_b_imapped_fstream *>(&is) == nullptr)
+    return nullptr;
+  const std::streampos start = is.is().tellg();
+  short w;
+  vsl_b_read(is, w);
+  if (w == 3)
+  {
+    int format;
+    unsigned n;
+    vsl_b_read(is, format);
+    vsl_b_read(is, n);
+    const vil_pixel_format pixel_format = vil_pixel_format(format);
+    std::shared_ptr<void> owner;
+    void * data = nullptr;
+    std::size_t size = 0;
+    switch (pixel_format)
+    {
+      case VIL_PIXEL_FORMAT_BYTE:
+        in_place_case_macro(vxl_byte);
+        break;
+      case VIL_PIXEL_FORMAT_SBYTE:
+        in_place_case_macro(vxl_sbyte);
+        break;
+      case VIL_PIXEL_FORMAT_FLOAT:
+        in_place_case_macro(float);
+        break;
+      case VIL_PIXEL_FORMAT_DOUBLE:
+        in_place_case_macro(double);
+        break;
+      default:
+        break;
+    }
+    if (data && !!is)
+      return new vil_mapped_memory_chunk(owner, data, size, pixel_format);
+  }
+  is.is().clear();
+  is.is().seekg(start);
+  return nullptr;
+}
+
+#undef in_place_case_macro
+
 //: Binary load vil_memory_chunk from stream  onto the heap
+// Pixels which need no conversion are used in place when is is a
+// vsl_b_imapped_fstream.
 void
 vsl_b_read(vsl_b_istream & is, vil_memory_chunk *& p)
 {
@@ -299,6 +355,9 @@ vsl_b_read(vsl_b_istream & is, vil_memory_chunk *& p)
   vsl_b_read(is, not_null_ptr);
   if (not_null_ptr)
   {
+    p = vil_io_memory_chunk_read_in_place(is);
+    if (p)
+      return;
     p = new vil_memory_chunk();
     vsl_b_read(is, *p);
   }
@@ -13,6 +13,8 @@
 #include "vil/vil_image_view.h"
 #include "vil/vil_blocked_image_resource.h"
 #include "vil/vil_block_cache.h"
+#include "vnl/vnl_thread_pool.h"
+#include <vil/file_formats/vil_tiff.h>
 #include "vul/vul_file.h"
 
 static std::string image_file;
@@ -333,6 +335,52 @@ test_blocked_image_resource()
   }
 }
 
+//: Compressed tiff blocks decoded on a thread pool must match a serial read
+//  Tiles of sbi x sbj, or strips if sbi is 0
+static void
+test_tiff_parallel_decode(unsigned sbi, unsigned sbj, unsigned np)
+{
+  std::cout << "Concurrent decoding of LZW tiff, block size " << sbi << 'x' << sbj << ", " << np << " planes\n";
+  constexpr unsigned int ni = 203, nj = 147;
+  vil_image_view<vxl_byte> image(ni, nj, np);
+  for (unsigned p = 0; p < np; ++p)
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = 0; i < ni; ++i)
+        image(i, j, p) = vxl_byte((i / 3 + j * j / 7 + p * 40) % 251);
+
+  std::string path("test_parallel_decode.tif");
+  { // scope for resource
+    vil_image_resource_sptr out =
+      sbi > 0 ? vil_new_blocked_image_resource(path.c_str(), ni, nj, np, VIL_PIXEL_FORMAT_BYTE, sbi, sbj, "tiff").ptr()
+              : vil_new_image_resource(path.c_str(), ni, nj, np, VIL_PIXEL_FORMAT_BYTE, "tiff");
+    auto * tiff_out = dynamic_cast<vil_tiff_image *>(out.ptr());
+    TEST("Set LZW compression", tiff_out && tiff_out->set_compression_method(vil_tiff_image::LZW), true);
+    TEST("Write compressed tiff", out->put_view(image), true);
+  }
+  {
+    vil_image_resource_sptr in = vil_load_image_resource(path.c_str());
+    auto * tiff_in = dynamic_cast<vil_tiff_image *>(in.ptr());
+    TEST("Reload as vil_tiff_image", tiff_in != nullptr, true);
+    if (tiff_in)
+    {
+      vil_image_view<vxl_byte> serial = in->get_view();
+      vil_image_view<vxl_byte> serial_part = in->get_view(17, 150, 9, 120);
+      vnl_thread_pool pool(4);
+      tiff_in->set_decode_pool(&pool);
+      vil_image_view<vxl_byte> parallel = in->get_view();
+      vil_image_view<vxl_byte> parallel_part = in->get_view(17, 150, 9, 120);
+      // and again, reusing the decoding handles
+      vil_image_view<vxl_byte> parallel_again = in->get_view(0, ni, 0, nj);
+      tiff_in->set_decode_pool(nullptr);
+      TEST("Serial read is correct", vil_image_view_deep_equality(serial, image), true);
+      TEST("Concurrent read is correct", vil_image_view_deep_equality(parallel, image), true);
+      TEST("Concurrent region read", vil_image_view_deep_equality(parallel_part, serial_part), true);
+      TEST("Repeated concurrent read", vil_image_view_deep_equality(parallel_again, image), true);
+    }
+  }
+  vpl_unlink(path.c_str());
+}
+
 int
 test_blocked_image_resource_main(int argc, char * argv[])
 {
@@ -353,5 +401,7 @@ test_blocked_image_resource_main(int argc, char * argv[])
   image_file += "/";
   std::cout << "Start test process\n";
   test_blocked_image_resource();
+  test_tiff_parallel_decode(32, 32, 1);
+  test_tiff_parallel_decode(0, 0, 3);
   return 0;
 }
@@ -0,0 +1,185 @@
+// This is core/vil/tests/test_concurrent_block_cache.cxx
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil/vil_concurrent_block_cache.h"
+#include "vil/vil_cached_image_resource.h"
+#include "vil/vil_new.h"
+#include "vil/vil_image_view.h"
+
+static vil_image_view_base_sptr
+make_block(unsigned value)
+{
+  auto * blk = new vil_image_view<vxl_byte>(8, 4);
+  blk->fill(vxl_byte(value));
+  return blk;
+}
+
+static void
+test_lru_order()
+{
+  // A single shard behaves as an exact LRU cache.
+  vil_concurrent_block_cache cache(3, 0, 1);
+  TEST("n_shards", cache.n_shards(), 1);
+  for (unsigned i = 0; i < 3; ++i)
+    cache.add_block(i, 0, make_block(i));
+  vil_image_view_base_sptr blk;
+  TEST("Block 0 present", cache.get_block(0, 0, blk), true); // 0 becomes most recent
+  cache.add_block(3, 0, make_block(3));                       // evicts 1, the oldest
+  TEST("Block 1 evicted", cache.get_block(1, 0, blk), false);
+  TEST("Block 0 kept", cache.get_block(0, 0, blk), true);
+  TEST("Block 3 present", cache.get_block(3, 0, blk), true);
+  TEST("Retrieved block value", vil_image_view<vxl_byte>(blk)(0, 0), 3);
+  TEST("n_blocks", cache.n_blocks(), 3);
+  TEST("n_hits", cache.n_hits(), 3);
+  TEST("n_misses", cache.n_misses(), 1);
+  TEST("n_evictions", cache.n_evictions(), 1);
+
+  // Replacing a block does not grow the cache
+  cache.add_block(3, 0, make_block(7));
+  TEST("Replace keeps size", cache.n_blocks(), 3);
+  cache.get_block(3, 0, blk);
+  TEST("Replaced block value", vil_image_view<vxl_byte>(blk)(0, 0), 7);
+
+  TEST("remove_block", cache.remove_block(3, 0), true);
+  TEST("removed block gone", cache.get_block(3, 0, blk), false);
+  cache.clear();
+  TEST("clear", cache.n_blocks() == 0 && cache.n_bytes() == 0, true);
+}
+
+static void
+test_byte_capacity()
+{
+  // Each block is 32 bytes; allow three of them.
+  vil_concurrent_block_cache cache(0, 96, 1);
+  TEST("block_bytes", vil_concurrent_block_cache::block_bytes(*make_block(0)), 32);
+  for (unsigned i = 0; i < 10; ++i)
+    cache.add_block(i, i, make_block(i));
+  TEST("Byte limit respected", cache.n_bytes(), 96);
+  TEST("Blocks within byte limit", cache.n_blocks(), 3);
+  vil_image_view_base_sptr big = new vil_image_view<float>(100, 100);
+  TEST("Oversized block refused", cache.add_block(20, 20, big), false);
+}
+
+static void
+test_global_budget()
+{
+  // With the default number of shards the limits still apply to the whole
+  // cache, and eviction is least-recently-used over all shards.
+  vil_concurrent_block_cache by_bytes(0, 96);
+  TEST("Default shards", by_bytes.n_shards() > 1, true);
+  for (unsigned i = 0; i < 10; ++i)
+    by_bytes.add_block(i, 0, make_block(i));
+  TEST("Tight byte budget filled", by_bytes.n_blocks(), 3);
+  TEST("Tight byte budget respected", by_bytes.n_bytes(), 96);
+  vil_image_view_base_sptr blk;
+  bool newest_kept = true;
+  for (unsigned i = 7; i < 10; ++i)
+    newest_kept = newest_kept && by_bytes.get_block(i, 0, blk);
+  TEST("Most recent blocks kept", newest_kept, true);
+  TEST("Older blocks evicted", by_bytes.get_block(6, 0, blk), false);
+  TEST("n_evictions", by_bytes.n_evictions(), 7);
+
+  vil_concurrent_block_cache by_count(5);
+  for (unsigned i = 0; i < 40; ++i)
+    by_count.add_block(i, i % 3, make_block(i));
+  TEST("Block limit filled", by_count.n_blocks(), 5);
+
+  // A cached resource with room for only a few blocks still caches them.
+  vil_image_view<vxl_byte> image(64, 32);
+  image.fill(9);
+  vil_blocked_image_resource_sptr bir = vil_new_blocked_image_facade(vil_new_image_resource_of_view(image), 8, 4);
+  vil_blocked_image_resource_sptr cached = vil_new_cached_image_resource(bir, 100, 4 * 32);
+  for (unsigned n = 0; n < 2; ++n)
+    for (unsigned bi = 0; bi < 4; ++bi)
+      cached->get_block(bi, 0);
+  auto * cir = static_cast<vil_cached_image_resource *>(cached.ptr());
+  TEST("Small budget cached resource hits", cir->cache().n_hits(), 4);
+  TEST("Small budget cached resource size", cir->cache().n_blocks(), 4);
+
+  // A cache_size of zero still means no caching.
+  vil_blocked_image_resource_sptr uncached = vil_new_cached_image_resource(bir, 0);
+  bool read_ok = true;
+  for (unsigned bi = 0; bi < 4; ++bi)
+    read_ok = read_ok && uncached->get_block(bi, 0);
+  auto * uir = static_cast<vil_cached_image_resource *>(uncached.ptr());
+  TEST("Zero cache_size reads blocks", read_ok, true);
+  TEST("Zero cache_size caches nothing", uir->cache().n_blocks(), 0);
+}
+
+static void
+test_concurrent_access()
+{
+  // Many threads hammer a small sharded cache; all lookups must return the
+  // block that was stored under that index.
+  vil_concurrent_block_cache cache(16, 0, 4);
+  std::atomic<bool> consistent(true);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 8; ++t)
+    threads.emplace_back([&cache, &consistent, t] {
+      for (unsigned n = 0; n < 2000; ++n)
+      {
+        const unsigned i = (n * 7 + t) % 40, j = n % 3;
+        vil_image_view_base_sptr blk;
+        if (cache.get_block(i, j, blk))
+        {
+          if (vil_image_view<vxl_byte>(blk)(0, 0) != vxl_byte(i + 40 * j))
+            consistent = false;
+        }
+        else
+          cache.add_block(i, j, make_block(i + 40 * j));
+      }
+    });
+  for (auto & th : threads)
+    th.join();
+  TEST("Concurrent lookups consistent", consistent, true);
+  TEST("Capacity respected", cache.n_blocks() <= 16, true);
+  TEST("Hits + misses", cache.n_hits() + cache.n_misses(), 8 * 2000);
+
+  // Concurrent readers of a cached resource
+  constexpr unsigned ni = 100, nj = 60;
+  vil_image_view<vxl_uint_16> image(ni, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      image(i, j) = vxl_uint_16(i + ni * j);
+  vil_blocked_image_resource_sptr bir =
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(image), 16, 16);
+  vil_blocked_image_resource_sptr cached = vil_new_cached_image_resource(bir, 8);
+  std::atomic<bool> reads_ok(true);
+  threads.clear();
+  for (unsigned t = 0; t < 6; ++t)
+    threads.emplace_back([&, t] {
+      for (unsigned n = 0; n < 200; ++n)
+      {
+        const unsigned bi = (n + t) % cached->n_block_i(), bj = (n / 3 + t) % cached->n_block_j();
+        vil_image_view<vxl_uint_16> blk = cached->get_block(bi, bj);
+        const unsigned i = bi * 16, j = bj * 16;
+        if (!blk || blk(0, 0) != image(i, j))
+          reads_ok = false;
+      }
+    });
+  for (auto & th : threads)
+    th.join();
+  TEST("Concurrent cached resource reads", reads_ok, true);
+  auto * cir = static_cast<vil_cached_image_resource *>(cached.ptr());
+  TEST("Cached resource reports hits", cir->cache().n_hits() > 0, true);
+}
+
+static void
+test_concurrent_block_cache()
+{
+  std::cout << "*************************************\n"
+            << " Testing vil_concurrent_block_cache\n"
+            << "*************************************\n";
+  test_lru_order();
+  test_byte_capacity();
+  test_global_budget();
+  test_concurrent_access();
+}
+
+TESTMAIN(test_concurrent_block_cache);
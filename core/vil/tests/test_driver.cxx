@@ -35,6 +35,9 @@ DECLARE(test_pyramid_image_view);
 DECLARE(test_na);
 DECLARE(test_rgb);
 DECLARE(test_flatten);
+DECLARE(test_parallel_blocks);
+DECLARE(test_concurrent_block_cache);
+DECLARE(test_mapped_image_resource);
 
 void
 register_tests()
@@ -74,6 +77,9 @@ register_tests()
   REGISTER(test_na);
   REGISTER(test_rgb);
   REGISTER(test_flatten);
+  REGISTER(test_parallel_blocks);
+  REGISTER(test_concurrent_block_cache);
+  REGISTER(test_mapped_image_resource);
 }
 
 DEFINE_MAIN;
@@ -1,6 +1,8 @@
 #include "vil/vil_bicub_interp.h"
 #include "vil/vil_bilin_interp.h"
 #include "vil/vil_block_cache.h"
+#include "vil/vil_concurrent_block_cache.h"
+#include "vil/vil_cpu_features.h"
 #include "vil/vil_border.h"
 #include "vil/vil_chord.h"
 #include "vil/vil_clamp.h"
@@ -26,10 +28,14 @@
 #include "vil/vil_pyramid_image_resource.h"
 #include "vil/vil_pyramid_image_view.h"
 #include "vil/vil_image_list.h"
+#include "vil/vil_thread_pool.h"
+#include "vil/vil_parallel_blocks.h"
 #include "vil/vil_image_view.h"
 #include "vil/vil_image_view_base.h"
 #include "vil/vil_load.h"
 #include "vil/vil_math.h"
+#include "vil/vil_mapped_image_resource.h"
+#include "vil/vil_mapped_memory_chunk.h"
 #include "vil/vil_memory_chunk.h"
 #include "vil/vil_memory_image.h"
 #include "vil/vil_nearest_interp.h"
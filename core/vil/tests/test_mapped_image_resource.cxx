@@ -0,0 +1,138 @@
+// This is core/vil/tests/test_mapped_image_resource.cxx
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil/vil_mapped_image_resource.h"
+#include "vil/vil_mapped_memory_chunk.h"
+#include "vil/vil_image_view.h"
+#include "vil/vil_property.h"
+#include "vil/vil_save.h"
+#include "vxl_config.h"
+#include "vul/vul_temp_filename.h"
+#include "vpl/vpl.h"
+
+static void
+test_mapped_pnm()
+{
+  constexpr unsigned ni = 37, nj = 23;
+  vil_image_view<vxl_byte> rgb(ni, nj, 1, 3);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      for (unsigned p = 0; p < 3; ++p)
+        rgb(i, j, p) = vxl_byte(i * 3 + j * 5 + p * 70);
+
+  std::string fname = vul_temp_filename() + ".ppm";
+  TEST("Save ppm", vil_save(rgb, fname.c_str(), "pnm"), true);
+
+  vil_image_resource_sptr ir = vil_load_mapped_image_resource(fname.c_str());
+  TEST("Loaded", !!ir, true);
+  std::ptrdiff_t layout[4] = { 0, 0, 0, 0 };
+  TEST("Has raw layout", ir && ir->get_property(vil_property_raw_layout, layout), true);
+  TEST("Layout is pixel interleaved", layout[1] == 3 && layout[2] == 3 * ni && layout[3] == 1, true);
+  TEST("Reports read only", ir && ir->get_property(vil_property_read_only), true);
+  auto * mapped = dynamic_cast<vil_mapped_image_resource *>(ir.ptr());
+  TEST("Resource is mapped", mapped && mapped->is_valid(), true);
+  if (!mapped)
+    return;
+
+  vil_image_view<vxl_byte> view = ir->get_view(4, 20, 3, 15);
+  TEST("View size", view.ni() == 20 && view.nj() == 15 && view.nplanes() == 3, true);
+  TEST("View shares the mapping", view.memory_chunk() == mapped->memory_chunk(), true);
+  bool same = true;
+  for (unsigned j = 0; j < view.nj(); ++j)
+    for (unsigned i = 0; i < view.ni(); ++i)
+      for (unsigned p = 0; p < 3; ++p)
+        same = same && view(i, j, p) == rgb(i + 4, j + 3, p);
+  TEST("Mapped pixels correct", same, true);
+
+  mapped->prefetch(0, ni, 10, 5);
+  mapped->advise(vil_mapped_memory_chunk::access_random);
+
+  vil_image_view<vxl_byte> copy = ir->get_copy_view();
+  TEST("Copy does not share the mapping", copy && copy.memory_chunk() != mapped->memory_chunk(), true);
+  TEST("Copy pixels correct", copy && copy(ni - 1, nj - 1, 2) == rgb(ni - 1, nj - 1, 2), true);
+  TEST("Out of range view", !ir->get_view(30, 10, 0, 1), true);
+  TEST("put_view refused", ir->put_view(rgb), false);
+
+  // The view keeps the mapping alive after the resource goes away
+  ir = nullptr;
+  TEST("View outlives resource", view(19, 14, 1) == rgb(23, 17, 1), true);
+
+  // Views are copy-on-write: writing works and leaves the file unchanged
+  view.fill(7);
+  view(0, 0, 1) = 200;
+  TEST("Write through mapped view", view(5, 5, 2) == 7 && view(0, 0, 1) == 200, true);
+  vil_image_resource_sptr reloaded = vil_load_mapped_image_resource(fname.c_str());
+  vil_image_view<vxl_byte> fresh = reloaded ? reloaded->get_view() : vil_image_view_base_sptr();
+  TEST("File unchanged by writes", fresh && fresh(4, 3, 1) == rgb(4, 3, 1) && fresh(9, 8, 2) == rgb(9, 8, 2), true);
+  fresh.clear();
+  reloaded = nullptr;
+  view.clear();
+  copy.clear();
+  vpl_unlink(fname.c_str());
+}
+
+static void
+test_mapped_raw()
+{
+  // A headed band-sequential file of 16 bit values in native byte order
+  constexpr unsigned ni = 11, nj = 7, np = 2, header = 13;
+  std::string fname = vul_temp_filename() + ".raw";
+  {
+    std::ofstream os(fname.c_str(), std::ios::binary);
+    for (unsigned k = 0; k < header; ++k)
+      os.put('h');
+    for (unsigned p = 0; p < np; ++p)
+      for (unsigned j = 0; j < nj; ++j)
+        for (unsigned i = 0; i < ni; ++i)
+        {
+          vxl_uint_16 v = vxl_uint_16(1000 * p + 10 * j + i);
+          os.write(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+  }
+
+  vil_mapped_image_resource bad(fname, ni, nj + 1, np, VIL_PIXEL_FORMAT_UINT_16, header, 1, ni, ni * nj);
+  TEST("Too short a file is not mapped", bad.is_valid(), false);
+
+  vil_image_resource_sptr ir =
+    new vil_mapped_image_resource(fname, ni, nj, np, VIL_PIXEL_FORMAT_UINT_16, header, 1, ni, ni * nj);
+  auto * mapped = static_cast<vil_mapped_image_resource *>(ir.ptr());
+  TEST("Raw file mapped", mapped->is_valid(), true);
+  vil_image_view<vxl_uint_16> view = ir->get_view(2, 5, 1, 6);
+  TEST("Raw view valid", !!view, true);
+  TEST("Raw pixel plane 0", view && view(0, 0, 0) == 12, true);
+  TEST("Raw pixel plane 1", view && view(4, 5, 1) == 1066, true);
+  view.clear();
+
+  // set_size keeps the mapping only if both the size and the format are unchanged
+  vil_memory_chunk_sptr chunk = mapped->memory_chunk();
+  auto * mapped_chunk = static_cast<vil_mapped_memory_chunk *>(chunk.ptr());
+  const unsigned long n_bytes = (unsigned long)chunk->size();
+  chunk->set_size(n_bytes, VIL_PIXEL_FORMAT_UINT_16);
+  TEST("Same size and format stays mapped", mapped_chunk->is_mapped(), true);
+  chunk->set_size(n_bytes, VIL_PIXEL_FORMAT_BYTE);
+  TEST("New format is applied", !mapped_chunk->is_mapped() && chunk->pixel_format() == VIL_PIXEL_FORMAT_BYTE, true);
+  chunk = nullptr;
+  ir = nullptr;
+  vpl_unlink(fname.c_str());
+}
+
+static void
+test_mapped_image_resource()
+{
+  std::cout << "***********************************\n"
+            << " Testing vil_mapped_image_resource\n"
+            << "***********************************\n";
+#if defined(_WIN32)
+  std::cout << "Memory mapping is not supported on this platform\n";
+#else
+  test_mapped_pnm();
+  test_mapped_raw();
+#endif
+}
+
+TESTMAIN(test_mapped_image_resource);
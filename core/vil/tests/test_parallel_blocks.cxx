@@ -0,0 +1,118 @@
+// This is core/vil/tests/test_parallel_blocks.cxx
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include "testlib/testlib_test.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vnl/vnl_thread_pool.h"
+#include "vil/vil_parallel_blocks.h"
+#include "vil/vil_new.h"
+#include "vil/vil_image_view.h"
+
+// A 3x3 box filter with constant extension, used as a stand-in for an
+// existing whole-image filter.
+static void
+box_3x3(const vil_image_view<int> & src, vil_image_view<int> & dest)
+{
+  dest.set_size(src.ni(), src.nj(), src.nplanes());
+  const int ni = src.ni(), nj = src.nj();
+  for (unsigned p = 0; p < src.nplanes(); ++p)
+    for (int j = 0; j < nj; ++j)
+      for (int i = 0; i < ni; ++i)
+      {
+        int sum = 0;
+        for (int dj = -1; dj <= 1; ++dj)
+          for (int di = -1; di <= 1; ++di)
+          {
+            int ii = i + di < 0 ? 0 : (i + di >= ni ? ni - 1 : i + di);
+            int jj = j + dj < 0 ? 0 : (j + dj >= nj ? nj - 1 : j + dj);
+            sum += src(ii, jj, p);
+          }
+        dest(i, j, p) = sum;
+      }
+}
+
+static void
+test_apply_tiled()
+{
+  vil_image_view<int> src(157, 93, 2);
+  for (unsigned p = 0; p < src.nplanes(); ++p)
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        src(i, j, p) = int((i * 17 + j * 5 + p) % 101);
+
+  vil_image_view<int> serial, tiled;
+  box_3x3(src, serial);
+  for (unsigned n_threads = 1; n_threads <= 4; ++n_threads)
+  {
+    vnl_thread_pool pool(n_threads);
+    // Small odd tiles so that seams and clipped border tiles are exercised.
+    vil_parallel_apply_tiled(src, tiled, 1, box_3x3, pool, 20, 11);
+    TEST("Tiled filter identical to serial", vil_image_view_deep_equality(serial, tiled), true);
+  }
+}
+
+static void
+test_for_each_block()
+{
+  constexpr unsigned ni = 73, nj = 43;
+  vil_image_view<vxl_uint_16> image(ni, nj);
+  for (unsigned j = 0; j < nj; ++j)
+    for (unsigned i = 0; i < ni; ++i)
+      image(i, j) = vxl_uint_16(i + ni * j);
+  vil_blocked_image_resource_sptr src =
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(image), 16, 16);
+  vnl_thread_pool pool(3);
+
+  std::atomic<unsigned> n_visited(0), n_pixels(0);
+  bool ok = vil_parallel_for_each_block(
+    src,
+    [&](unsigned, unsigned, const vil_image_view_base_sptr & blk) {
+      ++n_visited;
+      n_pixels += blk->ni() * blk->nj();
+      return true;
+    },
+    pool);
+  TEST("for_each_block succeeded", ok, true);
+  TEST("Visited every block", n_visited, src->n_block_i() * src->n_block_j());
+  TEST("Visited every pixel", n_pixels >= ni * nj, true);
+
+  vil_image_view<vxl_uint_16> out_image(ni, nj);
+  out_image.fill(0);
+  vil_blocked_image_resource_sptr dest =
+    vil_new_blocked_image_facade(vil_new_image_resource_of_view(out_image), 16, 16);
+  ok = vil_parallel_transform_blocks(
+    src,
+    dest,
+    [](unsigned, unsigned, const vil_image_view_base_sptr & blk) -> vil_image_view_base_sptr {
+      vil_image_view<vxl_uint_16> in(blk);
+      auto * out = new vil_image_view<vxl_uint_16>(in.ni(), in.nj());
+      for (unsigned j = 0; j < in.nj(); ++j)
+        for (unsigned i = 0; i < in.ni(); ++i)
+          (*out)(i, j) = vxl_uint_16(2 * in(i, j));
+      return out;
+    },
+    pool);
+  TEST("transform_blocks succeeded", ok, true);
+  vil_image_view<vxl_uint_16> result = dest->get_view();
+  bool correct = result.ni() == ni && result.nj() == nj;
+  for (unsigned j = 0; correct && j < nj; ++j)
+    for (unsigned i = 0; correct && i < ni; ++i)
+      correct = result(i, j) == vxl_uint_16(2 * image(i, j));
+  TEST("transform_blocks output", correct, true);
+}
+
+static void
+test_parallel_blocks()
+{
+  std::cout << "******************************\n"
+            << " Testing vil_parallel_blocks\n"
+            << "******************************\n";
+
+  test_apply_tiled();
+  test_for_each_block();
+}
+
+TESTMAIN(test_parallel_blocks);
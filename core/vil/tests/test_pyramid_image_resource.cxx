@@ -5,6 +5,7 @@
 //
 #include <iostream>
 #include <string>
+#include <vector>
 #include "testlib/testlib_test.h"
 #include "testlib/testlib_root_dir.h"
 #ifdef _MSC_VER
@@ -34,6 +35,51 @@
 #endif
 #define DEBUG
 
+//: Build several levels in one streaming pass and compare with direct 2x2 averaging
+static void
+test_stream_decimate(unsigned ni, unsigned nj, unsigned np, unsigned nlevels)
+{
+  std::cout << "Streaming " << nlevels << " levels from a " << ni << 'x' << nj << 'x' << np << " base\n";
+  vil_image_view<vxl_uint_16> base(ni, nj, np);
+  for (unsigned p = 0; p < np; ++p)
+    for (unsigned j = 0; j < nj; ++j)
+      for (unsigned i = 0; i < ni; ++i)
+        base(i, j, p) = static_cast<vxl_uint_16>((i * 7 + j * 131 + p * 1000) % 4099);
+  vil_image_resource_sptr bir = new vil_blocked_image_facade(vil_new_image_resource_of_view(base), 16, 16);
+
+  std::vector<vil_image_view<vxl_uint_16>> level_views;
+  std::vector<vil_blocked_image_resource_sptr> levels;
+  unsigned lni = ni, lnj = nj;
+  for (unsigned L = 1; L < nlevels; ++L)
+  {
+    lni = (lni + 1) / 2;
+    lnj = (lnj + 1) / 2;
+    vil_image_view<vxl_uint_16> v(lni, lnj, np);
+    v.fill(0);
+    level_views.push_back(v);
+    levels.push_back(new vil_blocked_image_facade(vil_new_image_resource_of_view(v), 16, 16));
+  }
+  TEST("stream_decimate", vil_pyramid_image_resource::stream_decimate(bir, levels), true);
+
+  bool good = true;
+  vil_image_view<vxl_uint_16> below = base;
+  for (const auto & lev : level_views)
+  {
+    for (unsigned p = 0; p < np; ++p)
+      for (unsigned j = 0; j < lev.nj(); ++j)
+        for (unsigned i = 0; i < lev.ni(); ++i)
+        {
+          unsigned i0 = 2 * i, j0 = 2 * j;
+          unsigned i1 = i0 + 1 < below.ni() ? i0 + 1 : i0, j1 = j0 + 1 < below.nj() ? j0 + 1 : j0;
+          float v = 0.25f * (float(below(i0, j0, p)) + float(below(i1, j0, p)) + float(below(i0, j1, p)) +
+                             float(below(i1, j1, p)));
+          good = good && lev(i, j, p) == static_cast<vxl_uint_16>(v);
+        }
+    below = lev;
+  }
+  TEST("streamed levels match 2x2 averaging", good, true);
+}
+
 static void
 test_pyramid_image_resource(int argc, char * argv[])
 {
@@ -52,6 +98,8 @@ test_pyramid_image_resource(int argc, char * argv[])
   std::cout << "************************************\n"
             << " Testing vil_pyramid_image_resource\n"
             << "************************************\n";
+  test_stream_decimate(73, 43, 1, 4);
+  test_stream_decimate(50, 97, 3, 6);
   // Test Resource
   const unsigned int ni = 73, nj = 43;
 
@@ -7,6 +7,9 @@
 #include "vxl_config.h" // for vxl_byte
 #include "vil/vil_image_view.h"
 #include "vil/vil_resample_bilin.h"
+#include "vil/vil_bilin_interp.h"
+#include "vil/vil_cpu_features.h"
+#include "vnl/vnl_thread_pool.h"
 
 static void
 test_resample_bilin_byte()
@@ -90,10 +93,53 @@ test_resample_bilin_byte()
   TEST_NEAR("dest_im(3,2,1)", dest_im(3, 2, 1), 179, 1e-6);
 }
 
+//: The axis-aligned fast path, with or without SIMD and threads, must match per-pixel interpolation
+template <class sType, class dType>
+static void
+test_resample_bilin_fast(const char * type_name)
+{
+  vil_image_view<sType> src(97, 61, 2);
+  for (unsigned p = 0; p < src.nplanes(); ++p)
+    for (unsigned j = 0; j < src.nj(); ++j)
+      for (unsigned i = 0; i < src.ni(); ++i)
+        src(i, j, p) = sType((i * 13 + j * 7 + p * 50) % 256);
+
+  // Includes integer sample positions in both directions
+  const double x0 = 2.0, y0 = 1.5, dx1 = 0.75, dy2 = 0.5;
+  const int n1 = 110, n2 = 100;
+  vil_image_view<dType> expected(n1, n2, 2);
+  double y = y0;
+  for (int j = 0; j < n2; ++j, y += dy2)
+  {
+    double x = x0;
+    for (int i = 0; i < n1; ++i, x += dx1)
+      for (unsigned p = 0; p < 2; ++p)
+        expected(i, j, p) = (dType)vil_bilin_interp_raw(x, y, &src(0, 0, p), src.istep(), src.jstep());
+  }
+
+  vnl_thread_pool pool(3);
+  const vil_simd_level detected = vil_simd_detected_level();
+  for (int level = vil_simd_none; level <= detected; ++level)
+  {
+    vil_simd_set_max_level(vil_simd_level(level));
+    vil_image_view<dType> serial, parallel;
+    vil_resample_bilin(src, serial, x0, y0, dx1, 0.0, 0.0, dy2, n1, n2);
+    vil_resample_bilin(src, parallel, x0, y0, dx1, 0.0, 0.0, dy2, n1, n2, pool);
+    std::cout << type_name << " at SIMD level " << level << ": ";
+    TEST("Fast path identical to interpolation", vil_image_view_deep_equality(expected, serial), true);
+    TEST("Threaded version identical", vil_image_view_deep_equality(expected, parallel), true);
+  }
+  vil_simd_set_max_level(vil_simd_avx2);
+}
+
 static void
 test_resample_bilin()
 {
   test_resample_bilin_byte();
+  test_resample_bilin_fast<vxl_byte, vxl_byte>("byte to byte");
+  test_resample_bilin_fast<vxl_byte, float>("byte to float");
+  test_resample_bilin_fast<float, float>("float to float");
+  test_resample_bilin_fast<vxl_uint_16, vxl_uint_16>("uint_16 to uint_16");
 }
 
 TESTMAIN(test_resample_bilin);
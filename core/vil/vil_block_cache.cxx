@@ -7,7 +7,7 @@
 #endif
 #include <cassert>
 
-unsigned long bcell::time_ = 0;
+std::atomic<unsigned long> bcell::time_(0);
 
 vil_block_cache::~vil_block_cache()
 {
@@ -6,6 +6,7 @@
 // \brief A block cache with block population prioritized by age
 // \author J. L. Mundy
 //
+#include <atomic>
 #include <iostream>
 #include <queue>
 #include <vector>
@@ -18,6 +19,8 @@
 //  Modifications
 //   J.L. Mundy replaced priority queue with sort on block vector
 //   container for simplicity, January 01, 2012
+//   Made the timestamp counter atomic.  Note the cache itself is not
+//   thread-safe; see vil_concurrent_block_cache for that.
 // \endverbatim
 
 // container for blocks to maintain a timestamp
@@ -52,7 +55,7 @@ struct bcell
   }
 
 private:
-  static unsigned long time_; // static timekeeper
+  static std::atomic<unsigned long> time_; // static timekeeper
 };
 // the ordering predicate for block birthdate. Oldest block is at
 // blocks_.begin()
@@ -8,11 +8,21 @@
 vil_image_view_base_sptr
 vil_cached_image_resource::get_block(unsigned block_index_i, unsigned block_index_j) const
 {
+  // a cache_size of zero means no caching
+  if (cache_.block_capacity() == 0)
+  {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    return bir_->get_block(block_index_i, block_index_j);
+  }
   // check if the block is already in the buffer
   vil_image_view_base_sptr blk;
   if (cache_.get_block(block_index_i, block_index_j, blk))
     return blk;
   // no - so get the block from the resource
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  // another thread may have read the block while we waited for the lock
+  if (cache_.get_block(block_index_i, block_index_j, blk))
+    return blk;
   blk = bir_->get_block(block_index_i, block_index_j);
   if (!blk)
     return blk; // get block failed
@@ -21,3 +31,19 @@ vil_cached_image_resource::get_block(unsigned block_index_i, unsigned block_inde
   non_const->cache_.add_block(block_index_i, block_index_j, blk);
   return blk;
 }
+
+bool
+vil_cached_image_resource::put_block(unsigned block_index_i, unsigned block_index_j, const vil_image_view_base & view)
+{
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  cache_.remove_block(block_index_i, block_index_j);
+  return bir_->put_block(block_index_i, block_index_j, view);
+}
+
+bool
+vil_cached_image_resource::put_view(const vil_image_view_base & im, unsigned i0, unsigned j0)
+{
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  cache_.clear();
+  return bir_->put_view(im, i0, j0);
+}
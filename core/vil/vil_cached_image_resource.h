@@ -5,16 +5,31 @@
 // \file
 // \brief A cached and blocked representation of the image_resource
 // \author J. L. Mundy
+//
+// The block cache is thread-safe, so several threads may read blocks from
+// one cached resource at the same time; cache hits proceed concurrently and
+// reads of the underlying resource on a miss are serialised.
+//
+// \verbatim
+//  Modifications
+//   Replaced vil_block_cache by the thread-safe vil_concurrent_block_cache
+// \endverbatim
 
+#include <cstddef>
+#include <mutex>
 #include "vil_blocked_image_resource.h"
-#include "vil_block_cache.h"
+#include "vil_concurrent_block_cache.h"
 
 class vil_cached_image_resource : public vil_blocked_image_resource
 {
 public:
-  vil_cached_image_resource(vil_blocked_image_resource_sptr bir, const unsigned cache_size)
+  //: Cache at most cache_size blocks and, if non-zero, cache_bytes bytes of bir
+  //  A cache_size of zero means that no block is cached.
+  vil_cached_image_resource(vil_blocked_image_resource_sptr bir,
+                            const unsigned cache_size,
+                            const std::size_t cache_bytes = 0)
     : bir_(bir)
-    , cache_(vil_block_cache(cache_size))
+    , cache_(cache_size, cache_bytes)
   {}
 
   ~vil_cached_image_resource() override = default;
@@ -65,11 +80,9 @@ public:
     return bir_->pixel_format();
   }
 
-  inline bool
-  put_view(const vil_image_view_base & im, unsigned i0, unsigned j0) override
-  {
-    return bir_->put_view(im, i0, j0);
-  }
+  //: Put the view into the underlying resource, discarding cached blocks
+  bool
+  put_view(const vil_image_view_base & im, unsigned i0, unsigned j0) override;
 
   //: Block access
   vil_image_view_base_sptr
@@ -77,10 +90,7 @@ public:
 
   //: put the block into the resource at the indicated location
   bool
-  put_block(unsigned block_index_i, unsigned block_index_j, const vil_image_view_base & view) override
-  {
-    return bir_->put_block(block_index_i, block_index_j, view);
-  }
+  put_block(unsigned block_index_i, unsigned block_index_j, const vil_image_view_base & view) override;
 
 
   //: Extra property information
@@ -90,9 +100,18 @@ public:
     return bir_->get_property(tag, property_value);
   }
 
+  //: The block cache, e.g. to inspect hit and miss counts
+  const vil_concurrent_block_cache &
+  cache() const
+  {
+    return cache_;
+  }
+
 protected:
   vil_blocked_image_resource_sptr bir_;
-  vil_block_cache cache_;
+  vil_concurrent_block_cache cache_;
+  //: Serialises access to bir_, which need not be thread-safe
+  mutable std::mutex io_mutex_;
 };
 
 #endif // vil_cached_image_resource_h_
@@ -0,0 +1,162 @@
+// This is core/vil/vil_concurrent_block_cache.cxx
+//:
+// \file
+#include "vil_concurrent_block_cache.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil_pixel_format.h"
+
+vil_concurrent_block_cache::vil_concurrent_block_cache(unsigned max_blocks, std::size_t max_bytes, unsigned n_shards)
+  : max_blocks_(max_blocks)
+  , max_bytes_(max_bytes)
+{
+  if (n_shards == 0)
+    n_shards = 1;
+  for (unsigned s = 0; s < n_shards; ++s)
+    shards_.emplace_back(new shard);
+}
+
+std::size_t
+vil_concurrent_block_cache::block_bytes(const vil_image_view_base & blk)
+{
+  const vil_pixel_format fmt = blk.pixel_format();
+  return std::size_t(blk.ni()) * blk.nj() * blk.nplanes() * vil_pixel_format_sizeof_components(fmt) *
+         vil_pixel_format_num_components(fmt);
+}
+
+vil_concurrent_block_cache::shard &
+vil_concurrent_block_cache::shard_for(key_type key) const
+{
+  // Mix the bits so that neighbouring blocks land in different shards.
+  key *= 0x9E3779B97F4A7C15ull;
+  return *shards_[(key >> 32) % shards_.size()];
+}
+
+bool
+vil_concurrent_block_cache::over_capacity() const
+{
+  return (max_blocks_ > 0 && n_blocks_ > max_blocks_) || (max_bytes_ > 0 && n_bytes_ > max_bytes_);
+}
+
+void
+vil_concurrent_block_cache::evict_to_capacity(key_type keep)
+{
+  while (over_capacity())
+  {
+    // Find the shard whose coldest block was used longest ago.
+    shard * victim = nullptr;
+    unsigned long long oldest = 0;
+    for (auto & s : shards_)
+    {
+      std::lock_guard<std::mutex> lock(s->mutex_);
+      if (s->lru_.empty() || s->lru_.back().key_ == keep)
+        continue;
+      if (!victim || s->lru_.back().last_use_ < oldest)
+      {
+        victim = s.get();
+        oldest = s->lru_.back().last_use_;
+      }
+    }
+    if (!victim)
+      return; // only the new block is left
+    std::lock_guard<std::mutex> lock(victim->mutex_);
+    // Another thread may have used or evicted the block meanwhile; if so look again.
+    if (victim->lru_.empty() || victim->lru_.back().last_use_ != oldest || victim->lru_.back().key_ == keep)
+      continue;
+    const entry & e = victim->lru_.back();
+    victim->bytes_ -= e.bytes_;
+    n_bytes_ -= e.bytes_;
+    --n_blocks_;
+    victim->index_.erase(e.key_);
+    victim->lru_.pop_back();
+    ++evictions_;
+  }
+}
+
+bool
+vil_concurrent_block_cache::add_block(unsigned block_index_i,
+                                      unsigned block_index_j,
+                                      const vil_image_view_base_sptr & blk)
+{
+  if (!blk)
+    return false;
+  const key_type key = make_key(block_index_i, block_index_j);
+  const std::size_t bytes = block_bytes(*blk);
+  if (max_bytes_ > 0 && bytes > max_bytes_)
+    return false;
+
+  {
+    shard & s = shard_for(key);
+    std::lock_guard<std::mutex> lock(s.mutex_);
+    auto it = s.index_.find(key);
+    if (it != s.index_.end())
+    {
+      s.bytes_ -= it->second->bytes_;
+      n_bytes_ -= it->second->bytes_;
+      --n_blocks_;
+      s.lru_.erase(it->second);
+      s.index_.erase(it);
+    }
+    s.lru_.push_front(entry{ key, blk, bytes, ++use_clock_ });
+    s.index_[key] = s.lru_.begin();
+    s.bytes_ += bytes;
+    n_bytes_ += bytes;
+    ++n_blocks_;
+  }
+  evict_to_capacity(key);
+  return true;
+}
+
+bool
+vil_concurrent_block_cache::get_block(unsigned block_index_i,
+                                      unsigned block_index_j,
+                                      vil_image_view_base_sptr & blk) const
+{
+  const key_type key = make_key(block_index_i, block_index_j);
+  shard & s = shard_for(key);
+  std::lock_guard<std::mutex> lock(s.mutex_);
+  auto it = s.index_.find(key);
+  if (it == s.index_.end())
+  {
+    ++misses_;
+    return false;
+  }
+  // move to the front of the recency list; iterators stay valid
+  s.lru_.splice(s.lru_.begin(), s.lru_, it->second);
+  it->second->last_use_ = ++use_clock_;
+  blk = it->second->blk_;
+  ++hits_;
+  return true;
+}
+
+bool
+vil_concurrent_block_cache::remove_block(unsigned block_index_i, unsigned block_index_j)
+{
+  const key_type key = make_key(block_index_i, block_index_j);
+  shard & s = shard_for(key);
+  std::lock_guard<std::mutex> lock(s.mutex_);
+  auto it = s.index_.find(key);
+  if (it == s.index_.end())
+    return false;
+  s.bytes_ -= it->second->bytes_;
+  n_bytes_ -= it->second->bytes_;
+  --n_blocks_;
+  s.lru_.erase(it->second);
+  s.index_.erase(it);
+  return true;
+}
+
+void
+vil_concurrent_block_cache::clear()
+{
+  for (auto & s : shards_)
+  {
+    std::lock_guard<std::mutex> lock(s->mutex_);
+    n_blocks_ -= s->lru_.size();
+    n_bytes_ -= s->bytes_;
+    s->lru_.clear();
+    s->index_.clear();
+    s->bytes_ = 0;
+  }
+}
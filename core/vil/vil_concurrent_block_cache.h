@@ -0,0 +1,173 @@
+// This is core/vil/vil_concurrent_block_cache.h
+#ifndef vil_concurrent_block_cache_h_
+#define vil_concurrent_block_cache_h_
+//:
+// \file
+// \brief A thread-safe block cache with least-recently-used eviction
+//
+// Blocks are keyed by their (i,j) block index and spread over a number of
+// shards, each with its own lock, hash map and recency list, so concurrent
+// readers of different blocks rarely contend.  Lookup and insertion are
+// O(1); each eviction compares the coldest block of every shard, so costs
+// O(number of shards).
+//
+// Capacity may be given as a number of blocks, a number of bytes, or both;
+// a limit of zero means "unlimited".  The limits apply to the cache as a
+// whole, not to each shard, so a small budget is not diluted by sharding.
+// When the cache is full the least recently used block over all shards is
+// evicted; only one shard lock is ever held at a time.
+//
+// Hit and miss counts are kept so that cache sizing can be tuned.
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vil_image_view_base.h"
+
+class vil_concurrent_block_cache
+{
+public:
+  //: Create a cache holding at most max_blocks blocks and max_bytes bytes of pixel data.
+  //  Zero means no limit, although at least one of the two should be set.
+  explicit vil_concurrent_block_cache(unsigned max_blocks, std::size_t max_bytes = 0, unsigned n_shards = 16);
+
+  //: Add a block, replacing any block already cached at the same index.
+  //  Least recently used blocks are evicted to make room.
+  //  Returns false if the block alone exceeds the byte limit.
+  bool
+  add_block(unsigned block_index_i, unsigned block_index_j, const vil_image_view_base_sptr & blk);
+
+  //: Retrieve a block, marking it as most recently used.
+  bool
+  get_block(unsigned block_index_i, unsigned block_index_j, vil_image_view_base_sptr & blk) const;
+
+  //: Remove a block if it is cached.  Returns true if it was.
+  bool
+  remove_block(unsigned block_index_i, unsigned block_index_j);
+
+  //: Remove all blocks (the hit and miss counts are kept).
+  void
+  clear();
+
+  //: Maximum number of blocks (0 = unlimited)
+  unsigned
+  block_capacity() const
+  {
+    return max_blocks_;
+  }
+
+  //: Maximum number of bytes of pixel data (0 = unlimited)
+  std::size_t
+  byte_capacity() const
+  {
+    return max_bytes_;
+  }
+
+  //: Number of shards the cache is split into
+  unsigned
+  n_shards() const
+  {
+    return unsigned(shards_.size());
+  }
+
+  //: Number of blocks currently held
+  std::size_t
+  n_blocks() const
+  {
+    return n_blocks_;
+  }
+
+  //: Bytes of pixel data currently held
+  std::size_t
+  n_bytes() const
+  {
+    return n_bytes_;
+  }
+
+  //: Number of successful get_block calls
+  unsigned long
+  n_hits() const
+  {
+    return hits_;
+  }
+
+  //: Number of unsuccessful get_block calls
+  unsigned long
+  n_misses() const
+  {
+    return misses_;
+  }
+
+  //: Number of blocks evicted to make room for others
+  unsigned long
+  n_evictions() const
+  {
+    return evictions_;
+  }
+
+  //: Bytes of pixel data in a view, as charged against the byte capacity
+  static std::size_t
+  block_bytes(const vil_image_view_base & blk);
+
+private:
+  typedef unsigned long long key_type;
+
+  struct entry
+  {
+    key_type key_;
+    vil_image_view_base_sptr blk_;
+    std::size_t bytes_;
+    //: Value of use_clock_ when the block was last added or retrieved
+    mutable unsigned long long last_use_;
+  };
+
+  //: One independently locked partition of the cache.
+  //  lru_ holds the most recently used entry at the front.
+  struct shard
+  {
+    std::mutex mutex_;
+    std::list<entry> lru_;
+    std::unordered_map<key_type, std::list<entry>::iterator> index_;
+    std::size_t bytes_{ 0 };
+  };
+
+  static key_type
+  make_key(unsigned i, unsigned j)
+  {
+    return (key_type(i) << 32) | key_type(j);
+  }
+
+  shard &
+  shard_for(key_type key) const;
+
+  //: True if the cache holds more than its block or byte limit
+  bool
+  over_capacity() const;
+
+  //: Evict least recently used blocks, other than keep, until within capacity
+  void
+  evict_to_capacity(key_type keep);
+
+  unsigned max_blocks_;
+  std::size_t max_bytes_;
+  std::vector<std::unique_ptr<shard>> shards_;
+
+  //: Totals over all shards, charged against the limits
+  std::atomic<std::size_t> n_blocks_{ 0 };
+  std::atomic<std::size_t> n_bytes_{ 0 };
+  mutable std::atomic<unsigned long long> use_clock_{ 0 };
+
+  mutable std::atomic<unsigned long> hits_{ 0 };
+  mutable std::atomic<unsigned long> misses_{ 0 };
+  std::atomic<unsigned long> evictions_{ 0 };
+};
+
+#endif // vil_concurrent_block_cache_h_
@@ -0,0 +1,78 @@
+// This is core/vil/vil_cpu_features.cxx
+//:
+// \file
+#include <atomic>
+#include <cstdlib>
+#include "vil_cpu_features.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+#if defined(VIL_SIMD_X86) && defined(_MSC_VER)
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
+static vil_simd_level
+vil_simd_probe()
+{
+#if defined(VIL_SIMD_X86) && defined(__GNUC__)
+  __builtin_cpu_init();
+  // __builtin_cpu_supports also checks that the OS saves the AVX registers
+  if (__builtin_cpu_supports("avx2"))
+    return vil_simd_avx2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return vil_simd_sse41;
+#elif defined(VIL_SIMD_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+  __cpuid(info, 1);
+  const bool sse41 = (info[2] & (1 << 19)) != 0;
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (osxsave && avx && max_leaf >= 7 && (_xgetbv(0) & 6) == 6)
+  {
+    __cpuidex(info, 7, 0);
+    if (info[1] & (1 << 5))
+      return vil_simd_avx2;
+  }
+  if (sse41)
+    return vil_simd_sse41;
+#endif
+  return vil_simd_none;
+}
+
+vil_simd_level
+vil_simd_detected_level()
+{
+  static const vil_simd_level level = vil_simd_probe();
+  return level;
+}
+
+//: Cap on the level in use; -1 until first read
+static std::atomic<int> vil_simd_max_level(-1);
+
+vil_simd_level
+vil_simd_active_level()
+{
+  int max_level = vil_simd_max_level.load(std::memory_order_relaxed);
+  if (max_level < 0)
+  {
+    max_level = vil_simd_avx2;
+    const char * env = std::getenv("VIL_SIMD_MAX_LEVEL");
+    if (env && *env >= '0' && *env <= '9')
+      max_level = std::atoi(env);
+    int expected = -1;
+    if (!vil_simd_max_level.compare_exchange_strong(expected, max_level))
+      max_level = expected; // somebody else got there first
+  }
+  const vil_simd_level detected = vil_simd_detected_level();
+  return max_level < int(detected) ? vil_simd_level(max_level) : detected;
+}
+
+void
+vil_simd_set_max_level(vil_simd_level level)
+{
+  vil_simd_max_level.store(int(level));
+}
@@ -0,0 +1,53 @@
+// This is core/vil/vil_cpu_features.h
+#ifndef vil_cpu_features_h_
+#define vil_cpu_features_h_
+//:
+// \file
+// \brief Run-time detection of the SIMD instruction sets available to vil
+//
+// Vectorised image kernels are compiled for several instruction sets and the
+// best one supported by the processor is chosen when they are called, so a
+// single binary runs everywhere.  The level actually used can be capped with
+// vil_simd_set_max_level() - e.g. to compare against the generic code, or to
+// work around a problem - or by setting the environment variable
+// VIL_SIMD_MAX_LEVEL to 0 (none), 1 (SSE4.1) or 2 (AVX2).
+
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+//: Defined if x86 SIMD kernels can be compiled, whatever the build's target flags.
+//  Functions containing such kernels are marked VIL_SIMD_TARGET("sse4.1")
+//  or VIL_SIMD_TARGET("avx2") and must only be called at that level.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define VIL_SIMD_X86 1
+#  define VIL_SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  define VIL_SIMD_X86 1
+#  define VIL_SIMD_TARGET(isa)
+#endif
+
+//: Instruction set levels, in increasing order of capability
+enum vil_simd_level
+{
+  vil_simd_none = 0,
+  vil_simd_sse41 = 1,
+  vil_simd_avx2 = 2
+};
+
+//: The best instruction set supported by this processor, OS and build
+vil_simd_level
+vil_simd_detected_level();
+
+//: The instruction set vectorised kernels should use now
+//  This is the detected level, limited by vil_simd_set_max_level().
+vil_simd_level
+vil_simd_active_level();
+
+//: Limit the instruction set used by vectorised kernels.
+//  vil_simd_none makes all kernels use the generic C++ code.
+//  Safe to call at any time, from any thread.
+void
+vil_simd_set_max_level(vil_simd_level level);
+
+#endif // vil_cpu_features_h_
@@ -0,0 +1,176 @@
+// This is core/vil/vil_mapped_image_resource.cxx
+//:
+// \file
+#include <complex>
+#include <cstring>
+#include "vil_mapped_image_resource.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil_image_view.h"
+#include "vil_copy.h"
+#include "vil_load.h"
+#include "vil_property.h"
+#include "vil_exception.h"
+
+vil_mapped_image_resource::vil_mapped_image_resource(const std::string & filename,
+                                                     unsigned ni,
+                                                     unsigned nj,
+                                                     unsigned nplanes,
+                                                     vil_pixel_format format,
+                                                     std::size_t offset,
+                                                     std::ptrdiff_t istep,
+                                                     std::ptrdiff_t jstep,
+                                                     std::ptrdiff_t planestep,
+                                                     vil_mapped_memory_chunk::access_pattern pattern)
+  : ni_(ni)
+  , nj_(nj)
+  , nplanes_(nplanes)
+  , format_(format)
+  , offset_(offset)
+  , istep_(istep)
+  , jstep_(jstep)
+  , planestep_(planestep)
+{
+  if (ni == 0 || nj == 0 || nplanes == 0 || istep <= 0 || jstep <= 0 || planestep <= 0 ||
+      vil_pixel_format_num_components(format) != 1 || format == VIL_PIXEL_FORMAT_BOOL)
+    return;
+  // one past the last component that any view can reach
+  const std::size_t n_components = std::size_t((ni - 1) * istep + (nj - 1) * jstep + (nplanes - 1) * planestep + 1);
+  chunk_ = new vil_mapped_memory_chunk(
+    filename, offset, n_components * vil_pixel_format_sizeof_components(format), format, pattern);
+  chunk_sptr_ = chunk_;
+}
+
+vil_image_view_base_sptr
+vil_mapped_image_resource::get_view(unsigned i0, unsigned n_i, unsigned j0, unsigned n_j) const
+{
+  if (!is_valid() || i0 + n_i > ni_ || j0 + n_j > nj_)
+    return nullptr;
+  const std::ptrdiff_t start = i0 * istep_ + j0 * jstep_;
+  switch (format_)
+  {
+#define GET_VIEW_CASE(FORMAT, T)                                                                             \
+  case FORMAT:                                                                                               \
+    return new vil_image_view<T>(                                                                            \
+      chunk_sptr_, static_cast<const T *>(chunk_->const_data()) + start, n_i, n_j, nplanes_, istep_, jstep_, planestep_)
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_BYTE, vxl_byte);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_SBYTE, vxl_sbyte);
+#if VXL_HAS_INT_64
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_64, vxl_uint_64);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_INT_64, vxl_int_64);
+#endif
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_32, vxl_uint_32);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_INT_32, vxl_int_32);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_16, vxl_uint_16);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_INT_16, vxl_int_16);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_FLOAT, float);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_DOUBLE, double);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_COMPLEX_FLOAT, std::complex<float>);
+    GET_VIEW_CASE(VIL_PIXEL_FORMAT_COMPLEX_DOUBLE, std::complex<double>);
+#undef GET_VIEW_CASE
+    default:
+      return nullptr;
+  }
+}
+
+vil_image_view_base_sptr
+vil_mapped_image_resource::get_copy_view(unsigned i0, unsigned n_i, unsigned j0, unsigned n_j) const
+{
+  vil_image_view_base_sptr view = get_view(i0, n_i, j0, n_j);
+  if (!view)
+    return view;
+  switch (format_)
+  {
+#define COPY_VIEW_CASE(FORMAT, T) \
+  case FORMAT:                    \
+    return new vil_image_view<T>(vil_copy_deep(static_cast<const vil_image_view<T> &>(*view)))
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_BYTE, vxl_byte);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_SBYTE, vxl_sbyte);
+#if VXL_HAS_INT_64
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_64, vxl_uint_64);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_INT_64, vxl_int_64);
+#endif
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_32, vxl_uint_32);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_INT_32, vxl_int_32);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_UINT_16, vxl_uint_16);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_INT_16, vxl_int_16);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_FLOAT, float);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_DOUBLE, double);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_COMPLEX_FLOAT, std::complex<float>);
+    COPY_VIEW_CASE(VIL_PIXEL_FORMAT_COMPLEX_DOUBLE, std::complex<double>);
+#undef COPY_VIEW_CASE
+    default:
+      return nullptr;
+  }
+}
+
+bool
+vil_mapped_image_resource::put_view(const vil_image_view_base & /*im*/, unsigned /*i0*/, unsigned /*j0*/)
+{
+  vil_exception_warning(vil_exception_unsupported_operation("vil_mapped_image_resource::put_view"));
+  return false;
+}
+
+bool
+vil_mapped_image_resource::get_property(const char * tag, void * value) const
+{
+  if (std::strcmp(vil_property_read_only, tag) == 0)
+    return true;
+  if (std::strcmp(vil_property_raw_layout, tag) == 0 && is_valid())
+  {
+    if (value)
+    {
+      auto * layout = static_cast<std::ptrdiff_t *>(value);
+      layout[0] = std::ptrdiff_t(offset_);
+      layout[1] = istep_;
+      layout[2] = jstep_;
+      layout[3] = planestep_;
+    }
+    return true;
+  }
+  return false;
+}
+
+void
+vil_mapped_image_resource::advise(vil_mapped_memory_chunk::access_pattern pattern)
+{
+  if (chunk_)
+    chunk_->advise(pattern);
+}
+
+void
+vil_mapped_image_resource::prefetch(unsigned i0, unsigned n_i, unsigned j0, unsigned n_j) const
+{
+  if (!is_valid() || n_i == 0 || n_j == 0 || i0 + n_i > ni_ || j0 + n_j > nj_)
+    return;
+  const std::size_t sz = vil_pixel_format_sizeof_components(format_);
+  const std::ptrdiff_t first = i0 * istep_ + j0 * jstep_;
+  const std::ptrdiff_t span = (n_i - 1) * istep_ + (n_j - 1) * jstep_ + 1;
+  if (planestep_ < span) // interleaved planes: one range covers them all
+    chunk_->prefetch(std::size_t(first) * sz, std::size_t(span + (nplanes_ - 1) * planestep_) * sz);
+  else
+    for (unsigned p = 0; p < nplanes_; ++p)
+      chunk_->prefetch(std::size_t(first + p * planestep_) * sz, std::size_t(span) * sz);
+}
+
+vil_image_resource_sptr
+vil_load_mapped_image_resource(const char * filename, vil_mapped_memory_chunk::access_pattern pattern)
+{
+  vil_image_resource_sptr ir = vil_load_image_resource(filename);
+  std::ptrdiff_t layout[4];
+  if (!ir || !ir->get_property(vil_property_raw_layout, layout))
+    return ir;
+  vil_mapped_image_resource * mapped = new vil_mapped_image_resource(filename,
+                                                                     ir->ni(),
+                                                                     ir->nj(),
+                                                                     ir->nplanes(),
+                                                                     ir->pixel_format(),
+                                                                     std::size_t(layout[0]),
+                                                                     layout[1],
+                                                                     layout[2],
+                                                                     layout[3],
+                                                                     pattern);
+  vil_image_resource_sptr result = mapped;
+  return mapped->is_valid() ? result : ir;
+}
@@ -0,0 +1,137 @@
+// This is core/vil/vil_mapped_image_resource.h
+#ifndef vil_mapped_image_resource_h_
+#define vil_mapped_image_resource_h_
+//:
+// \file
+// \brief Zero-copy access to uncompressed pixel data in a file
+//
+// A vil_mapped_image_resource memory-maps the pixel data of a file and
+// returns views from get_view() which point straight into the mapping, so
+// no pixel is read from disk until it is used and nothing is copied.
+// get_copy_view() still returns a deep copy.  The mapping is copy-on-write,
+// so views may be written to, e.g. filtered in place; the pages written are
+// copied and the file is never changed.  The resource itself is read-only.
+//
+// The data may have any fixed layout, described as in vil_image_view by the
+// component steps between neighbouring pixels, rows and planes.  For
+// example, for ENVI-style raw files of ni x nj pixels and np bands:
+// \verbatim
+//   interleave   istep   jstep     planestep
+//   BSQ          1       ni        ni*nj
+//   BIL          1       ni*np     ni
+//   BIP          np      ni*np     1
+// \endverbatim
+// The data must already be in the machine's byte order.
+//
+// vil_load_mapped_image_resource() opens any file whose format reports a
+// vil_property_raw_layout (binary PNM, VIFF and MIT files in native byte
+// order) through a mapping, and falls back to the normal loader otherwise.
+
+#include <cstddef>
+#include <string>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vil_image_resource.h"
+#include "vil_mapped_memory_chunk.h"
+
+class vil_mapped_image_resource : public vil_image_resource
+{
+public:
+  //: Map the pixel data of filename.
+  //  The pixel (0,0) of plane 0 starts at byte offset; steps are in
+  //  components of the given (scalar) pixel format and must be positive.
+  //  Check is_valid() before use.
+  vil_mapped_image_resource(const std::string & filename,
+                            unsigned ni,
+                            unsigned nj,
+                            unsigned nplanes,
+                            vil_pixel_format format,
+                            std::size_t offset,
+                            std::ptrdiff_t istep,
+                            std::ptrdiff_t jstep,
+                            std::ptrdiff_t planestep,
+                            vil_mapped_memory_chunk::access_pattern pattern = vil_mapped_memory_chunk::access_normal);
+
+  ~vil_mapped_image_resource() override = default;
+
+  //: True if the file was mapped successfully
+  bool
+  is_valid() const
+  {
+    return chunk_ && chunk_->is_mapped();
+  }
+
+  unsigned
+  nplanes() const override
+  {
+    return nplanes_;
+  }
+  unsigned
+  ni() const override
+  {
+    return ni_;
+  }
+  unsigned
+  nj() const override
+  {
+    return nj_;
+  }
+  enum vil_pixel_format
+  pixel_format() const override
+  {
+    return format_;
+  }
+
+  //: A view pointing directly into the mapped file. No pixels are copied.
+  vil_image_view_base_sptr
+  get_view(unsigned i0, unsigned ni, unsigned j0, unsigned nj) const override;
+
+  //: A deep copy of a section of the image
+  vil_image_view_base_sptr
+  get_copy_view(unsigned i0, unsigned ni, unsigned j0, unsigned nj) const override;
+
+  //: The file is never written to, so this always fails.
+  bool
+  put_view(const vil_image_view_base & im, unsigned i0, unsigned j0) override;
+
+  //: Reports vil_property_read_only and vil_property_raw_layout
+  bool
+  get_property(const char * tag, void * property_value = nullptr) const override;
+
+  //: Change the paging hint for the whole mapping
+  void
+  advise(vil_mapped_memory_chunk::access_pattern pattern);
+
+  //: Ask the kernel to start reading the rows covering a region
+  void
+  prefetch(unsigned i0, unsigned ni, unsigned j0, unsigned nj) const;
+
+  //: The underlying mapping
+  const vil_memory_chunk_sptr &
+  memory_chunk() const
+  {
+    return chunk_sptr_;
+  }
+
+private:
+  unsigned ni_, nj_, nplanes_;
+  vil_pixel_format format_;
+  std::size_t offset_;
+  std::ptrdiff_t istep_, jstep_, planestep_;
+  vil_mapped_memory_chunk * chunk_{ nullptr };
+  vil_memory_chunk_sptr chunk_sptr_;
+};
+
+//: Open an image so that get_view() does not copy pixel data, where possible.
+//  If the file's format reports vil_property_raw_layout, a
+//  vil_mapped_image_resource is returned.  Otherwise (compressed or
+//  byte-swapped data, or no mmap support) the result of
+//  vil_load_image_resource() is returned unchanged.
+// \relatesalso vil_mapped_image_resource
+vil_image_resource_sptr
+vil_load_mapped_image_resource(
+  const char * filename,
+  vil_mapped_memory_chunk::access_pattern pattern = vil_mapped_memory_chunk::access_normal);
+
+#endif // vil_mapped_image_resource_h_
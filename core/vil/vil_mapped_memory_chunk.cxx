@@ -0,0 +1,164 @@
+// This is core/vil/vil_mapped_memory_chunk.cxx
+//:
+// \file
+#include "vil_mapped_memory_chunk.h"
+#include <utility>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+#if !defined(_WIN32)
+#  define VIL_MAPPED_MEMORY_CHUNK_POSIX 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#ifdef VIL_MAPPED_MEMORY_CHUNK_POSIX
+static int
+vil_mapped_memory_chunk_advice(vil_mapped_memory_chunk::access_pattern pattern)
+{
+  switch (pattern)
+  {
+    case vil_mapped_memory_chunk::access_sequential:
+      return MADV_SEQUENTIAL;
+    case vil_mapped_memory_chunk::access_random:
+      return MADV_RANDOM;
+    default:
+      return MADV_NORMAL;
+  }
+}
+#endif
+
+vil_mapped_memory_chunk::vil_mapped_memory_chunk(const std::string & filename,
+                                                 std::size_t offset,
+                                                 std::size_t length,
+                                                 vil_pixel_format pixel_form,
+                                                 access_pattern pattern)
+{
+  pixel_format_ = pixel_form;
+#ifdef VIL_MAPPED_MEMORY_CHUNK_POSIX
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < offset ||
+      (length > 0 && std::size_t(st.st_size) - offset < length))
+  {
+    ::close(fd);
+    return;
+  }
+  if (length == 0)
+    length = std::size_t(st.st_size) - offset;
+  if (length == 0)
+  {
+    ::close(fd);
+    return;
+  }
+
+  // mmap offsets must be page aligned
+  const std::size_t page = std::size_t(::sysconf(_SC_PAGESIZE));
+  const std::size_t aligned = offset - offset % page;
+  map_offset_ = offset - aligned;
+  map_length_ = length + map_offset_;
+  // Private and writable: pages written to are copied, the file is never changed
+  void * p = ::mmap(nullptr, map_length_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, off_t(aligned));
+  ::close(fd); // the mapping keeps its own reference to the file
+  if (p == MAP_FAILED)
+  {
+    map_length_ = map_offset_ = 0;
+    return;
+  }
+  map_base_ = p;
+  size_ = length;
+  advise(pattern);
+#else
+  (void)filename;
+  (void)offset;
+  (void)length;
+  (void)pattern;
+#endif
+}
+
+vil_mapped_memory_chunk::vil_mapped_memory_chunk(std::shared_ptr<void> owner,
+                                                 void * data,
+                                                 std::size_t size,
+                                                 vil_pixel_format pixel_form)
+  : owner_(std::move(owner))
+  , shared_data_(data)
+{
+  pixel_format_ = pixel_form;
+  size_ = size;
+}
+
+vil_mapped_memory_chunk::~vil_mapped_memory_chunk() { unmap(); }
+
+void
+vil_mapped_memory_chunk::unmap()
+{
+#ifdef VIL_MAPPED_MEMORY_CHUNK_POSIX
+  if (map_base_)
+    ::munmap(map_base_, map_length_);
+#endif
+  map_base_ = nullptr;
+  map_length_ = map_offset_ = 0;
+  owner_.reset();
+  shared_data_ = nullptr;
+  size_ = 0;
+}
+
+void *
+vil_mapped_memory_chunk::data()
+{
+  return const_data();
+}
+
+void *
+vil_mapped_memory_chunk::const_data() const
+{
+  if (owner_)
+    return shared_data_;
+  return map_base_ ? static_cast<char *>(map_base_) + map_offset_ : data_;
+}
+
+void
+vil_mapped_memory_chunk::set_size(unsigned long n, vil_pixel_format pixel_form)
+{
+  if (size_ == n && pixel_format_ == pixel_form)
+    return;
+  if (is_mapped())
+    unmap();
+  vil_memory_chunk::set_size(n, pixel_form);
+  pixel_format_ = pixel_form;
+}
+
+void
+vil_mapped_memory_chunk::advise(access_pattern pattern)
+{
+#ifdef VIL_MAPPED_MEMORY_CHUNK_POSIX
+  if (map_base_)
+    ::madvise(map_base_, map_length_, vil_mapped_memory_chunk_advice(pattern));
+#else
+  (void)pattern;
+#endif
+}
+
+void
+vil_mapped_memory_chunk::prefetch(std::size_t offset, std::size_t length) const
+{
+#ifdef VIL_MAPPED_MEMORY_CHUNK_POSIX
+  if (!map_base_ || offset >= size_)
+    return;
+  if (length > size_ - offset)
+    length = size_ - offset;
+  // madvise needs a page-aligned start address
+  const std::size_t page = std::size_t(::sysconf(_SC_PAGESIZE));
+  std::size_t start = map_offset_ + offset;
+  const std::size_t aligned = start - start % page;
+  ::madvise(static_cast<char *>(map_base_) + aligned, length + (start - aligned), MADV_WILLNEED);
+#else
+  (void)offset;
+  (void)length;
+#endif
+}
@@ -0,0 +1,104 @@
+// This is core/vil/vil_mapped_memory_chunk.h
+#ifndef vil_mapped_memory_chunk_h_
+#define vil_mapped_memory_chunk_h_
+//:
+// \file
+// \brief A vil_memory_chunk whose data is a private memory mapping of part of a file
+//
+// Image views built on a vil_mapped_memory_chunk read pixels directly from
+// the page cache: no copy is made, pages are only loaded when touched, and
+// several processes mapping the same file share the physical memory.
+//
+// The mapping is private and copy-on-write: pages written through data()
+// are copied on first write, and the file itself is never changed.
+// Mapping is implemented with mmap() on POSIX systems; elsewhere (and if
+// the file cannot be mapped) is_mapped() returns false and the chunk is
+// empty, so callers should fall back to reading the file.
+//
+// A chunk can also refer to memory mapped by someone else, e.g. by a
+// vsl_b_imapped_fstream for pixels loaded in place, which it keeps alive.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vil_memory_chunk.h"
+
+class vil_mapped_memory_chunk : public vil_memory_chunk
+{
+public:
+  //: Expected access pattern, passed to the kernel as a paging hint.
+  enum access_pattern
+  {
+    access_normal,
+    //: Pages will be read in order; read ahead aggressively.
+    access_sequential,
+    //: Pages will be read in no particular order (e.g. random tiles); do not read ahead.
+    access_random
+  };
+
+  //: Map length bytes of filename, starting at byte offset.
+  //  If length is zero the rest of the file is mapped.
+  vil_mapped_memory_chunk(const std::string & filename,
+                          std::size_t offset,
+                          std::size_t length,
+                          vil_pixel_format pixel_format,
+                          access_pattern pattern = access_normal);
+
+  //: Refer to size bytes at data, in a mapping kept alive by owner.
+  //  The memory is used as is: whether it can be written depends on the mapping.
+  vil_mapped_memory_chunk(std::shared_ptr<void> owner, void * data, std::size_t size, vil_pixel_format pixel_format);
+
+  //: Unmaps the file
+  ~vil_mapped_memory_chunk() override;
+
+  //: True if the file was successfully mapped
+  bool
+  is_mapped() const
+  {
+    return map_base_ != nullptr || owner_ != nullptr;
+  }
+
+  //: Pointer to the first mapped byte (the one at the requested offset)
+  void *
+  data() override;
+
+  //: Pointer to the first mapped byte (the one at the requested offset)
+  void *
+  const_data() const override;
+
+  //: Unmap the file and allocate n bytes on the heap instead.
+  //  Nothing is done if both the size and the pixel format are unchanged.
+  void
+  set_size(unsigned long n, vil_pixel_format pixel_format) override;
+
+  //: Change the paging hint for the whole mapping
+  void
+  advise(access_pattern pattern);
+
+  //: Ask the kernel to start reading length bytes at offset (relative to data())
+  //  Useful just before processing a tile of a randomly accessed image.
+  void
+  prefetch(std::size_t offset, std::size_t length) const;
+
+private:
+  //: Page-aligned start of the mapping and its length
+  void * map_base_{ nullptr };
+  std::size_t map_length_{ 0 };
+  //: Offset of the requested data within the mapping
+  std::size_t map_offset_{ 0 };
+  //: A mapping shared with other objects, and the data in it
+  std::shared_ptr<void> owner_;
+  void * shared_data_{ nullptr };
+
+  void
+  unmap();
+
+  vil_mapped_memory_chunk(const vil_mapped_memory_chunk &) = delete;
+  vil_mapped_memory_chunk &
+  operator=(const vil_mapped_memory_chunk &) = delete;
+};
+
+#endif // vil_mapped_memory_chunk_h_
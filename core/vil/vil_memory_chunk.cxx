@@ -35,7 +35,7 @@ vil_memory_chunk::vil_memory_chunk(const vil_memory_chunk & d)
   , pixel_format_(d.pixel_format_)
   , ref_count_(0)
 {
-  std::memcpy(data_, d.data_, size_);
+  std::memcpy(data_, d.const_data(), size_);
 }
 
 //: Assignment operator
@@ -46,7 +46,7 @@ vil_memory_chunk::operator=(const vil_memory_chunk & d)
     return *this;
 
   set_size(d.size(), d.pixel_format());
-  std::memcpy(data_, d.data_, size_);
+  std::memcpy(data_, d.const_data(), size_);
   return *this;
 }
 
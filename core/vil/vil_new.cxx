@@ -211,9 +211,11 @@ vil_new_blocked_image_facade(const vil_image_resource_sptr & src, unsigned size_
 
 
 vil_blocked_image_resource_sptr
-vil_new_cached_image_resource(const vil_blocked_image_resource_sptr & bir, const unsigned cache_size)
+vil_new_cached_image_resource(const vil_blocked_image_resource_sptr & bir,
+                              const unsigned cache_size,
+                              const std::size_t cache_bytes)
 {
-  return new vil_cached_image_resource(bir, cache_size);
+  return new vil_cached_image_resource(bir, cache_size, cache_bytes);
 }
 
 vil_pyramid_image_resource_sptr
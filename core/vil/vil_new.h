@@ -20,6 +20,7 @@
 //   30 Mar 2007 Peter Vanroose- Removed deprecated vil_new_image_view_j_i_plane
 // \endverbatim
 
+#include <cstddef>
 #include "vil_fwd.h"
 #include "vil_image_resource.h"
 #include "vil_blocked_image_resource.h"
@@ -127,8 +128,13 @@ vil_new_blocked_image_facade(const vil_image_resource_sptr & src,
                              const unsigned size_block_i = 0,
                              const unsigned size_block_j = 0);
 //: Make a new cached resource
+//  At most cache_size blocks are cached and, if cache_bytes is non-zero,
+//  at most cache_bytes bytes of pixel data; a cache_size of zero means no
+//  caching.  The result may be read from several threads at once.
 vil_blocked_image_resource_sptr
-vil_new_cached_image_resource(const vil_blocked_image_resource_sptr & bir, const unsigned cache_size = 100);
+vil_new_cached_image_resource(const vil_blocked_image_resource_sptr & bir,
+                              const unsigned cache_size = 100,
+                              const std::size_t cache_bytes = 0);
 
 
 //: Make a new pyramid image resource for writing.
@@ -0,0 +1,161 @@
+// This is core/vil/vil_parallel_blocks.h
+#ifndef vil_parallel_blocks_h_
+#define vil_parallel_blocks_h_
+//:
+// \file
+// \brief Drivers which run per-block or per-tile work on a vnl_thread_pool
+//
+// Three entry points are provided:
+// - vil_parallel_for_each_block() visits every block of a
+//   vil_blocked_image_resource.
+// - vil_parallel_transform_blocks() maps each block of one blocked resource
+//   into the corresponding block of another.
+// - vil_parallel_apply_tiled() splits an in-memory view into tiles, each
+//   padded by a halo, and runs an existing whole-image filter on every tile.
+//
+// Image resources are generally not thread-safe, so all get_block() and
+// put_block() calls on the resources are serialised; only the user's
+// processing runs concurrently.  Every block or tile writes a disjoint part
+// of the output, so results are identical for any thread count.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vil_blocked_image_resource.h"
+#include "vil_image_view.h"
+#include "vil_crop.h"
+#include "vil_copy.h"
+#include "vnl/vnl_thread_pool.h"
+
+//: Call func(bi, bj, block) for every block of src, in parallel.
+//  func must be callable as bool(unsigned, unsigned, const vil_image_view_base_sptr &)
+//  and may be called concurrently from several threads.
+//  Blocks are read from src one at a time.
+//  \return false if a block could not be read or func returned false.
+template <class F>
+bool
+vil_parallel_for_each_block(const vil_blocked_image_resource_sptr & src,
+                            F func,
+                            vnl_thread_pool & pool = vnl_thread_pool::default_pool())
+{
+  if (!src)
+    return false;
+  const unsigned nbi = src->n_block_i(), nbj = src->n_block_j();
+  std::mutex io_mutex;
+  std::atomic<bool> ok(true);
+  pool.parallel_for(std::size_t(nbi) * nbj, [&](std::size_t k) {
+    const unsigned bi = unsigned(k % nbi), bj = unsigned(k / nbi);
+    vil_image_view_base_sptr blk;
+    {
+      std::lock_guard<std::mutex> lock(io_mutex);
+      blk = src->get_block(bi, bj);
+    }
+    if (!blk || !func(bi, bj, blk))
+      ok = false;
+  });
+  return ok;
+}
+
+//: Set each block of dest to func(bi, bj, block of src), in parallel.
+//  func must be callable as
+//  vil_image_view_base_sptr(unsigned, unsigned, const vil_image_view_base_sptr &)
+//  and may be called concurrently.  src and dest must have the same block
+//  layout; they may be the same resource.
+//  \return false if the layouts differ, or any read, func or write failed.
+template <class F>
+bool
+vil_parallel_transform_blocks(const vil_blocked_image_resource_sptr & src,
+                              const vil_blocked_image_resource_sptr & dest,
+                              F func,
+                              vnl_thread_pool & pool = vnl_thread_pool::default_pool())
+{
+  if (!src || !dest || src->n_block_i() != dest->n_block_i() || src->n_block_j() != dest->n_block_j())
+    return false;
+  const unsigned nbi = src->n_block_i(), nbj = src->n_block_j();
+  std::mutex io_mutex;
+  std::atomic<bool> ok(true);
+  pool.parallel_for(std::size_t(nbi) * nbj, [&](std::size_t k) {
+    const unsigned bi = unsigned(k % nbi), bj = unsigned(k / nbi);
+    vil_image_view_base_sptr blk;
+    {
+      std::lock_guard<std::mutex> lock(io_mutex);
+      blk = src->get_block(bi, bj);
+    }
+    if (!blk)
+    {
+      ok = false;
+      return;
+    }
+    vil_image_view_base_sptr out = func(bi, bj, blk);
+    if (!out)
+    {
+      ok = false;
+      return;
+    }
+    std::lock_guard<std::mutex> lock(io_mutex);
+    if (!dest->put_block(bi, bj, *out))
+      ok = false;
+  });
+  return ok;
+}
+
+//: Range [lo,hi) of a tile [t0,t0+n) grown by halo on each side within [0,size).
+//  A tile clipped by the image edge borrows extra context from the interior,
+//  so the range is never shorter than min(size, n + 2*halo).
+inline void
+vil_parallel_tile_extent(unsigned t0, unsigned n, unsigned halo, unsigned size, unsigned & lo, unsigned & hi)
+{
+  lo = t0 > halo ? t0 - halo : 0;
+  hi = std::min(size, t0 + n + halo);
+  const unsigned w = std::min(size, n + 2 * halo);
+  if (hi - lo < w)
+  {
+    if (lo == 0)
+      hi = w;
+    else
+      lo = hi - w;
+  }
+}
+
+//: Apply a whole-image filter to src tile by tile, in parallel.
+//  The image is divided into tiles of tile_ni x tile_nj pixels.  Each tile
+//  is grown by halo pixels on every side (see vil_parallel_tile_extent), passed to
+//  filter(const vil_image_view<srcT> &, vil_image_view<destT> &), and the
+//  centre of the filtered tile is copied into dest.
+//
+//  If halo is at least the radius of the filter's support (summed over
+//  all of its passes) the result is exactly that of filter(src, dest).
+//  dest is resized to src's size, and must not share memory with src.
+template <class srcT, class destT, class F>
+void
+vil_parallel_apply_tiled(const vil_image_view<srcT> & src,
+                         vil_image_view<destT> & dest,
+                         unsigned halo,
+                         F filter,
+                         vnl_thread_pool & pool = vnl_thread_pool::default_pool(),
+                         unsigned tile_ni = 256,
+                         unsigned tile_nj = 256)
+{
+  dest.set_size(src.ni(), src.nj(), src.nplanes());
+  if (src.ni() == 0 || src.nj() == 0 || tile_ni == 0 || tile_nj == 0)
+    return;
+  const unsigned nti = (src.ni() + tile_ni - 1) / tile_ni;
+  const unsigned ntj = (src.nj() + tile_nj - 1) / tile_nj;
+  pool.parallel_for(std::size_t(nti) * ntj, [&](std::size_t k) {
+    const unsigned i0 = unsigned(k % nti) * tile_ni, j0 = unsigned(k / nti) * tile_nj;
+    const unsigned ni = std::min(tile_ni, src.ni() - i0), nj = std::min(tile_nj, src.nj() - j0);
+    unsigned hi0, hi1, hj0, hj1;
+    vil_parallel_tile_extent(i0, ni, halo, src.ni(), hi0, hi1);
+    vil_parallel_tile_extent(j0, nj, halo, src.nj(), hj0, hj1);
+
+    vil_image_view<destT> tile_dest;
+    filter(vil_crop(src, hi0, hi1 - hi0, hj0, hj1 - hj0), tile_dest);
+    vil_copy_to_window(vil_crop(tile_dest, i0 - hi0, ni, j0 - hj0, nj), dest, i0, j0);
+  });
+}
+
+#endif // vil_parallel_blocks_h_
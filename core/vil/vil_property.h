@@ -78,6 +78,14 @@
 //: Block size in rows
 #define vil_property_size_block_j "size_block_j"
 
+//: Layout of pixel data stored uncompressed, in the machine's byte order.
+// Only implemented by file images whose pixels can be used in place, e.g.
+// by memory-mapping the file (see vil_mapped_image_resource).  The value
+// is the byte offset in the file of pixel (0,0) in plane 0, followed by
+// the istep, jstep and planestep in components, as in vil_image_view.
+// Type is std::ptrdiff_t[4].
+#define vil_property_raw_layout "raw_layout"
+
 //: true if image resource is a pyramid image
 #define vil_property_pyramid "pyramid"
 
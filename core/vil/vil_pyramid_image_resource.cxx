@@ -1,5 +1,8 @@
 // This is core/vil/vil_pyramid_image_resource.cxx
+#include <atomic>
 #include <cstring>
+#include <iostream>
+#include <string>
 #include <vector>
 #include "vil_pyramid_image_resource.h"
 //:
@@ -10,11 +13,13 @@
 #endif
 #include "vil/vil_property.h"
 #include "vil/vil_convert.h"
+#include "vil/vil_crop.h"
 #include "vil/vil_blocked_image_resource.h"
 #include "vil/vil_blocked_image_facade.h"
 #include "vil/vil_image_view.h"
 #include "vil/vil_new.h"
 #include "vil/vil_load.h"
+#include "vnl/vnl_thread_pool.h"
 
 
 vil_pyramid_image_resource::vil_pyramid_image_resource() = default;
@@ -355,3 +360,217 @@ vil_pyramid_image_resource::decimate(const vil_image_resource_sptr & resc, const
   vil_image_resource_sptr temp = vil_load_image_resource(filename);
   return temp;
 }
+
+//: The state of one output level while a pyramid is streamed
+template <class T>
+struct vil_pyramid_stream_level
+{
+  vil_blocked_image_resource_sptr resc;
+  //: One row of blocks, padded to a whole number of blocks
+  vil_image_view<T> strip;
+  unsigned int rows_in_strip{ 0 };
+  unsigned int block_row{ 0 };
+  //: Complete rows of blocks waiting to be written
+  std::vector<vil_image_view<T>> full_strips;
+  unsigned int first_full_row{ 0 };
+  //: A row of the level below, waiting for the row that pairs with it
+  vil_image_view<T> pending;
+  bool has_pending{ false };
+};
+
+//: Queue the buffered row of blocks of a level for writing and start a new one
+template <class T>
+static void
+vil_pyramid_queue_strip(vil_pyramid_stream_level<T> & lev)
+{
+  if (lev.full_strips.empty())
+    lev.first_full_row = lev.block_row;
+  lev.full_strips.push_back(lev.strip);
+  lev.strip = vil_image_view<T>(lev.strip.ni(), lev.strip.nj(), lev.strip.nplanes());
+  lev.strip.fill(T(0));
+  lev.rows_in_strip = 0;
+  ++lev.block_row;
+}
+
+//: Write the queued rows of blocks of all levels, one level per task
+//  Each level is a separate resource, so the levels are written concurrently.
+template <class T>
+static bool
+vil_pyramid_write_strips(std::vector<vil_pyramid_stream_level<T>> & levels, vnl_thread_pool & pool)
+{
+  std::vector<std::size_t> ready;
+  for (std::size_t k = 0; k < levels.size(); ++k)
+    if (!levels[k].full_strips.empty())
+      ready.push_back(k);
+  std::atomic<bool> ok(true);
+  pool.parallel_for(ready.size(), [&](std::size_t t) {
+    vil_pyramid_stream_level<T> & lev = levels[ready[t]];
+    const unsigned int sbi = lev.resc->size_block_i(), sbj = lev.resc->size_block_j();
+    for (std::size_t s = 0; s < lev.full_strips.size() && ok; ++s)
+      for (unsigned int bi = 0; bi < lev.resc->n_block_i(); ++bi)
+        if (!lev.resc->put_block(
+              bi, lev.first_full_row + unsigned(s), vil_crop(lev.full_strips[s], bi * sbi, sbi, 0, sbj)))
+        {
+          ok = false;
+          break;
+        }
+    lev.full_strips.clear();
+  });
+  return ok;
+}
+
+//: Feed one row of level k into the level above it, cascading up the pyramid
+//  Rows are combined in pairs; the averaging is done in float, as in blocked_decimate().
+template <class T>
+static void
+vil_pyramid_push_row(std::vector<vil_pyramid_stream_level<T>> & levels, std::size_t k, const vil_image_view<T> & row)
+{
+  vil_pyramid_stream_level<T> & lev = levels[k];
+  if (!lev.has_pending)
+  {
+    lev.pending.deep_copy(row);
+    lev.has_pending = true;
+    return;
+  }
+  lev.has_pending = false;
+  const vil_image_view<T> & r0 = lev.pending;
+  const unsigned int n_in = r0.ni(), n_out = lev.resc->ni(), np = r0.nplanes();
+  vil_image_view<T> out = vil_crop(lev.strip, 0, n_out, lev.rows_in_strip, 1);
+  for (unsigned int p = 0; p < np; ++p)
+    for (unsigned int i = 0; i < n_out; ++i)
+    {
+      const unsigned int i0 = 2 * i, i1 = i0 + 1 < n_in ? i0 + 1 : i0;
+      const float v = 0.25f * (float(r0(i0, 0, p)) + float(r0(i1, 0, p)) + float(row(i0, 0, p)) + float(row(i1, 0, p)));
+      out(i, 0, p) = static_cast<T>(v);
+    }
+  if (k + 1 < levels.size())
+    vil_pyramid_push_row(levels, k + 1, out);
+  if (++lev.rows_in_strip == lev.resc->size_block_j())
+    vil_pyramid_queue_strip(lev);
+}
+
+template <class T>
+static bool
+vil_pyramid_stream_decimate(const vil_image_resource_sptr & base,
+                            const std::vector<vil_blocked_image_resource_sptr> & resources,
+                            vnl_thread_pool & pool)
+{
+  const unsigned int np = base->nplanes();
+  std::vector<vil_pyramid_stream_level<T>> levels(resources.size());
+  unsigned int n_below = base->ni(), nj_below = base->nj();
+  for (std::size_t k = 0; k < resources.size(); ++k)
+  {
+    const vil_blocked_image_resource_sptr & r = resources[k];
+    if (!r || r->nplanes() != np || r->ni() != (n_below + 1) / 2 || r->nj() != (nj_below + 1) / 2)
+      return false;
+    levels[k].resc = r;
+    levels[k].strip.set_size(r->n_block_i() * r->size_block_i(), r->size_block_j(), np);
+    levels[k].strip.fill(T(0));
+    n_below = r->ni();
+    nj_below = r->nj();
+  }
+
+  // Read the base in bands of whole block rows where it is blocked
+  unsigned int band = 256;
+  vil_blocked_image_resource_sptr brsc = blocked_image_resource(base);
+  if (brsc && brsc->size_block_j() > 0)
+    band = brsc->size_block_j();
+  const unsigned int ni = base->ni(), nj = base->nj();
+  for (unsigned int j0 = 0; j0 < nj; j0 += band)
+  {
+    const unsigned int nrows = j0 + band <= nj ? band : nj - j0;
+    vil_image_view<T> rows = base->get_view(0, ni, j0, nrows);
+    if (!rows)
+      return false;
+    for (unsigned int j = 0; j < nrows; ++j)
+      vil_pyramid_push_row(levels, 0, vil_crop(rows, 0, ni, j, 1));
+    if (!vil_pyramid_write_strips(levels, pool))
+      return false;
+  }
+
+  // An odd number of rows leaves one unpaired; it is paired with itself.
+  // Finishing the levels in order lets the last rows cascade upwards.
+  for (std::size_t k = 0; k < levels.size(); ++k)
+  {
+    if (levels[k].has_pending)
+    {
+      vil_image_view<T> last = levels[k].pending;
+      vil_pyramid_push_row(levels, k, last);
+    }
+    if (levels[k].rows_in_strip > 0)
+      vil_pyramid_queue_strip(levels[k]);
+  }
+  return vil_pyramid_write_strips(levels, pool);
+}
+
+bool
+vil_pyramid_image_resource::stream_decimate(const vil_image_resource_sptr & base,
+                                            const std::vector<vil_blocked_image_resource_sptr> & levels,
+                                            vnl_thread_pool & pool)
+{
+  if (!base || base->ni() == 0 || base->nj() == 0)
+    return false;
+  if (levels.empty())
+    return true;
+  switch (vil_pixel_format_component_format(base->pixel_format()))
+  {
+#define STREAM_DECIMATE_CASE(FORMAT, T) \
+  case FORMAT:                          \
+    return vil_pyramid_stream_decimate<T>(base, levels, pool)
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_BYTE, vxl_byte);
+#if VXL_HAS_INT_64
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_UINT_64, vxl_uint_64);
+#endif
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_UINT_32, vxl_uint_32);
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_UINT_16, vxl_uint_16);
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_FLOAT, float);
+    STREAM_DECIMATE_CASE(VIL_PIXEL_FORMAT_DOUBLE, double);
+#undef STREAM_DECIMATE_CASE
+    default:
+      std::cout << "unrecognized pixel format in vil_pyramid_image_resource::stream_decimate()\n";
+      return false;
+  }
+}
+
+std::vector<vil_image_resource_sptr>
+vil_pyramid_image_resource::decimate_levels(const vil_image_resource_sptr & base,
+                                            const std::vector<std::string> & filenames,
+                                            const char * format)
+{
+  std::vector<vil_image_resource_sptr> result;
+  if (!base)
+    return result;
+  unsigned int sbi = 256, sbj = 256;
+  vil_blocked_image_resource_sptr brsc = blocked_image_resource(base);
+  if (brsc)
+  {
+    sbi = brsc->size_block_i();
+    sbj = brsc->size_block_j();
+  }
+  vil_pixel_format fmt = vil_pixel_format_component_format(base->pixel_format());
+  { // scope to close the output resources
+    std::vector<vil_blocked_image_resource_sptr> levels;
+    unsigned int ni = base->ni(), nj = base->nj();
+    for (const auto & filename : filenames)
+    {
+      ni = (ni + 1) / 2;
+      nj = (nj + 1) / 2;
+      vil_blocked_image_resource_sptr lev =
+        vil_new_blocked_image_resource(filename.c_str(), ni, nj, base->nplanes(), fmt, sbi, sbj, format);
+      if (!lev)
+        return result;
+      levels.push_back(lev);
+    }
+    if (!stream_decimate(base, levels))
+      return result;
+  }
+  // reopen the levels for reading
+  for (const auto & filename : filenames)
+  {
+    vil_image_resource_sptr lev = vil_load_image_resource(filename.c_str());
+    if (!lev)
+      return std::vector<vil_image_resource_sptr>();
+    result.push_back(lev);
+  }
+  return result;
+}
@@ -8,6 +8,7 @@
 // \author J. L. Mundy
 // \date 19 March 2006
 
+#include <string>
 #include <vector>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
@@ -17,6 +18,7 @@
 #include "vil_image_resource.h"
 #include "vil_image_resource_sptr.h"
 #include "vil_blocked_image_resource_sptr.h"
+#include "vnl/vnl_thread_pool.h"
 
 //: Representation of a pyramid resolution hierarchy; mostly pure virtual methods
 //
@@ -139,6 +141,34 @@ public:
   static vil_image_resource_sptr
   decimate(const vil_image_resource_sptr & resc, const char * filename, const char * format = "tiff");
 
+  //: Fill a whole set of pyramid levels in a single pass over the base image.
+  // levels[k] receives pyramid level k+1, which must be half the size of
+  // level k, rounded up (level 0 being the base).  Pixel (i,j) of each level
+  // is the mean of the 2x2 pixels (2i..2i+1, 2j..2j+1) of the level below,
+  // with the last row and column repeated where the level below has odd size.
+  //
+  // The base is read one band of block rows at a time and each level only
+  // buffers the rows of its own blocks completed during that band.  They are
+  // written out with put_block after each band, all levels concurrently on
+  // pool, one task per level, so each level must be a separate resource
+  // (e.g. a separate file).  Peak memory is therefore proportional to the
+  // image width times the block height, whatever the image height, so
+  // pyramids can be built for images which do not fit in memory.
+  static bool
+  stream_decimate(const vil_image_resource_sptr & base,
+                  const std::vector<vil_blocked_image_resource_sptr> & levels,
+                  vnl_thread_pool & pool = vnl_thread_pool::default_pool());
+
+  //: Create pyramid levels 1..filenames.size() from base in a single pass.
+  // Each level is a new blocked resource of the given file format with the
+  // block size of the base (256x256 if the base is not blocked), filled by
+  // stream_decimate().  Returns the levels reopened for reading, or an empty
+  // vector on failure.
+  static std::vector<vil_image_resource_sptr>
+  decimate_levels(const vil_image_resource_sptr & base,
+                  const std::vector<std::string> & filenames,
+                  const char * format = "tiff");
+
   //: for debug purposes
   virtual void
   print(const unsigned level) = 0;
@@ -12,12 +12,15 @@
 // the same change.
 
 #include "vil_image_view.h"
+#include "vnl/vnl_thread_pool.h"
 
 //: Sample grid of points in one image and place in another, using bicubic interpolation.
 //  dest_image(i,j,p) is sampled from the src_image at
 //  (x0+i.dx1+j.dx2,y0+i.dy1+j.dy2), where i=[0..n1-1], j=[0..n2-1]
 //  dest_image resized to (n1,n2,src_image.nplanes())
 //  Points outside image return zero.
+//  Sampling along the image axes (dy1==0 and dx2==0) inside the image uses
+//  cubic weights precomputed once per row and once per column.
 // \sa vil_resample_bilin
 // \relatesalso vil_image_view
 template <class sType, class dType>
@@ -40,6 +43,37 @@ template <class sType, class dType>
 void
 vil_resample_bicub(const vil_image_view<sType> & src_image, vil_image_view<dType> & dest_image, int n1, int n2);
 
+//: Sample grid of points in one image and place in another, using bicubic interpolation.
+//  As above, but the rows of dest_image are shared out between the threads
+//  of pool.  Only the common case of sampling along the image axes
+//  (dy1==0 and dx2==0) with every point inside the image is run in
+//  parallel; other grids are sampled on the calling thread.
+//  The result is identical to that of the serial version.
+// \relatesalso vil_image_view
+template <class sType, class dType>
+void
+vil_resample_bicub(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   double x0,
+                   double y0,
+                   double dx1,
+                   double dy1,
+                   double dx2,
+                   double dy2,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool);
+
+//: Resample image to a specified width (n1) and height (n2), sharing rows between the threads of pool
+// \relatesalso vil_image_view
+template <class sType, class dType>
+void
+vil_resample_bicub(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool);
+
 //: Sample grid of points in one image and place in another, using bicubic interpolation.
 //  dest_image(i,j,p) is sampled from the src_image at
 //  (x0+i.dx1+j.dx2,y0+i.dy1+j.dy2), where i=[0..n1-1], j=[0..n2-1]
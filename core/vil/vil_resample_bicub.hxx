@@ -12,7 +12,10 @@
 // the same change.
 
 #include "vil_resample_bicub.h"
+#include <algorithm>
+#include <vector>
 #include "vil_bicub_interp.h"
+#include "vnl/vnl_thread_pool.h"
 
 //: This function should not be the same in bicub and bilin
 inline bool
@@ -21,6 +24,130 @@ vil_resample_bicub_corner_in_image(double x0, double y0, const vil_image_view_ba
   return x0 >= 1 && y0 >= 1 && x0 + 2 <= image.ni() && y0 + 2 <= image.nj();
 }
 
+//: Position and cubic weights of one sample along an axis
+//  As in vil_bicub_interp_raw(), the weights are only valid if norm!=0.
+struct vil_resample_bicub_tap
+{
+  int p1;
+  double norm;
+  double w0, w1, w2, w3;
+
+  explicit vil_resample_bicub_tap(double x)
+    : p1(int(x))
+    , norm(x - p1)
+    , w0(((2 - norm) * norm - 1) * norm)
+    , w1((3 * norm - 5) * norm * norm + 2)
+    , w2(((4 - 3 * norm) * norm + 1) * norm)
+    , w3((norm - 1) * norm * norm)
+  {}
+};
+
+//: vil_bicub_interp_raw() with the weights already computed
+template <class T>
+inline double
+vil_resample_bicub_interp(const T * pix1,
+                          std::ptrdiff_t xstep,
+                          std::ptrdiff_t ystep,
+                          const vil_resample_bicub_tap & s,
+                          const vil_resample_bicub_tap & t)
+{
+  if (s.norm == 0.0 && t.norm == 0.0)
+    return pix1[0];
+
+#define vil_I(dx, dy) (pix1[(dx) * xstep + (dy) * ystep])
+
+  if (t.norm == 0.0)
+  {
+    double val = 0.0;
+    val += s.w0 * vil_I(-1, +0);
+    val += s.w1 * vil_I(+0, +0);
+    val += s.w2 * vil_I(+1, +0);
+    val += s.w3 * vil_I(+2, +0);
+    val *= 0.5;
+    return val;
+  }
+
+  if (s.norm == 0.0)
+  {
+    double val = t.w0 * vil_I(+0, -1) + t.w1 * vil_I(+0, +0) + t.w2 * vil_I(+0, +1) + t.w3 * vil_I(+0, +2);
+    val *= 0.5;
+    return val;
+  }
+
+  double xi0 = s.w0 * vil_I(-1, -1) + s.w1 * vil_I(+0, -1) + s.w2 * vil_I(+1, -1) + s.w3 * vil_I(+2, -1);
+  double xi1 = s.w0 * vil_I(-1, +0) + s.w1 * vil_I(+0, +0) + s.w2 * vil_I(+1, +0) + s.w3 * vil_I(+2, +0);
+  double xi2 = s.w0 * vil_I(-1, +1) + s.w1 * vil_I(+0, +1) + s.w2 * vil_I(+1, +1) + s.w3 * vil_I(+2, +1);
+  double xi3 = s.w0 * vil_I(-1, +2) + s.w1 * vil_I(+0, +2) + s.w2 * vil_I(+1, +2) + s.w3 * vil_I(+2, +2);
+
+#undef vil_I
+
+  return 0.25 * (xi0 * t.w0 + xi1 * t.w1 + xi2 * t.w2 + xi3 * t.w3);
+}
+
+//: Resample along the image axes (dy1==0, dx2==0) with every sample inside the image.
+//  The integer positions and cubic weights are found once per column and
+//  once per row, accumulating positions exactly as the general code does, so
+//  the result is identical to the general code.  Rows are shared out between
+//  the threads of pool, if given.
+template <class sType, class dType>
+void
+vil_resample_bicub_axis_aligned(const vil_image_view<sType> & src_image,
+                                vil_image_view<dType> & dest_image,
+                                double x0,
+                                double y0,
+                                double dx1,
+                                double dy2,
+                                int n1,
+                                int n2,
+                                vnl_thread_pool * pool)
+{
+  const unsigned np = src_image.nplanes();
+  const std::ptrdiff_t istep = src_image.istep();
+  const std::ptrdiff_t jstep = src_image.jstep();
+  const std::ptrdiff_t pstep = src_image.planestep();
+  const sType * plane0 = src_image.top_left_ptr();
+
+  dest_image.set_size(n1, n2, np);
+  if (n1 <= 0 || n2 <= 0)
+    return;
+  const std::ptrdiff_t d_istep = dest_image.istep();
+  const std::ptrdiff_t d_jstep = dest_image.jstep();
+  const std::ptrdiff_t d_pstep = dest_image.planestep();
+  dType * d_plane0 = dest_image.top_left_ptr();
+
+  std::vector<vil_resample_bicub_tap> cols, rows;
+  cols.reserve(n1);
+  rows.reserve(n2);
+  double x = x0;
+  for (int i = 0; i < n1; ++i, x += dx1)
+    cols.emplace_back(x);
+  double y = y0;
+  for (int j = 0; j < n2; ++j, y += dy2)
+    rows.emplace_back(y);
+
+  constexpr int rows_per_task = 16;
+  auto resample_rows = [&](std::size_t task) {
+    const int j_end = std::min(n2, int(task + 1) * rows_per_task);
+    for (int j = int(task) * rows_per_task; j < j_end; ++j)
+    {
+      const vil_resample_bicub_tap & t = rows[j];
+      for (unsigned p = 0; p < np; ++p)
+      {
+        const sType * row = plane0 + p * pstep + t.p1 * jstep;
+        dType * dpt = d_plane0 + p * d_pstep + j * d_jstep;
+        for (int i = 0; i < n1; ++i, dpt += d_istep)
+          *dpt = (dType)vil_resample_bicub_interp(row + cols[i].p1 * istep, istep, jstep, cols[i], t);
+      }
+    }
+  };
+  const std::size_t n_tasks = (n2 + rows_per_task - 1) / rows_per_task;
+  if (pool)
+    pool->parallel_for(n_tasks, resample_rows);
+  else
+    for (std::size_t task = 0; task < n_tasks; ++task)
+      resample_rows(task);
+}
+
 //: Sample grid of points in one image and place in another, using bicubic interpolation.
 //  dest_image(i,j,p) is sampled from the src_image at
 //  (x0+i.dx1+j.dx2,y0+i.dy1+j.dy2), where i=[0..n1-1], j=[0..n2-1]
@@ -46,6 +173,12 @@ vil_resample_bicub(const vil_image_view<sType> & src_image,
                       vil_resample_bicub_corner_in_image(
                         x0 + (n1 - 1) * dx1 + (n2 - 1) * dx2, y0 + (n1 - 1) * dy1 + (n2 - 1) * dy2, src_image);
 
+  if (all_in_image && dy1 == 0 && dx2 == 0)
+  {
+    vil_resample_bicub_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, nullptr);
+    return;
+  }
+
   const unsigned ni = src_image.ni();
   const unsigned nj = src_image.nj();
   const unsigned np = src_image.nplanes();
@@ -148,6 +281,12 @@ vil_resample_bicub_edge_extend(const vil_image_view<sType> & src_image,
                       vil_resample_bicub_corner_in_image(
                         x0 + (n1 - 1) * dx1 + (n2 - 1) * dx2, y0 + (n1 - 1) * dy1 + (n2 - 1) * dy2, src_image);
 
+  if (all_in_image && dy1 == 0 && dx2 == 0)
+  {
+    vil_resample_bicub_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, nullptr);
+    return;
+  }
+
   const unsigned ni = src_image.ni();
   const unsigned nj = src_image.nj();
   const unsigned np = src_image.nplanes();
@@ -240,6 +379,43 @@ vil_resample_bicub(const vil_image_view<sType> & src_image, vil_image_view<dType
   vil_resample_bicub(src_image, dest_image, x0, y0, dx1, dy1, dx2, dy2, n1, n2);
 }
 
+//: Sample grid of points in one image and place in another, sharing rows between threads.
+template <class sType, class dType>
+void
+vil_resample_bicub(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   double x0,
+                   double y0,
+                   double dx1,
+                   double dy1,
+                   double dx2,
+                   double dy2,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool)
+{
+  if (dy1 == 0 && dx2 == 0 && vil_resample_bicub_corner_in_image(x0, y0, src_image) &&
+      vil_resample_bicub_corner_in_image(x0 + (n1 - 1) * dx1, y0 + (n2 - 1) * dy2, src_image))
+    vil_resample_bicub_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, &pool);
+  else
+    vil_resample_bicub(src_image, dest_image, x0, y0, dx1, dy1, dx2, dy2, n1, n2);
+}
+
+//: Resample image to a specified width (n1) and height (n2), sharing rows between threads.
+template <class sType, class dType>
+void
+vil_resample_bicub(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool)
+{
+  double f = 1.0; // so sampler doesn't go off edge of image
+  double dx1 = f * (src_image.ni() - 1) * 1.0 / (n1 - 1);
+  double dy2 = f * (src_image.nj() - 1) * 1.0 / (n2 - 1);
+  vil_resample_bicub(src_image, dest_image, 0, 0, dx1, 0, 0, dy2, n1, n2, pool);
+}
+
 //: Resample image to a specified width (n1) and height (n2)
 template <class sType, class dType>
 void
@@ -271,6 +447,22 @@ vil_resample_bicub_edge_extend(const vil_image_view<sType> & src_image,
                                    int n2);                                                       \
   template void vil_resample_bicub(                                                               \
     const vil_image_view<sType> & src_image, vil_image_view<dType> & dest_image, int n1, int n2); \
+  template void vil_resample_bicub(const vil_image_view<sType> & src_image,                       \
+                                   vil_image_view<dType> & dest_image,                            \
+                                   double x0,                                                     \
+                                   double y0,                                                     \
+                                   double dx1,                                                    \
+                                   double dy1,                                                    \
+                                   double dx2,                                                    \
+                                   double dy2,                                                    \
+                                   int n1,                                                        \
+                                   int n2,                                                        \
+                                   vnl_thread_pool & pool);                                       \
+  template void vil_resample_bicub(const vil_image_view<sType> & src_image,                       \
+                                   vil_image_view<dType> & dest_image,                            \
+                                   int n1,                                                        \
+                                   int n2,                                                        \
+                                   vnl_thread_pool & pool);                                       \
   template void vil_resample_bicub_edge_extend(const vil_image_view<sType> & src_image,           \
                                                vil_image_view<dType> & dest_image,                \
                                                double x0,                                         \
@@ -12,8 +12,12 @@
 // corresponding bicub file that would likely also benefit from
 // the same change.
 
+#include <algorithm>
+#include <vector>
 #include "vil_resample_bilin.h"
 #include "vil_bilin_interp.h"
+#include "vil_resample_simd.h"
+#include "vnl/vnl_thread_pool.h"
 
 //: This function should not be the same in bicub and bilin
 inline bool
@@ -22,6 +26,91 @@ vil_resample_bilin_corner_in_image(double x0, double y0, const vil_image_view_ba
   return x0 >= 0.0 && y0 >= 0.0 && x0 + 1 <= image.ni() && y0 + 1 <= image.nj();
 }
 
+//: Resample along the image axes (dy1==0, dx2==0) with every sample inside the image.
+//  The integer positions and weights are found once per column and once per
+//  row, accumulating positions exactly as the general code does, and each row
+//  is interpolated by vil_resample_bilin_row_simd() where possible, so the
+//  result is identical to the general code.  Rows are shared out between the
+//  threads of pool, if given.
+template <class sType, class dType>
+void
+vil_resample_bilin_axis_aligned(const vil_image_view<sType> & src_image,
+                                vil_image_view<dType> & dest_image,
+                                double x0,
+                                double y0,
+                                double dx1,
+                                double dy2,
+                                int n1,
+                                int n2,
+                                vnl_thread_pool * pool)
+{
+  const unsigned np = src_image.nplanes();
+  const std::ptrdiff_t istep = src_image.istep();
+  const std::ptrdiff_t jstep = src_image.jstep();
+  const std::ptrdiff_t pstep = src_image.planestep();
+  const sType * plane0 = src_image.top_left_ptr();
+
+  dest_image.set_size(n1, n2, np);
+  if (n1 <= 0 || n2 <= 0)
+    return;
+  const std::ptrdiff_t d_istep = dest_image.istep();
+  const std::ptrdiff_t d_jstep = dest_image.jstep();
+  const std::ptrdiff_t d_pstep = dest_image.planestep();
+  dType * d_plane0 = dest_image.top_left_ptr();
+
+  // Column offsets and weights.  The right hand pixel is not read where its weight is zero.
+  std::vector<std::ptrdiff_t> off0(n1), off1(n1);
+  std::vector<double> wx(n1);
+  double x = x0;
+  for (int i = 0; i < n1; ++i, x += dx1)
+  {
+    const int p1x = int(x);
+    wx[i] = x - p1x;
+    off0[i] = p1x * istep;
+    off1[i] = wx[i] == 0 ? off0[i] : off0[i] + istep;
+  }
+  std::vector<double> ys(n2);
+  double y = y0;
+  for (int j = 0; j < n2; ++j, y += dy2)
+    ys[j] = y;
+
+  constexpr int rows_per_task = 16;
+  auto resample_rows = [&](std::size_t task) {
+    const int j_end = std::min(n2, int(task + 1) * rows_per_task);
+    for (int j = int(task) * rows_per_task; j < j_end; ++j)
+    {
+      const int p1y = int(ys[j]);
+      const double wy = ys[j] - p1y;
+      for (unsigned p = 0; p < np; ++p)
+      {
+        const sType * row0 = plane0 + p * pstep + p1y * jstep;
+        const sType * row1 = wy == 0 ? row0 : row0 + jstep;
+        dType * dpt = d_plane0 + p * d_pstep + j * d_jstep;
+        if (d_istep == 1 && vil_resample_bilin_row_simd(row0, row1, &off0[0], &off1[0], &wx[0], wy, dpt, std::size_t(n1)))
+          continue;
+        for (int i = 0; i < n1; ++i, dpt += d_istep)
+        {
+          const std::ptrdiff_t o0 = off0[i], o1 = off1[i];
+          if (wy != 0)
+          {
+            double i1 = row0[o0] + (row1[o0] - row0[o0]) * wy;
+            double i2 = row0[o1] + (row1[o1] - row0[o1]) * wy;
+            *dpt = (dType)(i1 + (i2 - i1) * wx[i]);
+          }
+          else
+            *dpt = (dType)(row0[o0] + (row0[o1] - row0[o0]) * wx[i]);
+        }
+      }
+    }
+  };
+  const std::size_t n_tasks = (n2 + rows_per_task - 1) / rows_per_task;
+  if (pool)
+    pool->parallel_for(n_tasks, resample_rows);
+  else
+    for (std::size_t t = 0; t < n_tasks; ++t)
+      resample_rows(t);
+}
+
 //: Sample grid of points in one image and place in another, using bilinear interpolation.
 //  dest_image(i,j,p) is sampled from the src_image at
 //  (x0+i.dx1+j.dx2,y0+i.dy1+j.dy2), where i=[0..n1-1], j=[0..n2-1]
@@ -55,6 +144,12 @@ vil_resample_bilin(const vil_image_view<sType> & src_image,
             << "y0+(n1-1)*dy1+(n2-1)*dy2=" << y0 + (n1 - 1) * dy1 + (n2 - 1) * dy2 << std::endl;
 #endif
 
+  if (all_in_image && dy1 == 0 && dx2 == 0)
+  {
+    vil_resample_bilin_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, nullptr);
+    return;
+  }
+
   const unsigned ni = src_image.ni();
   const unsigned nj = src_image.nj();
   const unsigned np = src_image.nplanes();
@@ -147,6 +242,43 @@ vil_resample_bilin(const vil_image_view<sType> & src_image, vil_image_view<dType
   vil_resample_bilin(src_image, dest_image, x0, y0, dx1, dy1, dx2, dy2, n1, n2);
 }
 
+//: Sample grid of points in one image and place in another, sharing rows between threads.
+template <class sType, class dType>
+void
+vil_resample_bilin(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   double x0,
+                   double y0,
+                   double dx1,
+                   double dy1,
+                   double dx2,
+                   double dy2,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool)
+{
+  if (dy1 == 0 && dx2 == 0 && vil_resample_bilin_corner_in_image(x0, y0, src_image) &&
+      vil_resample_bilin_corner_in_image(x0 + (n1 - 1) * dx1, y0 + (n2 - 1) * dy2, src_image))
+    vil_resample_bilin_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, &pool);
+  else
+    vil_resample_bilin(src_image, dest_image, x0, y0, dx1, dy1, dx2, dy2, n1, n2);
+}
+
+//: Resample image to a specified width (n1) and height (n2), sharing rows between threads.
+template <class sType, class dType>
+void
+vil_resample_bilin(const vil_image_view<sType> & src_image,
+                   vil_image_view<dType> & dest_image,
+                   int n1,
+                   int n2,
+                   vnl_thread_pool & pool)
+{
+  double f = 0.9999999; // so sampler doesn't go off edge of image
+  double dx1 = f * (src_image.ni() - 1) * 1.0 / (n1 - 1);
+  double dy2 = f * (src_image.nj() - 1) * 1.0 / (n2 - 1);
+  vil_resample_bilin(src_image, dest_image, 0, 0, dx1, 0, 0, dy2, n1, n2, pool);
+}
+
 
 //: Sample grid of points in one image and place in another, using bilinear interpolation.
 //  dest_image(i,j,p) is sampled from the src_image at
@@ -181,6 +313,12 @@ vil_resample_bilin_edge_extend(const vil_image_view<sType> & src_image,
             << "y0+(n1-1)*dy1+(n2-1)*dy2=" << y0 + (n1 - 1) * dy1 + (n2 - 1) * dy2 << std::endl;
 #endif
 
+  if (all_in_image && dy1 == 0 && dx2 == 0)
+  {
+    vil_resample_bilin_axis_aligned(src_image, dest_image, x0, y0, dx1, dy2, n1, n2, nullptr);
+    return;
+  }
+
   const unsigned ni = src_image.ni();
   const unsigned nj = src_image.nj();
   const unsigned np = src_image.nplanes();
@@ -288,6 +426,22 @@ vil_resample_bilin_edge_extend(const vil_image_view<sType> & src_image,
                                    int n2);                                                       \
   template void vil_resample_bilin(                                                               \
     const vil_image_view<sType> & src_image, vil_image_view<dType> & dest_image, int n1, int n2); \
+  template void vil_resample_bilin(const vil_image_view<sType> & src_image,                       \
+                                   vil_image_view<dType> & dest_image,                            \
+                                   double x0,                                                     \
+                                   double y0,                                                     \
+                                   double dx1,                                                    \
+                                   double dy1,                                                    \
+                                   double dx2,                                                    \
+                                   double dy2,                                                    \
+                                   int n1,                                                        \
+                                   int n2,                                                        \
+                                   vnl_thread_pool & pool);                                       \
+  template void vil_resample_bilin(const vil_image_view<sType> & src_image,                       \
+                                   vil_image_view<dType> & dest_image,                            \
+                                   int n1,                                                        \
+                                   int n2,                                                        \
+                                   vnl_thread_pool & pool);                                       \
   template void vil_resample_bilin_edge_extend(const vil_image_view<sType> & src_image,           \
                                                vil_image_view<dType> & dest_image,                \
                                                double x0,                                         \
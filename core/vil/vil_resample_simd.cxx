@@ -0,0 +1,217 @@
+// This is core/vil/vil_resample_simd.cxx
+//:
+// \file
+// \brief SSE4.1 and AVX2 versions of the axis-aligned vil_resample_bilin inner loop
+//
+// The source pixels of each lane are gathered with scalar loads; the
+// arithmetic, which dominates, is done in double precision vectors
+// exactly as in vil_bilin_interp_raw().
+
+#include <cstring>
+#include "vil_resample_simd.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vil_cpu_features.h"
+
+#ifdef VIL_SIMD_X86
+#  include <immintrin.h>
+
+//: Store 4 doubles, converted as a cast does
+VIL_SIMD_TARGET("avx2") static inline void vil_resample_store4(float * p, __m256d v)
+{
+  _mm_storeu_ps(p, _mm256_cvtpd_ps(v));
+}
+VIL_SIMD_TARGET("avx2") static inline void vil_resample_store4(vxl_byte * p, __m256d v)
+{
+  __m128i i32 = _mm256_cvttpd_epi32(v);
+  int r = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(i32, i32), i32));
+  std::memcpy(p, &r, 4);
+}
+
+//: Store 2 doubles, converted as a cast does
+VIL_SIMD_TARGET("sse4.1") static inline void vil_resample_store2(float * p, __m128d v)
+{
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_castps_si128(_mm_cvtpd_ps(v)));
+}
+VIL_SIMD_TARGET("sse4.1") static inline void vil_resample_store2(vxl_byte * p, __m128d v)
+{
+  __m128i i32 = _mm_cvttpd_epi32(v);
+  int r = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(i32, i32), i32));
+  p[0] = vxl_byte(r & 0xff);
+  p[1] = vxl_byte((r >> 8) & 0xff);
+}
+
+//: vil_bilin_interp_raw() for the pixels left over at the end of a row
+template <class sType, class dType>
+static inline void
+vil_resample_bilin_row_tail(const sType * row0,
+                            const sType * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            dType * dest,
+                            std::size_t i,
+                            std::size_t n)
+{
+  for (; i < n; ++i)
+  {
+    const std::ptrdiff_t o0 = off0[i], o1 = off1[i];
+    if (wy != 0)
+    {
+      double i1 = row0[o0] + (row1[o0] - row0[o0]) * wy;
+      double i2 = row0[o1] + (row1[o1] - row0[o1]) * wy;
+      dest[i] = dType(i1 + (i2 - i1) * wx[i]);
+    }
+    else
+      dest[i] = dType(row0[o0] + (row0[o1] - row0[o0]) * wx[i]);
+  }
+}
+
+template <class sType, class dType>
+VIL_SIMD_TARGET("avx2") static void
+vil_resample_bilin_row_avx2(const sType * row0,
+                            const sType * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            dType * dest,
+                            std::size_t n)
+{
+  const __m256d vwy = _mm256_set1_pd(wy);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const std::ptrdiff_t *o0 = off0 + i, *o1 = off1 + i;
+    // Differences are taken in float, as sType arithmetic does (exactly, for bytes)
+    __m128 a = _mm_set_ps(float(row0[o0[3]]), float(row0[o0[2]]), float(row0[o0[1]]), float(row0[o0[0]]));
+    __m128 b = _mm_set_ps(float(row0[o1[3]]), float(row0[o1[2]]), float(row0[o1[1]]), float(row0[o1[0]]));
+    __m256d ad = _mm256_cvtps_pd(a);
+    __m256d v;
+    if (wy != 0)
+    {
+      __m128 c = _mm_set_ps(float(row1[o0[3]]), float(row1[o0[2]]), float(row1[o0[1]]), float(row1[o0[0]]));
+      __m128 d = _mm_set_ps(float(row1[o1[3]]), float(row1[o1[2]]), float(row1[o1[1]]), float(row1[o1[0]]));
+      __m256d i1 = _mm256_add_pd(ad, _mm256_mul_pd(_mm256_cvtps_pd(_mm_sub_ps(c, a)), vwy));
+      __m256d i2 = _mm256_add_pd(_mm256_cvtps_pd(b), _mm256_mul_pd(_mm256_cvtps_pd(_mm_sub_ps(d, b)), vwy));
+      v = _mm256_add_pd(i1, _mm256_mul_pd(_mm256_sub_pd(i2, i1), _mm256_loadu_pd(wx + i)));
+    }
+    else
+      v = _mm256_add_pd(ad, _mm256_mul_pd(_mm256_cvtps_pd(_mm_sub_ps(b, a)), _mm256_loadu_pd(wx + i)));
+    vil_resample_store4(dest + i, v);
+  }
+  vil_resample_bilin_row_tail(row0, row1, off0, off1, wx, wy, dest, i, n);
+}
+
+template <class sType, class dType>
+VIL_SIMD_TARGET("sse4.1") static void
+vil_resample_bilin_row_sse41(const sType * row0,
+                             const sType * row1,
+                             const std::ptrdiff_t * off0,
+                             const std::ptrdiff_t * off1,
+                             const double * wx,
+                             double wy,
+                             dType * dest,
+                             std::size_t n)
+{
+  const __m128d vwy = _mm_set1_pd(wy);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+  {
+    const std::ptrdiff_t *o0 = off0 + i, *o1 = off1 + i;
+    __m128 a = _mm_set_ps(0.0f, 0.0f, float(row0[o0[1]]), float(row0[o0[0]]));
+    __m128 b = _mm_set_ps(0.0f, 0.0f, float(row0[o1[1]]), float(row0[o1[0]]));
+    __m128d ad = _mm_cvtps_pd(a);
+    __m128d v;
+    if (wy != 0)
+    {
+      __m128 c = _mm_set_ps(0.0f, 0.0f, float(row1[o0[1]]), float(row1[o0[0]]));
+      __m128 d = _mm_set_ps(0.0f, 0.0f, float(row1[o1[1]]), float(row1[o1[0]]));
+      __m128d i1 = _mm_add_pd(ad, _mm_mul_pd(_mm_cvtps_pd(_mm_sub_ps(c, a)), vwy));
+      __m128d i2 = _mm_add_pd(_mm_cvtps_pd(b), _mm_mul_pd(_mm_cvtps_pd(_mm_sub_ps(d, b)), vwy));
+      v = _mm_add_pd(i1, _mm_mul_pd(_mm_sub_pd(i2, i1), _mm_loadu_pd(wx + i)));
+    }
+    else
+      v = _mm_add_pd(ad, _mm_mul_pd(_mm_cvtps_pd(_mm_sub_ps(b, a)), _mm_loadu_pd(wx + i)));
+    vil_resample_store2(dest + i, v);
+  }
+  vil_resample_bilin_row_tail(row0, row1, off0, off1, wx, wy, dest, i, n);
+}
+#endif // VIL_SIMD_X86
+
+template <class sType, class dType>
+static bool
+vil_resample_bilin_row_dispatch(const sType * row0,
+                                const sType * row1,
+                                const std::ptrdiff_t * off0,
+                                const std::ptrdiff_t * off1,
+                                const double * wx,
+                                double wy,
+                                dType * dest,
+                                std::size_t n)
+{
+#ifdef VIL_SIMD_X86
+  switch (vil_simd_active_level())
+  {
+    case vil_simd_avx2:
+      vil_resample_bilin_row_avx2(row0, row1, off0, off1, wx, wy, dest, n);
+      return true;
+    case vil_simd_sse41:
+      vil_resample_bilin_row_sse41(row0, row1, off0, off1, wx, wy, dest, n);
+      return true;
+    default:
+      break;
+  }
+#else
+  (void)row0;
+  (void)row1;
+  (void)off0;
+  (void)off1;
+  (void)wx;
+  (void)wy;
+  (void)dest;
+  (void)n;
+#endif
+  return false;
+}
+
+bool
+vil_resample_bilin_row_simd(const vxl_byte * row0,
+                            const vxl_byte * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            vxl_byte * dest,
+                            std::size_t n)
+{
+  return vil_resample_bilin_row_dispatch(row0, row1, off0, off1, wx, wy, dest, n);
+}
+
+bool
+vil_resample_bilin_row_simd(const vxl_byte * row0,
+                            const vxl_byte * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            float * dest,
+                            std::size_t n)
+{
+  return vil_resample_bilin_row_dispatch(row0, row1, off0, off1, wx, wy, dest, n);
+}
+
+bool
+vil_resample_bilin_row_simd(const float * row0,
+                            const float * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            float * dest,
+                            std::size_t n)
+{
+  return vil_resample_bilin_row_dispatch(row0, row1, off0, off1, wx, wy, dest, n);
+}
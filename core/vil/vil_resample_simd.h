@@ -0,0 +1,77 @@
+// This is core/vil/vil_resample_simd.h
+#ifndef vil_resample_simd_h_
+#define vil_resample_simd_h_
+//:
+// \file
+// \brief Vectorised inner loop for axis-aligned vil_resample_bilin
+//
+// The function computes one destination row from two source rows, given
+// per-column offsets and weights, using the best instruction set reported by
+// vil_simd_active_level().  It returns false if it did nothing (no suitable
+// instruction set, or no fast version for these types), in which case the
+// caller runs its generic loop.  The generic template always returns false;
+// overload resolution picks the vectorised versions where they exist.
+//
+// Each vector lane evaluates exactly the same expression as
+// vil_bilin_interp_raw(), so the results are bitwise identical to it.
+
+#include <cstddef>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vxl_config.h>
+
+//: Bilinear interpolation along a row, for i in [0,n)
+//  With a=row0[off0[i]], b=row0[off1[i]], c=row1[off0[i]], d=row1[off1[i]]:
+//  if wy!=0, dest[i] = i1 + (i2-i1)*wx[i] where i1 = a+(c-a)*wy, i2 = b+(d-b)*wy;
+//  if wy==0, dest[i] = a + (b-a)*wx[i].
+//  off1[i] must equal off0[i] where wx[i]==0, and row1 must equal row0 if wy==0,
+//  so that no pixel with zero weight is read.  Generic version, which does nothing.
+template <class sType, class dType>
+inline bool
+vil_resample_bilin_row_simd(const sType *,
+                            const sType *,
+                            const std::ptrdiff_t *,
+                            const std::ptrdiff_t *,
+                            const double *,
+                            double,
+                            dType *,
+                            std::size_t)
+{
+  return false;
+}
+
+//: Vectorised bilinear row, byte to byte (truncated, as by a cast)
+bool
+vil_resample_bilin_row_simd(const vxl_byte * row0,
+                            const vxl_byte * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            vxl_byte * dest,
+                            std::size_t n);
+
+//: Vectorised bilinear row, byte to float
+bool
+vil_resample_bilin_row_simd(const vxl_byte * row0,
+                            const vxl_byte * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            float * dest,
+                            std::size_t n);
+
+//: Vectorised bilinear row, float to float
+bool
+vil_resample_bilin_row_simd(const float * row0,
+                            const float * row1,
+                            const std::ptrdiff_t * off0,
+                            const std::ptrdiff_t * off1,
+                            const double * wx,
+                            double wy,
+                            float * dest,
+                            std::size_t n);
+
+#endif // vil_resample_simd_h_
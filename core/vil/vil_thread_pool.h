@@ -0,0 +1,20 @@
+// This is core/vil/vil_thread_pool.h
+#ifndef vil_thread_pool_h_
+#define vil_thread_pool_h_
+//:
+// \file
+// \brief Another name for vnl_thread_pool
+//
+// vil runs its tile-parallel filters and block drivers on vnl_thread_pool,
+// by default on vnl_thread_pool::default_pool(), so that images and numerics
+// share one pool implementation and one process-wide default pool.  See
+// vnl_thread_pool for the scheduling and nesting rules.
+
+#include <vnl/vnl_thread_pool.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+
+typedef vnl_thread_pool vil_thread_pool;
+
+#endif // vil_thread_pool_h_
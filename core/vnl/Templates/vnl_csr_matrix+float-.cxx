@@ -0,0 +1,3 @@
+#include "vnl/vnl_csr_matrix.hxx"
+
+VNL_CSR_MATRIX_INSTANTIATE(float);
@@ -0,0 +1,8 @@
+#include <vnl/algo/vnl_svd_fixed_batch.hxx>
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 2, 2);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 3, 3);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 3, 4);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 4, 3);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 4, 4);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 8, 9);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(double, 9, 9);
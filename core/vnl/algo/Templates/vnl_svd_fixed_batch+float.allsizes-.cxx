@@ -0,0 +1,8 @@
+#include <vnl/algo/vnl_svd_fixed_batch.hxx>
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 2, 2);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 3, 3);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 3, 4);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 4, 3);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 4, 4);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 8, 9);
+VNL_SVD_FIXED_BATCH_INSTANTIATE(float, 9, 9);
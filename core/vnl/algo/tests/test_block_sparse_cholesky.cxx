@@ -0,0 +1,149 @@
+// This is core/vnl/algo/tests/test_block_sparse_cholesky.cxx
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include <vnl/vnl_random.h>
+#include <vnl/algo/vnl_block_sparse_cholesky.h>
+#include <vnl/algo/vnl_cholesky.h>
+
+//: A random symmetric positive definite block matrix with the given pattern.
+//  Returns the blocks in pattern order, and the same matrix in dense form.
+static std::vector<vnl_matrix<double>>
+random_spd(const std::vector<unsigned int> & sizes,
+           const std::vector<unsigned int> & ptr,
+           const std::vector<unsigned int> & col,
+           vnl_random & rng,
+           vnl_matrix<double> & dense)
+{
+  std::vector<unsigned int> start(sizes.size() + 1, 0);
+  for (unsigned int i = 0; i < sizes.size(); ++i)
+    start[i + 1] = start[i] + sizes[i];
+  dense.set_size(start.back(), start.back());
+  dense.fill(0.0);
+
+  std::vector<vnl_matrix<double>> blocks(col.size());
+  for (unsigned int i = 0; i < sizes.size(); ++i)
+    for (unsigned int e = ptr[i]; e < ptr[i + 1]; ++e)
+    {
+      const unsigned int h = col[e];
+      vnl_matrix<double> & B = blocks[e];
+      B.set_size(sizes[i], sizes[h]);
+      for (unsigned int r = 0; r < B.rows(); ++r)
+        for (unsigned int c = 0; c < B.cols(); ++c)
+          B(r, c) = rng.drand64(-1.0, 1.0);
+      if (h == i)
+        B = B + B.transpose();
+      dense.update(B, start[i], start[h]);
+      dense.update(B.transpose(), start[h], start[i]);
+    }
+  // make it diagonally dominant
+  for (unsigned int i = 0; i < sizes.size(); ++i)
+    for (unsigned int r = 0; r < sizes[i]; ++r)
+    {
+      double sum = 0.0;
+      for (unsigned int c = 0; c < dense.cols(); ++c)
+        sum += std::abs(dense(start[i] + r, c));
+      blocks[ptr[i]](r, r) += sum + 1.0;
+      dense(start[i] + r, start[i] + r) += sum + 1.0;
+    }
+  return blocks;
+}
+
+static void
+test_pattern(const std::vector<unsigned int> & sizes,
+             const std::vector<unsigned int> & ptr,
+             const std::vector<unsigned int> & col,
+             const char * name)
+{
+  vnl_random rng(9667);
+  vnl_matrix<double> dense;
+  const std::vector<vnl_matrix<double>> blocks = random_spd(sizes, ptr, col, rng, dense);
+
+  vnl_block_sparse_cholesky chol(sizes, ptr, col);
+  std::cout << name << ": " << sizes.size() << " blocks, " << chol.num_supernodes() << " supernodes, "
+            << chol.num_factor_entries() << " factor entries\n";
+  TEST("Size", chol.size(), dense.rows());
+  TEST("Factor", chol.factor(blocks), true);
+
+  vnl_vector<double> b(dense.rows()), x;
+  for (unsigned int i = 0; i < b.size(); ++i)
+    b[i] = rng.drand64(-1.0, 1.0);
+  chol.solve(b, x);
+  const vnl_vector<double> x_dense = vnl_cholesky(dense).solve(b);
+  TEST_NEAR("Solution = dense solution", (x - x_dense).inf_norm(), 0.0, 1e-10);
+  TEST_NEAR("Residual", (dense * x - b).inf_norm(), 0.0, 1e-10);
+
+  // the analysis can be reused for new values
+  std::vector<vnl_matrix<double>> blocks2(blocks);
+  for (auto & B : blocks2)
+    B *= 2.0;
+  TEST("Factor again", chol.factor(blocks2), true);
+  vnl_vector<double> x2;
+  chol.solve(b, x2);
+  TEST_NEAR("Refactored solution", (2.0 * x2 - x).inf_norm(), 0.0, 1e-10);
+}
+
+static void
+test_block_sparse_cholesky()
+{
+  // an arrow: block 0 is coupled to all others, which are independent
+  // elimination in the natural order would fill in everything
+  {
+    const unsigned int n = 40;
+    std::vector<unsigned int> sizes(n, 3), ptr(1, 0), col;
+    sizes[0] = 2;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      col.push_back(i);
+      if (i == 0)
+        for (unsigned int h = 1; h < n; ++h)
+          col.push_back(h);
+      ptr.push_back((unsigned int)col.size());
+    }
+    test_pattern(sizes, ptr, col, "arrow");
+    const vnl_block_sparse_cholesky chol(sizes, ptr, col);
+    // the hub and the last leaf end up with the same degree
+    TEST("Hub is eliminated last", chol.order(n - 2) == 0 || chol.order(n - 1) == 0, true);
+    // no fill: each leaf has its 3x3 block and a 2x3 block below it,
+    // except the last one, which forms a 5x5 supernode with the hub
+    TEST("No fill in", chol.num_factor_entries(), std::size_t(38 * (3 + 2) * 3 + 5 * 5));
+  }
+
+  // a band of blocks of different sizes, plus some random long range couplings
+  {
+    vnl_random rng(3);
+    const unsigned int n = 60;
+    std::vector<unsigned int> sizes(n), ptr(1, 0), col;
+    for (unsigned int i = 0; i < n; ++i)
+      sizes[i] = 1 + i % 7;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      std::vector<unsigned int> row(1, i);
+      for (unsigned int h = i + 1; h < n && h <= i + 3; ++h)
+        row.push_back(h);
+      const unsigned int far = i + 5 + rng.lrand32(20);
+      if (i % 4 == 0 && far < n)
+        row.push_back(far);
+      col.insert(col.end(), row.begin(), row.end());
+      ptr.push_back((unsigned int)col.size());
+    }
+    test_pattern(sizes, ptr, col, "band");
+  }
+
+  // a single dense block, and a fully coupled matrix
+  test_pattern({ 5 }, { 0, 1 }, { 0 }, "single block");
+  test_pattern({ 2, 3, 4 }, { 0, 3, 5, 6 }, { 0, 1, 2, 1, 2, 2 }, "full");
+
+  // not positive definite
+  {
+    std::vector<vnl_matrix<double>> blocks(3, vnl_matrix<double>(2, 2, 0.0));
+    blocks[0](0, 0) = blocks[0](1, 1) = 1.0;
+    blocks[2](0, 0) = blocks[2](1, 1) = 1.0;
+    blocks[1](0, 0) = 2.0;
+    vnl_block_sparse_cholesky chol({ 2, 2 }, { 0, 2, 3 }, { 0, 1, 1 });
+    TEST("Indefinite matrix is rejected", chol.factor(blocks), false);
+  }
+}
+
+TESTMAIN(test_block_sparse_cholesky);
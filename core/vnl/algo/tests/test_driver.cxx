@@ -27,6 +27,7 @@ DECLARE(test_sparse_matrix);
 DECLARE(test_integral);
 DECLARE(test_svd);
 DECLARE(test_svd_fixed);
+DECLARE(test_svd_fixed_batch);
 DECLARE(test_symmetric_eigensystem);
 DECLARE(test_algo);
 DECLARE(test_solve_qp);
@@ -34,6 +35,7 @@ DECLARE(test_sparse_lu);
 DECLARE(test_bracket_minimum);
 DECLARE(test_brent_minimizer);
 DECLARE(test_sparse_lm);
+DECLARE(test_block_sparse_cholesky);
 DECLARE(test_complex_algo);
 
 void
@@ -65,6 +67,7 @@ register_tests()
   REGISTER(test_sparse_matrix);
   REGISTER(test_svd);
   REGISTER(test_svd_fixed);
+  REGISTER(test_svd_fixed_batch);
   REGISTER(test_symmetric_eigensystem);
   REGISTER(test_algo);
   REGISTER(test_solve_qp);
@@ -72,6 +75,7 @@ register_tests()
   REGISTER(test_bracket_minimum);
   REGISTER(test_brent_minimizer);
   REGISTER(test_sparse_lm);
+  REGISTER(test_block_sparse_cholesky);
   REGISTER(test_complex_algo);
 }
 
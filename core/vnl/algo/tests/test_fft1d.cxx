@@ -1,4 +1,5 @@
 // This is core/vnl/algo/tests/test_fft1d.cxx
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
 #include <iostream>
@@ -133,6 +134,64 @@ test_fft_1d(int n)
   delete[] fTestPtrFwd;
 }
 
+//: The transform of a real signal must match that of the complexified signal.
+void
+test_fft_1d_real(int n)
+{
+  std::cout << "Testing real signals of length " << n << '\n';
+  vnl_fft_1d<double> fft(n);
+  std::vector<double> x(n);
+  std::vector<std::complex<double>> z(n);
+  for (int i = 0; i < n; ++i)
+    z[i] = x[i] = std::cos(0.3 * i * i) + 0.01 * i;
+  fft.fwd_transform(z);
+
+  std::vector<std::complex<double>> X(n / 2 + 1);
+  fft.fwd_transform_real(x.data(), X.data());
+  double err = 0.0;
+  for (int k = 0; k <= n / 2; ++k)
+    err = std::max(err, std::abs(X[k] - z[k]));
+  TEST_NEAR("fwd_transform_real = fwd_transform", err, 0.0, 1e-9 * n);
+
+  std::vector<double> y(n);
+  fft.bwd_transform_real(X.data(), y.data());
+  err = 0.0;
+  for (int i = 0; i < n; ++i)
+    err = std::max(err, std::abs(y[i] / n - x[i]));
+  TEST_NEAR("bwd_transform_real(fwd_transform_real(x)) = n x", err, 0.0, 1e-12 * n);
+}
+
+//: A strided batch must give the same result as the signals one at a time.
+void
+test_fft_1d_lot(int n, int lot)
+{
+  std::cout << "Testing " << lot << " interleaved signals of length " << n << '\n';
+  vnl_fft_1d<double> fft(n);
+  // signal l is column l of a n x lot matrix
+  std::vector<std::complex<double>> data(n * lot);
+  for (int i = 0; i < n * lot; ++i)
+    data[i] = std::complex<double>(std::sin(0.1 * i), std::cos(0.7 * i));
+  std::vector<std::complex<double>> batched(data);
+  fft.transform(batched.data(), lot, 1, lot, +1);
+
+  double err = 0.0;
+  std::vector<std::complex<double>> column(n);
+  for (int l = 0; l < lot; ++l)
+  {
+    for (int k = 0; k < n; ++k)
+      column[k] = data[k * lot + l];
+    fft.fwd_transform(column);
+    for (int k = 0; k < n; ++k)
+      err = std::max(err, std::abs(column[k] - batched[k * lot + l]));
+  }
+  TEST_NEAR("batched transform = single transforms", err, 0.0, 1e-12);
+
+  fft.set_num_threads(3);
+  std::vector<std::complex<double>> threaded(data);
+  fft.transform(threaded.data(), lot, 1, lot, +1);
+  TEST("threaded transform = batched transform", threaded == batched, true);
+}
+
 void
 test_fft1d()
 {
@@ -164,6 +223,18 @@ test_fft1d()
 
   test_fft_1d(10000);
   test_fft_1d(65536);
+
+  test_fft_1d_real(2);
+  test_fft_1d_real(4);
+  test_fft_1d_real(6);
+  test_fft_1d_real(10);
+  test_fft_1d_real(30);
+  test_fft_1d_real(256);
+  test_fft_1d_real(486);
+  test_fft_1d_real(10000);
+
+  test_fft_1d_lot(12, 5);
+  test_fft_1d_lot(60, 200);
 }
 
 TESTMAIN(test_fft1d);
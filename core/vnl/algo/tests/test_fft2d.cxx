@@ -1,4 +1,6 @@
 // This is core/vnl/algo/tests/test_fft2d.cxx
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <complex>
@@ -21,6 +23,7 @@
 //-----------------------------------------------------------------------------
 
 #include "vnl/vnl_complexify.h"
+#include <vnl/vnl_math.h>
 #include <vnl/algo/vnl_fft_2d.h>
 
 static inline double
@@ -43,6 +46,66 @@ test_cplx(const vnl_fft_prime_factors<double> & /*prx*/,
   TEST("test transform", fft_matrix == M, false);
 }
 
+//: Direct evaluation of the forward transform, exp(+2 pi i (m u/M + n v/N)).
+static vnl_matrix<std::complex<double>>
+direct_dft(const vnl_matrix<std::complex<double>> & x)
+{
+  const unsigned M = x.rows(), N = x.cols();
+  vnl_matrix<std::complex<double>> X(M, N, 0.0);
+  for (unsigned u = 0; u < M; ++u)
+    for (unsigned v = 0; v < N; ++v)
+      for (unsigned m = 0; m < M; ++m)
+        for (unsigned n = 0; n < N; ++n)
+          X(u, v) += x(m, n) * std::polar(1.0, vnl_math::twopi * (double(m * u % M) / M + double(n * v % N) / N));
+  return X;
+}
+
+static void
+test_sizes(unsigned M, unsigned N)
+{
+  std::cout << "Testing " << M << 'x' << N << '\n';
+  vnl_matrix<double> x(M, N);
+  for (unsigned m = 0; m < M; ++m)
+    for (unsigned n = 0; n < N; ++n)
+      x(m, n) = std::sin(0.37 * m * m + 0.11 * n) + 0.5 * std::cos(0.05 * m * n);
+  vnl_matrix<std::complex<double>> z(M, N);
+  for (unsigned m = 0; m < M; ++m)
+    for (unsigned n = 0; n < N; ++n)
+      z(m, n) = x(m, n);
+
+  const vnl_matrix<std::complex<double>> ref = direct_dft(z);
+  vnl_fft_2d<double> fft(M, N);
+  vnl_matrix<std::complex<double>> X = z;
+  fft.fwd_transform(X);
+  TEST_NEAR("fwd_transform = direct DFT", (X - ref).absolute_value_max(), 0.0, 1e-9);
+
+  fft.set_num_threads(3);
+  vnl_matrix<std::complex<double>> Xt = z;
+  fft.fwd_transform(Xt);
+  TEST("threaded = single threaded", Xt == X, true);
+
+  fft.set_num_threads(0);
+  vnl_matrix<std::complex<double>> Xd = z;
+  fft.fwd_transform(Xd);
+  TEST("default pool = single threaded", Xd == X, true);
+
+  if (N % 2 == 0)
+  {
+    vnl_matrix<std::complex<double>> H;
+    fft.fwd_transform_real(x, H);
+    TEST("fwd_transform_real size", H.rows() == M && H.cols() == N / 2 + 1, true);
+    double err = 0.0;
+    for (unsigned m = 0; m < M; ++m)
+      for (unsigned n = 0; n <= N / 2; ++n)
+        err = std::max(err, std::abs(H(m, n) - ref(m, n)));
+    TEST_NEAR("fwd_transform_real = left half of direct DFT", err, 0.0, 1e-9);
+
+    vnl_matrix<double> y;
+    fft.bwd_transform_real(H, y);
+    TEST_NEAR("bwd_transform_real(fwd_transform_real(x)) = MN x", (y / double(M * N) - x).absolute_value_max(), 0.0, 1e-12);
+  }
+}
+
 void
 test_fft2d()
 {
@@ -104,6 +167,11 @@ test_fft2d()
   const double error = (fft_matrix - std::complex<double>(cplx_matrix.size()) * cplx_matrix).fro_norm();
   std::cout << "error = " << error << std::endl;
   TEST_NEAR("fwd-bwd error", error, 0.0, 1e-7); // increase for float
+
+  test_sizes(6, 10);
+  test_sizes(9, 5);
+  test_sizes(30, 72);
+  test_sizes(100, 12);
 }
 
 TESTMAIN(test_fft2d);
@@ -62,6 +62,128 @@ struct linear_est : public vnl_least_squares_function
   vnl_vector<double> b_;
 };
 
+//: y = a exp(b t) + c, sampled at many t, with analytic rows
+struct exp_fit : public vnl_least_squares_function
+{
+  exp_fit(unsigned int m, bool rows)
+    : vnl_least_squares_function(3, m, use_gradient)
+    , t_(m)
+    , y_(m)
+  {
+    set_residual_rows(rows);
+    for (unsigned int i = 0; i < m; ++i)
+    {
+      t_[i] = 2.0 * i / m;
+      // data from a = 2, b = -1.5, c = 0.5, plus a deterministic wiggle
+      y_[i] = 2.0 * std::exp(-1.5 * t_[i]) + 0.5 + 1e-3 * std::sin(37.0 * i);
+    }
+  }
+
+  void
+  f(const vnl_vector<double> & x, vnl_vector<double> & fx) override
+  {
+    for (unsigned int i = 0; i < t_.size(); ++i)
+      fx[i] = x[0] * std::exp(x[1] * t_[i]) + x[2] - y_[i];
+  }
+
+  void
+  gradf(const vnl_vector<double> & x, vnl_matrix<double> & J) override
+  {
+    for (unsigned int i = 0; i < t_.size(); ++i)
+    {
+      const double e = std::exp(x[1] * t_[i]);
+      J(i, 0) = e;
+      J(i, 1) = x[0] * t_[i] * e;
+      J(i, 2) = 1.0;
+    }
+  }
+
+  void
+  f_and_gradf_rows(const vnl_vector<double> & x,
+                   unsigned int first,
+                   unsigned int last,
+                   vnl_vector<double> & fx,
+                   vnl_matrix<double> & J) override
+  {
+    for (unsigned int i = first; i < last; ++i)
+    {
+      const double e = std::exp(x[1] * t_[i]);
+      fx[i] = x[0] * e + x[2] - y_[i];
+      J(i, 0) = e;
+      J(i, 1) = x[0] * t_[i] * e;
+      J(i, 2) = 1.0;
+    }
+  }
+
+  vnl_vector<double> t_;
+  vnl_vector<double> y_;
+};
+
+static void
+do_normal_equations_test()
+{
+  // small problems, with and without the gradient
+  for (int with_grad = 1; with_grad >= 0; --with_grad)
+  {
+    vnl_rosenbrock f(with_grad != 0);
+    vnl_levenberg_marquardt lm(f);
+    lm.set_normal_equations(true);
+    vnl_vector<double> x(2);
+    x[0] = 2.7;
+    x[1] = -1.3;
+    const bool ok = lm.minimize(x);
+    lm.diagnose_outcome(std::cout);
+    TEST("normal equations: Rosenbrock converged", ok, true);
+    TEST_NEAR("normal equations: Rosenbrock minimum", std::abs(x[0] - 1) + std::abs(x[1] - 1), 0.0, 1e-8);
+  }
+
+  // a tall problem: same result from lmder, from the batched rows, and with threads
+  const unsigned int m = 5000;
+  exp_fit f_grad(m, false);
+  vnl_vector<double> x0(3);
+  x0[0] = 1.0;
+  x0[1] = -1.0;
+  x0[2] = 0.0;
+
+  vnl_vector<double> x_lmder(x0);
+  vnl_levenberg_marquardt lmder(f_grad);
+  lmder.set_f_tolerance(1e-14);
+  lmder.set_x_tolerance(1e-14);
+  lmder.set_g_tolerance(1e-12);
+  lmder.minimize(x_lmder);
+
+  vnl_vector<double> x_grad(x0);
+  vnl_levenberg_marquardt lm_grad(f_grad);
+  lm_grad.set_normal_equations(true);
+  lm_grad.set_f_tolerance(1e-14);
+  lm_grad.set_x_tolerance(1e-14);
+  lm_grad.set_g_tolerance(1e-12);
+  TEST("normal equations: converged", lm_grad.minimize(x_grad), true);
+  lm_grad.diagnose_outcome(std::cout);
+  std::cout << "lmder " << x_lmder << ", normal equations " << x_grad << std::endl;
+  TEST_NEAR("normal equations: same minimum as lmder", (x_grad - x_lmder).inf_norm(), 0.0, 1e-8);
+
+  exp_fit f_rows(m, true);
+  vnl_vector<double> x_rows(x0);
+  vnl_levenberg_marquardt lm_rows(f_rows);
+  lm_rows.set_normal_equations(true);
+  lm_rows.set_f_tolerance(1e-14);
+  lm_rows.set_x_tolerance(1e-14);
+  lm_rows.set_g_tolerance(1e-12);
+  lm_rows.minimize(x_rows);
+  TEST("normal equations: batched rows = f and gradf", x_rows == x_grad, true);
+
+  vnl_vector<double> x_threads(x0);
+  lm_rows.set_num_threads(3);
+  lm_rows.minimize(x_threads);
+  TEST("normal equations: 3 threads = 1 thread", x_threads == x_rows, true);
+
+  const vnl_matrix<double> & JtJ = lm_rows.get_JtJ();
+  vnl_matrix<double> J(m, 3);
+  f_grad.gradf(x_threads, J);
+  TEST_NEAR("normal equations: J'J at the minimum", (JtJ - J.transpose() * J).array_inf_norm(), 0.0, 1e-8);
+}
+
 static void
 do_rosenbrock_test(bool with_grad)
 {
@@ -147,6 +269,8 @@ test_levenberg_marquardt()
 
   do_linear_test(true);
   do_linear_test(false);
+
+  do_normal_equations_test();
 }
 
 TESTMAIN(test_levenberg_marquardt);
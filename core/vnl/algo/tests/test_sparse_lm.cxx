@@ -1,5 +1,6 @@
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <utility>
 
 #include "testlib/testlib_test.h"
@@ -96,6 +97,108 @@ camera_diff(const vnl_vector<double> & a1, const vnl_vector<double> & a2)
   return da;
 }
 
+//: Solve a 4 camera, 25 point problem with each method for the reduced camera system.
+//  The sparse methods must find the same solution as the dense one.
+template <class F>
+static void
+test_schur_solvers(const vnl_vector<double> & proj,
+                   const std::vector<std::vector<bool>> & mask,
+                   unsigned int num_c,
+                   const char * name)
+{
+  vnl_vector<double> pa[3], pb[3], pc[3];
+  for (int s = 0; s < 3; ++s)
+  {
+    // initial conditions (all points at origin)
+    pa[s].set_size(12);
+    pa[s].fill(0.0);
+    pb[s].set_size(50);
+    pb[s].fill(0.0);
+    pc[s].set_size(num_c);
+    pc[s].fill(1.0);
+    pa[s][2] = pa[s][5] = pa[s][8] = pa[s][11] = 10;
+    pa[s][4] = 5;
+    pa[s][7] = -5;
+    pa[s][10] = -2;
+
+    F my_func(4, 25, proj, mask, vnl_sparse_lst_sqr_function::use_gradient);
+
+    vnl_sparse_lm slm(my_func);
+    slm.set_schur_solver(vnl_sparse_lm::SchurSolver(s));
+    slm.minimize(pa[s], pb[s], pc[s]);
+    normalize(pa[s], pb[s]);
+  }
+  for (int s = 1; s < 3; ++s)
+  {
+    const double rms_error = camera_diff(pa[0], pa[s]).rms() + (pb[0] - pb[s]).rms() +
+                             (num_c > 0 ? (pc[0] - pc[s]).rms() : 0.0);
+    std::cout << name << (s == 1 ? "sparse Cholesky" : "conjugate gradients") << " vs dense: " << rms_error << '\n';
+    TEST(s == 1 ? "sparse Cholesky solution = dense solution" : "conjugate gradient solution = dense solution",
+         rms_error < 1e-8,
+         true);
+  }
+
+  // One minimizer may switch between the sparse solvers from one call to the next
+  F switch_func(4, 25, proj, mask, vnl_sparse_lst_sqr_function::use_gradient);
+  vnl_sparse_lm slm(switch_func);
+  bool same = true;
+  const int order[3] = { vnl_sparse_lm::sparse_cholesky,
+                         vnl_sparse_lm::preconditioned_cg,
+                         vnl_sparse_lm::sparse_cholesky };
+  for (int s : order)
+  {
+    vnl_vector<double> a(12, 0.0), b(50, 0.0), c(num_c, 1.0);
+    a[2] = a[5] = a[8] = a[11] = 10;
+    a[4] = 5;
+    a[7] = -5;
+    a[10] = -2;
+    slm.set_schur_solver(vnl_sparse_lm::SchurSolver(s));
+    slm.minimize(a, b, c);
+    normalize(a, b);
+    same = same && camera_diff(pa[0], a).rms() + (pb[0] - b).rms() < 1e-8;
+  }
+  TEST("solvers switched between calls give the dense solution", same, true);
+
+  // An infinite entry in the Jacobian never gives a solvable Sa; minimize must give up
+  struct inf_jacobian : public F
+  {
+    inf_jacobian(const vnl_vector<double> & proj, const std::vector<std::vector<bool>> & mask)
+      : F(4, 25, proj, mask, vnl_sparse_lst_sqr_function::use_gradient)
+    {}
+    void
+    jac_Aij(unsigned int i,
+            unsigned int j,
+            const vnl_vector<double> & ai,
+            const vnl_vector<double> & bj,
+            const vnl_vector<double> & c,
+            vnl_matrix<double> & Aij) override
+    {
+      F::jac_Aij(i, j, ai, bj, c, Aij);
+      if (i == 0 && j == 0)
+        Aij[0][1] = std::numeric_limits<double>::infinity();
+    }
+  };
+  inf_jacobian inf_func(proj, mask);
+  for (int s = 1; s < 3; ++s)
+  {
+    vnl_vector<double> a(12, 0.0), b(50, 0.0), c(num_c, 1.0);
+    a[2] = a[5] = a[8] = a[11] = 10;
+    vnl_sparse_lm inf_slm(inf_func);
+    inf_slm.set_schur_solver(vnl_sparse_lm::SchurSolver(s));
+    TEST("minimize fails with an infinite Jacobian", inf_slm.minimize(a, b, c), false);
+    TEST("failure code", inf_slm.get_failure_code(), vnl_nonlinear_minimizer::FAILED_XTOL_TOO_SMALL);
+  }
+
+  // Conjugate gradients which never reach the tolerance never give a step
+  F cg_func(4, 25, proj, mask, vnl_sparse_lst_sqr_function::use_gradient);
+  vnl_vector<double> a(12, 0.0), b(50, 0.0), c(num_c, 1.0);
+  a[2] = a[5] = a[8] = a[11] = 10;
+  vnl_sparse_lm cg_slm(cg_func);
+  cg_slm.set_schur_solver(vnl_sparse_lm::preconditioned_cg);
+  cg_slm.set_cg_tolerance(0.0, 1);
+  TEST("minimize fails when conjugate gradients do not converge", cg_slm.minimize(a, b, c), false);
+}
+
 
 // all ai.size() == 3, all bj.size() == 2, all fxij.size() == 1
 // this problem solve for 2d to 1d projection camera and 2d points
@@ -336,6 +439,8 @@ test_prob1()
     std::cout << "RMS camera error: " << rms_error_a << "\nRMS points error: " << rms_error_a << std::endl;
     TEST("convergence with missing projections and noise", rms_error_a < 1e-4 && rms_error_b < 1e-4, true);
   }
+
+  test_schur_solvers<bundle_2d>(proj2, mask, 0, "");
 }
 
 
@@ -587,6 +692,40 @@ test_prob2()
          rms_error_a < 1e-4 && rms_error_b < 1e-4 && rms_error_c < 1e-4,
          true);
   }
+
+  // the multithreaded solver must give exactly the same result as the serial one,
+  // with the analytic and with the finite difference Jacobian
+  for (int use_gradient = 0; use_gradient < 2; ++use_gradient)
+  {
+    vnl_vector<double> pa[2], pb[2], pc[2];
+    unsigned int num_iterations[2];
+    for (int t = 0; t < 2; ++t)
+    {
+      pa[t].set_size(12);
+      pa[t].fill(0.0);
+      pb[t].set_size(50);
+      pb[t].fill(0.0);
+      pc[t].set_size(1);
+      pc[t].fill(1.0);
+      pa[t][2] = pa[t][5] = pa[t][8] = pa[t][11] = 10;
+      pa[t][4] = 5;
+      pa[t][7] = -5;
+      pa[t][10] = -2;
+
+      bundle_2d_shared my_func(4, 25, proj2, mask, vnl_sparse_lst_sqr_function::use_gradient);
+
+      vnl_sparse_lm slm(my_func);
+      slm.set_num_threads(t == 0 ? 1 : 3);
+      TEST("function uses the same number of threads", my_func.num_threads(), t == 0 ? 1u : 3u);
+      slm.minimize(pa[t], pb[t], pc[t], use_gradient != 0);
+      num_iterations[t] = slm.get_num_iterations();
+    }
+    TEST("w/ globals: same result with 1 and 3 threads",
+         pa[0] == pa[1] && pb[0] == pb[1] && pc[0] == pc[1] && num_iterations[0] == num_iterations[1],
+         true);
+  }
+
+  test_schur_solvers<bundle_2d_shared>(proj2, mask, 1, "w/ globals: ");
 }
 
 
@@ -0,0 +1,79 @@
+// This is core/vnl/algo/tests/test_svd_fixed_batch.cxx
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "testlib/testlib_test.h"
+#include <vnl/vnl_random.h>
+#include <vnl/algo/vnl_svd_fixed.h>
+#include <vnl/algo/vnl_svd_fixed_batch.h>
+
+template <class T, unsigned int R, unsigned int C>
+static void
+test_size(const char * type, double tol)
+{
+  std::cout << "vnl_svd_fixed_batch<" << type << ',' << R << ',' << C << ">\n";
+  vnl_random rng(17);
+  const std::size_t n = 101;
+  vnl_matrix_fixed_batch<T, R, C> M(n);
+  for (std::size_t i = 0; i < n; ++i)
+    for (unsigned int r = 0; r < R; ++r)
+      for (unsigned int c = 0; c < C; ++c)
+        M(i, r, c) = T(rng.drand64(-1.0, 1.0));
+  // some degenerate matrices: a rank one matrix, a zero column, zero
+  for (unsigned int r = 0; r < R; ++r)
+    for (unsigned int c = 0; c < C; ++c)
+    {
+      M(1, r, c) = T((r + 1) * (c + 2));
+      M(2, r, 0) = T(0);
+      M(3, r, c) = T(0);
+    }
+
+  const vnl_svd_fixed_batch<T, R, C> svd(M);
+  std::cout << svd.num_sweeps() << " sweeps\n";
+  TEST("size", svd.size(), n);
+  double rec = 0.0, ortho = 0.0, sv = 0.0;
+  bool sorted = true;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const vnl_matrix_fixed<T, R, C> A = M.get(i);
+    const vnl_matrix_fixed<T, R, C> U = svd.U(i);
+    const vnl_matrix_fixed<T, C, C> V = svd.V(i);
+    vnl_matrix_fixed<T, C, C> W(T(0));
+    for (unsigned int k = 0; k < C; ++k)
+    {
+      W(k, k) = svd.W(i, k);
+      if (k > 0 && svd.W(i, k) > svd.W(i, k - 1))
+        sorted = false;
+    }
+    rec = std::max(rec, double((U * W * V.transpose() - A).absolute_value_max()));
+    vnl_matrix_fixed<T, C, C> I;
+    I.set_identity();
+    ortho = std::max(ortho, double((V.transpose() * V - I).absolute_value_max()));
+
+    vnl_svd_fixed<T, R, C> ref(A);
+    for (unsigned int k = 0; k < std::min(R, C); ++k)
+      sv = std::max(sv, double(std::abs(svd.W(i, k) - ref.W(k))));
+  }
+  TEST_NEAR("U W V' = M", rec, 0.0, tol);
+  TEST_NEAR("V is orthogonal", ortho, 0.0, tol);
+  TEST_NEAR("singular values = vnl_svd_fixed", sv, 0.0, tol);
+  TEST("singular values are sorted", sorted, true);
+  TEST("rank of rank one matrix", svd.rank(1, T(tol)), 1u);
+  TEST("rank of zero matrix", svd.rank(3, T(tol)), 0u);
+  TEST_NEAR("null vector", (M.get(2) * svd.nullvector(2)).magnitude(), 0.0, tol);
+}
+
+static void
+test_svd_fixed_batch()
+{
+  test_size<double, 2, 2>("double", 1e-12);
+  test_size<double, 3, 3>("double", 1e-12);
+  test_size<double, 3, 4>("double", 1e-12);
+  test_size<double, 4, 3>("double", 1e-12);
+  test_size<double, 4, 4>("double", 1e-12);
+  test_size<double, 9, 9>("double", 1e-12);
+  test_size<float, 3, 3>("float", 1e-4);
+  test_size<float, 4, 4>("float", 1e-4);
+}
+
+TESTMAIN(test_svd_fixed_batch);
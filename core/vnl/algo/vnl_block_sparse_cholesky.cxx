@@ -0,0 +1,328 @@
+// This is core/vnl/algo/vnl_block_sparse_cholesky.cxx
+//:
+// \file
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <set>
+#include <utility>
+#include "vnl_block_sparse_cholesky.h"
+#include <vnl/vnl_gemm.h>
+
+//: Minimum degree ordering of a graph, given by its sorted adjacency lists.
+//  Ties are broken by the lowest node index, so the result is reproducible.
+//  The structure of column v of the factor is the set of neighbours of v in
+//  the elimination graph when v is eliminated, which is returned in \p structure.
+static void
+vnl_block_sparse_min_degree(std::vector<std::vector<unsigned int>> & adj,
+                            std::vector<unsigned int> & perm,
+                            std::vector<std::vector<unsigned int>> & structure)
+{
+  const unsigned int n = (unsigned int)adj.size();
+  std::set<std::pair<std::size_t, unsigned int>> queue;
+  for (unsigned int v = 0; v < n; ++v)
+    queue.emplace(adj[v].size(), v);
+
+  perm.clear();
+  perm.reserve(n);
+  structure.assign(n, std::vector<unsigned int>());
+  std::vector<unsigned int> merged;
+  while (!queue.empty())
+  {
+    const unsigned int v = queue.begin()->second;
+    queue.erase(queue.begin());
+    perm.push_back(v);
+
+    // the remaining neighbours of v become a clique
+    const std::vector<unsigned int> & nv = adj[v];
+    for (unsigned int u : nv)
+    {
+      std::vector<unsigned int> & nu = adj[u];
+      queue.erase(std::make_pair(nu.size(), u));
+      merged.clear();
+      std::set_union(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(merged));
+      merged.erase(std::remove_if(merged.begin(), merged.end(), [u, v](unsigned int w) { return w == u || w == v; }),
+                   merged.end());
+      nu.swap(merged);
+      queue.emplace(nu.size(), u);
+    }
+    structure[v].swap(adj[v]);
+  }
+}
+
+vnl_block_sparse_cholesky::vnl_block_sparse_cholesky(const std::vector<unsigned int> & block_sizes,
+                                                     const std::vector<unsigned int> & ptr,
+                                                     const std::vector<unsigned int> & col)
+{
+  const unsigned int n = (unsigned int)block_sizes.size();
+  assert(ptr.size() == n + 1);
+
+  block_start_.resize(n + 1, 0);
+  for (unsigned int i = 0; i < n; ++i)
+    block_start_[i + 1] = block_start_[i] + block_sizes[i];
+  size_ = block_start_[n];
+
+  // graph of the blocks and its minimum degree ordering
+  std::vector<std::vector<unsigned int>> adj(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    assert(ptr[i] < ptr[i + 1] && col[ptr[i]] == i);
+    for (unsigned int e = ptr[i] + 1; e < ptr[i + 1]; ++e)
+    {
+      adj[i].push_back(col[e]);
+      adj[col[e]].push_back(i);
+    }
+  }
+  for (auto & a : adj)
+  {
+    std::sort(a.begin(), a.end());
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+  }
+  std::vector<std::vector<unsigned int>> structure;
+  vnl_block_sparse_min_degree(adj, perm_, structure);
+
+  std::vector<unsigned int> pos(n);
+  for (unsigned int p = 0; p < n; ++p)
+    pos[perm_[p]] = p;
+  pos_size_.resize(n);
+  pos_start_.resize(n + 1, 0);
+  for (unsigned int p = 0; p < n; ++p)
+  {
+    pos_size_[p] = block_sizes[perm_[p]];
+    pos_start_[p + 1] = pos_start_[p] + pos_size_[p];
+  }
+
+  // structure of each block column of L, in elimination positions
+  std::vector<std::vector<unsigned int>> below(n);
+  for (unsigned int p = 0; p < n; ++p)
+  {
+    for (unsigned int v : structure[perm_[p]])
+      below[p].push_back(pos[v]);
+    std::sort(below[p].begin(), below[p].end());
+  }
+
+  // column p joins column p+1 in a supernode if p+1 is its parent in the
+  // elimination tree and the two have the same structure below p+1
+  sn_first_.assign(1, 0);
+  for (unsigned int p = 0; p < n; ++p)
+  {
+    const bool merge =
+      p + 1 < n && !below[p].empty() && below[p][0] == p + 1 && below[p].size() == below[p + 1].size() + 1;
+    if (!merge)
+      sn_first_.push_back(p + 1);
+  }
+
+  const unsigned int n_sn = num_supernodes();
+  pos_sn_.resize(n);
+  pos_offset_.resize(n);
+  sn_rows_.resize(n_sn);
+  sn_row_offset_.resize(n_sn);
+  L_.resize(n_sn);
+  for (unsigned int t = 0; t < n_sn; ++t)
+  {
+    unsigned int width = 0;
+    for (unsigned int p = sn_first_[t]; p < sn_first_[t + 1]; ++p)
+    {
+      pos_sn_[p] = t;
+      pos_offset_[p] = width;
+      width += pos_size_[p];
+    }
+    unsigned int height = width;
+    sn_rows_[t].swap(below[sn_first_[t + 1] - 1]);
+    for (unsigned int p : sn_rows_[t])
+    {
+      sn_row_offset_[t].push_back(height);
+      height += pos_size_[p];
+    }
+    L_[t].set_size(height, width);
+  }
+
+  // where each block of the input lands in the lower triangle of the factor
+  targets_.resize(ptr[n]);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    for (unsigned int e = ptr[i]; e < ptr[i + 1]; ++e)
+    {
+      const unsigned int pi = pos[i];
+      const unsigned int ph = pos[col[e]];
+      const unsigned int lo = std::min(pi, ph);
+      const unsigned int t = pos_sn_[lo];
+      targets_[e].sn = t;
+      targets_[e].row = row_offset(t, std::max(pi, ph));
+      targets_[e].col = pos_offset_[lo];
+      targets_[e].transpose = pi <= ph;
+    }
+  }
+}
+
+unsigned int
+vnl_block_sparse_cholesky::row_offset(unsigned int t, unsigned int p) const
+{
+  if (p >= sn_first_[t] && p < sn_first_[t + 1])
+    return pos_offset_[p];
+  const std::vector<unsigned int> & rows = sn_rows_[t];
+  const auto it = std::lower_bound(rows.begin(), rows.end(), p);
+  assert(it != rows.end() && *it == p);
+  return sn_row_offset_[t][it - rows.begin()];
+}
+
+std::size_t
+vnl_block_sparse_cholesky::num_factor_entries() const
+{
+  std::size_t n = 0;
+  for (const auto & P : L_)
+    n += std::size_t(P.rows()) * P.cols();
+  return n;
+}
+
+bool
+vnl_block_sparse_cholesky::factor(const std::vector<vnl_matrix<double>> & blocks)
+{
+  assert(blocks.size() == targets_.size());
+  for (auto & P : L_)
+    P.fill(0.0);
+  for (std::size_t e = 0; e < blocks.size(); ++e)
+  {
+    const vnl_matrix<double> & B = blocks[e];
+    const target & d = targets_[e];
+    vnl_matrix<double> & P = L_[d.sn];
+    for (unsigned int r = 0; r < B.rows(); ++r)
+      for (unsigned int c = 0; c < B.cols(); ++c)
+      {
+        if (d.transpose)
+          P(d.row + c, d.col + r) = B(r, c);
+        else
+          P(d.row + r, d.col + c) = B(r, c);
+      }
+  }
+
+  vnl_matrix<double> U;
+  for (unsigned int t = 0; t < num_supernodes(); ++t)
+  {
+    vnl_matrix<double> & P = L_[t];
+    const unsigned int n = P.cols();
+    const unsigned int rows = P.rows();
+
+    // dense Cholesky of the panel: L11 on top, then L21 = A21 inv(L11')
+    for (unsigned int j = 0; j < n; ++j)
+    {
+      double * pj = P[j];
+      double d = pj[j];
+      for (unsigned int k = 0; k < j; ++k)
+        d -= pj[k] * pj[k];
+      if (!(d > 0.0))
+        return false;
+      d = std::sqrt(d);
+      pj[j] = d;
+      for (unsigned int i = j + 1; i < rows; ++i)
+      {
+        double * pi = P[i];
+        double s = pi[j];
+        for (unsigned int k = 0; k < j; ++k)
+          s -= pi[k] * pj[k];
+        pi[j] = s / d;
+      }
+    }
+
+    // subtract L21 L21' from the supernodes of the rows below
+    const unsigned int m = rows - n;
+    if (m == 0)
+      continue;
+    U.set_size(m, m);
+    vnl_gemm(false, true, m, m, n, 1.0, P[n], n, P[n], n, 0.0, U.data_block(), m);
+
+    const std::vector<unsigned int> & R = sn_rows_[t];
+    const std::vector<unsigned int> & off = sn_row_offset_[t];
+    for (unsigned int b = 0; b < R.size(); ++b)
+    {
+      const unsigned int tb = pos_sn_[R[b]];
+      const unsigned int cb = pos_offset_[R[b]];
+      const unsigned int nb = pos_size_[R[b]];
+      vnl_matrix<double> & T = L_[tb];
+      for (unsigned int a = b; a < R.size(); ++a)
+      {
+        const unsigned int ra = row_offset(tb, R[a]);
+        const unsigned int na = pos_size_[R[a]];
+        for (unsigned int q = 0; q < na; ++q)
+        {
+          const double * u = U[off[a] - n + q] + (off[b] - n);
+          double * l = T[ra + q] + cb;
+          for (unsigned int c = 0; c < nb; ++c)
+            l[c] -= u[c];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void
+vnl_block_sparse_cholesky::solve(const vnl_vector<double> & b, vnl_vector<double> & x) const
+{
+  assert(b.size() == size_);
+  const unsigned int n_pos = (unsigned int)perm_.size();
+  vnl_vector<double> y(size_);
+  for (unsigned int p = 0; p < n_pos; ++p)
+    std::copy(b.begin() + block_start_[perm_[p]], b.begin() + block_start_[perm_[p] + 1], y.begin() + pos_start_[p]);
+
+  // forward substitution, L y = b
+  for (unsigned int t = 0; t < num_supernodes(); ++t)
+  {
+    const vnl_matrix<double> & P = L_[t];
+    const unsigned int n = P.cols();
+    double * z = y.data_block() + pos_start_[sn_first_[t]];
+    for (unsigned int j = 0; j < n; ++j)
+    {
+      const double * pj = P[j];
+      double s = z[j];
+      for (unsigned int k = 0; k < j; ++k)
+        s -= pj[k] * z[k];
+      z[j] = s / pj[j];
+    }
+    const std::vector<unsigned int> & R = sn_rows_[t];
+    for (unsigned int a = 0; a < R.size(); ++a)
+    {
+      double * w = y.data_block() + pos_start_[R[a]];
+      for (unsigned int q = 0; q < pos_size_[R[a]]; ++q)
+      {
+        const double * pq = P[sn_row_offset_[t][a] + q];
+        double s = 0.0;
+        for (unsigned int c = 0; c < n; ++c)
+          s += pq[c] * z[c];
+        w[q] -= s;
+      }
+    }
+  }
+
+  // back substitution, L' x = y
+  for (unsigned int t = num_supernodes(); t-- > 0;)
+  {
+    const vnl_matrix<double> & P = L_[t];
+    const unsigned int n = P.cols();
+    double * z = y.data_block() + pos_start_[sn_first_[t]];
+    const std::vector<unsigned int> & R = sn_rows_[t];
+    for (unsigned int a = 0; a < R.size(); ++a)
+    {
+      const double * w = y.data_block() + pos_start_[R[a]];
+      for (unsigned int q = 0; q < pos_size_[R[a]]; ++q)
+      {
+        const double * pq = P[sn_row_offset_[t][a] + q];
+        for (unsigned int c = 0; c < n; ++c)
+          z[c] -= pq[c] * w[q];
+      }
+    }
+    for (unsigned int j = n; j-- > 0;)
+    {
+      double s = z[j];
+      for (unsigned int k = j + 1; k < n; ++k)
+        s -= P(k, j) * z[k];
+      z[j] = s / P(j, j);
+    }
+  }
+
+  x.set_size(size_);
+  for (unsigned int p = 0; p < n_pos; ++p)
+    std::copy(y.begin() + pos_start_[p], y.begin() + pos_start_[p + 1], x.begin() + block_start_[perm_[p]]);
+}
@@ -0,0 +1,119 @@
+// This is core/vnl/algo/vnl_block_sparse_cholesky.h
+#ifndef vnl_block_sparse_cholesky_h_
+#define vnl_block_sparse_cholesky_h_
+//:
+// \file
+// \brief Supernodal Cholesky factorization of a symmetric block sparse matrix
+//
+// The matrix is made of small dense blocks, e.g. the reduced camera system
+// of a bundle adjustment, in which block (i,h) is non-zero if cameras i
+// and h see a common point.  The block rows are reordered by minimum degree
+// on the graph of blocks to reduce fill-in, and consecutive block columns
+// of the factor with the same structure are stored together as supernodes,
+// i.e. as one dense panel.  The factorization is right-looking: the update
+// from each supernode to its ancestors is a dense matrix product (vnl_gemm).
+//
+// The ordering and the structure of the factor only depend on the pattern,
+// so they are computed once, and factor() can be called for each new set
+// of values.
+
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vnl/vnl_vector.h>
+#include <vnl/vnl_matrix.h>
+#include <vnl/algo/vnl_algo_export.h>
+
+//: Supernodal Cholesky factorization of a symmetric block sparse matrix.
+//  M = P' L L' P, where P is a block permutation and L is lower triangular.
+class VNL_ALGO_EXPORT vnl_block_sparse_cholesky
+{
+public:
+  //: Analyse the pattern of a symmetric block matrix.
+  //  Block row i has block_sizes[i] rows.  The blocks on or above the
+  //  diagonal of block row i that may be non-zero are in block columns
+  //  col[ptr[i]] to col[ptr[i+1]-1], in increasing order; the first is i.
+  vnl_block_sparse_cholesky(const std::vector<unsigned int> & block_sizes,
+                            const std::vector<unsigned int> & ptr,
+                            const std::vector<unsigned int> & col);
+
+  //: Factor the matrix with the given blocks, in the order of the pattern.
+  //  Only the upper triangle of the diagonal blocks is used.
+  //  Returns false if the matrix is not numerically positive definite.
+  bool
+  factor(const std::vector<vnl_matrix<double>> & blocks);
+
+  //: Solve M x = b, using the last successful factorization.
+  void
+  solve(const vnl_vector<double> & b, vnl_vector<double> & x) const;
+
+  //: Number of rows (and columns) of the matrix
+  unsigned int
+  size() const
+  {
+    return size_;
+  }
+
+  //: Block order(k) is eliminated k-th
+  unsigned int
+  order(unsigned int k) const
+  {
+    return perm_[k];
+  }
+
+  //: Number of supernodes
+  unsigned int
+  num_supernodes() const
+  {
+    return (unsigned int)(sn_first_.size() - 1);
+  }
+
+  //: Number of entries stored for the factor L
+  std::size_t
+  num_factor_entries() const;
+
+private:
+  //: Offset of elimination position p in supernode t (top part or rows below)
+  unsigned int
+  row_offset(unsigned int t, unsigned int p) const;
+
+  unsigned int size_{ 0 };
+
+  //: Size of the block at each elimination position
+  std::vector<unsigned int> pos_size_;
+  //: Offset of each elimination position in the permuted vector
+  std::vector<unsigned int> pos_start_;
+  //: Offset of each original block in the input vector
+  std::vector<unsigned int> block_start_;
+  //: Original block at each elimination position
+  std::vector<unsigned int> perm_;
+
+  //: Supernode t has positions sn_first_[t] to sn_first_[t+1]-1
+  std::vector<unsigned int> sn_first_;
+  //: Supernode of each position
+  std::vector<unsigned int> pos_sn_;
+  //: Column offset of each position within its supernode
+  std::vector<unsigned int> pos_offset_;
+  //: Positions of the blocks below the diagonal of each supernode, in order
+  std::vector<std::vector<unsigned int>> sn_rows_;
+  //: Row offsets of those blocks in the panel
+  std::vector<std::vector<unsigned int>> sn_row_offset_;
+
+  //: Where each input block goes: supernode, row, column, transposed
+  struct target
+  {
+    unsigned int sn;
+    unsigned int row;
+    unsigned int col;
+    bool transpose;
+  };
+  std::vector<target> targets_;
+
+  //: The dense panels of the factor, one per supernode.
+  //  The top square holds L11 (lower triangle), the rest L21.
+  std::vector<vnl_matrix<double>> L_;
+};
+
+#endif // vnl_block_sparse_cholesky_h_
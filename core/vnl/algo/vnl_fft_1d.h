@@ -11,6 +11,8 @@
 //   19 June 2003 - Peter Vanroose - added cmplx* and vector<cmplx> interfaces
 // \endverbatim
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
@@ -26,7 +28,7 @@ struct vnl_fft_1d : public vnl_fft_base<1, T>
   typedef vnl_fft_base<1, T> base;
 
   //: constructor takes length of signal.
-  vnl_fft_1d(int N) { base::factors_[0].resize(N); }
+  vnl_fft_1d(int N);
 
   //: return length of signal.
   unsigned int
@@ -56,6 +58,30 @@ struct vnl_fft_1d : public vnl_fft_base<1, T>
     base::transform(signal.data_block(), dir);
   }
 
+  //: Transform lot signals in place, e.g. the rows or columns of an image.
+  //  Element k of signal l is data[l*jump + k*inc].  The signals are
+  //  transformed in batches, split between threads if set_num_threads()
+  //  asked for it.  dir = +1/-1 according to direction of transform.
+  void
+  transform(std::complex<T> * data, std::ptrdiff_t inc, std::ptrdiff_t jump, std::ptrdiff_t lot, int dir)
+  {
+    base::transform_lot(base::factors_[0], data, inc, jump, lot, dir);
+  }
+
+  //: forward FFT of a real signal, whose length size() must be even.
+  //  Writes coefficients 0 to size()/2 to out, which must have room for
+  //  size()/2+1 elements; the others are out[size()-k] = conj(out[k]).
+  //  This is done with one complex FFT of half the length, so it takes
+  //  about half the time of fwd_transform() on the complexified signal.
+  void
+  fwd_transform_real(const T * in, std::complex<T> * out) const;
+
+  //: backward (inverse) FFT of the spectrum of a real signal.
+  //  in holds coefficients 0 to size()/2, as written by fwd_transform_real().
+  //  As with bwd_transform(), out is size() times the original signal.
+  void
+  bwd_transform_real(const std::complex<T> * in, T * out) const;
+
   //: forward FFT
   void
   fwd_transform(std::vector<std::complex<T>> & signal)
@@ -97,6 +123,12 @@ struct vnl_fft_1d : public vnl_fft_base<1, T>
   {
     transform(signal, -1);
   }
+
+private:
+  //: the half length transform used for real signals
+  vnl_fft_prime_factors<T> half_;
+  //: exp(2 pi i k/size()) for k = 0 to size()/4, shared by all transforms of this size
+  std::shared_ptr<const std::vector<std::complex<T>>> real_twiddles_;
 };
 
 #endif // vnl_fft_1d_h_
@@ -2,7 +2,107 @@
 #define vnl_fft_1d_hxx_
 // -*- c++ -*-
 
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <mutex>
 #include "vnl_fft_1d.h"
+#include <vnl/algo/vnl_fft.h>
+#include <vnl/vnl_math.h>
+
+//: exp(2 pi i k/N) for k = 0 to N/4, computed once for each N.
+//  As for the twiddle factors of vnl_fft_prime_factors, up to 64 sizes are cached.
+template <class T>
+static std::shared_ptr<const std::vector<std::complex<T>>>
+vnl_fft_1d_real_twiddles(int N)
+{
+  static std::mutex mutex;
+  static std::map<int, std::shared_ptr<const std::vector<std::complex<T>>>> cache;
+  {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(N);
+    if (it != cache.end())
+      return it->second;
+  }
+
+  auto w = std::make_shared<std::vector<std::complex<T>>>(N / 4 + 1);
+  for (int k = 0; k <= N / 4; ++k)
+    (*w)[k] = std::polar(T(1), T(vnl_math::twopi * k / N));
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() < 64)
+    return cache.emplace(N, w).first->second;
+  return w;
+}
+
+template <class T>
+vnl_fft_1d<T>::vnl_fft_1d(int N)
+{
+  base::factors_[0].resize(N);
+  if (N % 2 == 0)
+  {
+    half_.resize(N / 2);
+    real_twiddles_ = vnl_fft_1d_real_twiddles<T>(N);
+  }
+}
+
+// The real signal x of length N = 2M is transformed as the complex signal
+// z[n] = x[2n] + i x[2n+1] of length M.  Its transform Z = A + i B, where A
+// and B are the transforms of the even and odd samples, which are recovered
+// from A[k] = (Z[k] + conj(Z[M-k]))/2 and B[k] = (Z[k] - conj(Z[M-k]))/2i.
+// Then X[k] = A[k] + w^k B[k] and X[M-k] = conj(A[k] - w^k B[k]), with
+// w = exp(2 pi i/N) (the sign of the forward transform of vnl_fft).
+
+template <class T>
+void
+vnl_fft_1d<T>::fwd_transform_real(const T * in, std::complex<T> * out) const
+{
+  assert(half_ && real_twiddles_);
+  const int M = half_.number();
+  for (int n = 0; n < M; ++n)
+    out[n] = std::complex<T>(in[2 * n], in[2 * n + 1]);
+  long info = 0;
+  T * a = reinterpret_cast<T *>(out);
+  vnl_fft_gpfa(a, a + 1, half_.trigs(), 2, 0, M, 1, +1, half_.pqr(), &info);
+
+  const std::complex<T> * w = real_twiddles_->data();
+  const std::complex<T> Z0 = out[0];
+  out[0] = std::complex<T>(Z0.real() + Z0.imag(), 0);
+  out[M] = std::complex<T>(Z0.real() - Z0.imag(), 0);
+  for (int k = 1; 2 * k <= M; ++k)
+  {
+    const std::complex<T> Zk = out[k];
+    const std::complex<T> Zj = std::conj(out[M - k]);
+    const std::complex<T> A = T(0.5) * (Zk + Zj);
+    const std::complex<T> B = std::complex<T>(0, T(-0.5)) * (Zk - Zj);
+    out[k] = A + w[k] * B;
+    if (2 * k < M)
+      out[M - k] = std::conj(A - w[k] * B);
+  }
+}
+
+template <class T>
+void
+vnl_fft_1d<T>::bwd_transform_real(const std::complex<T> * in, T * out) const
+{
+  assert(half_ && real_twiddles_);
+  const int M = half_.number();
+  std::complex<T> * z = reinterpret_cast<std::complex<T> *>(out);
+  const std::complex<T> * w = real_twiddles_->data();
+  const std::complex<T> i(0, 1);
+  // 2 Z[k] = 2 A[k] + 2i B[k], so that the result is scaled by N = 2M
+  for (int k = 0; 2 * k <= M; ++k)
+  {
+    const std::complex<T> Xk = in[k];
+    const std::complex<T> Xj = std::conj(in[M - k]);
+    z[k] = (Xk + Xj) + i * std::conj(w[k]) * (Xk - Xj);
+    if (k > 0 && 2 * k < M)
+      // the same with k and M-k swapped, as conj(w^(M-k)) = -w^k
+      z[M - k] = std::conj(Xk + Xj) + i * w[k] * std::conj(Xk - Xj);
+  }
+  long info = 0;
+  vnl_fft_gpfa(out, out + 1, half_.trigs(), 2, 0, M, 1, -1, half_.pqr(), &info);
+}
 
 #undef VNL_FFT_1D_INSTANTIATE
 #define VNL_FFT_1D_INSTANTIATE(T) template struct VNL_ALGO_EXPORT vnl_fft_1d<T>
@@ -8,6 +8,7 @@
 
 #include <vnl/vnl_matrix.h>
 #include <vnl/algo/vnl_fft_base.h>
+#include <vnl/algo/vnl_fft_1d.h>
 
 //: In-place 2D fast Fourier transform
 
@@ -18,6 +19,7 @@ struct vnl_fft_2d : public vnl_fft_base<2, T>
 
   //: constructor takes size of signal.
   vnl_fft_2d(int M, int N)
+    : row_fft_(N)
   {
     base::factors_[0].resize(M);
     base::factors_[1].resize(N);
@@ -44,6 +46,17 @@ struct vnl_fft_2d : public vnl_fft_base<2, T>
     transform(signal, -1);
   }
 
+  //: forward FFT of a real signal, whose number of columns must be even.
+  //  The result is the left cols()/2+1 columns of the transform, the others
+  //  follow from spectrum(m,n) = conj(spectrum((M-m)%M, N-n)).
+  void
+  fwd_transform_real(const vnl_matrix<T> & signal, vnl_matrix<std::complex<T>> & spectrum);
+
+  //: backward (inverse) FFT of the spectrum of a real signal.
+  //  As with bwd_transform(), the result is rows()*cols() times the signal.
+  void
+  bwd_transform_real(const vnl_matrix<std::complex<T>> & spectrum, vnl_matrix<T> & signal);
+
   //: return size of signal.
   unsigned
   rows() const
@@ -55,6 +68,10 @@ struct vnl_fft_2d : public vnl_fft_base<2, T>
   {
     return base::factors_[1].number();
   }
+
+private:
+  //: transform of the rows of a real signal
+  vnl_fft_1d<T> row_fft_;
 };
 
 #endif // vnl_fft_2d_h_
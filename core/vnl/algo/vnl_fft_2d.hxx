@@ -2,7 +2,42 @@
 #define vnl_fft_2d_hxx_
 // -*- c++ -*-
 
+#include <cassert>
 #include "vnl_fft_2d.h"
+#include <vnl/vnl_thread_pool.h>
+
+template <class T>
+void
+vnl_fft_2d<T>::fwd_transform_real(const vnl_matrix<T> & signal, vnl_matrix<std::complex<T>> & spectrum)
+{
+  assert(signal.rows() == rows() && signal.cols() == cols());
+  const unsigned W = cols() / 2 + 1;
+  spectrum.set_size(rows(), W);
+  auto row = [&](std::size_t r) { row_fft_.fwd_transform_real(signal[r], spectrum[r]); };
+  if (vnl_thread_pool * const threads = base::pool())
+    threads->parallel_for(rows(), row);
+  else
+    for (unsigned r = 0; r < rows(); ++r)
+      row(r);
+  base::transform_lot(base::factors_[0], spectrum.data_block(), W, 1, W, +1);
+}
+
+template <class T>
+void
+vnl_fft_2d<T>::bwd_transform_real(const vnl_matrix<std::complex<T>> & spectrum, vnl_matrix<T> & signal)
+{
+  const unsigned W = cols() / 2 + 1;
+  assert(spectrum.rows() == rows() && spectrum.cols() == W);
+  vnl_matrix<std::complex<T>> tmp(spectrum);
+  base::transform_lot(base::factors_[0], tmp.data_block(), W, 1, W, -1);
+  signal.set_size(rows(), cols());
+  auto row = [&](std::size_t r) { row_fft_.bwd_transform_real(tmp[r], signal[r]); };
+  if (vnl_thread_pool * const threads = base::pool())
+    threads->parallel_for(rows(), row);
+  else
+    for (unsigned r = 0; r < rows(); ++r)
+      row(r);
+}
 
 #undef VNL_FFT_2D_INSTANTIATE
 #define VNL_FFT_2D_INSTANTIATE(T) template struct VNL_ALGO_EXPORT vnl_fft_2d<T>
@@ -7,12 +7,16 @@
 // \author fsm
 
 #include <complex>
+#include <cstddef>
+#include <memory>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
 #include <vnl/algo/vnl_algo_export.h>
 #include <vnl/algo/vnl_fft_prime_factors.h>
 
+class vnl_thread_pool;
+
 //: Base class for in-place ND fast Fourier transform.
 
 template <int D, class T>
@@ -24,9 +28,39 @@ struct VNL_ALGO_EXPORT vnl_fft_base
   void
   transform(std::complex<T> * signal, int dir);
 
+  //: Set the number of threads used by the transforms.
+  //  0 means the threads of vnl_thread_pool::default_pool(), which is shared
+  //  with the rest of vnl rather than created for this object.
+  //  The vectors along each dimension are split between the threads.
+  //  The result does not depend on the number of threads.  Default is 1.
+  void
+  set_num_threads(unsigned int n);
+
 protected:
   //: prime factorizations of signal dimensions.
   vnl_fft_prime_factors<T> factors_[D];
+
+  //: Transform lot vectors of length f.number(), in place.
+  //  Consecutive elements of a vector are inc elements apart, and
+  //  consecutive vectors start jump elements apart.  The lot is split
+  //  into batches, which GPFA transforms together: its inner loops run
+  //  across the vectors of a batch, so they vectorize well.
+  void
+  transform_lot(const vnl_fft_prime_factors<T> & f,
+                std::complex<T> * data,
+                std::ptrdiff_t inc,
+                std::ptrdiff_t jump,
+                std::ptrdiff_t lot,
+                int dir) const;
+
+  //: The pool to split the work over, or null to run serially
+  vnl_thread_pool *
+  pool() const;
+
+  //: Null unless set_num_threads() was given more than one thread
+  std::shared_ptr<vnl_thread_pool> pool_;
+  //: True if set_num_threads(0) selected the default pool
+  bool use_default_pool_{ false };
 };
 
 #endif // vnl_fft_base_h_
@@ -3,13 +3,75 @@
 /*
   fsm
 */
+#include <algorithm>
 #include "vnl_fft_base.h"
 #include <vnl/algo/vnl_fft.h>
+#include <vnl/vnl_thread_pool.h>
 #include <cassert>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
 
+template <int D, class T>
+void
+vnl_fft_base<D, T>::set_num_threads(unsigned int n)
+{
+  use_default_pool_ = n == 0;
+  if (n <= 1)
+    pool_.reset();
+  else if (!pool_ || pool_->n_threads() != n)
+    pool_ = std::make_shared<vnl_thread_pool>(n);
+}
+
+template <int D, class T>
+vnl_thread_pool *
+vnl_fft_base<D, T>::pool() const
+{
+  if (use_default_pool_)
+    return &vnl_thread_pool::default_pool();
+  return pool_.get();
+}
+
+template <int D, class T>
+void
+vnl_fft_base<D, T>::transform_lot(const vnl_fft_prime_factors<T> & f,
+                                  std::complex<T> * data,
+                                  std::ptrdiff_t inc,
+                                  std::ptrdiff_t jump,
+                                  std::ptrdiff_t lot,
+                                  int dir) const
+{
+  // Batches of 64 vectors keep a batch of columns of a large matrix in
+  // cache; the batches are also the unit of work for the threads.
+  const std::ptrdiff_t batch = 64;
+  const std::ptrdiff_t n_batches = (lot + batch - 1) / batch;
+  auto task = [&](std::size_t b) {
+    const std::ptrdiff_t first = std::ptrdiff_t(b) * batch;
+    // This relies on the assumption that std::complex<T> is layout
+    // compatible with "struct { T real; T imag; }". It is probably
+    // a valid assumption for all sane C++ libraries.
+    T * a = reinterpret_cast<T *>(data + first * jump);
+    long info = 0;
+    vnl_fft_gpfa(/* A */ a,
+                 /* B */ a + 1,
+                 /* TRIGS */ f.trigs(),
+                 /* INC */ 2 * inc,
+                 /* JUMP */ 2 * jump,
+                 /* N */ f.number(),
+                 /* LOT */ std::min(batch, lot - first),
+                 /* ISIGN */ dir,
+                 /* NIPQ */ f.pqr(),
+                 /* INFO */ &info);
+    assert(info != -1);
+  };
+  vnl_thread_pool * const threads = pool();
+  if (threads && n_batches > 1)
+    threads->parallel_for(n_batches, task);
+  else
+    for (std::ptrdiff_t b = 0; b < n_batches; ++b)
+      task(b);
+}
+
 template <int D, class T>
 void
 vnl_fft_base<D, T>::transform(std::complex<T> * signal, int dir)
@@ -35,32 +97,11 @@ vnl_fft_base<D, T>::transform(std::complex<T> * signal, int dir)
 
     // pretend the signal is N1xN2xN3. we want to transform
     // along the second dimension.
-    for (int n1 = 0; n1 < N1; ++n1)
-    {
-      // FIXME: we could avoid one loop by using the LOT parameter
-      // but it's not entirely clear that would save us anything.
-
-      for (int n3 = 0; n3 < N3; ++n3)
-      {
-        // This relies on the assumption that std::complex<T> is layout
-        // compatible with "struct { T real; T imag; }". It is probably
-        // a valid assumption for all sane C++ libraries.
-        T * data = (T *)(signal + n1 * N2 * N3 + n3);
-
-        long info = 0;
-        vnl_fft_gpfa(/* A */ data,
-                     /* B */ data + 1,
-                     /* TRIGS */ factors_[i].trigs(),
-                     /* INC */ 2 * N3,
-                     /* JUMP */ 0,
-                     /* N */ N2,
-                     /* LOT */ 1,
-                     /* ISIGN */ dir,
-                     /* NIPQ */ factors_[i].pqr(),
-                     /* INFO */ &info);
-        assert(info != -1);
-      }
-    }
+    if (N3 == 1) // the vectors are contiguous, one after the other
+      transform_lot(factors_[i], signal, 1, N2, N1, dir);
+    else // the vectors are interleaved, N3 at a time
+      for (int n1 = 0; n1 < N1; ++n1)
+        transform_lot(factors_[i], signal + std::ptrdiff_t(n1) * N2 * N3, N3, 1, N3, dir);
   }
 }
 
@@ -12,6 +12,8 @@
 //   10/4/2001 Ian Scott (Manchester) Converted perceps header to doxygen
 // \endverbatim
 
+#include <memory>
+#include <vector>
 #include "vnl/vnl_export.h"
 #include <vnl/algo/vnl_algo_export.h>
 
@@ -21,6 +23,10 @@
 // Given an integer N of the form
 //   $N = 2^P 3^Q 5^R$
 // split N into its primefactors (2, 3, 5)
+//
+// The twiddle factors for each N are computed once and shared by all
+// vnl_fft_prime_factors<T> of that size, so creating a transform object
+// for a size that was used before is cheap.
 
 template <class T>
 struct vnl_fft_prime_factors
@@ -38,7 +44,7 @@ public:
   const T *
   trigs() const
   {
-    return trigs_;
+    return table_ ? table_->trigs.data() : nullptr;
   }
 
   //: number which was factorized
@@ -58,12 +64,12 @@ public:
   explicit
   operator bool() const
   {
-    return (trigs_ && info_ >= 0) ? true : false;
+    return (table_ && info_ >= 0) ? true : false;
   }
   bool
   operator!() const
   {
-    return (trigs_ && info_ >= 0) ? false : true;
+    return (table_ && info_ >= 0) ? false : true;
   }
 
   void
@@ -73,8 +79,16 @@ public:
     construct(N);
   }
 
+  //: The twiddle factors and factorization of one size, as computed by setgpfa
+  struct table
+  {
+    std::vector<T> trigs;
+    long pqr[3];
+    long info;
+  };
+
 private:
-  T * trigs_;
+  std::shared_ptr<const table> table_;
   long number_; // the number that is being split into prime-facs
   long pqr_[3]; // store P, Q and R
   long info_;
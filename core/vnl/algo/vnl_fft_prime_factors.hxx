@@ -3,6 +3,8 @@
 /*
   fsm
 */
+#include <map>
+#include <mutex>
 #include "vnl_fft_prime_factors.h"
 #include <vnl/algo/vnl_fft.h>
 #include <cassert>
@@ -12,18 +14,47 @@
 
 template <class T>
 vnl_fft_prime_factors<T>::vnl_fft_prime_factors()
-  : trigs_(nullptr)
-  , number_(0)
+  : number_(0)
 {}
 
+//: The shared table for size N, computing it if it is not cached.
+//  Up to 64 sizes are kept for the lifetime of the program; tables for
+//  other sizes are released with the last object using them.
+template <class T>
+static std::shared_ptr<const typename vnl_fft_prime_factors<T>::table>
+vnl_fft_prime_factors_table(long N)
+{
+  typedef typename vnl_fft_prime_factors<T>::table table;
+  static std::mutex mutex;
+  static std::map<long, std::shared_ptr<const table>> cache;
+  {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(N);
+    if (it != cache.end())
+      return it->second;
+  }
+
+  auto t = std::make_shared<table>();
+  t->trigs.resize(2 * N);
+  vnl_fft_setgpfa(t->trigs.data(), N, t->pqr, &t->info);
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() < 64)
+    return cache.emplace(N, t).first->second; // another thread may have got there first
+  return t;
+}
+
 template <class T>
 void
 vnl_fft_prime_factors<T>::construct(int N)
 {
   assert(N > 0);
-  trigs_ = new T[2 * N];
   number_ = N;
-  vnl_fft_setgpfa(trigs_, number_, pqr_, &info_);
+  table_ = vnl_fft_prime_factors_table<T>(N);
+  pqr_[0] = table_->pqr[0];
+  pqr_[1] = table_->pqr[1];
+  pqr_[2] = table_->pqr[2];
+  info_ = table_->info;
   // info_ == -1 if cannot split into primes
   if (info_ == -1)
     assert(!"you probably gave a signal size not of the form 2^p 3^q 5^r");
@@ -33,8 +64,7 @@ template <class T>
 void
 vnl_fft_prime_factors<T>::destruct()
 {
-  if (trigs_)
-    delete[] trigs_;
+  table_.reset();
 }
 
 #undef VNL_FFT_PRIME_FACTORS_INSTANTIATE
@@ -6,12 +6,18 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <cassert>
 #include "vnl_levenberg_marquardt.h"
 #include "vnl/vnl_fastops.h"
+#include "vnl/vnl_gemm.h"
 #include "vnl/vnl_matrix_ref.h"
 #include "vnl/vnl_least_squares_function.h"
+#include "vnl/vnl_thread_pool.h"
+#include <vnl/algo/vnl_cholesky.h>
 #include <vnl/algo/vnl_netlib.h> // lmdif_()
 
 // see header
@@ -24,6 +30,11 @@ vnl_levenberg_marquardt_minimize(vnl_least_squares_function & f, const vnl_vecto
   return x;
 }
 
+vnl_levenberg_marquardt::vnl_levenberg_marquardt(vnl_least_squares_function & f)
+{
+  init(&f);
+}
+
 // ctor
 void
 vnl_levenberg_marquardt::init(vnl_least_squares_function * f)
@@ -126,6 +137,8 @@ vnl_levenberg_marquardt::lmdif_lsqfun(long * n,     // I   Number of residuals
 bool
 vnl_levenberg_marquardt::minimize(vnl_vector<double> & x)
 {
+  if (normal_equations_)
+    return minimize_normal_equations(x);
   if (f_->has_gradient())
     return minimize_using_gradient(x);
   else
@@ -420,6 +433,272 @@ vnl_levenberg_marquardt::minimize_using_gradient(vnl_vector<double> & x)
 
 //--------------------------------------------------------------------------------
 
+//: Set the number of threads used by minimize_normal_equations() (0 = all threads of the default pool).
+void
+vnl_levenberg_marquardt::set_num_threads(unsigned int n)
+{
+  num_threads_ = n;
+}
+
+// The rows of the residual vector are handled in blocks of this many rows.
+// The blocks do not depend on the number of threads, so neither do the results.
+static unsigned int
+vnl_levenberg_marquardt_block_rows(unsigned int m)
+{
+  // at most 64 blocks, to bound the memory for the partial sums of J'J
+  return std::max(256u, (m + 63) / 64);
+}
+
+bool
+vnl_levenberg_marquardt::evaluate(const vnl_vector<double> & x, vnl_vector<double> & fx, vnl_matrix<double> & J)
+{
+  ++num_evaluations_;
+  if (f_->has_residual_rows())
+  {
+    const unsigned int m = fx.size();
+    const unsigned int rows = vnl_levenberg_marquardt_block_rows(m);
+    const unsigned int n_blocks = (m + rows - 1) / rows;
+    auto task = [&](std::size_t b) {
+      const unsigned int first = (unsigned int)b * rows;
+      f_->f_and_gradf_rows(x, first, std::min(first + rows, m), fx, J);
+    };
+    if (num_threads_ != 1)
+      vnl_thread_pool::default_pool().parallel_for(n_blocks, task, num_threads_);
+    else
+      for (unsigned int b = 0; b < n_blocks; ++b)
+        task(b);
+  }
+  else if (f_->has_gradient())
+    f_->f_and_gradf(x, fx, J);
+  else
+  {
+    f_->f(x, fx);
+    if (!f_->failure)
+      fd_jacobian(x, fx, J);
+  }
+
+  if (f_->failure)
+  {
+    f_->clear_failure();
+    return false;
+  }
+  return true;
+}
+
+//: Forward differences, with the same step as lmdif's fdjac2.
+bool
+vnl_levenberg_marquardt::fd_jacobian(const vnl_vector<double> & x,
+                                     const vnl_vector<double> & fx,
+                                     vnl_matrix<double> & J)
+{
+  const double eps = std::sqrt(std::max(epsfcn, std::numeric_limits<double>::epsilon()));
+  vnl_vector<double> xh(x);
+  vnl_vector<double> fh(fx.size());
+  for (unsigned int j = 0; j < x.size(); ++j)
+  {
+    double h = eps * std::abs(x[j]);
+    if (h == 0.0)
+      h = eps;
+    xh[j] = x[j] + h;
+    f_->f(xh, fh);
+    if (f_->failure)
+      return false;
+    for (unsigned int i = 0; i < fx.size(); ++i)
+      J(i, j) = (fh[i] - fx[i]) / h;
+    xh[j] = x[j];
+  }
+  return true;
+}
+
+void
+vnl_levenberg_marquardt::normal_equations(const vnl_matrix<double> & J,
+                                          const vnl_vector<double> & fx,
+                                          vnl_matrix<double> & JtJ,
+                                          vnl_vector<double> & Jtf) const
+{
+  const unsigned int m = J.rows();
+  const unsigned int n = J.cols();
+  const unsigned int rows = vnl_levenberg_marquardt_block_rows(m);
+  const unsigned int n_blocks = (m + rows - 1) / rows;
+
+  std::vector<vnl_matrix<double>> JtJ_part(n_blocks);
+  std::vector<vnl_vector<double>> Jtf_part(n_blocks);
+  auto task = [&](std::size_t b) {
+    const unsigned int first = (unsigned int)b * rows;
+    const unsigned int count = std::min(first + rows, m) - first;
+    JtJ_part[b].set_size(n, n);
+    vnl_gemm(true, false, n, n, count, 1.0, J[first], n, J[first], n, 0.0, JtJ_part[b].data_block(), n);
+    vnl_vector<double> & g = Jtf_part[b];
+    g.set_size(n);
+    g.fill(0.0);
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+      const double * Ji = J[i];
+      for (unsigned int j = 0; j < n; ++j)
+        g[j] += Ji[j] * fx[i];
+    }
+  };
+  if (num_threads_ != 1)
+    vnl_thread_pool::default_pool().parallel_for(n_blocks, task, num_threads_);
+  else
+    for (unsigned int b = 0; b < n_blocks; ++b)
+      task(b);
+
+  JtJ = JtJ_part[0];
+  Jtf = Jtf_part[0];
+  for (unsigned int b = 1; b < n_blocks; ++b)
+  {
+    JtJ += JtJ_part[b];
+    Jtf += Jtf_part[b];
+  }
+}
+
+//
+bool
+vnl_levenberg_marquardt::minimize_normal_equations(vnl_vector<double> & x)
+{
+  const unsigned int m = f_->get_number_of_residuals();
+  const unsigned int n = f_->get_number_of_unknowns();
+
+  if (m < n)
+  {
+    std::cerr << __FILE__ ": Number of unknowns(" << n << ") greater than number of data (" << m << ")\n";
+    failure_code_ = ERROR_DODGY_INPUT;
+    return false;
+  }
+  if (x.size() != n)
+  {
+    std::cerr << __FILE__ ": Input vector length (" << x.size() << ") not equal to num unknowns (" << n << ")\n";
+    failure_code_ = ERROR_DODGY_INPUT;
+    return false;
+  }
+
+  num_iterations_ = 0;
+  num_evaluations_ = 0;
+  set_covariance_ = false;
+  start_error_ = end_error_ = 0;
+
+  vnl_vector<double> fx(m, 0.0), fx_new(m, 0.0);
+  vnl_matrix<double> J(m, n, 0.0), J_new(m, n, 0.0);
+  if (!evaluate(x, fx, J))
+  {
+    failure_code_ = ERROR_FAILURE;
+    return false;
+  }
+  start_error_ = fx.rms();
+  double F = fx.squared_magnitude();
+
+  vnl_matrix<double> JtJ;
+  vnl_vector<double> Jtf;
+  normal_equations(J, fx, JtJ, Jtf);
+
+  // initial damping, relative to the largest diagonal entry of J'J
+  double mu = 0.0;
+  for (unsigned int j = 0; j < n; ++j)
+    mu = std::max(mu, JtJ(j, j));
+  mu = mu > 0.0 ? 1e-3 * mu : 1e-3;
+  double nu = 2.0;
+
+  vnl_vector<double> x_new(n);
+  while (true)
+  {
+    // cosine of the angle between fx and the columns of J
+    double gnorm = 0.0;
+    if (F > 0.0)
+      for (unsigned int j = 0; j < n; ++j)
+        if (JtJ(j, j) > 0.0)
+          gnorm = std::max(gnorm, std::abs(Jtf[j]) / std::sqrt(JtJ(j, j) * F));
+    if (gnorm <= gtol)
+    {
+      failure_code_ = CONVERGED_GTOL;
+      break;
+    }
+    if (num_evaluations_ >= maxfev)
+    {
+      failure_code_ = TOO_MANY_ITERATIONS;
+      break;
+    }
+    if (!(mu < std::numeric_limits<double>::max()))
+    {
+      failure_code_ = FAILED_XTOL_TOO_SMALL;
+      break;
+    }
+
+    // damped step: (J'J + mu I) dx = -J'f
+    vnl_matrix<double> A(JtJ);
+    for (unsigned int j = 0; j < n; ++j)
+      A(j, j) += mu;
+    const vnl_cholesky chol(A, vnl_cholesky::quiet);
+    if (chol.rank_deficiency() > 0)
+    {
+      mu *= nu;
+      nu *= 2.0;
+      continue;
+    }
+    const vnl_vector<double> dx = chol.solve(-Jtf);
+    if (dx.two_norm() <= xtol * (x.two_norm() + xtol))
+    {
+      failure_code_ = CONVERGED_XTOL;
+      break;
+    }
+
+    x_new = x + dx;
+    if (!evaluate(x_new, fx_new, J_new))
+    {
+      failure_code_ = ERROR_FAILURE;
+      break;
+    }
+    const double F_new = fx_new.squared_magnitude();
+    // reduction of the sum of squares predicted by the linear model
+    const double predicted = dot_product(dx, mu * dx - Jtf);
+    const double rho = (F - F_new) / predicted;
+    if (rho > 0.0)
+    {
+      // as in lmdif, both the actual and the predicted reduction must be small
+      const bool small_reduction = F - F_new <= ftol * F && predicted <= ftol * F;
+      x = x_new;
+      fx.swap(fx_new);
+      J.swap(J_new);
+      F = F_new;
+      normal_equations(J, fx, JtJ, Jtf);
+      mu *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * rho - 1.0, 3));
+      nu = 2.0;
+
+      if (trace)
+        std::cerr << "vnl_levenberg_marquardt: iter " << num_iterations_ << " err = " << std::sqrt(F) << '\n';
+      f_->trace(num_iterations_, x, fx);
+      ++num_iterations_;
+      if (small_reduction)
+      {
+        failure_code_ = CONVERGED_FTOL;
+        break;
+      }
+    }
+    else
+    {
+      mu *= nu;
+      nu *= 2.0;
+    }
+  }
+
+  end_error_ = fx.rms();
+  // J'J at the minimum, for get_JtJ()
+  inv_covar_ = JtJ;
+  set_covariance_ = true;
+
+  switch (failure_code_)
+  {
+    case CONVERGED_FTOL:
+    case CONVERGED_XTOL:
+    case CONVERGED_GTOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+//--------------------------------------------------------------------------------
+
 void
 vnl_levenberg_marquardt::diagnose_outcome() const
 {
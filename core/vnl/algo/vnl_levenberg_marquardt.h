@@ -44,7 +44,7 @@ class VNL_ALGO_EXPORT vnl_levenberg_marquardt : public vnl_nonlinear_minimizer
 {
 public:
   //: Initialize with the function object that is to be minimized.
-  vnl_levenberg_marquardt(vnl_least_squares_function & f) { init(&f); }
+  vnl_levenberg_marquardt(vnl_least_squares_function & f);
 
   ~vnl_levenberg_marquardt() override;
 
@@ -62,7 +62,24 @@ public:
   bool
   minimize_using_gradient(vnl_vector<double> & x);
 
-  //: Calls minimize_using_gradient() or minimize_without_gradient(),
+  //: Minimize the function supplied in the constructor until convergence or failure.
+  //  Each step solves the damped normal equations (J'J + mu I) dx = -J'f by
+  //  Cholesky, which is much cheaper than lmdif/lmder when there are many
+  //  more residuals than unknowns.  J'J is accumulated in blocks of rows.
+  //
+  //  The residuals and the Jacobian are evaluated together at each trial
+  //  point, by f_and_gradf_rows() if the function has_residual_rows(), by
+  //  f_and_gradf() if it has_gradient(), and otherwise by forward differences
+  //  like lmdif.  The tolerances have the same meaning as for lmdif:
+  //  ftol on the relative reduction of the sum of squares, xtol on the
+  //  relative size of the step, and gtol on the cosine of the angle between
+  //  the residuals and the columns of the Jacobian.
+  //  Returns true for convergence, false for failure.
+  bool
+  minimize_normal_equations(vnl_vector<double> & x);
+
+  //: Calls minimize_normal_equations() if set_normal_equations(true), and
+  // otherwise minimize_using_gradient() or minimize_without_gradient(),
   // depending on whether the cost function provides a gradient.
   bool
   minimize(vnl_vector<double> & x);
@@ -99,6 +116,21 @@ public:
     return b;
   }
 
+  //: Make minimize() call minimize_normal_equations().  Default is false.
+  void
+  set_normal_equations(bool b)
+  {
+    normal_equations_ = b;
+  }
+
+  //: Set the number of threads used by minimize_normal_equations().
+  //  If the function has_residual_rows(), its rows are evaluated in
+  //  parallel, and J'J is accumulated in parallel in any case, on at most
+  //  n threads of vnl_thread_pool::default_pool() (0 means all of them).
+  //  The result does not depend on the number of threads.  Default is 1.
+  void
+  set_num_threads(unsigned int n);
+
   // Coping with failure-------------------------------------------------------
 
   //: Provide an ASCII diagnosis of the last minimization on std::ostream.
@@ -119,9 +151,28 @@ protected:
   vnl_matrix<double> inv_covar_;
   bool set_covariance_; // Set if covariance_ holds J'*J
 
+  bool normal_equations_{ false };
+  //: As given to set_num_threads(); 1 runs serially
+  unsigned int num_threads_{ 1 };
+
   void
   init(vnl_least_squares_function * f);
 
+  //: Evaluate fx and J at x for minimize_normal_equations(); false if f failed
+  bool
+  evaluate(const vnl_vector<double> & x, vnl_vector<double> & fx, vnl_matrix<double> & J);
+
+  //: Forward difference Jacobian at x, given fx = f(x); false if f failed
+  bool
+  fd_jacobian(const vnl_vector<double> & x, const vnl_vector<double> & fx, vnl_matrix<double> & J);
+
+  //: JtJ = J'J and Jtf = J'fx, summed over fixed blocks of rows
+  void
+  normal_equations(const vnl_matrix<double> & J,
+                   const vnl_vector<double> & fx,
+                   vnl_matrix<double> & JtJ,
+                   vnl_vector<double> & Jtf) const;
+
   // Communication with callback
   static void
   lmdif_lsqfun(long * m, long * n, double * x, double * fx, long * iflag, void * userdata);
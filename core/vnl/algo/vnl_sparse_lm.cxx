@@ -8,13 +8,16 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <algorithm>
 #include "vnl_sparse_lm.h"
 #include "vnl/vnl_fastops.h"
 #include "vnl/vnl_vector_ref.h"
 #include "vnl/vnl_crs_index.h"
 #include "vnl/vnl_sparse_lst_sqr_function.h"
+#include "vnl/vnl_thread_pool.h"
 
+#include <vnl/algo/vnl_block_sparse_cholesky.h>
 #include <vnl/algo/vnl_cholesky.h>
 #include <vnl/algo/vnl_svd.h>
 
@@ -75,6 +78,29 @@ vnl_sparse_lm::init(vnl_sparse_lst_sqr_function * f)
 vnl_sparse_lm::~vnl_sparse_lm() = default;
 
 
+//: Set the number of threads used by minimize() (0 = all threads of the default pool).
+void
+vnl_sparse_lm::set_num_threads(unsigned int n)
+{
+  num_threads_ = n;
+  f_->set_num_threads(n);
+}
+
+
+//: Call task(n) for each n in [0,count), in parallel if set_num_threads() asked for it
+void
+vnl_sparse_lm::for_each_block(unsigned int count, const std::function<void(unsigned int)> & task) const
+{
+  if (num_threads_ == 1)
+  {
+    for (unsigned int n = 0; n < count; ++n)
+      task(n);
+    return;
+  }
+  vnl_thread_pool::default_pool().parallel_for(count, [&](std::size_t n) { task((unsigned int)n); }, num_threads_);
+}
+
+
 //: Minimize the function supplied in the constructor until convergence or failure.
 //  On return, a, b, and c are such that f(a,b,c) is the lowest value achieved.
 //  Returns true for convergence, false for failure.
@@ -95,7 +121,16 @@ vnl_sparse_lm::minimize(vnl_vector<double> & a,
 
   //: Systems to solve will be Sc*dc=sec and Sa*da=sea
   const vnl_matrix<double> Sc(size_c_, size_c_);
-  vnl_matrix<double> Sa(size_a_, size_a_);
+  // the dense Sa is only needed by the dense solver
+  const bool dense = schur_solver_ == dense_cholesky;
+  vnl_matrix<double> Sa(dense ? size_a_ : 0, dense ? size_a_ : 0);
+  if (!dense)
+  {
+    if (S_ptr_.empty())
+      allocate_sparse_Sa();
+    // the solver may have been changed since the last call
+    allocate_schur_solver();
+  }
   const vnl_vector<double> sec(size_c_);
   vnl_vector<double> sea(size_a_);
   // update vectors
@@ -166,15 +201,46 @@ vnl_sparse_lm::minimize(vnl_vector<double> & a,
       mu = tau_ * diag_UVT.inf_norm();
 
     // Re-solve the system while adapting mu until we decrease error or converge
+    bool mu_overflow = false;
     while (true)
     {
+      // mu grows without bound if the system never solves or the error never
+      // decreases, e.g. with NaN or inf in the Jacobian
+      if (!(mu < std::numeric_limits<double>::max()))
+      {
+        failure_code_ = FAILED_XTOL_TOO_SMALL;
+        mu_overflow = true;
+        break;
+      }
+
       // augment the diagonals with damping term mu
       set_diagonal(diag_UVT + mu);
 
       // compute inv(Vj) and Yij
       compute_invV_Y();
 
-      if (size_c_ > 0)
+      bool solved = true;
+      if (size_c_ > 0 && !dense)
+      {
+        // compute Z = RYt-Q and the sparse Sa
+        compute_Z_S();
+
+        // construct Ma = Z*inv(Sa) and Mb = (R+MaW)inv(V)
+        solved = factor_S() && compute_Ma_sparse();
+        if (solved)
+        {
+          compute_Mb();
+
+          // use Ma and Mb to solve for dc
+          solve_dc(dc);
+
+          // compute sea from ea, Z, dc, Y, and eb
+          compute_sea(dc, sea);
+
+          solved = solve_S(sea, da);
+        }
+      }
+      else if (size_c_ > 0)
       {
         // compute Z = RYt-Q and Sa
         compute_Z_Sa(Sa);
@@ -210,7 +276,7 @@ vnl_sparse_lm::minimize(vnl_vector<double> & a,
           da = Sa_cholesky.solve(sea);
         delete Sa_svd;
       }
-      else // size_c_ == 0
+      else if (dense) // size_c_ == 0
       {
         // |I -W*inv(V)| * |U  W| * |da| = |I -W*inv(V)| * |ea|
         // |0     I    |   |Wt V|   |db|   |0     I    |   |eb|
@@ -240,6 +306,21 @@ vnl_sparse_lm::minimize(vnl_vector<double> & a,
         else
           da = Sa_cholesky.solve(sea);
       }
+      else if (!dense)
+      {
+        // as above, but with the sparse Sa
+        compute_S_sea(sea);
+        solved = factor_S() && solve_S(sea, da);
+      }
+
+      if (!solved)
+      {
+        // the sparse Sa is not numerically positive definite, or conjugate
+        // gradients did not converge, so increase the damping
+        mu *= nu;
+        nu *= 2.0;
+        continue;
+      }
 
       // substitute da and dc to compute db
       backsolve_db(da, dc, db);
@@ -298,6 +379,8 @@ vnl_sparse_lm::minimize(vnl_vector<double> & a,
                   << std::sqrt(sqr_error / e_.size()) << " mu = " << std::setprecision(6) << std::setw(12) << mu
                   << " nu = " << nu << std::endl;
     }
+    if (mu_overflow)
+      break;
   }
 
 
@@ -403,6 +486,38 @@ vnl_sparse_lm::allocate_matrices()
     Mb_[j].set_size(size_c_, bj_size);
     inv_V_[j].set_size(bj_size, bj_size);
   }
+
+  // Index the residual blocks by column, so that each b_j can be processed
+  // without scanning all a_i (as crs.sparse_col(j) does)
+  b_ptr_.assign(num_b_ + 1, 0);
+  b_blocks_.resize(num_nz_);
+  for (int i = 0; i < num_a_; ++i)
+    for (const auto & r_itr : crs.sparse_row(i))
+      ++b_ptr_[r_itr.second + 1];
+  for (int j = 0; j < num_b_; ++j)
+    b_ptr_[j + 1] += b_ptr_[j];
+  std::vector<unsigned int> fill(b_ptr_.begin(), b_ptr_.end() - 1);
+  for (int i = 0; i < num_a_; ++i)
+    for (const auto & r_itr : crs.sparse_row(i))
+      b_blocks_[fill[r_itr.second]++] = std::make_pair(unsigned(r_itr.first), unsigned(i));
+
+  // Split the a_i into runs of about run_size residual blocks for the sums
+  // into T and ec.  The split depends only on the problem, not on the number
+  // of threads, so neither do the sums.
+  constexpr int run_size = 1024;
+  a_runs_.assign(1, 0);
+  int run_blocks = 0;
+  for (int i = 0; i < num_a_; ++i)
+  {
+    run_blocks += 1 + int(crs.sparse_row(i).size());
+    if (run_blocks >= run_size || i + 1 == num_a_)
+    {
+      a_runs_.push_back(i + 1);
+      run_blocks = 0;
+    }
+  }
+  T_runs_.assign(a_runs_.size() - 1, vnl_matrix<double>(size_c_, size_c_));
+  ec_runs_.assign(a_runs_.size() - 1, vnl_vector<double>(size_c_));
 }
 
 
@@ -412,57 +527,78 @@ vnl_sparse_lm::compute_normal_equations()
 {
   // CRS matrix of indices into e, A, B, C, W, Y
   const vnl_crs_index & crs = f_->residual_indices();
-  // sparse vector iterator
 
-  // clear the ea and eb for summation
-  ea_.fill(0.0);
-  eb_.fill(0.0);
-  ec_.fill(0.0);
-  // clear the V for summation
-  for (unsigned int j = 0; j < f_->number_of_b(); ++j)
-  {
-    V_[j].fill(0.0);
-    R_[j].fill(0.0);
-  }
-  T_.fill(0.0);
   // compute blocks T, Q, R, U, V, W, ea, eb, and ec
   // JtJ = |T  Q  R|
   //       |Qt U  W|  with U and V block diagonal
   //       |Rt Wt V|  and W with same sparsity as residuals
-  for (unsigned int i = 0; i < f_->number_of_a(); ++i)
-  {
-    vnl_matrix<double> & Ui = U_[i];
-    Ui.fill(0.0);
-    vnl_matrix<double> & Qi = Q_[i];
-    Qi.fill(0.0);
-    const unsigned int ai_size = f_->number_of_params_a(i);
-    vnl_vector_ref<double> eai(ai_size, ea_.data_block() + f_->index_a(i));
+  //
+  // Each Ui, Qi, Wij and ea_i depends only on the residuals of a_i, and each
+  // Vj, Rj and eb_j only on those of b_j, so these are computed by a_i and
+  // then by b_j.  T and ec are summed over runs of a_i and then over runs.
+  for_each_block(unsigned(a_runs_.size() - 1), [&](unsigned int r) {
+    vnl_matrix<double> & Tr = T_runs_[r];
+    vnl_vector<double> & ecr = ec_runs_[r];
+    Tr.fill(0.0);
+    ecr.fill(0.0);
+    for (unsigned int i = a_runs_[r]; i < a_runs_[r + 1]; ++i)
+    {
+      vnl_matrix<double> & Ui = U_[i];
+      Ui.fill(0.0);
+      vnl_matrix<double> & Qi = Q_[i];
+      Qi.fill(0.0);
+      const unsigned int ai_size = f_->number_of_params_a(i);
+      vnl_vector_ref<double> eai(ai_size, ea_.data_block() + f_->index_a(i));
+      eai.fill(0.0);
+
+      const vnl_crs_index::sparse_vector row = crs.sparse_row(i);
+      for (auto & r_itr : row)
+      {
+        const unsigned int k = r_itr.first;
+        const vnl_matrix<double> & Aij = A_[k];
+        const vnl_matrix<double> & Bij = B_[k];
+        const vnl_matrix<double> & Cij = C_[k];
+
+        vnl_fastops::inc_X_by_AtA(Tr, Cij);      // T = C^T * C
+        vnl_fastops::inc_X_by_AtA(Ui, Aij);      // Ui += A_ij^T * A_ij
+        vnl_fastops::AtB(W_[k], Aij, Bij);       // Wij = A_ij^T * B_ij
+        vnl_fastops::inc_X_by_AtB(Qi, Cij, Aij); // Qi += C_ij^T * A_ij
+
+        const vnl_vector_ref<double> eij(f_->number_of_residuals(k), e_.data_block() + f_->index_e(k));
+        vnl_fastops::inc_X_by_AtB(eai, Aij, eij); // e_a_i += A_ij^T * e_ij
+        vnl_fastops::inc_X_by_AtB(ecr, Cij, eij); // e_c   += C_ij^T * e_ij
+      }
+    }
+  });
 
-    const vnl_crs_index::sparse_vector row = crs.sparse_row(i);
-    for (auto & r_itr : row)
+  for_each_block(num_b_, [&](unsigned int j) {
+    vnl_matrix<double> & Vj = V_[j];
+    Vj.fill(0.0);
+    vnl_matrix<double> & Rj = R_[j];
+    Rj.fill(0.0);
+    vnl_vector_ref<double> ebj(f_->number_of_params_b(j), eb_.data_block() + f_->index_b(j));
+    ebj.fill(0.0);
+
+    for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
     {
-      const unsigned int j = r_itr.second;
-      const unsigned int k = r_itr.first;
-      ;
-      const vnl_matrix<double> & Aij = A_[k];
+      const unsigned int k = b_blocks_[n].first;
       const vnl_matrix<double> & Bij = B_[k];
       const vnl_matrix<double> & Cij = C_[k];
-      vnl_matrix<double> & Vj = V_[j];
-      vnl_matrix<double> & Rj = R_[j];
-      vnl_vector_ref<double> ebj(Bij.cols(), eb_.data_block() + f_->index_b(j));
 
-      vnl_fastops::inc_X_by_AtA(T_, Cij);      // T = C^T * C
-      vnl_fastops::inc_X_by_AtA(Ui, Aij);      // Ui += A_ij^T * A_ij
       vnl_fastops::inc_X_by_AtA(Vj, Bij);      // Vj += B_ij^T * B_ij
-      vnl_fastops::AtB(W_[k], Aij, Bij);       // Wij = A_ij^T * B_ij
-      vnl_fastops::inc_X_by_AtB(Qi, Cij, Aij); // Qi += C_ij^T * A_ij
       vnl_fastops::inc_X_by_AtB(Rj, Cij, Bij); // Rj += C_ij^T * B_ij
 
       const vnl_vector_ref<double> eij(f_->number_of_residuals(k), e_.data_block() + f_->index_e(k));
-      vnl_fastops::inc_X_by_AtB(eai, Aij, eij); // e_a_i += A_ij^T * e_ij
       vnl_fastops::inc_X_by_AtB(ebj, Bij, eij); // e_b_j += B_ij^T * e_ij
-      vnl_fastops::inc_X_by_AtB(ec_, Cij, eij); // e_c   += C_ij^T * e_ij
     }
+  });
+
+  T_.fill(0.0);
+  ec_.fill(0.0);
+  for (unsigned int r = 0; r + 1 < a_runs_.size(); ++r)
+  {
+    T_ += T_runs_[r];
+    ec_ += ec_runs_[r];
   }
 }
 
@@ -519,11 +655,7 @@ vnl_sparse_lm::set_diagonal(const vnl_vector<double> & diag)
 void
 vnl_sparse_lm::compute_invV_Y()
 {
-  // CRS matrix of indices into e, A, B, C, W, Y
-  const vnl_crs_index & crs = f_->residual_indices();
-
-  for (int j = 0; j < num_b_; ++j)
-  {
+  for_each_block(num_b_, [&](unsigned int j) {
     vnl_matrix<double> & inv_Vj = inv_V_[j];
     const vnl_cholesky Vj_cholesky(V_[j], vnl_cholesky::quiet);
     // use SVD as a backup if Cholesky is deficient
@@ -535,13 +667,12 @@ vnl_sparse_lm::compute_invV_Y()
     else
       inv_Vj = Vj_cholesky.inverse();
 
-    const vnl_crs_index::sparse_vector col = crs.sparse_col(j);
-    for (auto & c_itr : col)
+    for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
     {
-      const unsigned int k = c_itr.first;
+      const unsigned int k = b_blocks_[n].first;
       Y_[k] = W_[k] * inv_Vj; // Y_ij = W_ij * inv(V_j)
     }
-  }
+  });
 }
 
 
@@ -554,8 +685,8 @@ vnl_sparse_lm::compute_Z_Sa(vnl_matrix<double> & Sa)
   // sparse vector iterator
 
   // compute Z = RYt-Q and Sa
-  for (int i = 0; i < num_a_; ++i)
-  {
+  // row i of blocks writes Zi and the blocks (i,h) and (h,i) of Sa for h >= i only
+  for_each_block(num_a_, [&](unsigned int i) {
     vnl_crs_index::sparse_vector row_i = crs.sparse_row(i);
     vnl_matrix<double> & Zi = Z_[i];
     Zi.fill(0.0);
@@ -574,7 +705,7 @@ vnl_sparse_lm::compute_Z_Sa(vnl_matrix<double> & Sa)
     Sa.update(Sii, f_->index_a(i), f_->index_a(i));
 
     // handle the (symmetric) off diagonal blocks
-    for (int h = i + 1; h < num_a_; ++h)
+    for (int h = int(i) + 1; h < num_a_; ++h)
     {
       vnl_crs_index::sparse_vector row_h = crs.sparse_row(h);
       vnl_matrix<double> Sih(f_->number_of_params_a(i), f_->number_of_params_a(h), 0.0);
@@ -599,7 +730,7 @@ vnl_sparse_lm::compute_Z_Sa(vnl_matrix<double> & Sa)
       Sa.update(Sih, f_->index_a(i), f_->index_a(h));
       Sa.update(Sih.transpose(), f_->index_a(h), f_->index_a(i));
     }
-  }
+  });
 }
 
 
@@ -608,46 +739,301 @@ void
 vnl_sparse_lm::compute_Ma(const vnl_matrix<double> & H)
 {
   // construct Ma = ZH
-  vnl_matrix<double> Hik;
-  for (int i = 0; i < num_a_; ++i)
-  {
+  for_each_block(num_a_, [&](unsigned int i) {
+    vnl_matrix<double> Hki;
     vnl_matrix<double> & Mai = Ma_[i];
     Mai.fill(0.0);
 
     for (int k = 0; k < num_a_; ++k)
     {
-      Hik.set_size(f_->number_of_params_a(i), f_->number_of_params_a(k));
-      H.extract(Hik, f_->index_a(i), f_->index_a(k));
-      vnl_fastops::inc_X_by_AB(Mai, Z_[k], Hik);
+      Hki.set_size(f_->number_of_params_a(k), f_->number_of_params_a(i));
+      H.extract(Hki, f_->index_a(k), f_->index_a(i));
+      vnl_fastops::inc_X_by_AB(Mai, Z_[k], Hki);
     }
+  });
+}
+
+
+//: set up the block structure of the sparse Sa
+void
+vnl_sparse_lm::allocate_sparse_Sa()
+{
+  // CRS matrix of indices into e, A, B, C, W, Y
+  const vnl_crs_index & crs = f_->residual_indices();
+
+  // block (i,h) of Sa is non-zero if a_i and a_h share some b_j
+  S_ptr_.assign(1, 0);
+  S_col_.clear();
+  std::vector<unsigned int> cols;
+  for (int i = 0; i < num_a_; ++i)
+  {
+    cols.assign(1, i);
+    for (const auto & r_itr : crs.sparse_row(i))
+    {
+      const unsigned int j = r_itr.second;
+      for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
+        if (int(b_blocks_[n].second) > i)
+          cols.push_back(b_blocks_[n].second);
+    }
+    std::sort(cols.begin() + 1, cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    S_col_.insert(S_col_.end(), cols.begin(), cols.end());
+    S_ptr_.push_back((unsigned int)S_col_.size());
   }
+
+  S_.resize(S_col_.size());
+  std::vector<unsigned int> lower_count(num_a_ + 1, 0);
+  for (int i = 0; i < num_a_; ++i)
+    for (unsigned int e = S_ptr_[i]; e < S_ptr_[i + 1]; ++e)
+    {
+      S_[e].set_size(f_->number_of_params_a(i), f_->number_of_params_a(S_col_[e]));
+      if (e > S_ptr_[i])
+        ++lower_count[S_col_[e] + 1];
+    }
+
+  // index the blocks below the diagonal by row, for the products in conjugate gradients
+  S_lower_ptr_.assign(num_a_ + 1, 0);
+  for (int h = 0; h < num_a_; ++h)
+    S_lower_ptr_[h + 1] = S_lower_ptr_[h] + lower_count[h + 1];
+  S_lower_col_.resize(S_lower_ptr_[num_a_]);
+  S_lower_idx_.resize(S_lower_ptr_[num_a_]);
+  std::vector<unsigned int> fill(S_lower_ptr_.begin(), S_lower_ptr_.end() - 1);
+  for (int i = 0; i < num_a_; ++i)
+    for (unsigned int e = S_ptr_[i] + 1; e < S_ptr_[i + 1]; ++e)
+    {
+      S_lower_col_[fill[S_col_[e]]] = i;
+      S_lower_idx_[fill[S_col_[e]]++] = e;
+    }
+
 }
 
 
-//: compute Mb
+//: set up the state of the selected sparse solver, if not done already
 void
-vnl_sparse_lm::compute_Mb()
+vnl_sparse_lm::allocate_schur_solver()
+{
+  if (schur_solver_ == sparse_cholesky && !S_cholesky_)
+  {
+    std::vector<unsigned int> sizes(num_a_);
+    for (int i = 0; i < num_a_; ++i)
+      sizes[i] = f_->number_of_params_a(i);
+    S_cholesky_.reset(new vnl_block_sparse_cholesky(sizes, S_ptr_, S_col_));
+  }
+  else if (schur_solver_ == preconditioned_cg && S_inv_diag_.size() != std::size_t(num_a_))
+    S_inv_diag_.resize(num_a_);
+}
+
+
+//: compute block row i of the sparse Sa
+void
+vnl_sparse_lm::compute_S_row(unsigned int i)
 {
   // CRS matrix of indices into e, A, B, C, W, Y
   const vnl_crs_index & crs = f_->residual_indices();
 
-  vnl_matrix<double> temp;
-  // construct Mb = (-R-MaW)inv(V)
-  for (int j = 0; j < num_b_; ++j)
+  const auto first = S_col_.begin() + S_ptr_[i];
+  const auto last = S_col_.begin() + S_ptr_[i + 1];
+  S_[S_ptr_[i]] = U_[i]; // copy Ui to initialize Sii
+  for (unsigned int e = S_ptr_[i] + 1; e < S_ptr_[i + 1]; ++e)
+    S_[e].fill(0.0);
+
+  // S_ih -= Y_ij * W_hj^T for all b_j shared by a_i and a_h, h >= i
+  for (const auto & ri : crs.sparse_row(i))
   {
-    temp.set_size(size_c_, f_->number_of_params_b(j));
-    temp.fill(0.0);
+    const unsigned int j = ri.second;
+    const vnl_matrix<double> & Yij = Y_[ri.first];
+    for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
+    {
+      const unsigned int h = b_blocks_[n].second;
+      if (h < i)
+        continue;
+      const auto it = std::lower_bound(first, last, h);
+      vnl_fastops::dec_X_by_ABt(S_[it - S_col_.begin()], Yij, W_[b_blocks_[n].first]);
+    }
+  }
+}
+
+
+//: compute Z and the sparse Sa
+void
+vnl_sparse_lm::compute_Z_S()
+{
+  // CRS matrix of indices into e, A, B, C, W, Y
+  const vnl_crs_index & crs = f_->residual_indices();
+
+  // compute Z = RYt-Q and Sa
+  for_each_block(num_a_, [&](unsigned int i) {
+    vnl_matrix<double> & Zi = Z_[i];
+    Zi.fill(0.0);
+    Zi -= Q_[i];
+    for (const auto & ri : crs.sparse_row(i))
+      vnl_fastops::inc_X_by_ABt(Zi, R_[ri.second], Y_[ri.first]); // Z_i  += R_j * Y_ij^T
+
+    compute_S_row(i);
+  });
+}
+
+
+//: compute the sparse Sa and sea
+// only used when size_c_ == 0
+void
+vnl_sparse_lm::compute_S_sea(vnl_vector<double> & sea)
+{
+  // CRS matrix of indices into e, A, B, C, W, Y
+  const vnl_crs_index & crs = f_->residual_indices();
+
+  sea = ea_; // initialize se to ea_
+  for_each_block(num_a_, [&](unsigned int i) {
+    vnl_vector_ref<double> sei(f_->number_of_params_a(i), sea.data_block() + f_->index_a(i));
+    for (const auto & ri : crs.sparse_row(i))
+    {
+      const vnl_matrix<double> & Yij = Y_[ri.first];
+      const vnl_vector_ref<double> ebj(Yij.cols(), eb_.data_block() + f_->index_b(ri.second));
+      sei -= Yij * ebj; // se_i -= Y_ij * e_b_j
+    }
+
+    compute_S_row(i);
+  });
+}
+
+
+//: factor the sparse Sa, or invert its diagonal blocks for conjugate gradients
+bool
+vnl_sparse_lm::factor_S()
+{
+  if (schur_solver_ == sparse_cholesky)
+    return S_cholesky_->factor(S_);
+
+  // block Jacobi preconditioner
+  std::vector<char> ok(num_a_, 1);
+  for_each_block(num_a_, [&](unsigned int i) {
+    const vnl_cholesky Sii_cholesky(S_[S_ptr_[i]], vnl_cholesky::quiet);
+    if (Sii_cholesky.rank_deficiency() > 0)
+      ok[i] = 0;
+    else
+      S_inv_diag_[i] = Sii_cholesky.inverse();
+  });
+  return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+
+//: solve Sa*x = b with the sparse Sa
+bool
+vnl_sparse_lm::solve_S(const vnl_vector<double> & b, vnl_vector<double> & x) const
+{
+  if (schur_solver_ == sparse_cholesky)
+  {
+    S_cholesky_->solve(b, x);
+    return true;
+  }
+
+  // y = Sa * v, one block row at a time
+  auto multiply = [&](const vnl_vector<double> & v, vnl_vector<double> & y) {
+    for_each_block(num_a_, [&](unsigned int i) {
+      vnl_vector_ref<double> yi(f_->number_of_params_a(i), y.data_block() + f_->index_a(i));
+      yi.fill(0.0);
+      for (unsigned int e = S_ptr_[i]; e < S_ptr_[i + 1]; ++e)
+      {
+        const vnl_matrix<double> & Sih = S_[e];
+        const double * vh = v.data_block() + f_->index_a(S_col_[e]);
+        for (unsigned int r = 0; r < Sih.rows(); ++r)
+        {
+          const double * row = Sih[r];
+          double sum = 0.0;
+          for (unsigned int c = 0; c < Sih.cols(); ++c)
+            sum += row[c] * vh[c];
+          yi[r] += sum;
+        }
+      }
+      for (unsigned int n = S_lower_ptr_[i]; n < S_lower_ptr_[i + 1]; ++n)
+      {
+        const vnl_matrix<double> & Shi = S_[S_lower_idx_[n]];
+        const vnl_vector_ref<double> vh(Shi.rows(), const_cast<double *>(v.data_block()) + f_->index_a(S_lower_col_[n]));
+        vnl_fastops::inc_X_by_AtB(yi, Shi, vh);
+      }
+    });
+  };
+  // z = inv(diag(Sa)) * r
+  auto precondition = [&](const vnl_vector<double> & r, vnl_vector<double> & z) {
+    for_each_block(num_a_, [&](unsigned int i) {
+      const unsigned int ai_size = f_->number_of_params_a(i);
+      vnl_vector_ref<double> zi(ai_size, z.data_block() + f_->index_a(i));
+      const vnl_vector_ref<double> ri(ai_size, const_cast<double *>(r.data_block()) + f_->index_a(i));
+      vnl_fastops::Ab(zi, S_inv_diag_[i], ri);
+    });
+  };
+
+  x.set_size(size_a_);
+  x.fill(0.0);
+  const double b_norm = b.two_norm();
+  if (b_norm == 0.0)
+    return true;
+
+  vnl_vector<double> r(b), z(size_a_), p(size_a_), q(size_a_);
+  precondition(r, z);
+  p = z;
+  double rz = dot_product(r, z);
+  const unsigned int max_iterations = cg_max_iterations_ > 0 ? cg_max_iterations_ : size_a_;
+  for (unsigned int k = 0; k < max_iterations; ++k)
+  {
+    multiply(p, q);
+    const double pq = dot_product(p, q);
+    if (!(pq > 0.0))
+      return false;
+    const double alpha = rz / pq;
+    x += alpha * p;
+    r -= alpha * q;
+    if (r.two_norm() <= cg_tol_ * b_norm)
+      return true;
+    precondition(r, z);
+    const double rz_new = dot_product(r, z);
+    p *= rz_new / rz;
+    p += z;
+    rz = rz_new;
+  }
+  // not converged in max_iterations
+  return false;
+}
+
+
+//: compute Ma = Z*inv(Sa) with the sparse Sa
+bool
+vnl_sparse_lm::compute_Ma_sparse()
+{
+  // Sa is symmetric, so row r of Ma is inv(Sa) times row r of Z
+  vnl_vector<double> z(size_a_), m;
+  for (int r = 0; r < size_c_; ++r)
+  {
+    for (int i = 0; i < num_a_; ++i)
+      for (unsigned int c = 0; c < Z_[i].cols(); ++c)
+        z[f_->index_a(i) + c] = Z_[i](r, c);
+    if (!solve_S(z, m))
+      return false;
+    for (int i = 0; i < num_a_; ++i)
+      for (unsigned int c = 0; c < Ma_[i].cols(); ++c)
+        Ma_[i](r, c) = m[f_->index_a(i) + c];
+  }
+  return true;
+}
+
+
+//: compute Mb
+void
+vnl_sparse_lm::compute_Mb()
+{
+  // construct Mb = (-R-MaW)inv(V)
+  for_each_block(num_b_, [&](unsigned int j) {
+    vnl_matrix<double> temp(size_c_, f_->number_of_params_b(j), 0.0);
     temp -= R_[j];
 
-    const vnl_crs_index::sparse_vector col = crs.sparse_col(j);
-    for (auto & c_itr : col)
+    for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
     {
-      const unsigned int k = c_itr.first;
-      const unsigned int i = c_itr.second;
+      const unsigned int k = b_blocks_[n].first;
+      const unsigned int i = b_blocks_[n].second;
       vnl_fastops::dec_X_by_AB(temp, Ma_[i], W_[k]);
     }
     vnl_fastops::AB(Mb_[j], temp, inv_V_[j]);
-  }
+  });
 }
 
 
@@ -702,8 +1088,7 @@ vnl_sparse_lm::compute_sea(const vnl_vector<double> & dc, vnl_vector<double> & s
   // sparse vector iterator
 
   sea = ea_; // initialize se to ea_
-  for (int i = 0; i < num_a_; ++i)
-  {
+  for_each_block(num_a_, [&](unsigned int i) {
     vnl_vector_ref<double> sei(f_->number_of_params_a(i), sea.data_block() + f_->index_a(i));
     const vnl_crs_index::sparse_vector row_i = crs.sparse_row(i);
 
@@ -716,7 +1101,7 @@ vnl_sparse_lm::compute_sea(const vnl_vector<double> & dc, vnl_vector<double> & s
       const vnl_vector_ref<double> ebj(Yij.cols(), eb_.data_block() + f_->index_b(ri.second));
       sei -= Yij * ebj; // se_i -= Y_ij * e_b_j
     }
-  }
+  });
 }
 
 
@@ -729,8 +1114,7 @@ vnl_sparse_lm::compute_Sa_sea(vnl_matrix<double> & Sa, vnl_vector<double> & sea)
   const vnl_crs_index & crs = f_->residual_indices();
 
   sea = ea_; // initialize se to ea_
-  for (int i = 0; i < num_a_; ++i)
-  {
+  for_each_block(num_a_, [&](unsigned int i) {
     vnl_vector_ref<double> sei(f_->number_of_params_a(i), sea.data_block() + f_->index_a(i));
     vnl_crs_index::sparse_vector row_i = crs.sparse_row(i);
 
@@ -747,7 +1131,7 @@ vnl_sparse_lm::compute_Sa_sea(vnl_matrix<double> & Sa, vnl_vector<double> & sea)
     Sa.update(Sii, f_->index_a(i), f_->index_a(i));
 
     // handle the (symmetric) off diagonal blocks
-    for (int h = i + 1; h < num_a_; ++h)
+    for (int h = int(i) + 1; h < num_a_; ++h)
     {
       vnl_crs_index::sparse_vector row_h = crs.sparse_row(h);
       vnl_matrix<double> Sih(f_->number_of_params_a(i), f_->number_of_params_a(h), 0.0);
@@ -772,7 +1156,7 @@ vnl_sparse_lm::compute_Sa_sea(vnl_matrix<double> & Sa, vnl_vector<double> & sea)
       Sa.update(Sih, f_->index_a(i), f_->index_a(h));
       Sa.update(Sih.transpose(), f_->index_a(h), f_->index_a(i));
     }
-  }
+  });
 }
 
 
@@ -780,29 +1164,23 @@ vnl_sparse_lm::compute_Sa_sea(vnl_matrix<double> & Sa, vnl_vector<double> & sea)
 void
 vnl_sparse_lm::backsolve_db(const vnl_vector<double> & da, const vnl_vector<double> & dc, vnl_vector<double> & db)
 {
-  // CRS matrix of indices into e, A, B, C, W, Y
-  const vnl_crs_index & crs = f_->residual_indices();
-  // sparse vector iterator
-
-  for (int j = 0; j < num_b_; ++j)
-  {
+  for_each_block(num_b_, [&](unsigned int j) {
     vnl_vector<double> seb(eb_.data_block() + f_->index_b(j), f_->number_of_params_b(j));
-    const vnl_crs_index::sparse_vector col = crs.sparse_col(j);
     if (size_c_ > 0)
     {
       vnl_fastops::dec_X_by_AtB(seb, R_[j], dc);
     }
-    for (auto & c_itr : col)
+    for (unsigned int n = b_ptr_[j]; n < b_ptr_[j + 1]; ++n)
     {
-      const unsigned int k = c_itr.first;
-      const unsigned int i = c_itr.second;
+      const unsigned int k = b_blocks_[n].first;
+      const unsigned int i = b_blocks_[n].second;
       const vnl_vector_ref<double> dai(f_->number_of_params_a(i),
                                        const_cast<double *>(da.data_block() + f_->index_a(i)));
       vnl_fastops::dec_X_by_AtB(seb, W_[k], dai);
     }
     vnl_vector_ref<double> dbi(f_->number_of_params_b(j), db.data_block() + f_->index_b(j));
     vnl_fastops::Ab(dbi, inv_V_[j], seb);
-  }
+  });
 }
 
 //------------------------------------------------------------------------------
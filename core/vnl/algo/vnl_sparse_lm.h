@@ -13,7 +13,9 @@
 // \endverbatim
 //
 
+#include <functional>
 #include <iosfwd>
+#include <memory>
 #include <vector>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
@@ -25,6 +27,7 @@
 #include <vnl/algo/vnl_algo_export.h>
 
 class vnl_sparse_lst_sqr_function;
+class vnl_block_sparse_cholesky;
 
 //: Sparse Levenberg Marquardt nonlinear least squares
 //  Unlike vnl_levenberg_marquardt this does not use the MINPACK routines.
@@ -35,6 +38,14 @@ class vnl_sparse_lst_sqr_function;
 class VNL_ALGO_EXPORT vnl_sparse_lm : public vnl_nonlinear_minimizer
 {
 public:
+  //: Methods for solving the reduced camera system Sa*da = sea
+  enum SchurSolver
+  {
+    dense_cholesky,   //!< dense Sa, Cholesky with an SVD fallback (default)
+    sparse_cholesky,  //!< block sparse Sa, supernodal Cholesky (vnl_block_sparse_cholesky)
+    preconditioned_cg //!< block sparse Sa, conjugate gradients with a block Jacobi preconditioner
+  };
+
   //: Initialize with the function object that is to be minimized.
   vnl_sparse_lm(vnl_sparse_lst_sqr_function & f);
 
@@ -55,6 +66,41 @@ public:
            bool use_gradient = true,
            bool use_weights = true);
 
+  //: Set the number of threads used by minimize().
+  //  With more than one thread the normal equations, the Schur complement
+  //  and the back substitution are built from independent blocks in
+  //  parallel, on at most n threads of vnl_thread_pool::default_pool()
+  //  (0 means all of them).  This also calls set_num_threads(n) on the function, so that
+  //  its default residual, Jacobian and weight loops run in parallel too;
+  //  call f.set_num_threads(1) afterwards if its per-block methods are not
+  //  safe to call concurrently.
+  //  The result does not depend on the number of threads.  Default is 1.
+  void
+  set_num_threads(unsigned int n);
+
+  //: Choose how the reduced camera system Sa*da = sea is solved.
+  //  The dense Sa has size_a^2 entries.  The sparse methods only store the
+  //  blocks of Sa for pairs of a_i that share a b_j, which is much less when
+  //  each b_j depends on few a_i (e.g. points seen by few cameras).
+  //  If the sparse Sa is not numerically positive definite the damping is
+  //  increased, instead of falling back to an SVD.
+  void
+  set_schur_solver(SchurSolver s)
+  {
+    schur_solver_ = s;
+  }
+
+  //: Stop conjugate gradients when |residual| <= tol*|sea|, or after
+  //  max_iterations iterations (0 means the number of parameters in a).
+  //  If the tolerance is not reached by then, the step is rejected and the
+  //  damping increased, as when Sa is not positive definite.
+  void
+  set_cg_tolerance(double tol, unsigned int max_iterations = 0)
+  {
+    cg_tol_ = tol;
+    cg_max_iterations_ = max_iterations;
+  }
+
   // Coping with failure-------------------------------------------------------
 
   //: Provide an ASCII diagnosis of the last minimization on std::ostream.
@@ -95,6 +141,10 @@ private:
   bool
   check_vector_sizes(const vnl_vector<double> & a, const vnl_vector<double> & b, const vnl_vector<double> & c);
 
+  //: Call task(n) for each n in [0,count), in parallel if set_num_threads() asked for it
+  void
+  for_each_block(unsigned int count, const std::function<void(unsigned int)> & task) const;
+
   //: compute the blocks making up the the normal equations: Jt J d = Jt e
   void
   compute_normal_equations();
@@ -136,6 +186,42 @@ private:
   void
   compute_Sa_sea(vnl_matrix<double> & Sa, vnl_vector<double> & sea);
 
+  //: set up the block structure of the sparse Sa
+  void
+  allocate_sparse_Sa();
+
+  //: set up the state of the selected sparse solver, if not done already
+  void
+  allocate_schur_solver();
+
+  //: compute block row i of the sparse Sa
+  void
+  compute_S_row(unsigned int i);
+
+  //: compute Z and the sparse Sa
+  void
+  compute_Z_S();
+
+  //: compute the sparse Sa and sea
+  // only used when size_c_ == 0
+  void
+  compute_S_sea(vnl_vector<double> & sea);
+
+  //: factor the sparse Sa, or invert its diagonal blocks for conjugate gradients.
+  //  Returns false if Sa is not numerically positive definite.
+  bool
+  factor_S();
+
+  //: solve Sa*x = b with the sparse Sa.
+  //  Returns false if Sa is not positive definite or conjugate gradients
+  //  did not converge.
+  bool
+  solve_S(const vnl_vector<double> & b, vnl_vector<double> & x) const;
+
+  //: compute Ma = Z*inv(Sa) with the sparse Sa
+  bool
+  compute_Ma_sparse();
+
   //: back solve to find db using da and dc
   void
   backsolve_db(const vnl_vector<double> & da, const vnl_vector<double> & dc, vnl_vector<double> & db);
@@ -181,6 +267,39 @@ private:
   std::vector<vnl_matrix<double>> Z_;
   std::vector<vnl_matrix<double>> Ma_;
   std::vector<vnl_matrix<double>> Mb_;
+
+  //: The residual blocks of each b_j, as (k, i) pairs in increasing i.
+  //  Those of b_j are b_blocks_[b_ptr_[j]] to b_blocks_[b_ptr_[j+1]-1].
+  std::vector<unsigned int> b_ptr_;
+  std::vector<std::pair<unsigned int, unsigned int>> b_blocks_;
+
+  //: The a_i are summed into T and ec in runs [a_runs_[r], a_runs_[r+1]),
+  //  each with its own partial sums, which are then added in order.
+  std::vector<unsigned int> a_runs_;
+  std::vector<vnl_matrix<double>> T_runs_;
+  std::vector<vnl_vector<double>> ec_runs_;
+
+  //: As given to set_num_threads(); 1 runs serially
+  unsigned int num_threads_{ 1 };
+
+  SchurSolver schur_solver_{ dense_cholesky };
+  double cg_tol_{ 1e-10 };
+  unsigned int cg_max_iterations_{ 0 };
+
+  //: The sparse Sa.  Block row i has the blocks S_[S_ptr_[i]] to S_[S_ptr_[i+1]-1]
+  //  on and above the diagonal, in block columns S_col_, starting with i.
+  std::vector<unsigned int> S_ptr_;
+  std::vector<unsigned int> S_col_;
+  std::vector<vnl_matrix<double>> S_;
+  //: The blocks below the diagonal of block row h are the transposes of
+  //  S_[S_lower_idx_[n]], in block columns S_lower_col_[n], for n from
+  //  S_lower_ptr_[h] to S_lower_ptr_[h+1]-1.
+  std::vector<unsigned int> S_lower_ptr_;
+  std::vector<unsigned int> S_lower_col_;
+  std::vector<unsigned int> S_lower_idx_;
+  //: Inverses of the diagonal blocks of Sa, for conjugate gradients
+  std::vector<vnl_matrix<double>> S_inv_diag_;
+  std::unique_ptr<vnl_block_sparse_cholesky> S_cholesky_;
 };
 
 
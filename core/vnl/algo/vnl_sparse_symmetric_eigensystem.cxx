@@ -69,6 +69,19 @@ int
 vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & M, int n, bool smallest, long nfigures)
 {
   mat = &M;
+  // The Lanczos iteration multiplies by M many times; do that in compressed form
+  csr_store = vnl_csr_matrix<double>(M, false);
+  const int ierr = CalculateNPairs(csr_store, n, smallest, nfigures);
+  csr_store = vnl_csr_matrix<double>();
+  return ierr;
+}
+
+//------------------------------------------------------------
+//: As above, for a matrix in compressed sparse row form.
+int
+vnl_sparse_symmetric_eigensystem::CalculateNPairs(const vnl_csr_matrix<double> & M, int n, bool smallest, long nfigures)
+{
+  csr_mat = &M;
 
   // Clear current vectors.
   if (vectors)
@@ -82,7 +95,7 @@ vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & M,
 
   current_system = this;
 
-  const long dim = mat->columns();
+  const long dim = csr_mat->columns();
   const long nvals = (smallest) ? -n : n;
   const long nperm = 0;
   const long nmval = n;
@@ -191,6 +204,7 @@ vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & M,
   for (auto & i : temp_store)
     delete[] i;
   temp_store.clear();
+  csr_mat = nullptr;
 
   return ierr;
 }
@@ -338,6 +352,10 @@ vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & A,
 
   vnl_vector<double> workVector;
 
+  // A and B are multiplied by once per iteration
+  const vnl_csr_matrix<double> A_csr(A, false);
+  const vnl_csr_matrix<double> B_csr(B, false);
+
   while (true)
   {
     // Calling arpack routine dsaupd.
@@ -396,7 +414,7 @@ vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & A,
         case -1:
           // Performing y <- OP*x for the first time when mode != 2.
           if (mode != 2)
-            B.mult(x, z);
+            B_csr.mult(x, z);
           // no "break;" - initialization continues below
         case 1:
           // Performing y <- OP*w.
@@ -404,13 +422,13 @@ vnl_sparse_symmetric_eigensystem::CalculateNPairs(vnl_sparse_matrix<double> & A,
             opLU.solve(z, &y);
           else
           {
-            A.mult(x, workVector);
+            A_csr.mult(x, workVector);
             x.update(workVector);
             opLU.solve(x, &y);
           }
           break;
         case 2:
-          B.mult(x, y);
+          B_csr.mult(x, y);
           break;
         default:
           break;
@@ -487,7 +505,10 @@ int
 vnl_sparse_symmetric_eigensystem::CalculateProduct(int n, int m, const double * p, double * q)
 {
   // Call the special multiply method on the matrix.
-  mat->mult(n, m, p, q);
+  if (csr_mat)
+    csr_mat->mult(n, m, p, q);
+  else
+    mat->mult(n, m, p, q);
 
   return 0;
 }
@@ -12,10 +12,12 @@
 //  28 Mar 2001: dac (Manchester) - tidied up documentation
 //  17 Dec 2010: Michael Bowers - added generalized sparse symmetric eigensystem
 //                                solver (see 2nd CalculateNPairs() method)
+//  Matrix products use a vnl_csr_matrix; added CalculateNPairs() taking one directly
 // \endverbatim
 
 #include <vector>
 #include <vnl/vnl_sparse_matrix.h>
+#include <vnl/vnl_csr_matrix.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -46,6 +48,11 @@ public:
   int
   CalculateNPairs(vnl_sparse_matrix<double> & M, int n, bool smallest = true, long nfigures = 10);
 
+  // As above, for a matrix already in compressed sparse row form.
+  // M must stay alive until this call returns.
+  int
+  CalculateNPairs(const vnl_csr_matrix<double> & M, int n, bool smallest = true, long nfigures = 10);
+
   // Find n eigenvalue/eigenvectors of the eigenproblem A * x = lambda * B * x.
   // !smallest and !magnitude - compute the N largest (algebraic) eigenvalues
   //  smallest and !magnitude - compute the N smallest (algebraic) eigenvalues
@@ -85,6 +92,10 @@ protected:
 
   // Matrix A of A*x = lambda*x (or lambda*B*x)
   vnl_sparse_matrix<double> * mat;
+  // The matrix whose products are computed by CalculateProduct()
+  const vnl_csr_matrix<double> * csr_mat{ nullptr };
+  // Compressed copy of mat, if CalculateNPairs() was given a vnl_sparse_matrix
+  vnl_csr_matrix<double> csr_store;
   // Matrix B of A*x = lambda*B*x
   vnl_sparse_matrix<double> * Bmat;
 
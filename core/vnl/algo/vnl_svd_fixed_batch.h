@@ -0,0 +1,108 @@
+// This is core/vnl/algo/vnl_svd_fixed_batch.h
+#ifndef vnl_svd_fixed_batch_h_
+#define vnl_svd_fixed_batch_h_
+//:
+// \file
+// \brief Singular value decompositions of a batch of small fixed size matrices
+//
+// Computes the SVD of every matrix of a vnl_matrix_fixed_batch at once, by
+// one-sided (Hestenes) Jacobi rotations: pairs of columns are rotated until
+// all the columns are orthogonal, and the column norms are the singular
+// values.  The same sequence of rotations is applied to all the matrices,
+// so every step is a loop over the batch, which vectorizes; a matrix whose
+// columns are already orthogonal gets the identity rotation.
+//
+// For a single matrix, vnl_svd_fixed is the better choice.  This is meant
+// for the many small problems of e.g. RANSAC, where one SVD is needed for
+// each of hundreds of hypotheses.
+
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vnl/vnl_vector_fixed.h>
+#include <vnl/vnl_matrix_fixed.h>
+#include <vnl/vnl_matrix_fixed_batch.h>
+#include <vnl/algo/vnl_algo_export.h>
+
+//: Singular value decompositions M[i] = U[i] W[i] V[i]' of a batch of R x C matrices.
+//  As in vnl_svd_fixed, U[i] is R x C, V[i] is C x C, and the C singular
+//  values in W[i] are in decreasing order.  When R < C, the last C - R
+//  singular values are zero, and the corresponding columns of U are zero.
+template <class T, unsigned int R, unsigned int C>
+class vnl_svd_fixed_batch
+{
+public:
+  //: Decompose all the matrices of M.
+  vnl_svd_fixed_batch(const vnl_matrix_fixed_batch<T, R, C> & M);
+
+  //: Number of matrices
+  std::size_t
+  size() const
+  {
+    return U_.size();
+  }
+
+  //: Singular value k of matrix i, in decreasing order
+  T
+  W(std::size_t i, unsigned int k) const
+  {
+    return W_(i, k, 0);
+  }
+
+  //: The left singular vectors of all the matrices
+  const vnl_matrix_fixed_batch<T, R, C> &
+  U() const
+  {
+    return U_;
+  }
+  //: The singular values of all the matrices
+  const vnl_matrix_fixed_batch<T, C, 1> &
+  W() const
+  {
+    return W_;
+  }
+  //: The right singular vectors of all the matrices
+  const vnl_matrix_fixed_batch<T, C, C> &
+  V() const
+  {
+    return V_;
+  }
+
+  //: The left singular vectors of matrix i
+  vnl_matrix_fixed<T, R, C>
+  U(std::size_t i) const
+  {
+    return U_.get(i);
+  }
+  //: The right singular vectors of matrix i
+  vnl_matrix_fixed<T, C, C>
+  V(std::size_t i) const
+  {
+    return V_.get(i);
+  }
+
+  //: Number of singular values of matrix i larger than tol
+  unsigned int
+  rank(std::size_t i, T tol) const;
+
+  //: The right singular vector of matrix i with the smallest singular value
+  vnl_vector_fixed<T, C>
+  nullvector(std::size_t i) const;
+
+  //: Largest number of sweeps over all pairs of columns needed by a matrix
+  unsigned int
+  num_sweeps() const
+  {
+    return sweeps_;
+  }
+
+private:
+  vnl_matrix_fixed_batch<T, R, C> U_;
+  vnl_matrix_fixed_batch<T, C, 1> W_;
+  vnl_matrix_fixed_batch<T, C, C> V_;
+  unsigned int sweeps_{ 0 };
+};
+
+#endif // vnl_svd_fixed_batch_h_
@@ -0,0 +1,178 @@
+// This is core/vnl/algo/vnl_svd_fixed_batch.hxx
+#ifndef vnl_svd_fixed_batch_hxx_
+#define vnl_svd_fixed_batch_hxx_
+//:
+// \file
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include "vnl_svd_fixed_batch.h"
+
+template <class T, unsigned int R, unsigned int C>
+vnl_svd_fixed_batch<T, R, C>::vnl_svd_fixed_batch(const vnl_matrix_fixed_batch<T, R, C> & M)
+  : U_(M)
+  , W_(M.size())
+  , V_(M.size())
+{
+  const std::size_t n = M.size();
+  for (unsigned int k = 0; k < C; ++k)
+  {
+    T * v = V_.lane(k, k);
+    for (std::size_t i = 0; i < n; ++i)
+      v[i] = T(1);
+  }
+
+  // Rotate columns p and q of all the matrices so that they become
+  // orthogonal.  With alpha = |u_p|^2, beta = |u_q|^2 and gamma = u_p.u_q,
+  // the rotation angle has tangent t, the smaller root of
+  // t^2 + 2 zeta t - 1 = 0, where zeta = (beta - alpha) / (2 gamma).
+  // Columns which are already orthogonal to working precision get the
+  // identity, and the iteration stops when all pairs of all matrices are.
+  // The rounding error of gamma is about sqrt(R) eps |u_p| |u_q|, and
+  // columns below eps |M| are rounding noise of a rank deficient matrix,
+  // so neither is worth a rotation.
+  const T eps = std::numeric_limits<T>::epsilon();
+  const T tol2 = R * eps * eps;
+  const unsigned int max_sweeps = 60;
+  std::vector<T> alpha(n), beta(n), gamma(n), cs(n), sn(n), tiny(n, T(0));
+  for (unsigned int r = 0; r < R; ++r)
+    for (unsigned int c = 0; c < C; ++c)
+    {
+      const T * m = U_.lane(r, c);
+      for (std::size_t i = 0; i < n; ++i)
+        tiny[i] += m[i] * m[i];
+    }
+  for (std::size_t i = 0; i < n; ++i)
+    tiny[i] *= tol2;
+  for (sweeps_ = 0; sweeps_ < max_sweeps;)
+  {
+    ++sweeps_;
+    bool rotated = false;
+    for (unsigned int p = 0; p + 1 < C; ++p)
+      for (unsigned int q = p + 1; q < C; ++q)
+      {
+        for (std::size_t i = 0; i < n; ++i)
+          alpha[i] = beta[i] = gamma[i] = T(0);
+        for (unsigned int r = 0; r < R; ++r)
+        {
+          const T * up = U_.lane(r, p);
+          const T * uq = U_.lane(r, q);
+          for (std::size_t i = 0; i < n; ++i)
+          {
+            alpha[i] += up[i] * up[i];
+            beta[i] += uq[i] * uq[i];
+            gamma[i] += up[i] * uq[i];
+          }
+        }
+
+        bool any = false;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+          const bool rotate =
+            gamma[i] * gamma[i] > tol2 * alpha[i] * beta[i] && alpha[i] > tiny[i] && beta[i] > tiny[i];
+          const T g = rotate ? gamma[i] : T(1);
+          const T zeta = (beta[i] - alpha[i]) / (2 * g);
+          const T t = (zeta < 0 ? T(-1) : T(1)) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+          const T c = 1 / std::sqrt(1 + t * t);
+          cs[i] = rotate ? c : T(1);
+          sn[i] = rotate ? c * t : T(0);
+          any = any || rotate;
+        }
+        if (!any)
+          continue;
+        rotated = true;
+
+        for (unsigned int r = 0; r < R; ++r)
+        {
+          T * up = U_.lane(r, p);
+          T * uq = U_.lane(r, q);
+          for (std::size_t i = 0; i < n; ++i)
+          {
+            const T a = up[i], b = uq[i];
+            up[i] = cs[i] * a - sn[i] * b;
+            uq[i] = sn[i] * a + cs[i] * b;
+          }
+        }
+        for (unsigned int r = 0; r < C; ++r)
+        {
+          T * vp = V_.lane(r, p);
+          T * vq = V_.lane(r, q);
+          for (std::size_t i = 0; i < n; ++i)
+          {
+            const T a = vp[i], b = vq[i];
+            vp[i] = cs[i] * a - sn[i] * b;
+            vq[i] = sn[i] * a + cs[i] * b;
+          }
+        }
+      }
+    if (!rotated)
+      break;
+  }
+
+  // the singular values are the norms of the columns
+  for (unsigned int k = 0; k < C; ++k)
+  {
+    T * w = W_.lane(k, 0);
+    for (unsigned int r = 0; r < R; ++r)
+    {
+      const T * u = U_.lane(r, k);
+      for (std::size_t i = 0; i < n; ++i)
+        w[i] += u[i] * u[i];
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      w[i] = std::sqrt(w[i]);
+      cs[i] = w[i] > 0 ? 1 / w[i] : T(0);
+    }
+    for (unsigned int r = 0; r < R; ++r)
+    {
+      T * u = U_.lane(r, k);
+      for (std::size_t i = 0; i < n; ++i)
+        u[i] *= cs[i];
+    }
+  }
+
+  // sort each decomposition by decreasing singular value
+  for (std::size_t i = 0; i < n; ++i)
+    for (unsigned int k = 0; k + 1 < C; ++k)
+    {
+      unsigned int m = k;
+      for (unsigned int j = k + 1; j < C; ++j)
+        if (W_(i, j, 0) > W_(i, m, 0))
+          m = j;
+      if (m == k)
+        continue;
+      std::swap(W_(i, k, 0), W_(i, m, 0));
+      for (unsigned int r = 0; r < R; ++r)
+        std::swap(U_(i, r, k), U_(i, r, m));
+      for (unsigned int r = 0; r < C; ++r)
+        std::swap(V_(i, r, k), V_(i, r, m));
+    }
+}
+
+template <class T, unsigned int R, unsigned int C>
+unsigned int
+vnl_svd_fixed_batch<T, R, C>::rank(std::size_t i, T tol) const
+{
+  unsigned int r = 0;
+  for (unsigned int k = 0; k < C; ++k)
+    if (W_(i, k, 0) > tol)
+      ++r;
+  return r;
+}
+
+template <class T, unsigned int R, unsigned int C>
+vnl_vector_fixed<T, C>
+vnl_svd_fixed_batch<T, R, C>::nullvector(std::size_t i) const
+{
+  vnl_vector_fixed<T, C> v;
+  for (unsigned int r = 0; r < C; ++r)
+    v[r] = V_(i, r, C - 1);
+  return v;
+}
+
+#undef VNL_SVD_FIXED_BATCH_INSTANTIATE
+#define VNL_SVD_FIXED_BATCH_INSTANTIATE(T, R, C) template class VNL_ALGO_EXPORT vnl_svd_fixed_batch<T, R, C>
+
+#endif // vnl_svd_fixed_batch_hxx_
@@ -1,8 +1,11 @@
 // This is core/vnl/io/tests/test_matrix_io.cxx
 #include <iostream>
+#include <memory>
+#include <vector>
 #include "vnl/vnl_matrix.h"
 #include <vnl/io/vnl_io_matrix.h>
 #include "vsl/vsl_binary_io.h"
+#include "vsl/vsl_mapped_fstream.h"
 #include "testlib/testlib_test.h"
 #include "vpl/vpl.h"
 
@@ -50,11 +53,95 @@ test_matrix_double_io()
   std::cout << std::endl;
 }
 
+static void
+test_matrix_in_place_io()
+{
+  std::cout << "*************************************\n"
+            << "Testing vnl_matrix io without copying\n"
+            << "*************************************\n";
+  const char * filename = "vnl_matrix_test_in_place_io.bvl.tmp";
+  vnl_matrix<unsigned char> b_out(7, 5);
+  for (unsigned i = 0; i < b_out.size(); ++i)
+    b_out.data_block()[i] = static_cast<unsigned char>(3 * i);
+  vnl_matrix<double> d_out(10, 6);
+  for (unsigned i = 0; i < d_out.size(); ++i)
+    d_out.data_block()[i] = 0.5 * i;
+  vnl_matrix<int> i_out(3, 4, -7);
+
+  vsl_b_ofstream bfs_out(filename);
+  vsl_b_write(bfs_out, b_out);
+  // One pad byte before each: the doubles start at every offset modulo 8
+  for (int k = 0; k < 8; ++k)
+  {
+    vsl_b_write(bfs_out, char(k));
+    vsl_b_write(bfs_out, d_out);
+  }
+  vsl_b_write(bfs_out, i_out);
+  bfs_out.close();
+
+  std::shared_ptr<void> b_owner, i_owner;
+  std::vector<std::shared_ptr<void>> d_owner(8);
+  std::vector<const double *> d_data(8);
+  {
+    vsl_b_imapped_fstream bfs_in(filename);
+    TEST("Opened vnl_matrix_test_in_place_io.bvl.tmp for reading", (!bfs_in), false);
+    const char * begin = bfs_in.mapping().get();
+    const char * end = begin + bfs_in.is().seekg(0, std::ios::end).tellg();
+    bfs_in.is().seekg(6);
+    auto in_map = [begin, end](const void * p) {
+      return static_cast<const char *>(p) >= begin && static_cast<const char *>(p) < end;
+    };
+
+    vnl_matrix_ref<unsigned char> b_in = vsl_b_read_in_place<unsigned char>(bfs_in, b_owner);
+    TEST("uchar matrix read", b_in, b_out);
+    TEST("uchar matrix in place", in_map(b_in.data_block()), true);
+    b_in(0, 0) = 99; // copy on write
+
+    int n_in_place = 0;
+    bool d_ok = true;
+    for (int k = 0; k < 8; ++k)
+    {
+      char c;
+      vsl_b_read(bfs_in, c);
+      vnl_matrix_ref<double> d_in = vsl_b_read_in_place<double>(bfs_in, d_owner[k]);
+      d_ok = d_ok && c == char(k) && d_in == d_out;
+      d_data[k] = d_in.data_block();
+      if (in_map(d_in.data_block()))
+        ++n_in_place;
+    }
+    TEST("double matrices read", d_ok, true);
+#if VXL_LITTLE_ENDIAN
+    TEST_EQUAL("Aligned double matrices in place", n_in_place, 1);
+#endif
+    vnl_matrix_ref<int> i_in = vsl_b_read_in_place<int>(bfs_in, i_owner);
+    TEST("int matrix read", i_in, i_out);
+    TEST("int matrix copied", in_map(i_in.data_block()), false);
+    TEST("Finished reading file successfully", (!bfs_in), false);
+  }
+
+  // The mapping outlives the stream
+  bool ok = true;
+  for (int k = 0; k < 8; ++k)
+    ok = ok && vnl_matrix_ref<double>(10, 6, d_data[k]) == d_out;
+  TEST("Data alive after the stream is closed", ok, true);
+
+  vsl_b_ifstream bfs_in(filename);
+  vnl_matrix<unsigned char> b_in2;
+  vsl_b_read(bfs_in, b_in2);
+  bfs_in.close();
+  TEST("File unchanged by writing to the mapping", b_in2, b_out);
+
+  b_owner.reset();
+  i_owner.reset();
+  d_owner.clear();
+  vpl_unlink(filename);
+}
 
 void
 test_matrix_io()
 {
   test_matrix_double_io();
+  test_matrix_in_place_io();
 }
 
 
@@ -7,8 +7,10 @@
 // \date 20-Mar-2001
 
 #include <iosfwd>
+#include <memory>
 #include <vsl/vsl_fwd.h>
 #include <vnl/vnl_matrix.h>
+#include <vnl/vnl_matrix_ref.h>
 #ifdef _MSC_VER
 #  include <vcl_msvc_warnings.h>
 #endif
@@ -25,6 +27,16 @@ template <class T>
 void
 vsl_b_read(vsl_b_istream & is, vnl_matrix<T> & v);
 
+//: Binary load vnl_matrix from stream, without copying the elements if possible.
+//  When is is a vsl_b_imapped_fstream and the elements need no conversion
+//  (see vsl_block_binary_read_in_place()), the matrix refers to them in the
+//  mapped file; otherwise they are read into memory allocated here.  Either
+//  way, owner keeps the elements alive, and must be kept while the matrix is used.
+//  \relatesalso vnl_matrix_ref
+template <class T>
+vnl_matrix_ref<T>
+vsl_b_read_in_place(vsl_b_istream & is, std::shared_ptr<void> & owner);
+
 //: Print human readable summary of object to a stream
 //  \relatesalso vnl_matrix
 template <class T>
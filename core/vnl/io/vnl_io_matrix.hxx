@@ -4,6 +4,7 @@
 //:
 // \file
 
+#include <memory>
 #include "vnl_io_matrix.h"
 #include <vnl/vnl_matrix.h>
 #include <vsl/vsl_b_read_block_old.h>
@@ -71,6 +72,46 @@ vsl_b_read(vsl_b_istream & is, vnl_matrix<T> & p)
   }
 }
 
+//=================================================================================
+//: Binary load self from stream, without copying if possible.
+template <class T>
+vnl_matrix_ref<T>
+vsl_b_read_in_place(vsl_b_istream & is, std::shared_ptr<void> & owner)
+{
+  owner.reset();
+  if (!is)
+    return vnl_matrix_ref<T>(0, 0, nullptr);
+
+  short v;
+  unsigned m, n;
+  vsl_b_read(is, v);
+  switch (v)
+  {
+    case 2:
+    {
+      vsl_b_read(is, m);
+      vsl_b_read(is, n);
+      if (m * n > 0)
+      {
+        T * data = vsl_block_binary_read_in_place<T>(is, m * n, owner);
+        if (data)
+          return vnl_matrix_ref<T>(m, n, data);
+      }
+      auto p = std::make_shared<vnl_matrix<T>>(m, n);
+      if (m * n > 0)
+        vsl_block_binary_read(is, p->data_block(), p->size());
+      owner = p;
+      return vnl_matrix_ref<T>(m, n, p->data_block());
+    }
+
+    default:
+      std::cerr << "I/O ERROR: vsl_b_read_in_place(vsl_b_istream&, std::shared_ptr<void>&)\n"
+                << "           Unsupported version number " << v << '\n';
+      is.is().clear(std::ios::badbit); // Set an unrecoverable IO error on stream
+      return vnl_matrix_ref<T>(0, 0, nullptr);
+  }
+}
+
 //====================================================================================
 //: Output a human readable summary to the stream
 template <class T>
@@ -105,9 +146,10 @@ vsl_print_summary(std::ostream & os, const vnl_matrix<T> & p)
 }
 
 
-#define VNL_IO_MATRIX_INSTANTIATE(T)                                                 \
-  template VNL_EXPORT void vsl_print_summary(std::ostream &, const vnl_matrix<T> &); \
-  template VNL_EXPORT void vsl_b_read(vsl_b_istream &, vnl_matrix<T> &);             \
+#define VNL_IO_MATRIX_INSTANTIATE(T)                                                                    \
+  template VNL_EXPORT void vsl_print_summary(std::ostream &, const vnl_matrix<T> &);                    \
+  template VNL_EXPORT void vsl_b_read(vsl_b_istream &, vnl_matrix<T> &);                                \
+  template VNL_EXPORT vnl_matrix_ref<T> vsl_b_read_in_place(vsl_b_istream &, std::shared_ptr<void> &); \
   template VNL_EXPORT void vsl_b_write(vsl_b_ostream &, const vnl_matrix<T> &)
 
 #endif // vnl_io_matrix_hxx_
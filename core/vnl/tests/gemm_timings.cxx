@@ -0,0 +1,91 @@
+//:
+// \file
+// \brief Tool to compare the speed of vnl_gemm with a simple matrix product loop.
+//
+// Usage: vnl_gemm_timings [size ...]
+// For each size n, times n x n products of double and float matrices
+// computed by the loop vnl_matrix::operator* used before vnl_gemm, by vnl_gemm
+// with one thread, and by operator* as it is now (vnl_gemm, all threads).
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "vnl/vnl_gemm.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_random.h"
+
+//: The matrix product loop of vnl_matrix::operator*, without vnl_gemm
+template <class T>
+static void
+simple_product(const vnl_matrix<T> & a, const vnl_matrix<T> & b, vnl_matrix<T> & c)
+{
+  const unsigned l = a.rows(), m = a.cols(), n = b.cols();
+  for (unsigned i = 0; i < l; ++i)
+    for (unsigned k = 0; k < n; ++k)
+    {
+      T sum{ 0 };
+      for (unsigned j = 0; j < m; ++j)
+        sum += T(a(i, j) * b(j, k));
+      c(i, k) = sum;
+    }
+}
+
+//: Best wall clock time of f() in seconds, over enough runs to take about a second
+template <class F>
+static double
+best_time(F f)
+{
+  double best = 1e30, total = 0;
+  for (unsigned run = 0; run < 20 && (run < 2 || total < 1.0); ++run)
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    best = std::min(best, t);
+    total += t;
+  }
+  return best;
+}
+
+template <class T>
+static void
+time_products(unsigned n, const char * type_name)
+{
+  vnl_random rng(9667566);
+  vnl_matrix<T> a(n, n), b(n, n), c(n, n);
+  for (unsigned i = 0; i < n; ++i)
+    for (unsigned j = 0; j < n; ++j)
+    {
+      a(i, j) = T(rng.drand64(-1, 1));
+      b(i, j) = T(rng.drand64(-1, 1));
+    }
+  const double gflop = 2e-9 * n * n * double(n);
+
+  const double t_simple = best_time([&]() { simple_product(a, b, c); });
+  vnl_gemm_set_max_threads(1);
+  const double t_gemm1 =
+    best_time([&]() { vnl_gemm(false, false, n, n, n, T(1), a.data_block(), n, b.data_block(), n, T(0), c.data_block(), n); });
+  vnl_gemm_set_max_threads(0);
+  const double t_op = best_time([&]() { c = a * b; });
+
+  std::cout << type_name << " n=" << n << ":  simple loop " << gflop / t_simple << " GFlop/s,  vnl_gemm 1 thread "
+            << gflop / t_gemm1 << " GFlop/s,  operator* " << gflop / t_op << " GFlop/s  (" << t_simple / t_op
+            << "x)\n";
+}
+
+int
+main(int argc, char * argv[])
+{
+  std::vector<unsigned> sizes;
+  for (int i = 1; i < argc; ++i)
+    sizes.push_back(unsigned(std::atoi(argv[i])));
+  if (sizes.empty())
+    sizes = { 32, 100, 256, 512 };
+  for (unsigned n : sizes)
+  {
+    time_products<double>(n, "double");
+    time_products<float>(n, "float ");
+  }
+  return 0;
+}
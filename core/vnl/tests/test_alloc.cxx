@@ -0,0 +1,105 @@
+// This is core/vnl/tests/test_alloc.cxx
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "vnl/vnl_alloc.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+#include "testlib/testlib_test.h"
+
+static bool
+is_aligned(const void * p, std::size_t align)
+{
+  return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+}
+
+static void
+test_alloc_single_thread()
+{
+  const std::size_t live0 = vnl_alloc::live_bytes();
+  bool aligned = true, distinct = true;
+  std::vector<void *> small, large;
+  for (std::size_t n = 1; n <= 2000; n += 7)
+  {
+    void * p = vnl_alloc::allocate(n);
+    std::memset(p, int(n & 0xff), n);
+    aligned = aligned && is_aligned(p, n > VNL_ALLOC_MAX_BYTES ? VNL_ALLOC_LARGE_ALIGN : VNL_ALLOC_ALIGN);
+    (n > VNL_ALLOC_MAX_BYTES ? large : small).push_back(p);
+  }
+  // The contents must have survived all later allocations
+  std::size_t k = 0;
+  for (std::size_t n = 1; n <= 2000; n += 7, ++k)
+  {
+    const auto * p = static_cast<const unsigned char *>(k < small.size() ? small[k] : large[k - small.size()]);
+    for (std::size_t i = 0; i < n; ++i)
+      distinct = distinct && p[i] == (n & 0xff);
+  }
+  TEST("Aligned allocations", aligned, true);
+  TEST("Allocations do not overlap", distinct, true);
+  TEST("live_bytes counts allocations", vnl_alloc::live_bytes() > live0, true);
+  TEST("reserved_bytes covers live_bytes", vnl_alloc::reserved_bytes() >= vnl_alloc::live_bytes() - live0, true);
+  k = 0;
+  for (std::size_t n = 1; n <= 2000; n += 7, ++k)
+    vnl_alloc::deallocate(k < small.size() ? small[k] : large[k - small.size()], n);
+  TEST("live_bytes back to start", vnl_alloc::live_bytes(), live0);
+
+  void * p = vnl_alloc::allocate(40);
+  std::memcpy(p, "0123456789012345678901234567890123456789", 40);
+  p = vnl_alloc::reallocate(p, 40, 1000);
+  TEST("reallocate keeps contents", std::memcmp(p, "0123456789012345678901234567890123456789", 40), 0);
+  vnl_alloc::deallocate(p, 1000);
+  TEST("live_bytes after reallocate", vnl_alloc::live_bytes(), live0);
+}
+
+//: Containers built in several threads, and freed in other threads
+static void
+test_alloc_threads()
+{
+  const std::size_t live0 = vnl_alloc::live_bytes();
+  constexpr unsigned n_threads = 4, n_iter = 2000;
+  std::vector<std::vector<vnl_matrix<double> *>> made(n_threads);
+  std::vector<int> ok(n_threads, 1);
+  {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t)
+      threads.emplace_back([t, &made, &ok]() {
+        for (unsigned i = 0; i < n_iter; ++i)
+        {
+          const unsigned r = 1 + (i + t) % 7, c = 1 + i % 5;
+          vnl_matrix<double> m(r, c, double(i));
+          vnl_vector<float> v(1 + i % 40, float(t));
+          if (m(r - 1, c - 1) != double(i) || v[v.size() - 1] != float(t))
+            ok[t] = 0;
+          if (i % 3 == 0)
+            made[t].push_back(new vnl_matrix<double>(m));
+        }
+      });
+    for (auto & th : threads)
+      th.join();
+  }
+  TEST("Concurrent allocation", ok == std::vector<int>(n_threads, 1), true);
+
+  // Free each thread's matrices in another thread
+  {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t)
+      threads.emplace_back([t, &made]() {
+        for (auto * m : made[(t + 1) % n_threads])
+          delete m;
+      });
+    for (auto & th : threads)
+      th.join();
+  }
+  TEST("live_bytes after cross-thread frees", vnl_alloc::live_bytes(), live0);
+}
+
+static void
+test_alloc()
+{
+  test_alloc_single_thread();
+  test_alloc_threads();
+}
+
+TESTMAIN(test_alloc);
@@ -0,0 +1,141 @@
+// This is core/vnl/tests/test_csr_matrix.cxx
+#include <iostream>
+#include <vector>
+#include "vnl/vnl_csr_matrix.h"
+#include "vnl/vnl_crs_index.h"
+#include "vnl/vnl_random.h"
+#include "vnl/vnl_sparse_matrix.h"
+#include "vnl/vnl_sparse_matrix_linear_system.h"
+#include "vnl/vnl_thread_pool.h"
+#include "testlib/testlib_test.h"
+
+//: A random sparse matrix, with some empty rows and some long ones
+template <class T>
+static vnl_sparse_matrix<T>
+random_sparse(unsigned rows, unsigned cols, unsigned per_row, vnl_random & rng)
+{
+  vnl_sparse_matrix<T> A(rows, cols);
+  for (unsigned i = 0; i < rows; ++i)
+  {
+    if (i % 17 == 3)
+      continue;
+    const unsigned n = (i % 29 == 0) ? 5 * per_row : 1 + rng.lrand32(2 * per_row);
+    for (unsigned k = 0; k < n; ++k)
+      A(i, rng.lrand32(cols - 1)) = T(rng.drand64(-1, 1));
+  }
+  return A;
+}
+
+template <class T>
+static void
+test_csr_products(unsigned rows, unsigned cols, unsigned per_row, double tol, const char * name)
+{
+  vnl_random rng(2500 + rows);
+  const vnl_sparse_matrix<T> A = random_sparse<T>(rows, cols, per_row, rng);
+  const vnl_csr_matrix<T> C(A), Cn(A, false);
+  vnl_vector<T> x(cols), u(rows);
+  for (unsigned j = 0; j < cols; ++j)
+    x[j] = T(rng.drand64(-1, 1));
+  for (unsigned i = 0; i < rows; ++i)
+    u[i] = T(rng.drand64(-1, 1));
+
+  std::cout << name << ' ' << rows << 'x' << cols << ", " << C.num_nonzero() << " non-zeros\n";
+  TEST("Size", C.rows() == rows && C.cols() == cols && C.has_transpose() && !Cn.has_transpose(), true);
+  TEST("Round trip", C.as_sparse_matrix() == A, true);
+  bool same = true;
+  for (unsigned i = 0; i < rows; i += 7)
+    for (unsigned j = 0; j < cols; j += 3)
+      same = same && C(i, j) == A(i, j);
+  TEST("Element access", same, true);
+
+  vnl_vector<T> y0, y1;
+  A.mult(x, y0);
+  C.mult(x, y1);
+  TEST_NEAR("mult", (y0 - y1).inf_norm(), 0.0, tol);
+
+  A.pre_mult(u, y0);
+  C.pre_mult(u, y1);
+  TEST_NEAR("pre_mult", (y0 - y1).inf_norm(), 0.0, tol);
+  Cn.pre_mult(u, y1);
+  TEST_NEAR("pre_mult without transpose", (y0 - y1).inf_norm(), 0.0, tol);
+
+  A.diag_AtA(y0);
+  C.diag_AtA(y1);
+  TEST_NEAR("diag_AtA", (y0 - y1).inf_norm(), 0.0, tol);
+
+  const unsigned pcols = 3;
+  std::vector<T> p(cols * pcols), q0(rows * pcols), q1(rows * pcols);
+  for (auto & v : p)
+    v = T(rng.drand64(-1, 1));
+  A.mult(cols, pcols, p.data(), q0.data());
+  C.mult(cols, pcols, p.data(), q1.data());
+  double err = 0;
+  for (unsigned k = 0; k < q0.size(); ++k)
+    err = std::max(err, double(std::abs(q0[k] - q1[k])));
+  TEST_NEAR("mult, Fortran order matrix", err, 0.0, tol);
+
+  // The result does not depend on the number of threads
+  vnl_thread_pool::set_default_n_threads(1);
+  C.mult(x, y0);
+  vnl_thread_pool::set_default_n_threads(4);
+  C.mult(x, y1);
+  TEST("mult is deterministic", y0 == y1, true);
+  C.pre_mult(u, y0);
+  vnl_thread_pool::set_default_n_threads(1);
+  C.pre_mult(u, y1);
+  TEST("pre_mult is deterministic", y0 == y1, true);
+  vnl_thread_pool::set_default_n_threads(0);
+}
+
+static void
+test_csr_crs_index()
+{
+  std::vector<std::vector<bool>> mask(3, std::vector<bool>(4, false));
+  mask[0][1] = mask[0][3] = mask[2][0] = mask[2][2] = true;
+  const vnl_crs_index idx(mask);
+  const std::vector<double> values = { 1.0, 2.0, 3.0, 4.0 };
+  const vnl_csr_matrix<double> C(idx, values);
+  TEST("From vnl_crs_index", C.rows() == 3 && C.cols() == 4 && C.num_nonzero() == 4, true);
+  TEST("Values", C(0, 1) == 1.0 && C(0, 3) == 2.0 && C(1, 1) == 0.0 && C(2, 2) == 4.0, true);
+  vnl_vector<double> x(4, 1.0), y;
+  C.mult(x, y);
+  TEST("mult", y[0] == 3.0 && y[1] == 0.0 && y[2] == 7.0, true);
+}
+
+//: vnl_sparse_matrix_linear_system multiplies with its CSR copy, if asked to
+static void
+test_csr_linear_system()
+{
+  vnl_random rng(77);
+  vnl_sparse_matrix<double> A = random_sparse<double>(300, 120, 6, rng);
+  const vnl_vector<double> b(300, 1.0);
+  const vnl_sparse_matrix_linear_system<double> ls(A, b, true);
+  vnl_vector<double> x(120), y0, y1(300), z0, z1(120);
+  for (unsigned j = 0; j < 120; ++j)
+    x[j] = rng.drand64(-1, 1);
+  A.mult(x, y0);
+  ls.multiply(x, y1);
+  TEST_NEAR("Linear system multiply", (y0 - y1).inf_norm(), 0.0, 1e-12);
+  A.pre_mult(y0, z0);
+  ls.transpose_multiply(y0, z1);
+  TEST_NEAR("Linear system transpose_multiply", (z0 - z1).inf_norm(), 0.0, 1e-12);
+
+  // Without the copy, the products follow changes to A
+  const vnl_sparse_matrix_linear_system<double> by_ref(A, b);
+  A(0, 0) += 1.0;
+  A.mult(x, y0);
+  by_ref.multiply(x, y1);
+  TEST_NEAR("Linear system sees changes to A", (y0 - y1).inf_norm(), 0.0, 1e-12);
+}
+
+static void
+test_csr_matrix()
+{
+  test_csr_products<double>(50, 40, 4, 1e-12, "double");
+  test_csr_products<double>(20000, 15000, 12, 1e-12, "double");
+  test_csr_products<float>(20000, 15000, 12, 1e-4, "float");
+  test_csr_crs_index();
+  test_csr_linear_system();
+}
+
+TESTMAIN(test_csr_matrix);
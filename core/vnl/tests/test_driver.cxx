@@ -15,6 +15,7 @@ DECLARE(test_matrix);
 DECLARE(test_container_interface);
 DECLARE(test_matrix_exp);
 DECLARE(test_matrix_fixed);
+DECLARE(test_matrix_fixed_batch);
 DECLARE(test_matrix_fixed_ref);
 DECLARE(test_na);
 DECLARE(test_numeric_traits);
@@ -29,12 +30,16 @@ DECLARE(test_rotation_matrix);
 DECLARE(test_sym_matrix);
 DECLARE(test_transpose);
 DECLARE(test_fastops);
+DECLARE(test_gemm);
+DECLARE(test_csr_matrix);
+DECLARE(test_thread_pool);
 DECLARE(test_vector);
 DECLARE(test_vector_fixed_ref);
 DECLARE(test_gamma);
 DECLARE(test_random);
 DECLARE(test_arithmetic);
 DECLARE(test_alignment);
+DECLARE(test_alloc);
 DECLARE(test_hungarian_algorithm);
 DECLARE(test_integrant);
 DECLARE(test_bessel);
@@ -61,6 +66,7 @@ register_tests()
   REGISTER(test_container_interface);
   REGISTER(test_matrix_exp);
   REGISTER(test_matrix_fixed);
+  REGISTER(test_matrix_fixed_batch);
   REGISTER(test_matrix_fixed_ref);
   REGISTER(test_na);
   REGISTER(test_numeric_traits);
@@ -75,12 +81,16 @@ register_tests()
   REGISTER(test_sym_matrix);
   REGISTER(test_transpose);
   REGISTER(test_fastops);
+  REGISTER(test_gemm);
+  REGISTER(test_csr_matrix);
+  REGISTER(test_thread_pool);
   REGISTER(test_vector);
   REGISTER(test_vector_fixed_ref);
   REGISTER(test_gamma);
   REGISTER(test_random);
   REGISTER(test_arithmetic);
   REGISTER(test_alignment);
+  REGISTER(test_alloc);
   REGISTER(test_hungarian_algorithm);
   REGISTER(test_integrant);
   REGISTER(test_bessel);
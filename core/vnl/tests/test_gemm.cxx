@@ -0,0 +1,168 @@
+// This is core/vnl/tests/test_gemm.cxx
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "vnl/vnl_gemm.h"
+#include "vnl/vnl_fastops.h"
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_matrix_fixed.h"
+#include "vnl/vnl_random.h"
+#include "testlib/testlib_test.h"
+
+template <class T>
+static void
+fill_random(std::vector<T> & v, vnl_random & rng)
+{
+  for (auto & x : v)
+    x = T(rng.drand64(-1, 1));
+}
+
+//: Largest difference between vnl_gemm and a simple double precision product
+template <class T>
+static double
+gemm_error(bool ta, bool tb, unsigned m, unsigned n, unsigned k, T alpha, T beta, vnl_random & rng)
+{
+  const std::ptrdiff_t lda = (ta ? m : k) + 3, ldb = (tb ? k : n) + 1, ldc = n + 2;
+  std::vector<T> A((ta ? k : m) * lda), B((tb ? n : k) * ldb), C(m * ldc);
+  fill_random(A, rng);
+  fill_random(B, rng);
+  fill_random(C, rng);
+  std::vector<double> expected(m * n);
+  for (unsigned i = 0; i < m; ++i)
+    for (unsigned j = 0; j < n; ++j)
+    {
+      double sum = 0;
+      for (unsigned p = 0; p < k; ++p)
+        sum += double(ta ? A[p * lda + i] : A[i * lda + p]) * double(tb ? B[j * ldb + p] : B[p * ldb + j]);
+      expected[i * n + j] = double(alpha) * sum + (beta == T(0) ? 0.0 : double(beta) * C[i * ldc + j]);
+    }
+  vnl_gemm(ta, tb, m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+  double err = 0;
+  for (unsigned i = 0; i < m; ++i)
+    for (unsigned j = 0; j < n; ++j)
+      err = std::max(err, std::fabs(C[i * ldc + j] - expected[i * n + j]));
+  return err;
+}
+
+template <class T>
+static void
+test_gemm_shapes(const char * type_name, double tol)
+{
+  vnl_random rng(1234);
+  const unsigned shapes[][3] = { { 1, 1, 1 },     { 7, 5, 3 },     { 13, 17, 300 }, { 100, 37, 61 },
+                                 { 37, 200, 19 }, { 130, 97, 513 }, { 250, 250, 40 } };
+  for (bool simd : { true, false })
+  {
+    vnl_gemm_set_simd(simd);
+    for (unsigned threads : { 1u, 4u })
+    {
+      vnl_gemm_set_max_threads(threads);
+      double err = 0;
+      for (const auto & s : shapes)
+        for (int t = 0; t < 4; ++t)
+        {
+          err = std::max(err, gemm_error<T>(t & 1, t & 2, s[0], s[1], s[2], T(1), T(0), rng));
+          err = std::max(err, gemm_error<T>(t & 1, t & 2, s[0], s[1], s[2], T(-0.5), T(2), rng));
+        }
+      std::cout << type_name << " simd=" << simd << " threads=" << threads << " max error " << err << '\n';
+      TEST("vnl_gemm matches simple product", err < tol, true);
+    }
+  }
+  vnl_gemm_set_simd(true);
+  vnl_gemm_set_max_threads(0);
+
+  // k == 0 only scales C
+  std::vector<T> C(4, T(3));
+  vnl_gemm(false, false, 2, 2, 0, T(1), (const T *)nullptr, 0, (const T *)nullptr, 2, T(2), C.data(), 2);
+  TEST("k == 0 gives beta*C", C[0] == T(6) && C[3] == T(6), true);
+}
+
+//: operator*, vnl_matrix_fixed and vnl_fastops use vnl_gemm above the threshold
+static void
+test_gemm_users()
+{
+  vnl_random rng(4321);
+  const unsigned l = 70, m = 45, n = 53;
+  TEST("product is worth vnl_gemm", vnl_gemm_worthwhile(l, n, m), true);
+  TEST("small product is not", vnl_gemm_worthwhile(4, 4, 4), false);
+  vnl_matrix<double> A(l, m), B(m, n), At, Bt;
+  for (unsigned i = 0; i < l; ++i)
+    for (unsigned j = 0; j < m; ++j)
+      A(i, j) = rng.drand64(-1, 1);
+  for (unsigned i = 0; i < m; ++i)
+    for (unsigned j = 0; j < n; ++j)
+      B(i, j) = rng.drand64(-1, 1);
+  At = A.transpose();
+  Bt = B.transpose();
+  vnl_matrix<double> expected(l, n);
+  for (unsigned i = 0; i < l; ++i)
+    for (unsigned j = 0; j < n; ++j)
+    {
+      double sum = 0;
+      for (unsigned p = 0; p < m; ++p)
+        sum += A(i, p) * B(p, j);
+      expected(i, j) = sum;
+    }
+  TEST_NEAR("operator*", (A * B - expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_matrix<float> Af(l, m), Bf(m, n);
+  for (unsigned i = 0; i < l; ++i)
+    for (unsigned j = 0; j < m; ++j)
+      Af(i, j) = float(A(i, j));
+  for (unsigned i = 0; i < m; ++i)
+    for (unsigned j = 0; j < n; ++j)
+      Bf(i, j) = float(B(i, j));
+  vnl_matrix<float> Cf = Af * Bf;
+  double err = 0;
+  for (unsigned i = 0; i < l; ++i)
+    for (unsigned j = 0; j < n; ++j)
+      err = std::max(err, std::fabs(Cf(i, j) - expected(i, j)));
+  TEST_NEAR("operator* float", err, 0.0, 1e-4);
+
+  vnl_matrix<double> X;
+  vnl_fastops::AB(X, A, B);
+  TEST_NEAR("vnl_fastops::AB", (X - expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::AtB(X, At, B);
+  TEST_NEAR("vnl_fastops::AtB", (X - expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::ABt(X, A, Bt);
+  TEST_NEAR("vnl_fastops::ABt", (X - expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::AtA(X, A);
+  TEST_NEAR("vnl_fastops::AtA", (X - At * A).absolute_value_max(), 0.0, 1e-12);
+  TEST("vnl_fastops::AtA is symmetric", X == X.transpose(), true);
+  X = expected;
+  vnl_fastops::inc_X_by_AB(X, A, B);
+  TEST_NEAR("vnl_fastops::inc_X_by_AB", (X - 2.0 * expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::dec_X_by_AtB(X, At, B);
+  TEST_NEAR("vnl_fastops::dec_X_by_AtB", (X - expected).absolute_value_max(), 0.0, 1e-12);
+  vnl_fastops::inc_X_by_ABt(X, A, Bt);
+  TEST_NEAR("vnl_fastops::inc_X_by_ABt", (X - 2.0 * expected).absolute_value_max(), 0.0, 1e-12);
+
+  vnl_matrix_fixed<double, 40, 36> Fa;
+  vnl_matrix_fixed<double, 36, 40> Fb;
+  for (unsigned i = 0; i < 40; ++i)
+    for (unsigned j = 0; j < 36; ++j)
+    {
+      Fa(i, j) = rng.drand64(-1, 1);
+      Fb(j, i) = rng.drand64(-1, 1);
+    }
+  const vnl_matrix_fixed<double, 40, 40> Fc = Fa * Fb;
+  err = 0;
+  for (unsigned i = 0; i < 40; ++i)
+    for (unsigned j = 0; j < 40; ++j)
+    {
+      double sum = 0;
+      for (unsigned p = 0; p < 36; ++p)
+        sum += Fa(i, p) * Fb(p, j);
+      err = std::max(err, std::fabs(Fc(i, j) - sum));
+    }
+  TEST_NEAR("vnl_matrix_fixed operator*", err, 0.0, 1e-12);
+}
+
+static void
+test_gemm()
+{
+  test_gemm_shapes<double>("double", 1e-12);
+  test_gemm_shapes<float>("float", 1e-4);
+  test_gemm_users();
+}
+
+TESTMAIN(test_gemm);
@@ -0,0 +1,87 @@
+// This is core/vnl/tests/test_matrix_fixed_batch.cxx
+#include <iostream>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include <vnl/vnl_matrix_fixed_batch.h>
+#include <vnl/vnl_inverse.h>
+#include <vnl/vnl_random.h>
+
+template <unsigned int R, unsigned int C>
+static vnl_matrix_fixed_batch<double, R, C>
+random_batch(std::size_t n, vnl_random & rng)
+{
+  vnl_matrix_fixed_batch<double, R, C> B(n);
+  for (std::size_t i = 0; i < n; ++i)
+    for (unsigned int r = 0; r < R; ++r)
+      for (unsigned int c = 0; c < C; ++c)
+        B(i, r, c) = rng.drand64(-1.0, 1.0);
+  return B;
+}
+
+template <unsigned int N>
+static void
+test_inverse(vnl_random & rng)
+{
+  const std::size_t n = 37;
+  vnl_matrix_fixed_batch<double, N, N> A = random_batch<N, N>(n, rng), Ainv;
+  std::vector<double> det;
+  vnl_batch_inverse(A, Ainv, det);
+  double err = 0.0, det_err = 0.0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const vnl_matrix_fixed<double, N, N> M = A.get(i);
+    err = std::max(err, (Ainv.get(i) - vnl_inverse(M)).absolute_value_max() * std::abs(det[i]));
+    det_err = std::max(det_err, std::abs(det[i] - vnl_det(M)));
+  }
+  std::cout << N << 'x' << N << ":\n";
+  TEST_NEAR("batch inverse = vnl_inverse", err, 0.0, 1e-12);
+  TEST_NEAR("batch determinant = vnl_det", det_err, 0.0, 1e-12);
+}
+
+static void
+test_matrix_fixed_batch()
+{
+  vnl_random rng(1234);
+
+  vnl_matrix_fixed_batch<double, 3, 4> A(5);
+  TEST("size", A.size(), std::size_t(5));
+  vnl_matrix_fixed<double, 3, 4> M;
+  for (unsigned int r = 0; r < 3; ++r)
+    for (unsigned int c = 0; c < 4; ++c)
+      M(r, c) = r * 4 + c;
+  A.set(2, M);
+  TEST("set/get", A.get(2), M);
+  TEST("structure of arrays layout", A.lane(1, 2) - A.lane(0, 0), std::ptrdiff_t((1 * 4 + 2) * 5));
+  TEST("element access", A(2, 1, 2), 6.0);
+
+  // products, including matrix-vector
+  const std::size_t n = 50;
+  const vnl_matrix_fixed_batch<double, 3, 4> P = random_batch<3, 4>(n, rng);
+  const vnl_matrix_fixed_batch<double, 4, 2> Q = random_batch<4, 2>(n, rng);
+  const vnl_matrix_fixed_batch<double, 4, 1> x = random_batch<4, 1>(n, rng);
+  vnl_matrix_fixed_batch<double, 3, 2> PQ;
+  vnl_matrix_fixed_batch<double, 3, 1> Px;
+  vnl_batch_multiply(P, Q, PQ);
+  vnl_batch_multiply(P, x, Px);
+  double err = 0.0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    err = std::max(err, (PQ.get(i) - P.get(i) * Q.get(i)).absolute_value_max());
+    err = std::max(err, (Px.get(i) - P.get(i) * x.get(i)).absolute_value_max());
+  }
+  TEST_NEAR("batch products", err, 0.0, 1e-14);
+
+  test_inverse<2>(rng);
+  test_inverse<3>(rng);
+  test_inverse<4>(rng);
+
+  // a singular matrix is reported through its determinant
+  vnl_matrix_fixed_batch<double, 3, 3> S(2), Sinv;
+  S.set(0, vnl_matrix_fixed<double, 3, 3>().set_identity());
+  std::vector<double> det;
+  vnl_batch_inverse(S, Sinv, det);
+  TEST("determinants", det[0] == 1.0 && det[1] == 0.0, true);
+  TEST("inverse of the identity", Sinv.get(0), S.get(0));
+}
+
+TESTMAIN(test_matrix_fixed_batch);
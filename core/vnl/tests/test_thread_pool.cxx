@@ -0,0 +1,86 @@
+// This is core/vnl/tests/test_thread_pool.cxx
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "vnl/vnl_thread_pool.h"
+#include "testlib/testlib_test.h"
+
+static void
+test_parallel_for(unsigned n_threads)
+{
+  vnl_thread_pool pool(n_threads);
+  TEST("n_threads", pool.n_threads(), n_threads);
+
+  // Every task runs exactly once, over several rounds on the same pool.
+  bool all_once = true;
+  for (unsigned round = 0; round < 5; ++round)
+  {
+    const std::size_t n = 1000 + 37 * round;
+    std::vector<std::atomic<int>> counts(n);
+    for (auto & c : counts)
+      c = 0;
+    pool.parallel_for(n, [&](std::size_t k) { ++counts[k]; });
+    for (auto & c : counts)
+      all_once = all_once && c == 1;
+  }
+  TEST("Each task executed exactly once", all_once, true);
+
+  // Nested calls are run serially rather than deadlocking.
+  std::atomic<int> nested(0);
+  pool.parallel_for(8, [&](std::size_t) { pool.parallel_for(10, [&](std::size_t) { ++nested; }); });
+  TEST("Nested parallel_for", nested, 80);
+
+  // Exceptions propagate to the caller, and the pool stays usable.
+  bool caught = false;
+  try
+  {
+    pool.parallel_for(100, [](std::size_t k) {
+      if (k == 42)
+        throw std::runtime_error("task failed");
+    });
+  }
+  catch (const std::runtime_error &)
+  {
+    caught = true;
+  }
+  TEST("Exception rethrown", caught, true);
+  std::atomic<int> after(0);
+  pool.parallel_for(64, [&](std::size_t) { ++after; });
+  TEST("Pool usable after exception", after, 64);
+
+  // At most max_threads threads take part when asked.
+  std::mutex ids_mutex;
+  std::set<std::thread::id> ids;
+  std::atomic<int> capped(0);
+  pool.parallel_for(
+    2000,
+    [&](std::size_t) {
+      ++capped;
+      std::lock_guard<std::mutex> lock(ids_mutex);
+      ids.insert(std::this_thread::get_id());
+    },
+    2);
+  TEST("Capped parallel_for runs every task", capped, 2000);
+  TEST("Capped parallel_for uses at most 2 threads", ids.size() <= 2, true);
+}
+
+static void
+test_thread_pool()
+{
+  test_parallel_for(1);
+  test_parallel_for(2);
+  test_parallel_for(4);
+
+  vnl_thread_pool::set_default_n_threads(3);
+  TEST("Default pool size", vnl_thread_pool::default_pool().n_threads(), 3u);
+  vnl_thread_pool::set_default_n_threads(0);
+  TEST("Default pool uses hardware threads",
+       vnl_thread_pool::default_pool().n_threads(),
+       vnl_thread_pool::hardware_threads());
+}
+
+TESTMAIN(test_thread_pool);
@@ -1,116 +1,326 @@
 // This is core/vnl/vnl_alloc.cxx
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
-#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
 #include "vnl_alloc.h"
 
-char *
-vnl_alloc::chunk_alloc(std::size_t size, int & nobjs)
+// A free object.  Every size class is at least 32 bytes, so there is room
+// for the links of a free list and of the depot's list of batches.
+struct vnl_alloc_node
 {
-  char * result;
-  std::size_t total_bytes = size * nobjs;
-  const std::size_t bytes_left = end_free - start_free;
+  vnl_alloc_node * next;       // next object in the same batch or free list
+  vnl_alloc_node * next_batch; // only used in the first object of a batch
+  std::size_t count;           // number of objects in the batch, ditto
+};
 
-  if (bytes_left >= total_bytes)
-  {
-    result = start_free;
-    start_free += total_bytes;
-    return result;
-  }
-  else if (bytes_left >= size)
+static_assert(sizeof(vnl_alloc_node) <= VNL_ALLOC_ALIGN, "size classes too small for the free list links");
+
+//: Number of objects moved between a thread cache and the depot at once
+static const unsigned vnl_alloc_batch_size = 32;
+
+//: Size of the chunks obtained from the system for small objects
+static const std::size_t vnl_alloc_chunk_bytes = 64 * 1024;
+
+static std::size_t
+vnl_alloc_class(std::size_t bytes)
+{
+  return bytes == 0 ? 0 : (bytes - 1) / VNL_ALLOC_ALIGN;
+}
+
+static std::size_t
+vnl_alloc_class_bytes(std::size_t cls)
+{
+  return (cls + 1) * VNL_ALLOC_ALIGN;
+}
+
+struct vnl_alloc_cache;
+
+//: The central depot of batches of free objects, shared by all threads.
+//  Also the registry of thread caches, for the memory counters.
+struct vnl_alloc_depot
+{
+  std::mutex mutex;
+  vnl_alloc_node * batches[VNL_ALLOC_NFREELISTS] = { nullptr };
+  // The unused part of the current chunk
+  char * start_free = nullptr;
+  char * end_free = nullptr;
+
+  std::vector<vnl_alloc_cache *> caches;
+  //: live bytes of exited threads, and of allocations made without a cache
+  std::atomic<std::ptrdiff_t> orphan_live{ 0 };
+  std::atomic<std::size_t> chunk_bytes{ 0 };
+  //: large bytes of exited threads, and of allocations made without a cache
+  std::atomic<std::ptrdiff_t> orphan_large{ 0 };
+
+  //: Add a batch of free objects; requires the lock.
+  void
+  push_batch(std::size_t cls, vnl_alloc_node * head, std::size_t count)
   {
-    nobjs = int(bytes_left / size);
-    total_bytes = size * nobjs;
-    result = start_free;
-    start_free += total_bytes;
-    return result;
+    head->count = count;
+    head->next_batch = batches[cls];
+    batches[cls] = head;
   }
-  else
+
+  //: Take a batch of free objects, carving new ones if needed; requires the lock.
+  vnl_alloc_node *
+  pop_batch(std::size_t cls, std::size_t & count);
+
+  //: Make a batch of new free objects of class cls from the current chunk; requires the lock.
+  vnl_alloc_node *
+  carve(std::size_t cls, std::size_t & count);
+};
+
+//: The depot lives for the whole process, including static destruction.
+static vnl_alloc_depot &
+vnl_alloc_the_depot()
+{
+  static auto * depot = new vnl_alloc_depot;
+  return *depot;
+}
+
+vnl_alloc_node *
+vnl_alloc_depot::carve(std::size_t cls, std::size_t & count)
+{
+  const std::size_t size = vnl_alloc_class_bytes(cls);
+  std::size_t bytes_left = std::size_t(end_free - start_free);
+  if (bytes_left < size)
   {
-    const std::size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
-    // Try to make use of the left-over piece.
-    if (bytes_left > 0)
+    // Give the left-over piece to the class that fits it exactly
+    if (bytes_left >= VNL_ALLOC_ALIGN)
     {
-      obj ** my_free_list = free_list + FREELIST_INDEX(bytes_left);
-      ((obj *)start_free)->free_list_link = *my_free_list;
-      *my_free_list = (obj *)start_free;
+      auto * left = reinterpret_cast<vnl_alloc_node *>(start_free);
+      left->next = nullptr;
+      push_batch(vnl_alloc_class(bytes_left), left, 1);
     }
-    start_free = (char *)std::malloc(bytes_to_get);
-    if (nullptr == start_free)
-    {
-      // Try to make do with what we have.  That can't
-      // hurt.  We do not try smaller requests, since that tends
-      // to result in disaster on multi-process machines.
-      for (std::size_t i = size; i <= VNL_ALLOC_MAX_BYTES; i += VNL_ALLOC_ALIGN)
+    void * raw = std::malloc(vnl_alloc_chunk_bytes + VNL_ALLOC_LARGE_ALIGN);
+    if (!raw)
+      throw std::bad_alloc();
+    chunk_bytes += vnl_alloc_chunk_bytes + VNL_ALLOC_LARGE_ALIGN;
+    const std::uintptr_t a = (reinterpret_cast<std::uintptr_t>(raw) + VNL_ALLOC_LARGE_ALIGN - 1) &
+                             ~std::uintptr_t(VNL_ALLOC_LARGE_ALIGN - 1);
+    start_free = reinterpret_cast<char *>(a);
+    end_free = start_free + vnl_alloc_chunk_bytes;
+    bytes_left = vnl_alloc_chunk_bytes;
+  }
+  count = bytes_left / size;
+  if (count > vnl_alloc_batch_size)
+    count = vnl_alloc_batch_size;
+  auto * head = reinterpret_cast<vnl_alloc_node *>(start_free);
+  vnl_alloc_node * node = head;
+  for (std::size_t i = 1; i < count; ++i)
+  {
+    node->next = reinterpret_cast<vnl_alloc_node *>(start_free + i * size);
+    node = node->next;
+  }
+  node->next = nullptr;
+  start_free += count * size;
+  return head;
+}
+
+vnl_alloc_node *
+vnl_alloc_depot::pop_batch(std::size_t cls, std::size_t & count)
+{
+  vnl_alloc_node * head = batches[cls];
+  if (!head)
+    return carve(cls, count);
+  batches[cls] = head->next_batch;
+  count = head->count;
+  return head;
+}
+
+//: A thread's private free lists
+struct vnl_alloc_cache
+{
+  vnl_alloc_node * heads[VNL_ALLOC_NFREELISTS] = { nullptr };
+  std::size_t counts[VNL_ALLOC_NFREELISTS] = { 0 };
+  //: Written only by the owning thread; read by live_bytes()
+  std::atomic<std::ptrdiff_t> live{ 0 };
+  //: Bytes of large objects, which bypass the free lists; read by reserved_bytes()
+  std::atomic<std::ptrdiff_t> large{ 0 };
+
+  vnl_alloc_cache()
+  {
+    vnl_alloc_depot & depot = vnl_alloc_the_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    depot.caches.push_back(this);
+  }
+
+  //: Hand everything back to the depot
+  ~vnl_alloc_cache()
+  {
+    vnl_alloc_depot & depot = vnl_alloc_the_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    for (std::size_t cls = 0; cls < VNL_ALLOC_NFREELISTS; ++cls)
+      if (heads[cls])
+        depot.push_batch(cls, heads[cls], counts[cls]);
+    depot.orphan_live += live.load();
+    depot.orphan_large += large.load();
+    for (auto it = depot.caches.begin(); it != depot.caches.end(); ++it)
+      if (*it == this)
       {
-        obj ** my_free_list = free_list + FREELIST_INDEX(i);
-        obj * p = *my_free_list;
-        if (nullptr != p)
-        {
-          *my_free_list = p->free_list_link;
-          start_free = (char *)p;
-          end_free = start_free + i;
-          return chunk_alloc(size, nobjs);
-          // Any leftover piece will eventually make it to the
-          // right free std::list.
-        }
+        depot.caches.erase(it);
+        break;
       }
-      start_free = (char *)std::malloc(bytes_to_get);
-      // This should either throw an
-      // exception or remedy the situation.  Thus we assume it
-      // succeeded.
-    }
-    heap_size += bytes_to_get;
-    end_free = start_free + bytes_to_get;
-    return chunk_alloc(size, nobjs);
   }
-}
 
+  void
+  add_live(std::ptrdiff_t n)
+  {
+    // only this thread writes, so no read-modify-write is needed
+    live.store(live.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
 
-/* Returns an object of size n, and optionally adds to size n free std::list.*/
-/* We assume that n is properly aligned.                                */
-/* We hold the allocation lock.                                         */
-void *
-vnl_alloc::refill(std::size_t n)
+  void
+  add_large(std::ptrdiff_t n)
+  {
+    large.store(large.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    add_live(n);
+  }
+};
+
+// The cache pointer is trivially destructible, so it can still be tested
+// after the thread's cache has gone, e.g. when static objects are destroyed.
+static thread_local vnl_alloc_cache * vnl_alloc_tl_cache = nullptr;
+static thread_local bool vnl_alloc_tl_cache_gone = false;
+
+//: Deletes the thread's cache at thread exit
+struct vnl_alloc_cache_owner
+{
+  ~vnl_alloc_cache_owner()
+  {
+    delete vnl_alloc_tl_cache;
+    vnl_alloc_tl_cache = nullptr;
+    vnl_alloc_tl_cache_gone = true;
+  }
+};
+static thread_local vnl_alloc_cache_owner vnl_alloc_tl_owner;
+
+//: The calling thread's cache, or null once the thread is shutting down
+static vnl_alloc_cache *
+vnl_alloc_thread_cache()
+{
+  if (vnl_alloc_tl_cache || vnl_alloc_tl_cache_gone)
+    return vnl_alloc_tl_cache;
+  (void)&vnl_alloc_tl_owner; // make sure the owner is constructed
+  vnl_alloc_tl_cache = new vnl_alloc_cache;
+  return vnl_alloc_tl_cache;
+}
+
+static void *
+vnl_alloc_large(std::size_t n)
 {
-  int nobjs = 20;
-  char * chunk = chunk_alloc(n, nobjs);
-  obj * next_obj;
+  // Room to align, and to store the pointer to free before the result
+  void * raw = std::malloc(n + VNL_ALLOC_LARGE_ALIGN);
+  if (!raw)
+    throw std::bad_alloc();
+  const std::uintptr_t a =
+    (reinterpret_cast<std::uintptr_t>(raw) + VNL_ALLOC_LARGE_ALIGN) & ~std::uintptr_t(VNL_ALLOC_LARGE_ALIGN - 1);
+  void ** result = reinterpret_cast<void **>(a);
+  result[-1] = raw;
+  return result;
+}
 
-  if (1 == nobjs)
-    return chunk;
-  obj ** my_free_list = free_list + FREELIST_INDEX(n);
+static void
+vnl_alloc_free_large(void * p)
+{
+  std::free(static_cast<void **>(p)[-1]);
+}
 
-  /* Build free std::list in chunk */
-  obj * result = (obj *)chunk;
-  *my_free_list = next_obj = (obj *)(chunk + n);
-  for (int i = 1;; i++)
+void *
+vnl_alloc::allocate(std::size_t n)
+{
+  vnl_alloc_cache * cache = vnl_alloc_thread_cache();
+  if (n > VNL_ALLOC_MAX_BYTES)
   {
-    obj * current_obj = next_obj;
-    next_obj = (obj *)((char *)next_obj + n);
-    if (nobjs - 1 == i)
+    void * p = vnl_alloc_large(n);
+    if (cache)
+      cache->add_large(std::ptrdiff_t(n));
+    else
     {
-      current_obj->free_list_link = nullptr;
-      break;
+      vnl_alloc_the_depot().orphan_live += std::ptrdiff_t(n);
+      vnl_alloc_the_depot().orphan_large += std::ptrdiff_t(n);
     }
+    return p;
+  }
+  const std::size_t cls = vnl_alloc_class(n);
+  if (!cache)
+  {
+    vnl_alloc_depot & depot = vnl_alloc_the_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    std::size_t count;
+    vnl_alloc_node * head = depot.pop_batch(cls, count);
+    if (count > 1)
+      depot.push_batch(cls, head->next, count - 1);
+    depot.orphan_live += std::ptrdiff_t(vnl_alloc_class_bytes(cls));
+    return head;
+  }
+  vnl_alloc_node * result = cache->heads[cls];
+  if (!result)
+  {
+    vnl_alloc_depot & depot = vnl_alloc_the_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    result = depot.pop_batch(cls, cache->counts[cls]);
+  }
+  cache->heads[cls] = result->next;
+  --cache->counts[cls];
+  cache->add_live(std::ptrdiff_t(vnl_alloc_class_bytes(cls)));
+  return result;
+}
+
+void
+vnl_alloc::deallocate(void * p, std::size_t n)
+{
+  vnl_alloc_cache * cache = vnl_alloc_thread_cache();
+  if (n > VNL_ALLOC_MAX_BYTES)
+  {
+    vnl_alloc_free_large(p);
+    if (cache)
+      cache->add_large(-std::ptrdiff_t(n));
     else
     {
-      current_obj->free_list_link = next_obj;
+      vnl_alloc_the_depot().orphan_live -= std::ptrdiff_t(n);
+      vnl_alloc_the_depot().orphan_large -= std::ptrdiff_t(n);
     }
+    return;
   }
-  return result;
+  const std::size_t cls = vnl_alloc_class(n);
+  auto * q = static_cast<vnl_alloc_node *>(p);
+  if (!cache)
+  {
+    vnl_alloc_depot & depot = vnl_alloc_the_depot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    q->next = nullptr;
+    depot.push_batch(cls, q, 1);
+    depot.orphan_live -= std::ptrdiff_t(vnl_alloc_class_bytes(cls));
+    return;
+  }
+  q->next = cache->heads[cls];
+  cache->heads[cls] = q;
+  cache->add_live(-std::ptrdiff_t(vnl_alloc_class_bytes(cls)));
+  if (++cache->counts[cls] < 2 * vnl_alloc_batch_size)
+    return;
+  // Too many free objects in this thread: give a batch back to the depot
+  vnl_alloc_node * batch = cache->heads[cls];
+  vnl_alloc_node * last = batch;
+  for (unsigned i = 1; i < vnl_alloc_batch_size; ++i)
+    last = last->next;
+  cache->heads[cls] = last->next;
+  cache->counts[cls] -= vnl_alloc_batch_size;
+  last->next = nullptr;
+  vnl_alloc_depot & depot = vnl_alloc_the_depot();
+  std::lock_guard<std::mutex> lock(depot.mutex);
+  depot.push_batch(cls, batch, vnl_alloc_batch_size);
 }
 
 void *
 vnl_alloc::reallocate(void * p, std::size_t old_sz, std::size_t new_sz)
 {
-
-  if (old_sz > VNL_ALLOC_MAX_BYTES && new_sz > VNL_ALLOC_MAX_BYTES)
-  {
-    return std::realloc(p, new_sz);
-  }
-  if (ROUND_UP(old_sz) == ROUND_UP(new_sz))
+  if (old_sz <= VNL_ALLOC_MAX_BYTES && new_sz <= VNL_ALLOC_MAX_BYTES && ROUND_UP(old_sz) == ROUND_UP(new_sz))
     return p;
   void * result = allocate(new_sz);
   const std::size_t copy_sz = new_sz > old_sz ? old_sz : new_sz;
@@ -119,20 +329,26 @@ vnl_alloc::reallocate(void * p, std::size_t old_sz, std::size_t new_sz)
   return result;
 }
 
-char * vnl_alloc::start_free = nullptr;
-char * vnl_alloc::end_free = nullptr;
-std::size_t vnl_alloc::heap_size = 0;
-
-vnl_alloc::obj * vnl_alloc::free_list[VNL_ALLOC_NFREELISTS] = { nullptr };
-
-#ifdef TEST
-int
-main()
+std::size_t
+vnl_alloc::live_bytes()
 {
-  char * p = (char *)vnl_alloc::allocate(10);
-  std::strcpy(p, "fred\n");
-  std::cerr << p << '\n';
-  vnl_alloc::deallocate(p, 10);
+  vnl_alloc_depot & depot = vnl_alloc_the_depot();
+  std::lock_guard<std::mutex> lock(depot.mutex);
+  std::ptrdiff_t total = depot.orphan_live.load();
+  for (auto cache : depot.caches)
+    total += cache->live.load(std::memory_order_relaxed);
+  // Individual threads can go negative when they free others' objects, the total cannot
+  return total > 0 ? std::size_t(total) : 0;
 }
 
-#endif // TEST
+std::size_t
+vnl_alloc::reserved_bytes()
+{
+  vnl_alloc_depot & depot = vnl_alloc_the_depot();
+  std::lock_guard<std::mutex> lock(depot.mutex);
+  std::ptrdiff_t large = depot.orphan_large.load();
+  for (auto cache : depot.caches)
+    large += cache->large.load(std::memory_order_relaxed);
+  // As for live_bytes(), only the total is meaningful
+  return depot.chunk_bytes.load() + (large > 0 ? std::size_t(large) : 0);
+}
@@ -0,0 +1,175 @@
+// This is core/vnl/vnl_csr_matrix.h
+#ifndef vnl_csr_matrix_h_
+#define vnl_csr_matrix_h_
+//:
+// \file
+// \brief Frozen compressed sparse row matrix, for fast matrix-vector products
+//
+// A vnl_csr_matrix is a read-only copy of a sparse matrix in compressed
+// sparse row (CSR) form: the column indices and values of all non-zero
+// entries are stored row after row in two flat arrays, and a third array
+// holds the start of each row.  Optionally the transpose is stored too, in
+// the same form (i.e. the matrix in compressed sparse column form), so that
+// products with the transpose are as fast as products with the matrix.
+//
+// The products visit the arrays sequentially, use AVX2 gathers for float and
+// double when the processor has them, and are split over the rows of the
+// result across vnl_thread_pool::default_pool() when the matrix is large.
+// Each entry of the result is computed by one thread, in a fixed order, so
+// the results do not depend on the number of threads.
+//
+// Build one from a vnl_sparse_matrix when the structure is final and many
+// products are needed, e.g. in iterative solvers such as vnl_lsqr.
+
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vnl_vector.h"
+#include "vnl_sparse_matrix.h"
+#include "vnl_crs_index.h"
+#include "vnl/vnl_export.h"
+
+//: Frozen compressed sparse row matrix
+template <class T>
+class VNL_EXPORT vnl_csr_matrix
+{
+public:
+  //: Construct an empty matrix
+  vnl_csr_matrix() = default;
+
+  //: Copy the non-zero entries of A.
+  //  If with_transpose is true, the transpose is stored too, which doubles
+  //  the memory used but makes pre_mult() as fast (and as parallel) as mult().
+  explicit vnl_csr_matrix(const vnl_sparse_matrix<T> & A, bool with_transpose = true);
+
+  //: Construct from a sparsity pattern and the values it indexes.
+  //  The entry at (i,j) is values[idx(i,j)].
+  vnl_csr_matrix(const vnl_crs_index & idx, const std::vector<T> & values, bool with_transpose = true);
+
+  //: Get the number of rows in the matrix.
+  unsigned int
+  rows() const
+  {
+    return rows_;
+  }
+
+  //: Get the number of columns in the matrix.
+  unsigned int
+  columns() const
+  {
+    return cols_;
+  }
+
+  //: Get the number of columns in the matrix.
+  unsigned int
+  cols() const
+  {
+    return cols_;
+  }
+
+  //: Number of stored entries
+  std::size_t
+  num_nonzero() const
+  {
+    return val_.size();
+  }
+
+  //: True if the transpose is stored as well
+  bool
+  has_transpose() const
+  {
+    return with_transpose_;
+  }
+
+  //: Start of each row in col_idx() and values(); row_ptr()[rows()] == num_nonzero()
+  const std::vector<std::size_t> &
+  row_ptr() const
+  {
+    return row_ptr_;
+  }
+
+  //: Column of each stored entry, in increasing order within a row
+  const std::vector<unsigned int> &
+  col_idx() const
+  {
+    return col_idx_;
+  }
+
+  //: Value of each stored entry
+  const std::vector<T> &
+  values() const
+  {
+    return val_;
+  }
+
+  //: Get the value of an entry in the matrix.
+  T
+  operator()(unsigned int row, unsigned int column) const;
+
+  //: result = this*rhs.  result must not be rhs.
+  void
+  mult(const vnl_vector<T> & rhs, vnl_vector<T> & result) const;
+
+  //: Multiply this*p, where p is a prows x pcols Fortran order (column major) matrix.
+  //  q must have room for rows() x pcols values, also in Fortran order.
+  void
+  mult(unsigned int prows, unsigned int pcols, const T * p, T * q) const;
+
+  //: result = lhs*this, i.e. transpose(this)*lhs.  result must not be lhs.
+  void
+  pre_mult(const vnl_vector<T> & lhs, vnl_vector<T> & result) const;
+
+  //: Get diag(A_transpose * A).
+  void
+  diag_AtA(vnl_vector<T> & result) const;
+
+  //: Convert back to a vnl_sparse_matrix
+  vnl_sparse_matrix<T>
+  as_sparse_matrix() const;
+
+private:
+  //: Fill the transpose arrays and the work splits from the row arrays
+  void
+  finish(bool with_transpose);
+
+  unsigned int rows_{ 0 };
+  unsigned int cols_{ 0 };
+  bool with_transpose_{ false };
+  std::vector<std::size_t> row_ptr_{ 0 };
+  std::vector<unsigned int> col_idx_;
+  std::vector<T> val_;
+
+  // The transpose, in the same form
+  std::vector<std::size_t> col_ptr_;
+  std::vector<unsigned int> row_idx_;
+  std::vector<T> tval_;
+
+  //: Boundaries of runs of rows (of this and of the transpose) with about equal numbers of entries
+  std::vector<unsigned int> row_split_;
+  std::vector<unsigned int> col_split_;
+};
+
+//: Sum of val[k]*x[col[k]] for k in [0,n), where col is increasing.  Generic version.
+template <class T>
+inline T
+vnl_csr_row_dot(const T * val, const unsigned int * col, std::size_t n, const T * x)
+{
+  T sum(0);
+  for (std::size_t k = 0; k < n; ++k)
+    sum += val[k] * x[col[k]];
+  return sum;
+}
+
+//: Sum of val[k]*x[col[k]] for k in [0,n), vectorised if possible
+VNL_EXPORT double
+vnl_csr_row_dot(const double * val, const unsigned int * col, std::size_t n, const double * x);
+
+//: Sum of val[k]*x[col[k]] for k in [0,n), vectorised if possible
+VNL_EXPORT float
+vnl_csr_row_dot(const float * val, const unsigned int * col, std::size_t n, const float * x);
+
+#define VNL_CSR_MATRIX_INSTANTIATE(T) extern "please include vnl/vnl_csr_matrix.hxx instead"
+
+#endif // vnl_csr_matrix_h_
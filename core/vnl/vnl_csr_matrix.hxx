@@ -0,0 +1,251 @@
+// This is core/vnl/vnl_csr_matrix.hxx
+#ifndef vnl_csr_matrix_hxx_
+#define vnl_csr_matrix_hxx_
+//:
+// \file
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include "vnl_csr_matrix.h"
+#include "vnl_thread_pool.h"
+
+//: Rows are handed to threads in runs of about this many entries
+constexpr std::size_t vnl_csr_matrix_run_size = 16384;
+
+//: Matrices with fewer entries than this are multiplied in the calling thread
+constexpr std::size_t vnl_csr_matrix_parallel_min = 65536;
+
+//: Split [0,n) into runs with about vnl_csr_matrix_run_size entries each.
+//  ptr[i] is the start of row i; each row also counts as one entry.
+static inline std::vector<unsigned int>
+vnl_csr_matrix_split(const std::vector<std::size_t> & ptr, unsigned int n)
+{
+  std::vector<unsigned int> split(1, 0);
+  std::size_t start = 0;
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    const std::size_t weight = ptr[i + 1] + i + 1;
+    if (weight - start >= vnl_csr_matrix_run_size)
+    {
+      split.push_back(i + 1);
+      start = weight;
+    }
+  }
+  if (split.back() != n)
+    split.push_back(n);
+  return split;
+}
+
+//: Call f(begin,end) for each run of rows, in parallel if the matrix is large enough
+template <class F>
+static inline void
+vnl_csr_matrix_for_runs(const std::vector<unsigned int> & split, std::size_t nnz, F f)
+{
+  const std::size_t n_runs = split.size() - 1;
+  if (nnz < vnl_csr_matrix_parallel_min || n_runs < 2)
+  {
+    for (std::size_t r = 0; r < n_runs; ++r)
+      f(split[r], split[r + 1]);
+    return;
+  }
+  vnl_thread_pool::default_pool().parallel_for(n_runs, [&](std::size_t r) { f(split[r], split[r + 1]); });
+}
+
+template <class T>
+vnl_csr_matrix<T>::vnl_csr_matrix(const vnl_sparse_matrix<T> & A, bool with_transpose)
+  : rows_(A.rows())
+  , cols_(A.columns())
+{
+  // Count the entries of each row, then copy them into place
+  row_ptr_.assign(rows_ + 1, 0);
+  for (A.reset(); A.next();)
+    ++row_ptr_[A.getrow() + 1];
+  for (unsigned int i = 0; i < rows_; ++i)
+    row_ptr_[i + 1] += row_ptr_[i];
+  col_idx_.resize(row_ptr_[rows_]);
+  val_.resize(row_ptr_[rows_]);
+  std::vector<std::size_t> fill(row_ptr_.begin(), row_ptr_.end() - 1);
+  for (A.reset(); A.next();)
+  {
+    const std::size_t k = fill[A.getrow()]++;
+    col_idx_[k] = A.getcolumn();
+    val_[k] = A.value();
+  }
+
+  // vnl_sparse_matrix keeps rows sorted if built with put(), but not necessarily with set_row()
+  std::vector<std::pair<unsigned int, T>> tmp;
+  for (unsigned int i = 0; i < rows_; ++i)
+  {
+    const std::size_t b = row_ptr_[i], e = row_ptr_[i + 1];
+    if (std::is_sorted(col_idx_.begin() + b, col_idx_.begin() + e))
+      continue;
+    tmp.clear();
+    for (std::size_t k = b; k < e; ++k)
+      tmp.emplace_back(col_idx_[k], val_[k]);
+    std::sort(tmp.begin(), tmp.end(), [](const std::pair<unsigned int, T> & x, const std::pair<unsigned int, T> & y) {
+      return x.first < y.first;
+    });
+    for (std::size_t k = b; k < e; ++k)
+    {
+      col_idx_[k] = tmp[k - b].first;
+      val_[k] = tmp[k - b].second;
+    }
+  }
+  finish(with_transpose);
+}
+
+template <class T>
+vnl_csr_matrix<T>::vnl_csr_matrix(const vnl_crs_index & idx, const std::vector<T> & values, bool with_transpose)
+  : rows_(idx.num_rows() < 0 ? 0 : idx.num_rows())
+  , cols_(idx.num_cols())
+{
+  assert(values.size() >= std::size_t(idx.num_non_zero()));
+  row_ptr_.assign(rows_ + 1, 0);
+  col_idx_.reserve(idx.num_non_zero());
+  val_.reserve(idx.num_non_zero());
+  for (unsigned int i = 0; i < rows_; ++i)
+  {
+    for (const auto & e : idx.sparse_row(int(i)))
+    {
+      col_idx_.push_back(unsigned(e.second));
+      val_.push_back(values[e.first]);
+    }
+    row_ptr_[i + 1] = col_idx_.size();
+  }
+  finish(with_transpose);
+}
+
+template <class T>
+void
+vnl_csr_matrix<T>::finish(bool with_transpose)
+{
+  with_transpose_ = with_transpose;
+  row_split_ = vnl_csr_matrix_split(row_ptr_, rows_);
+  if (!with_transpose)
+    return;
+
+  // Counting sort by column; rows stay in increasing order within each column
+  col_ptr_.assign(cols_ + 1, 0);
+  for (unsigned int c : col_idx_)
+    ++col_ptr_[c + 1];
+  for (unsigned int j = 0; j < cols_; ++j)
+    col_ptr_[j + 1] += col_ptr_[j];
+  row_idx_.resize(val_.size());
+  tval_.resize(val_.size());
+  std::vector<std::size_t> fill(col_ptr_.begin(), col_ptr_.end() - 1);
+  for (unsigned int i = 0; i < rows_; ++i)
+    for (std::size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k)
+    {
+      const std::size_t t = fill[col_idx_[k]]++;
+      row_idx_[t] = i;
+      tval_[t] = val_[k];
+    }
+  col_split_ = vnl_csr_matrix_split(col_ptr_, cols_);
+}
+
+template <class T>
+T
+vnl_csr_matrix<T>::operator()(unsigned int row, unsigned int column) const
+{
+  assert(row < rows_ && column < cols_);
+  const auto b = col_idx_.begin() + row_ptr_[row], e = col_idx_.begin() + row_ptr_[row + 1];
+  const auto it = std::lower_bound(b, e, column);
+  return (it != e && *it == column) ? val_[it - col_idx_.begin()] : T(0);
+}
+
+template <class T>
+void
+vnl_csr_matrix<T>::mult(const vnl_vector<T> & rhs, vnl_vector<T> & result) const
+{
+  assert(rhs.size() == cols_);
+  assert(&rhs != &result);
+  result.set_size(rows_);
+  const T * x = rhs.data_block();
+  T * y = result.data_block();
+  const T * val = val_.data();
+  const unsigned int * col = col_idx_.data();
+  const std::size_t * ptr = row_ptr_.data();
+  vnl_csr_matrix_for_runs(row_split_, val_.size(), [=](unsigned int b, unsigned int e) {
+    for (unsigned int i = b; i < e; ++i)
+      y[i] = vnl_csr_row_dot(val + ptr[i], col + ptr[i], ptr[i + 1] - ptr[i], x);
+  });
+}
+
+template <class T>
+void
+vnl_csr_matrix<T>::mult(unsigned int prows, unsigned int pcols, const T * p, T * q) const
+{
+  assert(prows == cols_);
+  const T * val = val_.data();
+  const unsigned int * col = col_idx_.data();
+  const std::size_t * ptr = row_ptr_.data();
+  const std::size_t qrows = rows_;
+  vnl_csr_matrix_for_runs(row_split_, val_.size() * pcols, [=](unsigned int b, unsigned int e) {
+    for (unsigned int c = 0; c < pcols; ++c)
+    {
+      const T * x = p + std::size_t(c) * prows;
+      T * y = q + c * qrows;
+      for (unsigned int i = b; i < e; ++i)
+        y[i] = vnl_csr_row_dot(val + ptr[i], col + ptr[i], ptr[i + 1] - ptr[i], x);
+    }
+  });
+}
+
+template <class T>
+void
+vnl_csr_matrix<T>::pre_mult(const vnl_vector<T> & lhs, vnl_vector<T> & result) const
+{
+  assert(lhs.size() == rows_);
+  assert(&lhs != &result);
+  result.set_size(cols_);
+  const T * x = lhs.data_block();
+  T * y = result.data_block();
+  if (!with_transpose_)
+  {
+    // Scatter, row by row
+    result.fill(T(0));
+    for (unsigned int i = 0; i < rows_; ++i)
+      for (std::size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k)
+        y[col_idx_[k]] += x[i] * val_[k];
+    return;
+  }
+  const T * val = tval_.data();
+  const unsigned int * row = row_idx_.data();
+  const std::size_t * ptr = col_ptr_.data();
+  vnl_csr_matrix_for_runs(col_split_, tval_.size(), [=](unsigned int b, unsigned int e) {
+    for (unsigned int j = b; j < e; ++j)
+      y[j] = vnl_csr_row_dot(val + ptr[j], row + ptr[j], ptr[j + 1] - ptr[j], x);
+  });
+}
+
+template <class T>
+void
+vnl_csr_matrix<T>::diag_AtA(vnl_vector<T> & result) const
+{
+  result.set_size(cols_);
+  result.fill(T(0));
+  for (std::size_t k = 0; k < val_.size(); ++k)
+    result[col_idx_[k]] += val_[k] * val_[k];
+}
+
+template <class T>
+vnl_sparse_matrix<T>
+vnl_csr_matrix<T>::as_sparse_matrix() const
+{
+  vnl_sparse_matrix<T> A(rows_, cols_);
+  std::vector<int> cols;
+  std::vector<T> vals;
+  for (unsigned int i = 0; i < rows_; ++i)
+  {
+    cols.assign(col_idx_.begin() + row_ptr_[i], col_idx_.begin() + row_ptr_[i + 1]);
+    vals.assign(val_.begin() + row_ptr_[i], val_.begin() + row_ptr_[i + 1]);
+    A.set_row(i, cols, vals);
+  }
+  return A;
+}
+
+#undef VNL_CSR_MATRIX_INSTANTIATE
+#define VNL_CSR_MATRIX_INSTANTIATE(T) template class VNL_EXPORT vnl_csr_matrix<T>
+
+#endif // vnl_csr_matrix_hxx_
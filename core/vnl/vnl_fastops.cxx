@@ -10,6 +10,7 @@
 #include <cstring>
 #include <iostream>
 #include "vnl_fastops.h"
+#include "vnl_gemm.h"
 
 //: Compute $A^\top A$.
 void
@@ -25,6 +26,12 @@ vnl_fastops::AtA(vnl_matrix<double> & out, const vnl_matrix<double> & A)
   const double * const * a = A.data_array();
   double ** ata = out.data_array();
 
+  if (vnl_gemm_worthwhile(n, n, m))
+  {
+    vnl_gemm(true, false, n, n, m, 1.0, a[0], n, a[0], n, 0.0, ata[0], n);
+    return;
+  }
+
   /* Simple Implementation for reference:
       for (unsigned int i = 0; i < n; ++i)
         for (unsigned int j = i; j < n; ++j) {
@@ -78,6 +85,12 @@ vnl_fastops::AB(vnl_matrix<double> & out, const vnl_matrix<double> & A, const vn
   const double * const * b = B.data_array();
   double ** outdata = out.data_array();
 
+  if (vnl_gemm_worthwhile(ma, nb, na))
+  {
+    vnl_gemm(false, false, ma, nb, na, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j)
     {
@@ -113,6 +126,12 @@ vnl_fastops::AtB(vnl_matrix<double> & out, const vnl_matrix<double> & A, const v
   const double * const * b = B.data_array();
   double ** outdata = out.data_array();
 
+  if (vnl_gemm_worthwhile(na, nb, ma))
+  {
+    vnl_gemm(true, false, na, nb, ma, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j)
     {
@@ -214,6 +233,12 @@ vnl_fastops::ABt(vnl_matrix<double> & out, const vnl_matrix<double> & A, const v
   const double * const * b = B.data_array();
   double ** outdata = out.data_array();
 
+  if (vnl_gemm_worthwhile(ma, mb, na))
+  {
+    vnl_gemm(false, true, ma, mb, na, 1.0, a[0], na, b[0], nb, 0.0, outdata[0], mb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < mb; ++j)
     {
@@ -325,6 +350,12 @@ vnl_fastops::inc_X_by_AtA(vnl_matrix<double> & X, const vnl_matrix<double> & A)
   const double * const * a = A.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(n, n, l))
+  {
+    vnl_gemm(true, false, n, n, l, 1.0, a[0], n, a[0], n, 1.0, x[0], n);
+    return;
+  }
+
   if (l == 2)
   {
     for (unsigned int i = 0; i < n; ++i)
@@ -383,6 +414,12 @@ vnl_fastops::inc_X_by_AB(vnl_matrix<double> & X, const vnl_matrix<double> & A, c
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(ma, nb, na))
+  {
+    vnl_gemm(false, false, ma, nb, na, 1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j)
       for (unsigned int k = 0; k < na; ++k)
@@ -419,6 +456,12 @@ vnl_fastops::dec_X_by_AB(vnl_matrix<double> & X, const vnl_matrix<double> & A, c
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(ma, nb, na))
+  {
+    vnl_gemm(false, false, ma, nb, na, -1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < ma; ++i)
     for (unsigned int j = 0; j < nb; ++j)
       for (unsigned int k = 0; k < na; ++k)
@@ -455,6 +498,12 @@ vnl_fastops::inc_X_by_AtB(vnl_matrix<double> & X, const vnl_matrix<double> & A,
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(na, nb, ma))
+  {
+    vnl_gemm(true, false, na, nb, ma, 1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j)
     {
@@ -495,6 +544,12 @@ vnl_fastops::dec_X_by_AtB(vnl_matrix<double> & X, const vnl_matrix<double> & A,
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(na, nb, ma))
+  {
+    vnl_gemm(true, false, na, nb, ma, -1.0, a[0], na, b[0], nb, 1.0, x[0], nb);
+    return;
+  }
+
   for (unsigned int i = 0; i < na; ++i)
     for (unsigned int j = 0; j < nb; ++j)
     {
@@ -598,6 +653,12 @@ vnl_fastops::dec_X_by_AtA(vnl_matrix<double> & X, const vnl_matrix<double> & A)
   const double * const * a = A.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(n, n, l))
+  {
+    vnl_gemm(true, false, n, n, l, -1.0, a[0], n, a[0], n, 1.0, x[0], n);
+    return;
+  }
+
   if (l == 2)
   {
     for (unsigned int i = 0; i < n; ++i)
@@ -684,6 +745,12 @@ vnl_fastops::inc_X_by_ABt(vnl_matrix<double> & X, const vnl_matrix<double> & A,
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(ma, mb, na))
+  {
+    vnl_gemm(false, true, ma, mb, na, 1.0, a[0], na, b[0], nb, 1.0, x[0], mb);
+    return;
+  }
+
   if (na == 3)
   {
     for (unsigned int i = 0; i < mb; ++i)
@@ -740,6 +807,12 @@ vnl_fastops::dec_X_by_ABt(vnl_matrix<double> & X, const vnl_matrix<double> & A,
   const double * const * b = B.data_array();
   double ** x = X.data_array();
 
+  if (vnl_gemm_worthwhile(ma, mb, na))
+  {
+    vnl_gemm(false, true, ma, mb, na, -1.0, a[0], na, b[0], nb, 1.0, x[0], mb);
+    return;
+  }
+
   if (na == 3)
   {
     for (unsigned int i = 0; i < mb; ++i)
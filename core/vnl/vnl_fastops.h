@@ -13,6 +13,7 @@
 //   Jun.2004 -Peter Vanroose- Added inc_X_by_ABt dec_X_by_AtB {inc,dec}_X_by_AB
 //   Jun.2004 -Peter Vanroose- First step to migrate towards non-pointer args
 //   Mar.2007 -Peter Vanroose- Commented deprecated versions of the functions
+//   Large matrix products are passed on to vnl_gemm
 // \endverbatim
 
 #include "vnl_vector.h"
@@ -0,0 +1,415 @@
+// This is core/vnl/vnl_gemm.cxx
+//:
+// \file
+// \brief Cache-blocked general matrix multiply for float and double
+//
+// The layout follows the usual scheme for portable high performance GEMM:
+// op(B) is copied a KC x NC block at a time into column slivers NR wide,
+// op(A) an MC x KC block at a time into row slivers MR high, and an MR x NR
+// kernel multiplies one sliver of each, keeping the MR x NR sums in registers.
+// Slivers at the edges are padded with zeros, so the kernel never needs to
+// know about matrix sizes.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "vnl_gemm.h"
+#include "vnl_thread_pool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define VNL_GEMM_X86 1
+#  include <immintrin.h>
+#endif
+
+//: Block sizes.  MC x KC of A stays in L2 cache, KC x NR of B in L1.
+template <class T>
+struct vnl_gemm_traits;
+
+template <>
+struct vnl_gemm_traits<double>
+{
+  static constexpr unsigned MR = 6, NR = 8, MC = 96, KC = 256, NC = 2048;
+};
+
+template <>
+struct vnl_gemm_traits<float>
+{
+  static constexpr unsigned MR = 6, NR = 16, MC = 96, KC = 256, NC = 4096;
+};
+
+//: Products smaller than this many multiply-adds per thread are not split further
+static const std::uint64_t vnl_gemm_work_per_thread = std::uint64_t(1) << 20;
+
+static std::atomic<unsigned> vnl_gemm_max_threads{ 0 };
+static std::atomic<bool> vnl_gemm_simd_enabled{ true };
+
+static bool
+vnl_gemm_have_avx2()
+{
+#ifdef VNL_GEMM_X86
+  static const bool have = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }();
+  return have;
+#else
+  return false;
+#endif
+}
+
+//: ab = sum over p<kc of a[p*MR+i]*b[p*NR+j], stored as ab[i*NR+j]
+template <class T>
+static void
+vnl_gemm_kernel_generic(unsigned kc, const T * a, const T * b, T * ab)
+{
+  constexpr unsigned MR = vnl_gemm_traits<T>::MR, NR = vnl_gemm_traits<T>::NR;
+  T acc[MR * NR] = {};
+  for (unsigned p = 0; p < kc; ++p, a += MR, b += NR)
+    for (unsigned i = 0; i < MR; ++i)
+    {
+      const T ai = a[i];
+      T * row = acc + i * NR;
+      for (unsigned j = 0; j < NR; ++j)
+        row[j] += ai * b[j];
+    }
+  std::copy(acc, acc + MR * NR, ab);
+}
+
+#ifdef VNL_GEMM_X86
+__attribute__((target("avx2,fma"))) static void
+vnl_gemm_kernel_avx2(unsigned kc, const double * a, const double * b, double * ab)
+{
+  __m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00;
+  __m256d c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 6, b += 8)
+  {
+    const __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+    __m256d ai = _mm256_broadcast_sd(a);
+    c00 = _mm256_fmadd_pd(ai, b0, c00);
+    c01 = _mm256_fmadd_pd(ai, b1, c01);
+    ai = _mm256_broadcast_sd(a + 1);
+    c10 = _mm256_fmadd_pd(ai, b0, c10);
+    c11 = _mm256_fmadd_pd(ai, b1, c11);
+    ai = _mm256_broadcast_sd(a + 2);
+    c20 = _mm256_fmadd_pd(ai, b0, c20);
+    c21 = _mm256_fmadd_pd(ai, b1, c21);
+    ai = _mm256_broadcast_sd(a + 3);
+    c30 = _mm256_fmadd_pd(ai, b0, c30);
+    c31 = _mm256_fmadd_pd(ai, b1, c31);
+    ai = _mm256_broadcast_sd(a + 4);
+    c40 = _mm256_fmadd_pd(ai, b0, c40);
+    c41 = _mm256_fmadd_pd(ai, b1, c41);
+    ai = _mm256_broadcast_sd(a + 5);
+    c50 = _mm256_fmadd_pd(ai, b0, c50);
+    c51 = _mm256_fmadd_pd(ai, b1, c51);
+  }
+  _mm256_storeu_pd(ab + 0, c00);
+  _mm256_storeu_pd(ab + 4, c01);
+  _mm256_storeu_pd(ab + 8, c10);
+  _mm256_storeu_pd(ab + 12, c11);
+  _mm256_storeu_pd(ab + 16, c20);
+  _mm256_storeu_pd(ab + 20, c21);
+  _mm256_storeu_pd(ab + 24, c30);
+  _mm256_storeu_pd(ab + 28, c31);
+  _mm256_storeu_pd(ab + 32, c40);
+  _mm256_storeu_pd(ab + 36, c41);
+  _mm256_storeu_pd(ab + 40, c50);
+  _mm256_storeu_pd(ab + 44, c51);
+}
+
+__attribute__((target("avx2,fma"))) static void
+vnl_gemm_kernel_avx2(unsigned kc, const float * a, const float * b, float * ab)
+{
+  __m256 c00 = _mm256_setzero_ps(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00;
+  __m256 c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+  for (unsigned p = 0; p < kc; ++p, a += 6, b += 16)
+  {
+    const __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+    __m256 ai = _mm256_broadcast_ss(a);
+    c00 = _mm256_fmadd_ps(ai, b0, c00);
+    c01 = _mm256_fmadd_ps(ai, b1, c01);
+    ai = _mm256_broadcast_ss(a + 1);
+    c10 = _mm256_fmadd_ps(ai, b0, c10);
+    c11 = _mm256_fmadd_ps(ai, b1, c11);
+    ai = _mm256_broadcast_ss(a + 2);
+    c20 = _mm256_fmadd_ps(ai, b0, c20);
+    c21 = _mm256_fmadd_ps(ai, b1, c21);
+    ai = _mm256_broadcast_ss(a + 3);
+    c30 = _mm256_fmadd_ps(ai, b0, c30);
+    c31 = _mm256_fmadd_ps(ai, b1, c31);
+    ai = _mm256_broadcast_ss(a + 4);
+    c40 = _mm256_fmadd_ps(ai, b0, c40);
+    c41 = _mm256_fmadd_ps(ai, b1, c41);
+    ai = _mm256_broadcast_ss(a + 5);
+    c50 = _mm256_fmadd_ps(ai, b0, c50);
+    c51 = _mm256_fmadd_ps(ai, b1, c51);
+  }
+  _mm256_storeu_ps(ab + 0, c00);
+  _mm256_storeu_ps(ab + 8, c01);
+  _mm256_storeu_ps(ab + 16, c10);
+  _mm256_storeu_ps(ab + 24, c11);
+  _mm256_storeu_ps(ab + 32, c20);
+  _mm256_storeu_ps(ab + 40, c21);
+  _mm256_storeu_ps(ab + 48, c30);
+  _mm256_storeu_ps(ab + 56, c31);
+  _mm256_storeu_ps(ab + 64, c40);
+  _mm256_storeu_ps(ab + 72, c41);
+  _mm256_storeu_ps(ab + 80, c50);
+  _mm256_storeu_ps(ab + 88, c51);
+}
+#endif // VNL_GEMM_X86
+
+//: The operands of one product
+template <class T>
+struct vnl_gemm_problem
+{
+  bool trans_a, trans_b;
+  unsigned k;
+  T alpha;
+  const T * A;
+  std::ptrdiff_t lda;
+  const T * B;
+  std::ptrdiff_t ldb;
+  T beta;
+  T * C;
+  std::ptrdiff_t ldc;
+  bool simd;
+};
+
+//: Copy rows [i0,i0+mc) and columns [p0,p0+kc) of op(A) into MR-high slivers
+template <class T>
+static void
+vnl_gemm_pack_a(const vnl_gemm_problem<T> & pb, unsigned i0, unsigned mc, unsigned p0, unsigned kc, T * dst)
+{
+  constexpr unsigned MR = vnl_gemm_traits<T>::MR;
+  for (unsigned ir = 0; ir < mc; ir += MR)
+  {
+    const unsigned mr = std::min(MR, mc - ir);
+    for (unsigned p = 0; p < kc; ++p, dst += MR)
+    {
+      for (unsigned r = 0; r < mr; ++r)
+      {
+        const std::ptrdiff_t i = i0 + ir + r, q = p0 + p;
+        dst[r] = pb.trans_a ? pb.A[q * pb.lda + i] : pb.A[i * pb.lda + q];
+      }
+      for (unsigned r = mr; r < MR; ++r)
+        dst[r] = T(0);
+    }
+  }
+}
+
+//: Copy rows [p0,p0+kc) and columns [j0,j0+nc) of op(B) into NR-wide slivers
+template <class T>
+static void
+vnl_gemm_pack_b(const vnl_gemm_problem<T> & pb, unsigned p0, unsigned kc, unsigned j0, unsigned nc, T * dst)
+{
+  constexpr unsigned NR = vnl_gemm_traits<T>::NR;
+  for (unsigned jr = 0; jr < nc; jr += NR)
+  {
+    const unsigned nr = std::min(NR, nc - jr);
+    for (unsigned p = 0; p < kc; ++p, dst += NR)
+    {
+      const std::ptrdiff_t q = p0 + p;
+      if (pb.trans_b)
+        for (unsigned c = 0; c < nr; ++c)
+          dst[c] = pb.B[std::ptrdiff_t(j0 + jr + c) * pb.ldb + q];
+      else
+      {
+        const T * src = pb.B + q * pb.ldb + j0 + jr;
+        for (unsigned c = 0; c < nr; ++c)
+          dst[c] = src[c];
+      }
+      for (unsigned c = nr; c < NR; ++c)
+        dst[c] = T(0);
+    }
+  }
+}
+
+template <class T>
+static inline void
+vnl_gemm_kernel(bool simd, unsigned kc, const T * a, const T * b, T * ab)
+{
+#ifdef VNL_GEMM_X86
+  if (simd)
+  {
+    vnl_gemm_kernel_avx2(kc, a, b, ab);
+    return;
+  }
+#else
+  (void)simd;
+#endif
+  vnl_gemm_kernel_generic(kc, a, b, ab);
+}
+
+//: Compute rows [r0,r1) and columns [c0,c1) of C, in the calling thread
+template <class T>
+static void
+vnl_gemm_serial(const vnl_gemm_problem<T> & pb, unsigned r0, unsigned r1, unsigned c0, unsigned c1)
+{
+  typedef vnl_gemm_traits<T> tr;
+  constexpr unsigned MR = tr::MR, NR = tr::NR;
+
+  for (unsigned i = r0; i < r1; ++i)
+  {
+    T * row = pb.C + std::ptrdiff_t(i) * pb.ldc;
+    if (pb.beta == T(0))
+      std::fill(row + c0, row + c1, T(0));
+    else if (pb.beta != T(1))
+      for (unsigned j = c0; j < c1; ++j)
+        row[j] *= pb.beta;
+  }
+  if (pb.k == 0 || pb.alpha == T(0))
+    return;
+
+  const unsigned mc_max = std::min(tr::MC, (r1 - r0 + MR - 1) / MR * MR);
+  const unsigned nc_max = std::min(tr::NC, (c1 - c0 + NR - 1) / NR * NR);
+  const unsigned kc_max = std::min(tr::KC, pb.k);
+  std::vector<T> a_pack(std::size_t(mc_max) * kc_max), b_pack(std::size_t(nc_max) * kc_max);
+  T ab[MR * NR];
+
+  for (unsigned jc = c0; jc < c1; jc += tr::NC)
+  {
+    const unsigned nc = std::min(tr::NC, c1 - jc);
+    for (unsigned pc = 0; pc < pb.k; pc += tr::KC)
+    {
+      const unsigned kc = std::min(tr::KC, pb.k - pc);
+      vnl_gemm_pack_b(pb, pc, kc, jc, nc, b_pack.data());
+      for (unsigned ic = r0; ic < r1; ic += tr::MC)
+      {
+        const unsigned mc = std::min(tr::MC, r1 - ic);
+        vnl_gemm_pack_a(pb, ic, mc, pc, kc, a_pack.data());
+        for (unsigned jr = 0; jr < nc; jr += NR)
+        {
+          const unsigned nr = std::min(NR, nc - jr);
+          for (unsigned ir = 0; ir < mc; ir += MR)
+          {
+            const unsigned mr = std::min(MR, mc - ir);
+            vnl_gemm_kernel(pb.simd, kc, a_pack.data() + std::size_t(ir) * kc, b_pack.data() + std::size_t(jr) * kc, ab);
+            T * c = pb.C + std::ptrdiff_t(ic + ir) * pb.ldc + jc + jr;
+            for (unsigned i = 0; i < mr; ++i, c += pb.ldc)
+              for (unsigned j = 0; j < nr; ++j)
+                c[j] += pb.alpha * ab[i * NR + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+template <class T>
+static void
+vnl_gemm_impl(bool trans_a,
+              bool trans_b,
+              unsigned m,
+              unsigned n,
+              unsigned k,
+              T alpha,
+              const T * A,
+              std::ptrdiff_t lda,
+              const T * B,
+              std::ptrdiff_t ldb,
+              T beta,
+              T * C,
+              std::ptrdiff_t ldc)
+{
+  if (m == 0 || n == 0)
+    return;
+  const bool simd = vnl_gemm_simd_enabled && vnl_gemm_have_avx2();
+  const vnl_gemm_problem<T> pb = { trans_a, trans_b, k, alpha, A, lda, B, ldb, beta, C, ldc, simd };
+
+  // Split the larger dimension of C into whole slivers, one part per thread.
+  // The parts run on the default pool, which runs them serially when vnl_gemm
+  // is itself called from a pool task, so nested use does not oversubscribe.
+  vnl_thread_pool & pool = vnl_thread_pool::default_pool();
+  unsigned n_threads = vnl_gemm_max_threads;
+  if (n_threads == 0 || n_threads > pool.n_threads())
+    n_threads = pool.n_threads();
+  const std::uint64_t work = std::uint64_t(m) * n * std::max(k, 1u);
+  n_threads = unsigned(std::min<std::uint64_t>(n_threads, std::max<std::uint64_t>(1, work / vnl_gemm_work_per_thread)));
+  const bool split_rows = m >= n;
+  const unsigned unit = split_rows ? vnl_gemm_traits<T>::MR : vnl_gemm_traits<T>::NR;
+  const unsigned n_units = ((split_rows ? m : n) + unit - 1) / unit;
+  n_threads = std::min(n_threads, n_units);
+  if (n_threads <= 1)
+  {
+    vnl_gemm_serial(pb, 0, m, 0, n);
+    return;
+  }
+
+  const unsigned extent = split_rows ? m : n;
+  pool.parallel_for(n_threads, [&](std::size_t t) {
+    const unsigned start = unsigned((std::uint64_t(n_units) * t / n_threads) * unit);
+    const unsigned end = std::min(extent, unsigned((std::uint64_t(n_units) * (t + 1) / n_threads) * unit));
+    if (split_rows)
+      vnl_gemm_serial(pb, start, end, 0, n);
+    else
+      vnl_gemm_serial(pb, 0, m, start, end);
+  });
+}
+
+void
+vnl_gemm(bool trans_a,
+         bool trans_b,
+         unsigned m,
+         unsigned n,
+         unsigned k,
+         double alpha,
+         const double * A,
+         std::ptrdiff_t lda,
+         const double * B,
+         std::ptrdiff_t ldb,
+         double beta,
+         double * C,
+         std::ptrdiff_t ldc)
+{
+  vnl_gemm_impl(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+void
+vnl_gemm(bool trans_a,
+         bool trans_b,
+         unsigned m,
+         unsigned n,
+         unsigned k,
+         float alpha,
+         const float * A,
+         std::ptrdiff_t lda,
+         const float * B,
+         std::ptrdiff_t ldb,
+         float beta,
+         float * C,
+         std::ptrdiff_t ldc)
+{
+  vnl_gemm_impl(trans_a, trans_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+unsigned
+vnl_gemm_set_max_threads(unsigned n)
+{
+  return vnl_gemm_max_threads.exchange(n);
+}
+
+bool
+vnl_gemm_set_simd(bool enable)
+{
+  return vnl_gemm_simd_enabled.exchange(enable);
+}
+
+bool
+vnl_gemm_product(unsigned l, unsigned m, unsigned n, const double * a, const double * b, double * c)
+{
+  if (!vnl_gemm_worthwhile(l, n, m))
+    return false;
+  vnl_gemm(false, false, l, n, m, 1.0, a, m, b, n, 0.0, c, n);
+  return true;
+}
+
+bool
+vnl_gemm_product(unsigned l, unsigned m, unsigned n, const float * a, const float * b, float * c)
+{
+  if (!vnl_gemm_worthwhile(l, n, m))
+    return false;
+  vnl_gemm(false, false, l, n, m, 1.0f, a, m, b, n, 0.0f, c, n);
+  return true;
+}
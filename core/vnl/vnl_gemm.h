@@ -0,0 +1,102 @@
+// This is core/vnl/vnl_gemm.h
+#ifndef vnl_gemm_h_
+#define vnl_gemm_h_
+//:
+// \file
+// \brief Cache-blocked general matrix multiply for float and double
+//
+// vnl_gemm() computes C = alpha*op(A)*op(B) + beta*C for row-major
+// matrices, where op(X) is X or its transpose.  The operands are copied
+// in cache-sized blocks into packed panels, and the product of each pair
+// of panels is accumulated by a small register-blocked kernel, which uses
+// AVX2/FMA instructions when the processor has them.  Large products are
+// split by rows (or columns) of C over the threads of
+// vnl_thread_pool::default_pool().
+//
+// vnl_matrix<T>::operator*, vnl_matrix_fixed and vnl_fastops call it
+// through vnl_gemm_product() for float and double matrices when
+// vnl_gemm_worthwhile() says the product is big enough; smaller products
+// keep their simple loops.  Because the order of the additions differs,
+// the results can differ from those loops in the last few bits.
+
+#include <cstddef>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vnl/vnl_export.h"
+
+//: C = alpha*op(A)*op(B) + beta*C, with op(A) m x k and op(B) k x n.
+//  All matrices are row-major; lda, ldb and ldc are the distances between
+//  the starts of consecutive rows of the stored A, B and C.  If beta is
+//  zero, C need not be initialised.  C must not overlap A or B.
+VNL_EXPORT void
+vnl_gemm(bool trans_a,
+         bool trans_b,
+         unsigned m,
+         unsigned n,
+         unsigned k,
+         double alpha,
+         const double * A,
+         std::ptrdiff_t lda,
+         const double * B,
+         std::ptrdiff_t ldb,
+         double beta,
+         double * C,
+         std::ptrdiff_t ldc);
+
+//: C = alpha*op(A)*op(B) + beta*C, for float
+VNL_EXPORT void
+vnl_gemm(bool trans_a,
+         bool trans_b,
+         unsigned m,
+         unsigned n,
+         unsigned k,
+         float alpha,
+         const float * A,
+         std::ptrdiff_t lda,
+         const float * B,
+         std::ptrdiff_t ldb,
+         float beta,
+         float * C,
+         std::ptrdiff_t ldc);
+
+//: True if an (m x k) times (k x n) product is large enough for vnl_gemm to beat a simple loop.
+//  Below this, packing the operands costs more than the better memory access saves.
+//  constexpr, so that the test vanishes for vnl_matrix_fixed.
+constexpr bool
+vnl_gemm_worthwhile(unsigned m, unsigned n, unsigned k)
+{
+  return m >= 8 && n >= 8 && k >= 8 && (unsigned long long)m * n * k >= 32 * 32 * 32;
+}
+
+//: Set the maximum number of threads vnl_gemm may use; 0 (the default) means all threads of the default pool.
+//  Returns the previous setting.
+VNL_EXPORT unsigned
+vnl_gemm_set_max_threads(unsigned n);
+
+//: Enable or disable the AVX2/FMA kernel (to compare with the portable one).
+//  Returns the previous setting.  The AVX2 kernel is only used if the processor has it.
+VNL_EXPORT bool
+vnl_gemm_set_simd(bool enable);
+
+//: Hook used by the dense matrix products: compute the l x n matrix c = a*b.
+//  a is l x m and b is m x n, all contiguous and row-major.  Returns false,
+//  leaving c untouched, if the caller should use its own loop instead.
+//  This generic version always returns false; overload resolution picks the
+//  float and double versions below.
+template <class T>
+inline bool
+vnl_gemm_product(unsigned, unsigned, unsigned, const T *, const T *, T *)
+{
+  return false;
+}
+
+//: c = a*b using vnl_gemm, if vnl_gemm_worthwhile(l, n, m).
+VNL_EXPORT bool
+vnl_gemm_product(unsigned l, unsigned m, unsigned n, const double * a, const double * b, double * c);
+
+//: c = a*b using vnl_gemm, if vnl_gemm_worthwhile(l, n, m).
+VNL_EXPORT bool
+vnl_gemm_product(unsigned l, unsigned m, unsigned n, const float * a, const float * b, float * c);
+
+#endif // vnl_gemm_h_
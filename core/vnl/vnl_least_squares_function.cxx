@@ -23,6 +23,25 @@ vnl_least_squares_function::gradf(const vnl_vector<double> & /*x*/, vnl_matrix<d
   std::cerr << "Warning: gradf() called but not implemented in derived class\n";
 }
 
+void
+vnl_least_squares_function::f_and_gradf(const vnl_vector<double> & x,
+                                        vnl_vector<double> & fx,
+                                        vnl_matrix<double> & jacobian)
+{
+  f(x, fx);
+  gradf(x, jacobian);
+}
+
+void
+vnl_least_squares_function::f_and_gradf_rows(const vnl_vector<double> & /*x*/,
+                                             unsigned int /*first*/,
+                                             unsigned int /*last*/,
+                                             vnl_vector<double> & /*fx*/,
+                                             vnl_matrix<double> & /*jacobian*/)
+{
+  std::cerr << "Warning: f_and_gradf_rows() called but not implemented in derived class\n";
+}
+
 //: Compute finite differences gradient using central differences.
 void
 vnl_least_squares_function::fdgradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian, double stepsize)
@@ -81,6 +81,24 @@ public:
   virtual void
   gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian);
 
+  //: Compute the residuals and the Jacobian at x in one call.
+  //  The default calls f() and then gradf().  Override it when the two
+  //  share most of their work, e.g. projecting the same points.
+  virtual void
+  f_and_gradf(const vnl_vector<double> & x, vnl_vector<double> & fx, vnl_matrix<double> & jacobian);
+
+  //: Compute residuals first to last-1 and the same rows of the Jacobian.
+  //  fx and jacobian have their full size; only the given rows are written.
+  //  This lets a minimizer split the rows between threads, so it must be
+  //  safe to call concurrently for disjoint ranges.  It is only used if
+  //  has_residual_rows() is true, see set_residual_rows().
+  virtual void
+  f_and_gradf_rows(const vnl_vector<double> & x,
+                   unsigned int first,
+                   unsigned int last,
+                   vnl_vector<double> & fx,
+                   vnl_matrix<double> & jacobian);
+
   //: Use this to compute a finite-difference gradient other than lmdif
   void
   fdgradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian, double stepsize);
@@ -119,10 +137,25 @@ public:
     return use_gradient_;
   }
 
+  //: Return true if the derived class has implemented f_and_gradf_rows()
+  bool
+  has_residual_rows() const
+  {
+    return residual_rows_;
+  }
+
 protected:
   unsigned int p_;
   unsigned int n_;
   bool use_gradient_;
+  bool residual_rows_{ false };
+
+  //: Derived classes that implement f_and_gradf_rows() call this from their constructor
+  void
+  set_residual_rows(bool b)
+  {
+    residual_rows_ = b;
+  }
 
   void
   init(unsigned int number_of_unknowns, unsigned int number_of_residuals)
@@ -38,6 +38,7 @@
 #include "vnl_c_vector.h"
 #include <vnl/vnl_config.h>
 #include "vnl_error.h"
+#include "vnl_gemm.h"
 #ifndef NDEBUG
 #  if VNL_CONFIG_CHECK_BOUNDS
 #    include <cassert>
@@ -476,6 +477,10 @@ public:
     const unsigned int m = this->num_cols; // == rhs.num_rows
     const unsigned int n = rhs.num_cols;
 
+    // Large float and double products go to the cache-blocked vnl_gemm
+    if (vnl_gemm_product(l, m, n, this->data_block(), rhs.data_block(), result.data_block()))
+      return result;
+
     for (unsigned int i = 0; i < l; ++i)
     {
       for (unsigned int k = 0; k < n; ++k)
@@ -1142,6 +1142,9 @@ inline vnl_matrix_fixed<T, M, O>
 vnl_matrix_fixed_mat_mat_mult(const vnl_matrix_fixed<T, M, N> & a, const vnl_matrix_fixed<T, N, O> & b)
 {
   vnl_matrix_fixed<T, M, O> out;
+  // Only large float and double products go to vnl_gemm; the test is a compile time constant
+  if (vnl_gemm_worthwhile(M, O, N) && vnl_gemm_product(M, N, O, &a(0, 0), &b(0, 0), &out(0, 0)))
+    return out;
   for (unsigned i = 0; i < M; ++i)
     for (unsigned j = 0; j < O; ++j)
     {
@@ -0,0 +1,268 @@
+// This is core/vnl/vnl_matrix_fixed_batch.h
+#ifndef vnl_matrix_fixed_batch_h_
+#define vnl_matrix_fixed_batch_h_
+//:
+// \file
+// \brief A batch of small fixed size matrices, stored as a structure of arrays
+//
+// Many small problems of the same size (e.g. one 3x3 or 4x4 system per
+// RANSAC hypothesis or per point) are slow to solve one at a time with
+// vnl_matrix_fixed: each is too small for the loops to vectorize.  A
+// vnl_matrix_fixed_batch<T,R,C> holds N matrices with element (r,c) of all
+// N matrices stored contiguously, so that the operations below process
+// the whole batch with loops over the batch dimension, which the compiler
+// vectorizes.  See vnl_svd_fixed_batch for the singular value decomposition.
+
+#include <cstddef>
+#include <vector>
+#include <cassert>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vnl_matrix_fixed.h"
+
+//: A batch of R x C matrices, stored as a structure of arrays.
+template <class T, unsigned int R, unsigned int C>
+class vnl_matrix_fixed_batch
+{
+public:
+  //: An empty batch
+  vnl_matrix_fixed_batch() = default;
+
+  //: A batch of n matrices, filled with zeros
+  explicit vnl_matrix_fixed_batch(std::size_t n)
+    : n_(n)
+    , data_(R * C * n, T(0))
+  {}
+
+  //: Number of matrices in the batch
+  std::size_t
+  size() const
+  {
+    return n_;
+  }
+
+  //: Change the number of matrices; all elements are set to zero
+  void
+  set_size(std::size_t n)
+  {
+    n_ = n;
+    data_.assign(R * C * n, T(0));
+  }
+
+  //: Element (r,c) of all the matrices: element (r,c) of matrix i is lane(r,c)[i]
+  T *
+  lane(unsigned int r, unsigned int c)
+  {
+    return data_.data() + (r * C + c) * n_;
+  }
+  const T *
+  lane(unsigned int r, unsigned int c) const
+  {
+    return data_.data() + (r * C + c) * n_;
+  }
+
+  //: Element (r,c) of matrix i
+  T &
+  operator()(std::size_t i, unsigned int r, unsigned int c)
+  {
+    return lane(r, c)[i];
+  }
+  const T &
+  operator()(std::size_t i, unsigned int r, unsigned int c) const
+  {
+    return lane(r, c)[i];
+  }
+
+  //: Copy M into matrix i
+  void
+  set(std::size_t i, const vnl_matrix_fixed<T, R, C> & M)
+  {
+    for (unsigned int r = 0; r < R; ++r)
+      for (unsigned int c = 0; c < C; ++c)
+        lane(r, c)[i] = M(r, c);
+  }
+
+  //: Matrix i
+  vnl_matrix_fixed<T, R, C>
+  get(std::size_t i) const
+  {
+    vnl_matrix_fixed<T, R, C> M;
+    for (unsigned int r = 0; r < R; ++r)
+      for (unsigned int c = 0; c < C; ++c)
+        M(r, c) = lane(r, c)[i];
+    return M;
+  }
+
+private:
+  std::size_t n_{ 0 };
+  std::vector<T> data_;
+};
+
+//: AB[i] = A[i] * B[i] for all the matrices of the batches.
+//  For matrix-vector products, use a batch of C x 1 matrices for B.
+//  \relatesalso vnl_matrix_fixed_batch
+template <class T, unsigned int R, unsigned int K, unsigned int C>
+void
+vnl_batch_multiply(const vnl_matrix_fixed_batch<T, R, K> & A,
+                   const vnl_matrix_fixed_batch<T, K, C> & B,
+                   vnl_matrix_fixed_batch<T, R, C> & AB)
+{
+  assert(A.size() == B.size());
+  const std::size_t n = A.size();
+  if (AB.size() != n)
+    AB.set_size(n);
+  for (unsigned int r = 0; r < R; ++r)
+    for (unsigned int c = 0; c < C; ++c)
+    {
+      T * ab = AB.lane(r, c);
+      for (std::size_t i = 0; i < n; ++i)
+        ab[i] = T(0);
+      for (unsigned int k = 0; k < K; ++k)
+      {
+        const T * a = A.lane(r, k);
+        const T * b = B.lane(k, c);
+        for (std::size_t i = 0; i < n; ++i)
+          ab[i] += a[i] * b[i];
+      }
+    }
+}
+
+//: Ainv[i] = inverse of A[i], by cofactors, and det[i] = its determinant.
+//  A matrix with a zero determinant gives a matrix of inf or nan; check det.
+//  \relatesalso vnl_matrix_fixed_batch
+template <class T>
+void
+vnl_batch_inverse(const vnl_matrix_fixed_batch<T, 2, 2> & A,
+                  vnl_matrix_fixed_batch<T, 2, 2> & Ainv,
+                  std::vector<T> & det)
+{
+  const std::size_t n = A.size();
+  if (Ainv.size() != n)
+    Ainv.set_size(n);
+  det.resize(n);
+  const T *a00 = A.lane(0, 0), *a01 = A.lane(0, 1), *a10 = A.lane(1, 0), *a11 = A.lane(1, 1);
+  T *b00 = Ainv.lane(0, 0), *b01 = Ainv.lane(0, 1), *b10 = Ainv.lane(1, 0), *b11 = Ainv.lane(1, 1);
+  T * d = det.data();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    d[i] = a00[i] * a11[i] - a01[i] * a10[i];
+    const T s = T(1) / d[i];
+    const T m00 = a00[i], m01 = a01[i], m10 = a10[i], m11 = a11[i];
+    b00[i] = m11 * s;
+    b01[i] = -m01 * s;
+    b10[i] = -m10 * s;
+    b11[i] = m00 * s;
+  }
+}
+
+//: Ainv[i] = inverse of A[i], by cofactors, and det[i] = its determinant.
+//  A matrix with a zero determinant gives a matrix of inf or nan; check det.
+//  \relatesalso vnl_matrix_fixed_batch
+template <class T>
+void
+vnl_batch_inverse(const vnl_matrix_fixed_batch<T, 3, 3> & A,
+                  vnl_matrix_fixed_batch<T, 3, 3> & Ainv,
+                  std::vector<T> & det)
+{
+  const std::size_t n = A.size();
+  if (Ainv.size() != n)
+    Ainv.set_size(n);
+  det.resize(n);
+  const T * a[3][3];
+  T * b[3][3];
+  for (unsigned int r = 0; r < 3; ++r)
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+      a[r][c] = A.lane(r, c);
+      b[r][c] = Ainv.lane(r, c);
+    }
+  T * d = det.data();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const T m00 = a[0][0][i], m01 = a[0][1][i], m02 = a[0][2][i];
+    const T m10 = a[1][0][i], m11 = a[1][1][i], m12 = a[1][2][i];
+    const T m20 = a[2][0][i], m21 = a[2][1][i], m22 = a[2][2][i];
+    const T c00 = m11 * m22 - m12 * m21;
+    const T c01 = m12 * m20 - m10 * m22;
+    const T c02 = m10 * m21 - m11 * m20;
+    d[i] = m00 * c00 + m01 * c01 + m02 * c02;
+    const T s = T(1) / d[i];
+    b[0][0][i] = c00 * s;
+    b[1][0][i] = c01 * s;
+    b[2][0][i] = c02 * s;
+    b[0][1][i] = (m02 * m21 - m01 * m22) * s;
+    b[1][1][i] = (m00 * m22 - m02 * m20) * s;
+    b[2][1][i] = (m01 * m20 - m00 * m21) * s;
+    b[0][2][i] = (m01 * m12 - m02 * m11) * s;
+    b[1][2][i] = (m02 * m10 - m00 * m12) * s;
+    b[2][2][i] = (m00 * m11 - m01 * m10) * s;
+  }
+}
+
+//: Ainv[i] = inverse of A[i], by cofactors, and det[i] = its determinant.
+//  The cofactors are computed from the 2x2 minors of the top and bottom
+//  two rows.  A matrix with a zero determinant gives a matrix of inf or
+//  nan; check det.
+//  \relatesalso vnl_matrix_fixed_batch
+template <class T>
+void
+vnl_batch_inverse(const vnl_matrix_fixed_batch<T, 4, 4> & A,
+                  vnl_matrix_fixed_batch<T, 4, 4> & Ainv,
+                  std::vector<T> & det)
+{
+  const std::size_t n = A.size();
+  if (Ainv.size() != n)
+    Ainv.set_size(n);
+  det.resize(n);
+  const T * a[4][4];
+  T * b[4][4];
+  for (unsigned int r = 0; r < 4; ++r)
+    for (unsigned int c = 0; c < 4; ++c)
+    {
+      a[r][c] = A.lane(r, c);
+      b[r][c] = Ainv.lane(r, c);
+    }
+  T * d = det.data();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const T m00 = a[0][0][i], m01 = a[0][1][i], m02 = a[0][2][i], m03 = a[0][3][i];
+    const T m10 = a[1][0][i], m11 = a[1][1][i], m12 = a[1][2][i], m13 = a[1][3][i];
+    const T m20 = a[2][0][i], m21 = a[2][1][i], m22 = a[2][2][i], m23 = a[2][3][i];
+    const T m30 = a[3][0][i], m31 = a[3][1][i], m32 = a[3][2][i], m33 = a[3][3][i];
+    // minors of rows 0,1
+    const T s0 = m00 * m11 - m10 * m01;
+    const T s1 = m00 * m12 - m10 * m02;
+    const T s2 = m00 * m13 - m10 * m03;
+    const T s3 = m01 * m12 - m11 * m02;
+    const T s4 = m01 * m13 - m11 * m03;
+    const T s5 = m02 * m13 - m12 * m03;
+    // minors of rows 2,3
+    const T c5 = m22 * m33 - m32 * m23;
+    const T c4 = m21 * m33 - m31 * m23;
+    const T c3 = m21 * m32 - m31 * m22;
+    const T c2 = m20 * m33 - m30 * m23;
+    const T c1 = m20 * m32 - m30 * m22;
+    const T c0 = m20 * m31 - m30 * m21;
+    d[i] = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    const T s = T(1) / d[i];
+    b[0][0][i] = (m11 * c5 - m12 * c4 + m13 * c3) * s;
+    b[0][1][i] = (-m01 * c5 + m02 * c4 - m03 * c3) * s;
+    b[0][2][i] = (m31 * s5 - m32 * s4 + m33 * s3) * s;
+    b[0][3][i] = (-m21 * s5 + m22 * s4 - m23 * s3) * s;
+    b[1][0][i] = (-m10 * c5 + m12 * c2 - m13 * c1) * s;
+    b[1][1][i] = (m00 * c5 - m02 * c2 + m03 * c1) * s;
+    b[1][2][i] = (-m30 * s5 + m32 * s2 - m33 * s1) * s;
+    b[1][3][i] = (m20 * s5 - m22 * s2 + m23 * s1) * s;
+    b[2][0][i] = (m10 * c4 - m11 * c2 + m13 * c0) * s;
+    b[2][1][i] = (-m00 * c4 + m01 * c2 - m03 * c0) * s;
+    b[2][2][i] = (m30 * s4 - m31 * s2 + m33 * s0) * s;
+    b[2][3][i] = (-m20 * s4 + m21 * s2 - m23 * s0) * s;
+    b[3][0][i] = (-m10 * c3 + m11 * c1 - m12 * c0) * s;
+    b[3][1][i] = (m00 * c3 - m01 * c1 + m02 * c0) * s;
+    b[3][2][i] = (-m30 * s3 + m31 * s1 - m32 * s0) * s;
+    b[3][3][i] = (m20 * s3 - m21 * s1 + m22 * s0) * s;
+  }
+}
+
+#endif // vnl_matrix_fixed_batch_h_
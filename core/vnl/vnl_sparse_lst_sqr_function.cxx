@@ -9,6 +9,7 @@
 #include <cassert>
 #include "vnl_sparse_lst_sqr_function.h"
 #include "vnl/vnl_vector_ref.h"
+#include "vnl/vnl_thread_pool.h"
 
 void
 vnl_sparse_lst_sqr_function::dim_warning(unsigned int nr_of_unknowns, unsigned int nr_of_residuals)
@@ -19,6 +20,31 @@ vnl_sparse_lst_sqr_function::dim_warning(unsigned int nr_of_unknowns, unsigned i
               << "residuals(" << nr_of_residuals << ")\n";
 }
 
+void
+vnl_sparse_lst_sqr_function::set_num_threads(unsigned int n)
+{
+  num_threads_ = n;
+}
+
+unsigned int
+vnl_sparse_lst_sqr_function::num_threads() const
+{
+  return num_threads_;
+}
+
+void
+vnl_sparse_lst_sqr_function::for_each_a(const std::function<void(unsigned int)> & task) const
+{
+  const unsigned int n = number_of_a();
+  if (num_threads_ == 1)
+  {
+    for (unsigned int i = 0; i < n; ++i)
+      task(i);
+    return;
+  }
+  vnl_thread_pool::default_pool().parallel_for(n, [&](std::size_t i) { task((unsigned int)i); }, num_threads_);
+}
+
 //: Construct vnl_sparse_lst_sqr_function.
 // Assumes A consists of \p num_a parameters each of size \p num_params_per_a
 // Assumes B consists of \p num_b parameters each of size \p num_params_per_b
@@ -153,8 +179,7 @@ vnl_sparse_lst_sqr_function::f(const vnl_vector<double> & a,
                                const vnl_vector<double> & c,
                                vnl_vector<double> & e)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     // This is semi const incorrect - there is no vnl_vector_ref_const
     const vnl_vector_ref<double> ai(number_of_params_a(i), const_cast<double *>(a.data_block()) + index_a(i));
 
@@ -168,7 +193,7 @@ vnl_sparse_lst_sqr_function::f(const vnl_vector<double> & a,
       vnl_vector_ref<double> eij(number_of_residuals(k), e.data_block() + index_e(k));
       fij(i, j, ai, bj, c, eij); // compute residual vector e_ij
     }
-  }
+  });
 }
 
 
@@ -188,8 +213,7 @@ vnl_sparse_lst_sqr_function::jac_blocks(const vnl_vector<double> & a,
                                         std::vector<vnl_matrix<double>> & B,
                                         std::vector<vnl_matrix<double>> & C)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     // This is semi const incorrect - there is no vnl_vector_ref_const
     const vnl_vector_ref<double> ai(number_of_params_a(i), const_cast<double *>(a.data_block()) + index_a(i));
 
@@ -205,7 +229,7 @@ vnl_sparse_lst_sqr_function::jac_blocks(const vnl_vector<double> & a,
       jac_Bij(i, j, ai, bj, c, B[k]); // compute Jacobian B_ij
       jac_Cij(i, j, ai, bj, c, C[k]); // compute Jacobian C_ij
     }
-  }
+  });
 }
 
 
@@ -226,8 +250,7 @@ vnl_sparse_lst_sqr_function::fd_jac_blocks(const vnl_vector<double> & a,
                                            std::vector<vnl_matrix<double>> & C,
                                            double stepsize)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     // This is semi const incorrect - there is no vnl_vector_ref_const
     const vnl_vector_ref<double> ai(number_of_params_a(i), const_cast<double *>(a.data_block()) + index_a(i));
 
@@ -243,7 +266,7 @@ vnl_sparse_lst_sqr_function::fd_jac_blocks(const vnl_vector<double> & a,
       fd_jac_Bij(i, j, ai, bj, c, B[k], stepsize); // compute Jacobian B_ij with finite differences
       fd_jac_Cij(i, j, ai, bj, c, C[k], stepsize); // compute Jacobian C_ij with finite differences
     }
-  }
+  });
 }
 
 
@@ -260,8 +283,7 @@ vnl_sparse_lst_sqr_function::compute_weights(const vnl_vector<double> & a,
                                              const vnl_vector<double> & e,
                                              vnl_vector<double> & weights)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     // This is semi const incorrect - there is no vnl_vector_ref_const
     const vnl_vector_ref<double> ai(number_of_params_a(i), const_cast<double *>(a.data_block()) + index_a(i));
 
@@ -275,7 +297,7 @@ vnl_sparse_lst_sqr_function::compute_weights(const vnl_vector<double> & a,
       const vnl_vector_ref<double> eij(number_of_residuals(k), const_cast<double *>(e.data_block() + index_e(k)));
       compute_weight_ij(i, j, ai, bj, c, eij, weights[k]);
     }
-  }
+  });
 }
 
 
@@ -287,8 +309,7 @@ vnl_sparse_lst_sqr_function::compute_weights(const vnl_vector<double> & a,
 void
 vnl_sparse_lst_sqr_function::apply_weights(const vnl_vector<double> & weights, vnl_vector<double> & e)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     const vnl_crs_index::sparse_vector row = residual_indices_.sparse_row(i);
     for (auto & r_itr : row)
     {
@@ -297,7 +318,7 @@ vnl_sparse_lst_sqr_function::apply_weights(const vnl_vector<double> & weights, v
       vnl_vector_ref<double> eij(number_of_residuals(k), e.data_block() + index_e(k));
       apply_weight_ij(i, j, weights[k], eij);
     }
-  }
+  });
 }
 
 
@@ -312,8 +333,7 @@ vnl_sparse_lst_sqr_function::apply_weights(const vnl_vector<double> & weights,
                                            std::vector<vnl_matrix<double>> & B,
                                            std::vector<vnl_matrix<double>> & C)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     const vnl_crs_index::sparse_vector row = residual_indices_.sparse_row(i);
     for (auto & r_itr : row)
     {
@@ -321,7 +341,7 @@ vnl_sparse_lst_sqr_function::apply_weights(const vnl_vector<double> & weights,
       const unsigned int k = r_itr.first;
       apply_weight_ij(i, j, weights[k], A[k], B[k], C[k]);
     }
-  }
+  });
 }
 
 
@@ -13,11 +13,13 @@
 //   Mar 15, 2010  MJL - Modified to add 'c' parameters (globals)
 // \endverbatim
 //
+#include <functional>
 #include "vnl_vector.h"
 #include "vnl_matrix.h"
 #include "vnl_crs_index.h"
 #include "vnl/vnl_export.h"
 
+
 //: Abstract base for sparse least squares functions.
 //    vnl_sparse_lst_sqr_function is an abstract base for functions to be minimized
 //    by an optimizer.  To define your own function to be minimized, subclass
@@ -123,6 +125,22 @@ public:
     failure = false;
   }
 
+  //: Set the number of threads used by the default block loops.
+  //  The default implementations of f, jac_blocks, fd_jac_blocks,
+  //  compute_weights and apply_weights process the blocks of different a_i
+  //  concurrently when \p n is not 1, on at most \p n threads of
+  //  vnl_thread_pool::default_pool() (0 means all of them).
+  //  Only use this if fij, jac_Aij, jac_Bij, jac_Cij, compute_weight_ij and
+  //  apply_weight_ij can safely be called from several threads at once.
+  //  Every block is written by exactly one thread, so the results do not
+  //  depend on the number of threads.  The default is 1 (serial).
+  void
+  set_num_threads(unsigned int n);
+
+  //: Number of threads used by the default block loops (0 = the default pool)
+  unsigned int
+  num_threads() const;
+
   //: Compute all residuals.
   //  Given the parameter vectors a, b, and c, compute the vector of residuals f.
   //  f has been sized appropriately before the call.
@@ -413,7 +431,15 @@ protected:
   bool use_gradient_;
   bool use_weights_;
 
+  //: Call task(i) for each a_i, concurrently if set_num_threads() asked for it.
+  //  Tasks for different i must write to disjoint outputs.
+  void
+  for_each_a(const std::function<void(unsigned int)> & task) const;
+
 private:
+  //: Used by for_each_a; 1 to run serially
+  unsigned int num_threads_{ 1 };
+
   void
   dim_warning(unsigned int n_unknowns, unsigned int n_residuals);
 };
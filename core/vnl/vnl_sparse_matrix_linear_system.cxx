@@ -15,7 +15,10 @@ template <>
 void
 vnl_sparse_matrix_linear_system<double>::transpose_multiply(const vnl_vector<double> & b, vnl_vector<double> & x) const
 {
-  A_.pre_mult(b, x);
+  if (use_csr_)
+    csr_.pre_mult(b, x);
+  else
+    A_.pre_mult(b, x);
 }
 
 template <>
@@ -38,7 +41,10 @@ vnl_sparse_matrix_linear_system<float>::transpose_multiply(const vnl_vector<doub
     b_float = vnl_vector<float>(b.size());
 
   vnl_copy(b, b_float);
-  A_.pre_mult(b_float, x_float);
+  if (use_csr_)
+    csr_.pre_mult(b_float, x_float);
+  else
+    A_.pre_mult(b_float, x_float);
   vnl_copy(x_float, x);
 }
 
@@ -46,7 +52,10 @@ template <>
 void
 vnl_sparse_matrix_linear_system<double>::multiply(const vnl_vector<double> & x, vnl_vector<double> & b) const
 {
-  A_.mult(x, b);
+  if (use_csr_)
+    csr_.mult(x, b);
+  else
+    A_.mult(x, b);
 }
 
 
@@ -63,7 +72,10 @@ vnl_sparse_matrix_linear_system<float>::multiply(const vnl_vector<double> & x, v
     b_float = vnl_vector<float>(b.size());
 
   vnl_copy(x, x_float);
-  A_.mult(x_float, b_float);
+  if (use_csr_)
+    csr_.mult(x_float, b_float);
+  else
+    A_.mult(x_float, b_float);
   vnl_copy(b_float, b);
 }
 
@@ -77,7 +89,10 @@ vnl_sparse_matrix_linear_system<T>::apply_preconditioner(const vnl_vector<double
   if (jacobi_precond_.empty())
   {
     vnl_vector<T> tmp(get_number_of_unknowns());
-    A_.diag_AtA(tmp);
+    if (use_csr_)
+      csr_.diag_AtA(tmp);
+    else
+      A_.diag_AtA(tmp);
     const_cast<vnl_vector<double> &>(jacobi_precond_) = vnl_vector<double>(tmp.size());
     for (unsigned int i = 0; i < tmp.size(); ++i)
       const_cast<vnl_vector<double> &>(jacobi_precond_)[i] = 1.0 / double(tmp[i]);
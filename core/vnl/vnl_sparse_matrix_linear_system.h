@@ -19,6 +19,7 @@
 
 #include "vnl_linear_system.h"
 #include "vnl_sparse_matrix.h"
+#include "vnl_csr_matrix.h"
 #include "vnl/vnl_export.h"
 
 //: vnl_sparse_matrix -> vnl_linear_system adaptor
@@ -29,12 +30,19 @@ class VNL_EXPORT vnl_sparse_matrix_linear_system : public vnl_linear_system
 public:
   //::Constructor from vnl_sparse_matrix<double> for system Ax = b
   // Keeps a reference to the original sparse matrix A and vector b so DO NOT DELETE THEM!!
-  vnl_sparse_matrix_linear_system(const vnl_sparse_matrix<T> & A, const vnl_vector<T> & b)
+  // If copy_to_csr is set, A is also copied into compressed sparse row form,
+  // and the products use the copy: they are faster, but A must then not be
+  // changed while this system is in use.
+  vnl_sparse_matrix_linear_system(const vnl_sparse_matrix<T> & A, const vnl_vector<T> & b, bool copy_to_csr = false)
     : vnl_linear_system(A.columns(), A.rows())
     , A_(A)
     , b_(b)
+    , use_csr_(copy_to_csr)
     , jacobi_precond_()
-  {}
+  {
+    if (use_csr_)
+      csr_ = vnl_csr_matrix<T>(A);
+  }
 
   //:  Implementations of the vnl_linear_system virtuals.
   void
@@ -52,6 +60,9 @@ public:
 protected:
   const vnl_sparse_matrix<T> & A_;
   const vnl_vector<T> & b_;
+  //: The products use csr_, a copy of A_, rather than A_ itself
+  bool use_csr_;
+  vnl_csr_matrix<T> csr_;
   vnl_vector<double> jacobi_precond_;
 };
 
@@ -46,15 +46,11 @@
 
 #define VNL_SSE_HEAP_STORE(pf) _mm_storeu_##pf
 #define VNL_SSE_HEAP_LOAD(pf) _mm_loadu_##pf
-#if VNL_CONFIG_THREAD_SAFE
-#  define VNL_SSE_ALLOC(n, s, a) new char[(n) * (s)]
-#  define VNL_SSE_FREE(v, n, s) (delete[] static_cast<char *>(v))
-#else
-#  define VNL_SSE_ALLOC(n, s, a) vnl_alloc::allocate((n == 0) ? 8 : (n * s));
-#  define VNL_SSE_FREE(v, n, s) \
-    if (v)                      \
-      vnl_alloc::deallocate(v, (n == 0) ? 8 : (n * s));
-#endif
+// vnl_alloc is thread safe, and aligns to at least VNL_ALLOC_ALIGN bytes
+#define VNL_SSE_ALLOC(n, s, a) vnl_alloc::allocate((n == 0) ? 8 : (n * s));
+#define VNL_SSE_FREE(v, n, s) \
+  if (v)                      \
+    vnl_alloc::deallocate(v, (n == 0) ? 8 : (n * s));
 
 
 // Stack memory can be aligned -> use SSE aligned store
@@ -68,7 +64,7 @@
 #  define VNL_SSE_HEAP_LOAD(pf) _mm_load_##pf
 #endif
 
-//: Custom memory allocation function to force 16 byte alignment of data
+//: Custom memory allocation function to force (at least) 16 byte alignment of data
 VNL_SSE_FORCE_INLINE void *
 vnl_sse_alloc(std::size_t n, unsigned size)
 {
@@ -0,0 +1,200 @@
+// This is core/vnl/vnl_thread_pool.cxx
+//:
+// \file
+#include "vnl_thread_pool.h"
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+
+//: True while the current thread is executing a task of some pool.
+static thread_local bool vnl_thread_pool_in_task = false;
+
+vnl_thread_pool::vnl_thread_pool(unsigned n_threads)
+  : n_threads_(n_threads == 0 ? hardware_threads() : n_threads)
+{
+  for (unsigned i = 0; i < n_threads_; ++i)
+    ranges_.emplace_back(new task_range);
+  for (unsigned i = 1; i < n_threads_; ++i)
+    workers_.emplace_back(&vnl_thread_pool::worker_loop, this, i);
+}
+
+vnl_thread_pool::~vnl_thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  for (auto & w : workers_)
+    w.join();
+}
+
+unsigned
+vnl_thread_pool::hardware_threads()
+{
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+void
+vnl_thread_pool::parallel_for(std::size_t n_tasks,
+                              const std::function<void(std::size_t)> & task,
+                              unsigned max_threads)
+{
+  if (n_tasks == 0)
+    return;
+  const unsigned n_active = (max_threads == 0 || max_threads > n_threads_) ? n_threads_ : max_threads;
+
+  // Nothing to gain from waking workers; also avoids deadlock when nested.
+  if (n_active == 1 || n_tasks == 1 || vnl_thread_pool_in_task)
+  {
+    for (std::size_t k = 0; k < n_tasks; ++k)
+      task(k);
+    return;
+  }
+
+  std::lock_guard<std::mutex> job_lock(job_mutex_);
+  error_ = nullptr;
+  task_ = &task;
+  remaining_ = n_tasks;
+  n_active_ = n_active;
+
+  // Give each participant a contiguous run of tasks, and the other threads
+  // none. task_ is published to the workers by the range mutexes, which
+  // they must take to get a task.
+  for (unsigned p = 0; p < n_threads_; ++p)
+  {
+    std::lock_guard<std::mutex> lock(ranges_[p]->mutex_);
+    ranges_[p]->begin_ = p < n_active ? n_tasks * p / n_active : 0;
+    ranges_[p]->end_ = p < n_active ? n_tasks * (p + 1) / n_active : 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    ++generation_;
+  }
+  wake_cv_.notify_all();
+
+  run_tasks(0);
+
+  {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    done_cv_.wait(lock, [this] { return remaining_ == 0; });
+  }
+  task_ = nullptr;
+  if (error_)
+  {
+    std::exception_ptr e = error_;
+    error_ = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+void
+vnl_thread_pool::worker_loop(unsigned id)
+{
+  unsigned long seen = 0;
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(state_mutex_);
+      wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+    }
+    run_tasks(id);
+  }
+}
+
+void
+vnl_thread_pool::run_tasks(unsigned id)
+{
+  bool was_in_task = vnl_thread_pool_in_task;
+  vnl_thread_pool_in_task = true;
+  std::size_t k;
+  while (next_task(id, k))
+  {
+    try
+    {
+      (*task_)(k);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      if (!error_)
+        error_ = std::current_exception();
+    }
+    if (--remaining_ == 0)
+    {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      done_cv_.notify_all();
+    }
+  }
+  vnl_thread_pool_in_task = was_in_task;
+}
+
+bool
+vnl_thread_pool::next_task(unsigned id, std::size_t & task)
+{
+  {
+    task_range & own = *ranges_[id];
+    std::lock_guard<std::mutex> lock(own.mutex_);
+    if (own.begin_ < own.end_)
+    {
+      task = own.begin_++;
+      return true;
+    }
+  }
+  // Own run is exhausted, steal from the back of someone else's, unless this
+  // thread is left out of the parallel_for.  n_active_ is set before the
+  // ranges, so it is up to date once a range lock is held.
+  for (unsigned off = 1; off < n_threads_; ++off)
+  {
+    task_range & victim = *ranges_[(id + off) % n_threads_];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (victim.begin_ < victim.end_ && id < n_active_)
+    {
+      task = --victim.end_;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The default pool is created on first use, and recreated if the thread
+// count is changed.
+static std::mutex &
+vnl_thread_pool_default_mutex()
+{
+  static std::mutex m;
+  return m;
+}
+
+static std::unique_ptr<vnl_thread_pool> &
+vnl_thread_pool_default_ptr()
+{
+  static std::unique_ptr<vnl_thread_pool> p;
+  return p;
+}
+
+static unsigned vnl_thread_pool_default_n = 0;
+
+vnl_thread_pool &
+vnl_thread_pool::default_pool()
+{
+  std::lock_guard<std::mutex> lock(vnl_thread_pool_default_mutex());
+  std::unique_ptr<vnl_thread_pool> & p = vnl_thread_pool_default_ptr();
+  if (!p)
+    p.reset(new vnl_thread_pool(vnl_thread_pool_default_n));
+  return *p;
+}
+
+void
+vnl_thread_pool::set_default_n_threads(unsigned n_threads)
+{
+  std::lock_guard<std::mutex> lock(vnl_thread_pool_default_mutex());
+  vnl_thread_pool_default_n = n_threads;
+  std::unique_ptr<vnl_thread_pool> & p = vnl_thread_pool_default_ptr();
+  if (p && p->n_threads() != (n_threads == 0 ? hardware_threads() : n_threads))
+    p.reset();
+}
@@ -0,0 +1,121 @@
+// This is core/vnl/vnl_thread_pool.h
+#ifndef vnl_thread_pool_h_
+#define vnl_thread_pool_h_
+//:
+// \file
+// \brief A small work-stealing thread pool for data-parallel numerics
+//
+// A vnl_thread_pool runs a batch of independent tasks, identified by an
+// index in [0,n), across a fixed set of worker threads.  The calling
+// thread takes part in the work, so a pool of n threads starts n-1
+// workers.  Each participant owns a contiguous run of task indices and
+// steals from the far end of another participant's run once its own is
+// exhausted, so neighbouring blocks tend to be processed by the same thread
+// while load stays balanced.
+//
+// Tasks must write to disjoint outputs.  Under that condition the result
+// of parallel_for does not depend on scheduling or on the number of
+// threads, i.e. the output is deterministic.
+//
+// A parallel_for issued from inside a task (of any pool) is run serially
+// on the calling thread, so nested parallel loops cannot deadlock.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include "vnl/vnl_export.h"
+
+class VNL_EXPORT vnl_thread_pool
+{
+public:
+  //: Create a pool using n_threads threads (including the calling thread).
+  //  If n_threads is zero, the number of hardware threads is used.
+  explicit vnl_thread_pool(unsigned n_threads = 0);
+
+  //: Stops and joins all worker threads.
+  ~vnl_thread_pool();
+
+  //: Number of threads taking part in each parallel_for (including caller).
+  unsigned
+  n_threads() const
+  {
+    return n_threads_;
+  }
+
+  //: Call task(k) for every k in [0,n_tasks), spread across the pool.
+  //  At most max_threads of the threads take part (0 = all of them), so
+  //  that callers asking for a number of threads can share one pool, e.g.
+  //  default_pool().parallel_for(n, task, n_threads).
+  //  Returns once all tasks have completed.  If any task throws, the first
+  //  exception caught is rethrown here after the remaining tasks finish.
+  void
+  parallel_for(std::size_t n_tasks, const std::function<void(std::size_t)> & task, unsigned max_threads = 0);
+
+  //: The process-wide pool used when no pool is passed explicitly.
+  static vnl_thread_pool &
+  default_pool();
+
+  //: Set the number of threads used by default_pool() (0 = hardware threads).
+  //  Must not be called while the default pool is executing tasks.
+  static void
+  set_default_n_threads(unsigned n_threads);
+
+  //: Number of hardware threads, or 1 if that cannot be determined.
+  static unsigned
+  hardware_threads();
+
+private:
+  //: A participant's run of task indices, [begin_,end_).
+  //  The owner takes from the front, thieves take from the back.
+  struct task_range
+  {
+    std::mutex mutex_;
+    std::size_t begin_{ 0 };
+    std::size_t end_{ 0 };
+  };
+
+  void
+  worker_loop(unsigned id);
+
+  //: Execute tasks until there are none left to take or steal.
+  void
+  run_tasks(unsigned id);
+
+  //: Take the next task for participant id; false if all ranges are empty.
+  bool
+  next_task(unsigned id, std::size_t & task);
+
+  unsigned n_threads_;
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<task_range>> ranges_;
+
+  //: Serialises concurrent parallel_for calls from different threads.
+  std::mutex job_mutex_;
+
+  std::mutex state_mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable done_cv_;
+  unsigned long generation_{ 0 };
+  bool stop_{ false };
+  //: Number of threads taking part in the current parallel_for
+  std::atomic<unsigned> n_active_{ 0 };
+
+  const std::function<void(std::size_t)> * task_{ nullptr };
+  std::atomic<std::size_t> remaining_{ 0 };
+  std::exception_ptr error_;
+
+  vnl_thread_pool(const vnl_thread_pool &) = delete;
+  vnl_thread_pool &
+  operator=(const vnl_thread_pool &) = delete;
+};
+
+#endif // vnl_thread_pool_h_
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include "testlib/testlib_test.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
@@ -12,9 +13,64 @@
 #include <vgl/algo/vgl_rotation_3d.h>
 #include <vpgl/algo/vpgl_optimize_camera.h>
 #include "vnl/vnl_double_3.h"
+#include "vnl/vnl_double_3x3.h"
 #include "vnl/vnl_random.h"
 #include "vnl/vnl_math.h" // for pi
 
+//: Compare the analytic Jacobian with central differences
+static void
+check_jacobian(vnl_least_squares_function & f, const vnl_vector<double> & x, const std::string & name)
+{
+  const unsigned int m = f.get_number_of_residuals();
+  const unsigned int n = f.get_number_of_unknowns();
+  vnl_matrix<double> J(m, n), J_fd(m, n);
+  f.gradf(x, J);
+  f.fdgradf(x, J_fd, 1e-6);
+  TEST_NEAR((name + ": Jacobian = finite differences").c_str(),
+            (J - J_fd).array_inf_norm() / J_fd.array_inf_norm(),
+            0.0,
+            1e-6);
+
+  vnl_vector<double> fx(m), fx_rows(m);
+  f.f(x, fx);
+  f.f_and_gradf_rows(x, 0, m / 2, fx_rows, J);
+  f.f_and_gradf_rows(x, m / 2, m, fx_rows, J);
+  TEST_NEAR((name + ": residual rows = f").c_str(), (fx - fx_rows).inf_norm(), 0.0, 1e-8);
+}
+
+static void
+test_jacobians(const vpgl_perspective_camera<double> & cam,
+               const std::vector<vgl_homg_point_3d<double>> & world,
+               const std::vector<vgl_point_2d<double>> & image)
+{
+  const vpgl_calibration_matrix<double> & K = cam.get_calibration();
+  const vgl_point_3d<double> c = cam.get_camera_center();
+  const vnl_double_3 w = cam.get_rotation().as_rodrigues() + vnl_double_3(0.01, -0.02, 0.03);
+
+  vpgl_orientation_lsqr f_orient(K, c, world, image);
+  check_jacobian(f_orient, w.as_vector(), "orientation");
+  // close to the identity rotation
+  check_jacobian(f_orient, vnl_double_3(1e-7, -2e-7, 0.0).as_vector(), "orientation near identity");
+
+  vnl_vector<double> x(10);
+  x[0] = w[0];
+  x[1] = w[1];
+  x[2] = w[2];
+  x[3] = c.x() + 0.1;
+  x[4] = c.y() - 0.2;
+  x[5] = c.z();
+  vpgl_orientation_position_lsqr f_orient_pos(K, world, image);
+  check_jacobian(f_orient_pos, x.extract(6), "orientation and position");
+
+  const vnl_double_3x3 kk = K.get_matrix();
+  x[6] = kk[0][0];
+  x[7] = kk[0][2];
+  x[8] = kk[1][1];
+  x[9] = kk[1][2];
+  vpgl_orientation_position_calibration_lsqr f_cal(world, image);
+  check_jacobian(f_cal, x, "orientation, position and calibration");
+}
+
 void
 test_opt_orient_pos(const vpgl_perspective_camera<double> & cam,
                     const std::vector<vgl_homg_point_3d<double>> & world,
@@ -60,6 +116,10 @@ test_opt_orient_pos(const vpgl_perspective_camera<double> & cam,
   }
   double angle = std::acos(cos_angle);
   TEST_NEAR("opt_orient_pos: principal_axis", angle, 0, 0.1);
+
+  opt_cam = vpgl_optimize_camera::opt_orient_pos(err_cam, world, image, true);
+  dist = vgl_distance(opt_cam.get_camera_center(), cam.get_camera_center());
+  TEST_NEAR("opt_orient_pos with the normal equations: position", dist, 0, 0.25);
 }
 
 void
@@ -153,6 +213,7 @@ test_optimize_camera()
   }
   std::cout << cam << std::endl;
 
+  test_jacobians(cam, world, image);
   test_opt_orient_pos(cam, world, image, rnd);
   test_opt_orient_pos_f(cam, world, image, rnd);
 }
@@ -100,10 +100,10 @@ public:
 
 
 protected:
-  //: The shared internal camera calibration
-  mutable vpgl_calibration_matrix<double> K_;
+  //: The shared internal camera calibration (the focal length is taken from c)
+  vpgl_calibration_matrix<double> K_;
   //: The shared internal camera calibration in matrix form
-  mutable vnl_double_3x3 Km_;
+  vnl_double_3x3 Km_;
 };
 
 
@@ -196,6 +196,7 @@ vpgl_bundle_adjust::optimize(std::vector<vpgl_perspective_camera<double>> & came
   lm.set_x_tolerance(x_tol_);
   lm.set_g_tolerance(g_tol_);
   lm.set_epsilon_function(epsilon_);
+  lm.set_num_threads(num_threads_);
   if (!lm.minimize(a_, b_, c_, use_gradient_, use_m_estimator_) && lm.get_num_iterations() < int(max_iterations_))
   {
     return false;
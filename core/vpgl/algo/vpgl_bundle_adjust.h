@@ -83,6 +83,12 @@ public:
   {
     epsilon_ = eps;
   }
+  //: number of threads used by the optimizer (0 = hardware threads)
+  void
+  set_num_threads(unsigned n)
+  {
+    num_threads_ = n;
+  }
 
   //: Return the ending error
   double
@@ -196,6 +202,7 @@ private:
   double x_tol_{ 1e-8 };
   double g_tol_{ 1e-8 };
   double epsilon_{ 1e-3 };
+  unsigned int num_threads_{ 1 };
 
   double start_error_{ 0.0 };
   double end_error_{ 0.0 };
@@ -101,8 +101,7 @@ vpgl_bundle_adjust_lsqr::f(const vnl_vector<double> & a,
                            const vnl_vector<double> & c,
                            vnl_vector<double> & e)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     //: Construct the ith camera
     vnl_double_3x4 Pi = param_to_cam_matrix(i, a, c);
 
@@ -130,7 +129,7 @@ vpgl_bundle_adjust_lsqr::f(const vnl_vector<double> & a,
         eij[1] *= Sij(1, 1);
       }
     }
-  }
+  });
 }
 
 
@@ -177,8 +176,7 @@ vpgl_bundle_adjust_lsqr::jac_blocks(const vnl_vector<double> & a,
                                     std::vector<vnl_matrix<double>> & B,
                                     std::vector<vnl_matrix<double>> & C)
 {
-  for (unsigned int i = 0; i < number_of_a(); ++i)
-  {
+  for_each_a([&](unsigned int i) {
     //: Construct the ith camera
     vnl_double_3x4 Pi = param_to_cam_matrix(i, a, c);
 
@@ -204,7 +202,7 @@ vpgl_bundle_adjust_lsqr::jac_blocks(const vnl_vector<double> & a,
         C[k] = Sij * C[k];
       }
     }
-  }
+  });
 }
 
 
@@ -6,6 +6,7 @@
 #include "vnl/vnl_rotation_matrix.h"
 #include "vnl/vnl_double_3.h"
 #include "vnl/vnl_double_3x3.h"
+#include "vnl/vnl_cross_product_matrix.h"
 #include <vnl/algo/vnl_levenberg_marquardt.h>
 #include "vgl/vgl_homg_point_2d.h"
 #if 0
@@ -17,19 +18,87 @@
 #  include "vcl_msvc_warnings.h"
 #endif
 
+//: Residuals and Jacobian rows first to last-1 for the camera K[R|-Rc], with R given by its Rodrigues vector w.
+//  The columns of the Jacobian are w, then c if n_params > 3, then the
+//  calibration (K[0][0], K[0][2], K[1][1], K[1][2]) if n_params > 6.
+//  Rows 2i and 2i+1 are the x and y errors of point i.
+static void
+vpgl_optimize_camera_rows(const vnl_double_3x3 & K,
+                          const vnl_double_3 & w,
+                          const vgl_point_3d<double> & c,
+                          unsigned int n_params,
+                          const std::vector<vgl_homg_point_3d<double>> & world_points,
+                          const std::vector<vgl_point_2d<double>> & image_points,
+                          unsigned int first,
+                          unsigned int last,
+                          vnl_vector<double> & fx,
+                          vnl_matrix<double> & jacobian)
+{
+  const vnl_double_3x3 R = vgl_rotation_3d<double>(w).as_matrix();
+
+  // dR/dw_i = (w_i [w]x + [w x (I-R) e_i]x) R / |w|^2  (Gallego and Yezzi, 2015);
+  // near w = 0 use the first order expansion, [e_i]x + ([e_i]x [w]x + [w]x [e_i]x)/2
+  vnl_double_3x3 dR[3];
+  const double theta2 = w.squared_magnitude();
+  const vnl_cross_product_matrix W(w);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    vnl_double_3 e(0.0, 0.0, 0.0);
+    e[i] = 1.0;
+    const vnl_cross_product_matrix E(e);
+    const vnl_double_3 v = e - R.get_column(i);
+    if (theta2 > 1e-8)
+      dR[i] = (w[i] * W + vnl_cross_product_matrix(vnl_cross_3d(w, v))) * R / theta2;
+    else
+      dR[i] = E + 0.5 * (E * W + W * E);
+  }
+
+  for (unsigned int r = first; r < last; ++r)
+  {
+    const unsigned int i = r / 2;
+    const unsigned int a = r % 2;
+    const vgl_homg_point_3d<double> & X = world_points[i];
+    const vnl_double_3 d(X.x() - c.x() * X.w(), X.y() - c.y() * X.w(), X.z() - c.z() * X.w());
+    const vnl_double_3 q = R * d;
+    const vnl_double_3 p = K * q;
+    const double u = p[a] / p[2];
+    fx[r] = (a ? image_points[i].y() : image_points[i].x()) - u;
+
+    // the derivative of the residual when q changes by dq
+    auto derivative = [&](const vnl_double_3 & dq) {
+      const vnl_double_3 dp = K * dq;
+      return -(dp[a] - u * dp[2]) / p[2];
+    };
+    double * J = jacobian[r];
+    for (unsigned int k = 0; k < 3; ++k)
+      J[k] = derivative(dR[k] * d);
+    if (n_params > 3)
+      for (unsigned int k = 0; k < 3; ++k)
+        J[3 + k] = derivative(-X.w() * R.get_column(k));
+    if (n_params > 6)
+    {
+      J[6] = a == 0 ? -q[0] / p[2] : 0.0;
+      J[7] = a == 0 ? -q[2] / p[2] : 0.0;
+      J[8] = a == 1 ? -q[1] / p[2] : 0.0;
+      J[9] = a == 1 ? -q[2] / p[2] : 0.0;
+    }
+  }
+}
+
 
 //: Constructor
 vpgl_orientation_lsqr::vpgl_orientation_lsqr(const vpgl_calibration_matrix<double> & K,
                                              const vgl_point_3d<double> & c,
                                              const std::vector<vgl_homg_point_3d<double>> & world_points,
                                              std::vector<vgl_point_2d<double>> image_points)
-  : vnl_least_squares_function(3, static_cast<unsigned int>(2 * world_points.size()), no_gradient)
+  : vnl_least_squares_function(3, static_cast<unsigned int>(2 * world_points.size()), use_gradient)
   , K_(K)
   , c_(c)
   , world_points_(world_points)
   , image_points_(std::move(image_points))
 {
   assert(world_points_.size() == image_points_.size());
+  set_residual_rows(true);
 }
 
 
@@ -50,6 +119,26 @@ vpgl_orientation_lsqr::f(const vnl_vector<double> & x, vnl_vector<double> & fx)
   }
 }
 
+//: The Jacobian of f, computed analytically
+void
+vpgl_orientation_lsqr::gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian)
+{
+  vnl_vector<double> fx(get_number_of_residuals());
+  f_and_gradf_rows(x, 0, get_number_of_residuals(), fx, jacobian);
+}
+
+//: Residuals first to last-1 of f, and the same rows of the Jacobian
+void
+vpgl_orientation_lsqr::f_and_gradf_rows(const vnl_vector<double> & x,
+                                        unsigned int first,
+                                        unsigned int last,
+                                        vnl_vector<double> & fx,
+                                        vnl_matrix<double> & jacobian)
+{
+  vpgl_optimize_camera_rows(
+    K_.get_matrix(), vnl_double_3(x[0], x[1], x[2]), c_, 3, world_points_, image_points_, first, last, fx, jacobian);
+}
+
 //==============================================================================
 
 //: Constructor
@@ -57,12 +146,13 @@ vpgl_orientation_position_lsqr::vpgl_orientation_position_lsqr(
   const vpgl_calibration_matrix<double> & K,
   const std::vector<vgl_homg_point_3d<double>> & world_points,
   std::vector<vgl_point_2d<double>> image_points)
-  : vnl_least_squares_function(6, static_cast<unsigned int>(2 * world_points.size()), no_gradient)
+  : vnl_least_squares_function(6, static_cast<unsigned int>(2 * world_points.size()), use_gradient)
   , K_(K)
   , world_points_(world_points)
   , image_points_(std::move(image_points))
 {
   assert(world_points_.size() == image_points_.size());
+  set_residual_rows(true);
 }
 
 
@@ -86,6 +176,35 @@ vpgl_orientation_position_lsqr::f(const vnl_vector<double> & x, vnl_vector<doubl
   }
 }
 
+//: The Jacobian of f, computed analytically
+void
+vpgl_orientation_position_lsqr::gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian)
+{
+  vnl_vector<double> fx(get_number_of_residuals());
+  f_and_gradf_rows(x, 0, get_number_of_residuals(), fx, jacobian);
+}
+
+//: Residuals first to last-1 of f, and the same rows of the Jacobian
+void
+vpgl_orientation_position_lsqr::f_and_gradf_rows(const vnl_vector<double> & x,
+                                                 unsigned int first,
+                                                 unsigned int last,
+                                                 vnl_vector<double> & fx,
+                                                 vnl_matrix<double> & jacobian)
+{
+  assert(x.size() == 6);
+  vpgl_optimize_camera_rows(K_.get_matrix(),
+                            vnl_double_3(x[0], x[1], x[2]),
+                            vgl_point_3d<double>(x[3], x[4], x[5]),
+                            6,
+                            world_points_,
+                            image_points_,
+                            first,
+                            last,
+                            fx,
+                            jacobian);
+}
+
 #if 0
 //: Called after each LM iteration to print debugging etc.
 void
@@ -110,11 +229,12 @@ vpgl_orientation_position_lsqr::trace(int iteration,
 vpgl_orientation_position_calibration_lsqr::vpgl_orientation_position_calibration_lsqr(
   const std::vector<vgl_homg_point_3d<double>> & world_points,
   std::vector<vgl_point_2d<double>> image_points)
-  : vnl_least_squares_function(10, 2 * world_points.size(), no_gradient)
+  : vnl_least_squares_function(10, 2 * world_points.size(), use_gradient)
   , world_points_(world_points)
   , image_points_(std::move(image_points))
 {
   assert(world_points_.size() == image_points_.size());
+  set_residual_rows(true);
 }
 
 
@@ -159,6 +279,52 @@ vpgl_orientation_position_calibration_lsqr::f(const vnl_vector<double> & x, vnl_
   }
 }
 
+//: The Jacobian of f, computed analytically
+void
+vpgl_orientation_position_calibration_lsqr::gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian)
+{
+  vnl_vector<double> fx(get_number_of_residuals());
+  f_and_gradf_rows(x, 0, get_number_of_residuals(), fx, jacobian);
+}
+
+//: Residuals first to last-1 of f, and the same rows of the Jacobian
+void
+vpgl_orientation_position_calibration_lsqr::f_and_gradf_rows(const vnl_vector<double> & x,
+                                                             unsigned int first,
+                                                             unsigned int last,
+                                                             vnl_vector<double> & fx,
+                                                             vnl_matrix<double> & jacobian)
+{
+  assert(x.size() == 10);
+  // Check that it is a valid calibration matrix, as in f()
+  if (!(x[6] > 0) || !(x[8] > 0))
+  {
+    for (unsigned int r = first; r < last; ++r)
+    {
+      fx[r] = 100000000;
+      jacobian.set_row(r, 0.0);
+    }
+    return;
+  }
+  vnl_double_3x3 kk;
+  kk.fill(0);
+  kk[0][0] = x[6];
+  kk[0][2] = x[7];
+  kk[1][1] = x[8];
+  kk[1][2] = x[9];
+  kk[2][2] = 1.0;
+  vpgl_optimize_camera_rows(kk,
+                            vnl_double_3(x[0], x[1], x[2]),
+                            vgl_point_3d<double>(x[3], x[4], x[5]),
+                            10,
+                            world_points_,
+                            image_points_,
+                            first,
+                            last,
+                            fx,
+                            jacobian);
+}
+
 //: Constructor
 vpgl_orientation_position_focal_lsqr::vpgl_orientation_position_focal_lsqr(
   const vpgl_calibration_matrix<double> & K_init,
@@ -314,7 +480,8 @@ vpgl_orientation_position_focal_lsqr::gradf(const vnl_vector<double> & xvec, vnl
 vpgl_perspective_camera<double>
 vpgl_optimize_camera::opt_orient(const vpgl_perspective_camera<double> & camera,
                                  const std::vector<vgl_homg_point_3d<double>> & world_points,
-                                 const std::vector<vgl_point_2d<double>> & image_points)
+                                 const std::vector<vgl_point_2d<double>> & image_points,
+                                 const bool normal_equations)
 {
   const vpgl_calibration_matrix<double> & K = camera.get_calibration();
   const vgl_point_3d<double> & c = camera.get_camera_center();
@@ -325,6 +492,7 @@ vpgl_optimize_camera::opt_orient(const vpgl_perspective_camera<double> & camera,
 
   vpgl_orientation_lsqr lsqr_func(K, c, world_points, image_points);
   vnl_levenberg_marquardt lm(lsqr_func);
+  lm.set_normal_equations(normal_equations);
   // lm.set_trace(true);
   lm.minimize(w);
 
@@ -336,7 +504,8 @@ vpgl_optimize_camera::opt_orient(const vpgl_perspective_camera<double> & camera,
 vpgl_perspective_camera<double>
 vpgl_optimize_camera::opt_orient_pos(const vpgl_perspective_camera<double> & camera,
                                      const std::vector<vgl_homg_point_3d<double>> & world_points,
-                                     const std::vector<vgl_point_2d<double>> & image_points)
+                                     const std::vector<vgl_point_2d<double>> & image_points,
+                                     const bool normal_equations)
 {
   const vpgl_calibration_matrix<double> & K = camera.get_calibration();
   vgl_point_3d<double> c = camera.get_camera_center();
@@ -347,6 +516,7 @@ vpgl_optimize_camera::opt_orient_pos(const vpgl_perspective_camera<double> & cam
 
   vpgl_orientation_position_lsqr lsqr_func(K, world_points, image_points);
   vnl_levenberg_marquardt lm(lsqr_func);
+  lm.set_normal_equations(normal_equations);
   vnl_vector<double> params(6);
   params[0] = w[0];
   params[1] = w[1];
@@ -408,7 +578,8 @@ vpgl_optimize_camera::opt_orient_pos_cal(const vpgl_perspective_camera<double> &
                                          const std::vector<vgl_homg_point_3d<double>> & world_points,
                                          const std::vector<vgl_point_2d<double>> & image_points,
                                          const double xtol,
-                                         const unsigned nevals)
+                                         const unsigned nevals,
+                                         const bool normal_equations)
 {
   const vpgl_calibration_matrix<double> & K = camera.get_calibration();
   vgl_point_3d<double> c = camera.get_camera_center();
@@ -418,6 +589,7 @@ vpgl_optimize_camera::opt_orient_pos_cal(const vpgl_perspective_camera<double> &
   vnl_double_3x3 kk = K.get_matrix();
   vpgl_orientation_position_calibration_lsqr lsqr_func(world_points, image_points);
   vnl_levenberg_marquardt lm(lsqr_func);
+  lm.set_normal_equations(normal_equations);
   vnl_vector<double> params(10);
   params[0] = w[0];
   params[1] = w[1];
@@ -35,6 +35,18 @@ public:
   void
   f(const vnl_vector<double> & x, vnl_vector<double> & fx) override;
 
+  //: The Jacobian of f, computed analytically
+  void
+  gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian) override;
+
+  //: Residuals first to last-1 of f, and the same rows of the Jacobian
+  void
+  f_and_gradf_rows(const vnl_vector<double> & x,
+                   unsigned int first,
+                   unsigned int last,
+                   vnl_vector<double> & fx,
+                   vnl_matrix<double> & jacobian) override;
+
 #if 0
   //: Called after each LM iteration to print debugging etc.
   virtual void trace(int iteration, vnl_vector<double> const& x, vnl_vector<double> const& fx);
@@ -73,6 +85,18 @@ public:
   void
   f(const vnl_vector<double> & x, vnl_vector<double> & fx) override;
 
+  //: The Jacobian of f, computed analytically
+  void
+  gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian) override;
+
+  //: Residuals first to last-1 of f, and the same rows of the Jacobian
+  void
+  f_and_gradf_rows(const vnl_vector<double> & x,
+                   unsigned int first,
+                   unsigned int last,
+                   vnl_vector<double> & fx,
+                   vnl_matrix<double> & jacobian) override;
+
 #if 0
   //: Called after each LM iteration to print debugging etc.
   virtual void trace(int iteration, vnl_vector<double> const& x, vnl_vector<double> const& fx);
@@ -106,6 +130,18 @@ public:
   void
   f(const vnl_vector<double> & x, vnl_vector<double> & fx) override;
 
+  //: The Jacobian of f, computed analytically
+  void
+  gradf(const vnl_vector<double> & x, vnl_matrix<double> & jacobian) override;
+
+  //: Residuals first to last-1 of f, and the same rows of the Jacobian
+  void
+  f_and_gradf_rows(const vnl_vector<double> & x,
+                   unsigned int first,
+                   unsigned int last,
+                   vnl_vector<double> & fx,
+                   vnl_matrix<double> & jacobian) override;
+
 #if 0
   //: Called after each LM iteration to print debugging etc.
   virtual void trace(int iteration, vnl_vector<double> const& x, vnl_vector<double> const& fx);
@@ -164,16 +200,21 @@ public:
   ~vpgl_optimize_camera();
 
   //: optimize orientation for a perspective camera
+  //  If normal_equations is true, each step is solved from the normal
+  //  equations instead of with MINPACK, which is faster for many points.
   static vpgl_perspective_camera<double>
   opt_orient(const vpgl_perspective_camera<double> & camera,
              const std::vector<vgl_homg_point_3d<double>> & world_points,
-             const std::vector<vgl_point_2d<double>> & image_points);
+             const std::vector<vgl_point_2d<double>> & image_points,
+             const bool normal_equations = false);
 
   //: optimize orientation and position for a perspective camera
+  //  normal_equations is as for opt_orient().
   static vpgl_perspective_camera<double>
   opt_orient_pos(const vpgl_perspective_camera<double> & camera,
                  const std::vector<vgl_homg_point_3d<double>> & world_points,
-                 const std::vector<vgl_point_2d<double>> & image_points);
+                 const std::vector<vgl_point_2d<double>> & image_points,
+                 const bool normal_equations = false);
 
   //: optimize orientation, position and focal length for a perspective camera
   static vpgl_perspective_camera<double>
@@ -184,12 +225,14 @@ public:
                    const unsigned nevals = 10000);
 
   //: optimize orientation, position and internal calibration(no skew)for a perspective camera
+  //  normal_equations is as for opt_orient().
   static vpgl_perspective_camera<double>
   opt_orient_pos_cal(const vpgl_perspective_camera<double> & camera,
                      const std::vector<vgl_homg_point_3d<double>> & world_points,
                      const std::vector<vgl_point_2d<double>> & image_points,
                      const double xtol = 0.0001,
-                     const unsigned nevals = 10000);
+                     const unsigned nevals = 10000,
+                     const bool normal_equations = false);
 
 
 private:
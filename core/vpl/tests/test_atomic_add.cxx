@@ -0,0 +1,27 @@
+// This is core/vpl/tests/test_atomic_add.cxx
+#include <thread>
+#include <vector>
+#include "testlib/testlib_test.h"
+#include "vpl/vpl_atomic_add.h"
+
+static void
+test_atomic_add()
+{
+  float x[2] = { 1.0f, 0.0f };
+  vpl_atomic_add(x[0], 0.5f);
+  TEST("Add on one thread", x[0], 1.5f);
+
+  // small integers add exactly, whatever the order of the additions
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&x] {
+      for (int k = 0; k < 10000; ++k)
+        vpl_atomic_add(x[1], 1.0f);
+    });
+  for (auto & t : threads)
+    t.join();
+  TEST("No addition lost on four threads", x[1], 40000.0f);
+  TEST("Neighbour unchanged", x[0], 1.5f);
+}
+
+TESTMAIN(test_atomic_add);
@@ -2,11 +2,13 @@
 #include "testlib/testlib_register.h"
 
 DECLARE(test_unistd);
+DECLARE(test_atomic_add);
 
 void
 register_tests()
 {
   REGISTER(test_unistd);
+  REGISTER(test_atomic_add);
 }
 
 DEFINE_MAIN;
@@ -1,5 +1,6 @@
 // This is core/vpl/tests/test_include.cxx
 #include "vpl/vpl.h"
+#include "vpl/vpl_atomic_add.h"
 #include "vpl/vpl_fdopen.h"
 #include "vpl/vpl_fileno.h"
 
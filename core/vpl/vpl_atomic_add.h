@@ -0,0 +1,59 @@
+// This is core/vpl/vpl_atomic_add.h
+#ifndef vpl_atomic_add_h_
+#define vpl_atomic_add_h_
+//:
+// \file
+// \brief Atomic addition to a float which is not a std::atomic
+//
+// Accumulators shared by several threads are often elements of plain
+// float arrays, over which a std::atomic<float> may not be placed.
+// vpl_atomic_add() does a compare-and-swap loop with the compiler's
+// atomic builtins on the 32 bit pattern of the float instead.
+
+#include <cstring>
+#include "vxl_config.h"
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+//: Add v to x, atomically with respect to other calls on the same x.
+//  The ordering is relaxed: only the sum is guaranteed.
+inline void
+vpl_atomic_add(float & x, float v)
+{
+  static_assert(sizeof(float) == sizeof(vxl_uint_32), "vpl_atomic_add needs a 32 bit float");
+#if defined(_MSC_VER)
+  auto * bits = reinterpret_cast<volatile long *>(&x);
+  long old_bits = *bits;
+  for (;;)
+  {
+    float old_value;
+    std::memcpy(&old_value, &old_bits, sizeof(float));
+    const float new_value = old_value + v;
+    long new_bits;
+    std::memcpy(&new_bits, &new_value, sizeof(float));
+    const long seen = _InterlockedCompareExchange(bits, new_bits, old_bits);
+    if (seen == old_bits)
+      return;
+    old_bits = seen;
+  }
+#elif defined(__GNUC__) || defined(__clang__)
+  auto * bits = reinterpret_cast<vxl_uint_32 *>(&x);
+  vxl_uint_32 old_bits = __atomic_load_n(bits, __ATOMIC_RELAXED);
+  for (;;)
+  {
+    float old_value;
+    std::memcpy(&old_value, &old_bits, sizeof(float));
+    const float new_value = old_value + v;
+    vxl_uint_32 new_bits;
+    std::memcpy(&new_bits, &new_value, sizeof(float));
+    // on failure, old_bits is set to the current value of x
+    if (__atomic_compare_exchange(bits, &old_bits, &new_bits, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      return;
+  }
+#else
+#  error "vpl_atomic_add: no atomic builtins for this compiler"
+#endif
+}
+
+#endif // vpl_atomic_add_h_
@@ -227,6 +227,27 @@ test_homography2d_est()
     param /= param.two_norm();
     TEST("(Projective) Weighted Least Squares", (param - true_param).two_norm() < tol, true);
 
+    // several samples at once, as asked for by the random sampling search
+    std::vector<std::vector<int>> sets = { { 0, 2, 8, 10 }, { 10, 1, 2, 3 }, { 2, 5, 8, 10 }, { 1, 4, 7, 9 } };
+    std::vector<vnl_vector<double>> params;
+    std::vector<bool> ok;
+    homo_est.fit_from_minimal_sets(sets, params, ok);
+    bool same = params.size() == sets.size() && ok.size() == sets.size();
+    for (unsigned int s = 0; same && s < sets.size(); ++s)
+    {
+      vnl_vector<double> single;
+      same = ok[s] == homo_est.fit_from_minimal_set(sets[s], single);
+      if (same && ok[s])
+      {
+        vnl_vector<double> batched = params[s] / params[s].two_norm();
+        single /= single.two_norm();
+        if (dot_product(batched, single) < 0)
+          batched = -batched;
+        same = (batched - single).two_norm() < tol;
+      }
+    }
+    TEST("(Projective) batch of minimal-set estimations", same, true);
+
     // degenerate
     std::vector<double> wgts(n, 0.0);
     for (i = 0; i < 5; i++)
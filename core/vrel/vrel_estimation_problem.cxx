@@ -4,6 +4,7 @@
 #include "vrel_estimation_problem.h"
 
 #include <vrel/vrel_wls_obj.h>
+#include <vnl/vnl_vector.h>
 
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
@@ -25,6 +26,18 @@ vrel_estimation_problem::vrel_estimation_problem()
 vrel_estimation_problem::~vrel_estimation_problem() { delete multiple_scales_; }
 
 
+void
+vrel_estimation_problem::fit_from_minimal_sets(const std::vector<std::vector<int>> & point_indices,
+                                               std::vector<vnl_vector<double>> & params,
+                                               std::vector<bool> & ok) const
+{
+  params.resize(point_indices.size());
+  ok.resize(point_indices.size());
+  for (unsigned int s = 0; s < point_indices.size(); ++s)
+    ok[s] = this->fit_from_minimal_set(point_indices[s], params[s]);
+}
+
+
 void
 vrel_estimation_problem::compute_weights(const std::vector<double> & residuals,
                                          const vrel_wls_obj * obj,
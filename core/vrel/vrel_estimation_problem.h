@@ -116,6 +116,17 @@ public:
   virtual bool
   fit_from_minimal_set(const std::vector<int> & /* point_indices */, vnl_vector<double> & /* params */) const = 0;
 
+  //: Generate parameter vectors from several minimal sample sets.
+  // ok[s] and params[s] are set as by fit_from_minimal_set(point_indices[s], params[s]).
+  // The default calls fit_from_minimal_set() for each set.  Problems
+  // whose fit is a small fixed size decomposition may override this to
+  // solve all the sets together (see vnl_svd_fixed_batch), which is how
+  // random sampling searches ask for their fits.
+  virtual void
+  fit_from_minimal_sets(const std::vector<std::vector<int>> & point_indices,
+                        std::vector<vnl_vector<double>> & params,
+                        std::vector<bool> & ok) const;
+
   //: Compute the residuals relative to the given parameter vector.
   // The number of residuals must be equal to the value returned
   // by num_samples().
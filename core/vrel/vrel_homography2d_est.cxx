@@ -7,7 +7,9 @@
 #include "vgl/vgl_homg_point_2d.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_math.h"
+#include <vnl/vnl_matrix_fixed_batch.h>
 #include <vnl/algo/vnl_svd.h>
+#include <vnl/algo/vnl_svd_fixed_batch.h>
 
 #include <cassert>
 #ifdef _MSC_VER
@@ -103,6 +105,47 @@ vrel_homography2d_est ::fit_from_minimal_set(const std::vector<int> & point_indi
   }
 }
 
+void
+vrel_homography2d_est ::fit_from_minimal_sets(const std::vector<std::vector<int>> & point_indices,
+                                              std::vector<vnl_vector<double>> & params,
+                                              std::vector<bool> & ok) const
+{
+  if (homog_dof_ != 8)
+  {
+    vrel_estimation_problem::fit_from_minimal_sets(point_indices, params, ok);
+    return;
+  }
+
+  // the same rows as in fit_from_minimal_set, for all the samples
+  const std::size_t n = point_indices.size();
+  vnl_matrix_fixed_batch<double, 8, 9> A(n);
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    assert(point_indices[s].size() == min_num_pts_);
+    for (unsigned int i = 0; i < min_num_pts_; ++i)
+    {
+      const vnl_vector<double> & p = from_pts_[point_indices[s][i]];
+      const vnl_vector<double> & q = to_pts_[point_indices[s][i]];
+      for (unsigned int j = 0; j < 3; ++j)
+      {
+        A(s, 2 * i, j) = A(s, 2 * i + 1, 3 + j) = p[j] * q[2];
+        A(s, 2 * i, 6 + j) = -p[j] * q[0];
+        A(s, 2 * i + 1, 6 + j) = -p[j] * q[1];
+      }
+    }
+  }
+
+  const vnl_svd_fixed_batch<double, 8, 9> svd(A);
+  params.resize(n);
+  ok.resize(n);
+  for (std::size_t s = 0; s < n; ++s)
+  {
+    ok[s] = svd.rank(s, 1.0e-8) >= homog_dof_;
+    if (ok[s])
+      params[s] = svd.nullvector(s).as_vector();
+  }
+}
+
 void
 vrel_homography2d_est ::compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const
 {
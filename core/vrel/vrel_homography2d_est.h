@@ -74,6 +74,14 @@ public:
   bool
   fit_from_minimal_set(const std::vector<int> & point_indices, vnl_vector<double> & params) const override;
 
+  //: Generate parameter estimates from several minimal samples.
+  //  With 8 degrees of freedom, the null vectors of all the 8x9 systems
+  //  are computed together with vnl_svd_fixed_batch.
+  void
+  fit_from_minimal_sets(const std::vector<std::vector<int>> & point_indices,
+                        std::vector<vnl_vector<double>> & params,
+                        std::vector<bool> & ok) const override;
+
   //: Compute unsigned fit residuals relative to the parameter estimate.
   void
   compute_residuals(const vnl_vector<double> & params, std::vector<double> & residuals) const override;
@@ -1,4 +1,5 @@
 // This is core/vrel/vrel_ran_sam_search.cxx
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <vector>
@@ -94,7 +95,6 @@ vrel_ran_sam_search::estimate(const vrel_estimation_problem * problem, const vre
   unsigned int points_per = problem->num_samples_to_instantiate();
   unsigned int num_points = problem->num_samples();
   std::vector<int> point_indices(points_per);
-  vnl_vector<double> new_params;
   std::vector<double> residuals(num_points);
   min_obj_ = 0.0;
   bool obj_set = false;
@@ -111,13 +111,36 @@ vrel_ran_sam_search::estimate(const vrel_estimation_problem * problem, const vre
   //  correctly for probabilistic sampling because the possibility
   //  is rare.
   //
-  for (unsigned int s = 0; s < samples_to_take_; ++s)
+  //  The samples are drawn in batches, and the fits of a batch are
+  //  asked for together, so that a problem can compute them at once.
+  //  The samples and their order do not depend on the batching.
+  //
+  const unsigned int batch_size = 64;
+  std::vector<std::vector<int>> samples;
+  std::vector<vnl_vector<double>> fits;
+  std::vector<bool> fitted;
+  for (unsigned int first = 0; first < samples_to_take_; first += batch_size)
   {
-    this->next_sample(s, num_points, point_indices, points_per);
-    if (trace_level_ >= 2)
-      this->trace_sample(point_indices);
-    if (problem->fit_from_minimal_set(point_indices, new_params))
+    const unsigned int count = std::min(batch_size, samples_to_take_ - first);
+    samples.resize(count);
+    for (unsigned int b = 0; b < count; ++b)
     {
+      this->next_sample(first + b, num_points, point_indices, points_per);
+      if (trace_level_ >= 2)
+        this->trace_sample(point_indices);
+      samples[b] = point_indices;
+    }
+    problem->fit_from_minimal_sets(samples, fits, fitted);
+
+    for (unsigned int b = 0; b < count; ++b)
+    {
+      if (!fitted[b])
+      {
+        if (trace_level_ >= 1)
+          std::cout << "No fit to sample.\n";
+        continue;
+      }
+      vnl_vector<double> & new_params = fits[b];
       if (trace_level_ >= 1)
         std::cout << "Fit = " << new_params << std::endl;
       problem->compute_residuals(new_params, residuals);
@@ -150,12 +173,10 @@ vrel_ran_sam_search::estimate(const vrel_estimation_problem * problem, const vre
         obj_set = true;
         min_obj_ = new_obj;
         params_ = new_params;
-        indices_ = point_indices;
+        indices_ = samples[b];
         residuals_ = residuals;
       }
     }
-    else if (trace_level_ >= 1)
-      std::cout << "No fit to sample.\n";
   }
 
   if (!obj_set)
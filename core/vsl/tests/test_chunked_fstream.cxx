@@ -0,0 +1,135 @@
+// This is core/vsl/tests/test_chunked_fstream.cxx
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#  include "vcl_msvc_warnings.h"
+#endif
+#include "vsl/vsl_binary_io.h"
+#include "vsl/vsl_chunked_fstream.h"
+#include "vsl/vsl_vector_io.h"
+#include "vsl/vsl_string_io.h"
+#include "testlib/testlib_test.h"
+#include "vpl/vpl.h"
+
+static void
+test_chunked_fstream()
+{
+  std::cout << "*******************************\n"
+            << " Testing vsl_b_ichunked_fstream\n"
+            << "*******************************\n";
+
+  const char * filename = "vsl_chunked_fstream_test.bvl.tmp";
+
+  // Objects spanning several small chunks, some compressible, some not
+  const int n_objects = 20;
+  std::vector<std::vector<int>> v_out(n_objects);
+  std::vector<std::string> s_out(n_objects);
+  unsigned seed = 12345;
+  for (int k = 0; k < n_objects; ++k)
+  {
+    v_out[k].resize(100 + 37 * k);
+    for (unsigned i = 0; i < v_out[k].size(); ++i)
+    {
+      seed = seed * 1103515245u + 12345u;
+      v_out[k][i] = (k % 2) ? int(i / 10) : int(seed >> 8);
+    }
+    s_out[k] = "object " + std::to_string(k);
+  }
+
+  {
+    vsl_b_ochunked_fstream bfs_out(filename, 1000, 3);
+    TEST("Created vsl_chunked_fstream_test.bvl.tmp for writing", (!bfs_out), false);
+    for (int k = 0; k < n_objects; ++k)
+    {
+      TEST_EQUAL("mark number", bfs_out.mark(), std::size_t(k));
+      vsl_b_write(bfs_out, k);
+      vsl_b_write(bfs_out, s_out[k]);
+      vsl_b_write(bfs_out, v_out[k]);
+    }
+    bfs_out.close();
+    TEST("Wrote file", (!bfs_out), false);
+  }
+  TEST("vsl_chunked_fstream_test", vsl_chunked_fstream_test(filename), true);
+
+  {
+    vsl_b_ichunked_fstream bfs_in(filename);
+    TEST("Opened vsl_chunked_fstream_test.bvl.tmp for reading", (!bfs_in), false);
+    TEST_EQUAL("number_of_marks", bfs_in.number_of_marks(), std::size_t(n_objects));
+    bool ok = true;
+    for (int k = 0; k < n_objects; ++k)
+    {
+      int k_in = -1;
+      std::string s_in;
+      std::vector<int> v_in;
+      vsl_b_read(bfs_in, k_in);
+      vsl_b_read(bfs_in, s_in);
+      vsl_b_read(bfs_in, v_in);
+      ok = ok && k_in == k && s_in == s_out[k] && v_in == v_out[k];
+    }
+    TEST("Sequential read", ok && !!bfs_in, true);
+    char c;
+    bfs_in.is().read(&c, 1);
+    TEST("End of stream", bfs_in.is().eof(), true);
+
+    // random access, backwards
+    ok = true;
+    for (int k = n_objects - 1; k >= 0; k -= 3)
+    {
+      bfs_in.seek_mark(k);
+      int k_in = -1;
+      std::string s_in;
+      std::vector<int> v_in;
+      vsl_b_read(bfs_in, k_in);
+      vsl_b_read(bfs_in, s_in);
+      vsl_b_read(bfs_in, v_in);
+      ok = ok && k_in == k && s_in == s_out[k] && v_in == v_out[k];
+    }
+    TEST("seek_mark", ok && !!bfs_in, true);
+
+    // tellg and seekg work on the uncompressed stream
+    bfs_in.seek_mark(5);
+    const std::streampos p5 = bfs_in.is().tellg();
+    int k_in = -1;
+    vsl_b_read(bfs_in, k_in);
+    bfs_in.is().seekg(p5);
+    TEST_EQUAL("tellg", bfs_in.is().tellg(), p5);
+    vsl_b_read(bfs_in, k_in);
+    TEST_EQUAL("seekg", k_in, 5);
+    bfs_in.close();
+  }
+
+  // Corrupt one byte in the middle of the file
+  {
+    std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(0, std::ios::end);
+    const std::streamoff middle = f.tellg() / 2;
+    char c = 0;
+    f.seekg(middle);
+    f.read(&c, 1);
+    c ^= 0x5a;
+    f.seekp(middle);
+    f.write(&c, 1);
+  }
+  {
+    vsl_b_ichunked_fstream bfs_in(filename);
+    TEST("Opened corrupted file", (!bfs_in), false);
+    for (int k = 0; k < n_objects && !!bfs_in; ++k)
+    {
+      int k_in = -1;
+      std::string s_in;
+      std::vector<int> v_in;
+      vsl_b_read(bfs_in, k_in);
+      vsl_b_read(bfs_in, s_in);
+      vsl_b_read(bfs_in, v_in);
+    }
+    TEST("Corrupted chunk detected", bfs_in.is().bad(), true);
+  }
+
+  TEST("Non chunked file rejected", vsl_chunked_fstream_test("vsl_no_such_file.bvl.tmp"), false);
+
+  vpl_unlink(filename);
+}
+
+TESTMAIN(test_chunked_fstream);
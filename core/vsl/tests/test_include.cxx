@@ -8,12 +8,14 @@
 #include "vsl/vsl_block_binary.h"
 #include "vsl/vsl_block_binary_rle.h"
 #include "vsl/vsl_b_read_block_old.h"
+#include "vsl/vsl_chunked_fstream.h"
 #include "vsl/vsl_clipon_binary_loader.h"
 #include "vsl/vsl_complex_io.h"
 #include "vsl/vsl_deque_io.h"
 #include "vsl/vsl_indent.h"
 #include "vsl/vsl_list_io.h"
 #include "vsl/vsl_map_io.h"
+#include "vsl/vsl_mapped_fstream.h"
 #include "vsl/vsl_pair_io.h"
 #include "vsl/vsl_quick_file.h"
 #include "vsl/vsl_set_io.h"
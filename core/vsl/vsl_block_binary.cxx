@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include "vsl_block_binary.h"
+#include "vsl_mapped_fstream.h"
 #ifdef _MSC_VER
 #  include "vcl_msvc_warnings.h"
 #endif
@@ -264,6 +265,32 @@ vsl_block_binary_read_byte_impl(vsl_b_istream & is, T * begin, std::size_t nelem
   is.is().read((char *)begin, nelems);
 }
 
+/////////////////////////////////////////////////////////////////////////
+
+//: Return a pointer to a block of nbytes in the mapping of is, and skip it.
+void *
+vsl_block_binary_read_in_place_impl(vsl_b_istream & is,
+                                    std::size_t nbytes,
+                                    std::size_t alignment,
+                                    bool needs_conversion,
+                                    std::shared_ptr<void> & owner)
+{
+  auto * mapped = dynamic_cast<vsl_b_imapped_fstream *>(&is);
+  if (!mapped || needs_conversion || !is)
+    return nullptr;
+  // The block is the flag written by the specialised form, then the data
+  char * p = mapped->take(1 + nbytes);
+  if (!p)
+    return nullptr;
+  if (p[0] == 0 || reinterpret_cast<std::size_t>(p + 1) % alignment != 0)
+  {
+    is.is().seekg(-std::streamoff(1 + nbytes), std::ios::cur);
+    return nullptr;
+  }
+  owner = mapped->mapping();
+  return p + 1;
+}
+
 
 // Instantiate templates for POD types.
 
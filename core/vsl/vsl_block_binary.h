@@ -6,6 +6,7 @@
 // \brief Set of functions to do binary IO on a block of values.
 // \author Ian Scott, ISBE Manchester, Feb 2003
 
+#include <memory>
 #include "vsl_binary_io.h"
 #include "vsl_binary_explicit_io.h"
 
@@ -372,4 +373,63 @@ vsl_block_binary_read(vsl_b_istream & is, T * begin, std::size_t nelems)
     vsl_b_read(is, *(begin++));
 }
 
+/////////////////////////////////////////////////////////////////////////
+
+// Internal implementation
+void *
+vsl_block_binary_read_in_place_impl(vsl_b_istream & is,
+                                    std::size_t nbytes,
+                                    std::size_t alignment,
+                                    bool needs_conversion,
+                                    std::shared_ptr<void> & owner);
+
+//: Read a block of values in place, without copying, if possible.
+// If is is a vsl_b_imapped_fstream, and the block was saved in the fast form
+// and needs no conversion on this platform (bytes, and floats and doubles on
+// a little endian machine), and it is suitably aligned in the file, this
+// returns a pointer to the block in the mapped file, moves is past it, and
+// sets owner to keep the mapping alive.  Otherwise it returns nullptr and
+// leaves is where it was, so that the block can be read with
+// vsl_block_binary_read().
+template <class T>
+inline T *
+vsl_block_binary_read_in_place(vsl_b_istream & /*is*/, std::size_t /*nelems*/, std::shared_ptr<void> & /*owner*/)
+{
+  return nullptr;
+}
+
+//: Read a block of doubles in place, if possible.
+template <>
+inline double *
+vsl_block_binary_read_in_place(vsl_b_istream & is, std::size_t nelems, std::shared_ptr<void> & owner)
+{
+  return static_cast<double *>(
+    vsl_block_binary_read_in_place_impl(is, nelems * sizeof(double), alignof(double), !VXL_LITTLE_ENDIAN, owner));
+}
+
+//: Read a block of floats in place, if possible.
+template <>
+inline float *
+vsl_block_binary_read_in_place(vsl_b_istream & is, std::size_t nelems, std::shared_ptr<void> & owner)
+{
+  return static_cast<float *>(
+    vsl_block_binary_read_in_place_impl(is, nelems * sizeof(float), alignof(float), !VXL_LITTLE_ENDIAN, owner));
+}
+
+//: Read a block of unsigned chars in place, if possible.
+template <>
+inline unsigned char *
+vsl_block_binary_read_in_place(vsl_b_istream & is, std::size_t nelems, std::shared_ptr<void> & owner)
+{
+  return static_cast<unsigned char *>(vsl_block_binary_read_in_place_impl(is, nelems, 1, false, owner));
+}
+
+//: Read a block of signed chars in place, if possible.
+template <>
+inline signed char *
+vsl_block_binary_read_in_place(vsl_b_istream & is, std::size_t nelems, std::shared_ptr<void> & owner)
+{
+  return static_cast<signed char *>(vsl_block_binary_read_in_place_impl(is, nelems, 1, false, owner));
+}
+
 #endif // vsl_block_binary_io_h_
@@ -0,0 +1,585 @@
+// This is core/vsl/vsl_chunked_fstream.cxx
+//:
+// \file
+// \brief Compressed binary file streams, with an index for random access
+//
+// File layout (all integers little endian):
+// \verbatim
+//  "VSLC"  u32 format version  u64 chunk size
+//  for each chunk:   u32 raw size  u32 stored size  u8 method  u32 checksum  data
+//  index:            u64 number of chunks
+//                    for each chunk: u64 position in file  u64 position in stream
+//                    u64 size of stream  u64 number of marks  u64 marks...
+//  footer:           u64 position of index  "VSLI"
+// \endverbatim
+// The data of a chunk are either stored as is (method 0) or in the LZ4
+// block format (method 1).  The checksum is the 32 bit FNV-1a hash of the
+// uncompressed data.
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include "vsl_chunked_fstream.h"
+#include <vnl/vnl_thread_pool.h>
+
+static const char vsl_chunked_file_magic[4] = { 'V', 'S', 'L', 'C' };
+static const char vsl_chunked_index_magic[4] = { 'V', 'S', 'L', 'I' };
+static const unsigned vsl_chunked_format_version = 1;
+//: Size of the chunk header: raw size, stored size, method, checksum
+static const std::size_t vsl_chunked_header_size = 13;
+
+//: Write n bytes of v to os, least significant first
+static void
+vsl_chunked_write_le(std::ostream & os, vxl_uint_64 v, unsigned n)
+{
+  char b[8];
+  for (unsigned i = 0; i < n; ++i, v >>= 8)
+    b[i] = static_cast<char>(v & 0xff);
+  os.write(b, n);
+}
+
+//: Read n bytes, least significant first
+static vxl_uint_64
+vsl_chunked_read_le(std::istream & is, unsigned n)
+{
+  unsigned char b[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  is.read(reinterpret_cast<char *>(b), n);
+  vxl_uint_64 v = 0;
+  for (unsigned i = n; i > 0; --i)
+    v = (v << 8) | b[i - 1];
+  return v;
+}
+
+//: 32 bit FNV-1a hash
+static vxl_uint_32
+vsl_chunked_checksum(const char * data, std::size_t n)
+{
+  vxl_uint_32 h = 2166136261u;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+//============================================================================
+// LZ4 block format coder.
+// Each sequence is a token (number of literals in the high nibble, match
+// length - 4 in the low nibble, 15 meaning more bytes follow), the
+// literals, and the 16 bit offset of the match.  The last sequence has
+// literals only; as required by the format, the last 5 bytes are literals
+// and no match starts in the last 12 bytes.
+
+static vxl_uint_32
+vsl_lz_read32(const unsigned char * p)
+{
+  vxl_uint_32 v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+static void
+vsl_lz_write_length(std::vector<char> & dst, std::size_t len)
+{
+  for (; len >= 255; len -= 255)
+    dst.push_back(static_cast<char>(255));
+  dst.push_back(static_cast<char>(len));
+}
+
+static void
+vsl_lz_write_literals(std::vector<char> & dst, const unsigned char * lit, std::size_t n_lit, unsigned match_nibble)
+{
+  dst.push_back(static_cast<char>(((n_lit < 15 ? n_lit : 15) << 4) | match_nibble));
+  if (n_lit >= 15)
+    vsl_lz_write_length(dst, n_lit - 15);
+  dst.insert(dst.end(), lit, lit + n_lit);
+}
+
+//: Compress n bytes of src into dst
+static void
+vsl_lz_compress(const char * src, std::size_t n, std::vector<char> & dst)
+{
+  const unsigned hash_log = 14;
+  const auto * in = reinterpret_cast<const unsigned char *>(src);
+  dst.clear();
+  dst.reserve(n + n / 255 + 16);
+
+  std::size_t anchor = 0;
+  if (n >= 13)
+  {
+    std::vector<vxl_uint_32> table(1u << hash_log, 0);
+    const std::size_t match_limit = n - 12;
+    const std::size_t match_end = n - 5;
+    std::size_t ip = 0;
+    unsigned misses = 0;
+    while (ip < match_limit)
+    {
+      const vxl_uint_32 seq = vsl_lz_read32(in + ip);
+      const vxl_uint_32 h = (seq * 2654435761u) >> (32 - hash_log);
+      std::size_t ref = table[h];
+      table[h] = static_cast<vxl_uint_32>(ip);
+      if (ref >= ip || ip - ref > 65535 || vsl_lz_read32(in + ref) != seq)
+      {
+        // step faster through data which does not compress
+        ip += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+      while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1])
+      {
+        --ip;
+        --ref;
+      }
+      std::size_t len = 4;
+      while (ip + len < match_end && in[ip + len] == in[ref + len])
+        ++len;
+
+      const std::size_t ml = len - 4;
+      vsl_lz_write_literals(dst, in + anchor, ip - anchor, ml < 15 ? unsigned(ml) : 15u);
+      const std::size_t offset = ip - ref;
+      dst.push_back(static_cast<char>(offset & 0xff));
+      dst.push_back(static_cast<char>(offset >> 8));
+      if (ml >= 15)
+        vsl_lz_write_length(dst, ml - 15);
+      ip += len;
+      anchor = ip;
+    }
+  }
+  vsl_lz_write_literals(dst, in + anchor, n - anchor, 0);
+}
+
+//: Decompress n_src bytes of src into exactly n_dst bytes of dst.
+//  Returns false if the data are not valid.
+static bool
+vsl_lz_decompress(const char * src, std::size_t n_src, char * dst, std::size_t n_dst)
+{
+  const auto * in = reinterpret_cast<const unsigned char *>(src);
+  std::size_t ip = 0, op = 0;
+  while (ip < n_src)
+  {
+    const unsigned token = in[ip++];
+    std::size_t n_lit = token >> 4;
+    if (n_lit == 15)
+    {
+      unsigned char b;
+      do
+      {
+        if (ip >= n_src)
+          return false;
+        b = in[ip++];
+        n_lit += b;
+      } while (b == 255);
+    }
+    if (n_lit > n_src - ip || n_lit > n_dst - op)
+      return false;
+    std::memcpy(dst + op, in + ip, n_lit);
+    ip += n_lit;
+    op += n_lit;
+    if (ip == n_src) // last sequence
+      break;
+
+    if (n_src - ip < 2)
+      return false;
+    const std::size_t offset = in[ip] | (std::size_t(in[ip + 1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > op)
+      return false;
+    std::size_t len = token & 15;
+    if (len == 15)
+    {
+      unsigned char b;
+      do
+      {
+        if (ip >= n_src)
+          return false;
+        b = in[ip++];
+        len += b;
+      } while (b == 255);
+    }
+    len += 4;
+    if (len > n_dst - op)
+      return false;
+    // byte by byte, as the match may overlap the bytes being written
+    for (const char * m = dst + op - offset; len > 0; --len)
+      dst[op++] = *m++;
+  }
+  return op == n_dst;
+}
+
+//: A chunk ready to be written
+struct vsl_chunked_packed
+{
+  std::vector<char> data;
+  unsigned char method{ 0 };
+  vxl_uint_32 checksum{ 0 };
+};
+
+static void
+vsl_chunked_pack(const std::vector<char> & raw, vsl_chunked_packed & packed)
+{
+  packed.checksum = vsl_chunked_checksum(raw.data(), raw.size());
+  vsl_lz_compress(raw.data(), raw.size(), packed.data);
+  packed.method = 1;
+  if (packed.data.size() >= raw.size()) // store as is
+  {
+    packed.data.clear();
+    packed.method = 0;
+  }
+}
+
+//============================================================================
+// vsl_chunked_ofilebuf
+
+vsl_chunked_ofilebuf::vsl_chunked_ofilebuf(const char * filename, std::size_t chunk_size, unsigned n_threads)
+  : file_(filename, std::ios::out | std::ios::binary)
+  , chunk_size_(std::min<std::size_t>(std::max<std::size_t>(chunk_size, 1), std::numeric_limits<vxl_uint_32>::max()))
+  , n_threads_(n_threads > 0 ? n_threads : vnl_thread_pool::default_pool().n_threads())
+  , buffer_(chunk_size_)
+  , open_(file_.good())
+{
+  setp(buffer_.data(), buffer_.data() + buffer_.size());
+  if (!open_)
+    return;
+  file_.write(vsl_chunked_file_magic, 4);
+  vsl_chunked_write_le(file_, vsl_chunked_format_version, 4);
+  vsl_chunked_write_le(file_, chunk_size_, 8);
+}
+
+vsl_chunked_ofilebuf::~vsl_chunked_ofilebuf()
+{
+  close();
+}
+
+std::size_t
+vsl_chunked_ofilebuf::mark()
+{
+  marks_.push_back(stream_pos_ + (pptr() - pbase()));
+  return marks_.size() - 1;
+}
+
+void
+vsl_chunked_ofilebuf::close()
+{
+  if (!open_)
+    return;
+  end_chunk(true);
+
+  const vxl_uint_64 index_pos = file_.tellp();
+  vsl_chunked_write_le(file_, file_offset_.size(), 8);
+  for (std::size_t c = 0; c < file_offset_.size(); ++c)
+  {
+    vsl_chunked_write_le(file_, file_offset_[c], 8);
+    vsl_chunked_write_le(file_, stream_offset_[c], 8);
+  }
+  vsl_chunked_write_le(file_, written_, 8);
+  vsl_chunked_write_le(file_, marks_.size(), 8);
+  for (vxl_uint_64 m : marks_)
+    vsl_chunked_write_le(file_, m, 8);
+  vsl_chunked_write_le(file_, index_pos, 8);
+  file_.write(vsl_chunked_index_magic, 4);
+  file_.close();
+  open_ = false;
+}
+
+std::streambuf::int_type
+vsl_chunked_ofilebuf::overflow(int_type c)
+{
+  if (!open_)
+    return traits_type::eof();
+  end_chunk(false);
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return file_.good() ? traits_type::not_eof(c) : traits_type::eof();
+}
+
+std::streambuf::pos_type
+vsl_chunked_ofilebuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  // Only the current position can be asked for
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out))
+    return pos_type(off_type(-1));
+  return pos_type(off_type(stream_pos_ + (pptr() - pbase())));
+}
+
+void
+vsl_chunked_ofilebuf::end_chunk(bool flush_all)
+{
+  if (pptr() > pbase())
+  {
+    pending_.emplace_back(pbase(), pptr());
+    stream_pos_ += pptr() - pbase();
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+  if (pending_.empty() || (!flush_all && pending_.size() < n_threads_))
+    return;
+
+  // Compress the pending chunks in parallel, one per thread
+  const std::size_t n = pending_.size();
+  std::vector<vsl_chunked_packed> packed(n);
+  vnl_thread_pool::default_pool().parallel_for(
+    n, [&](std::size_t i) { vsl_chunked_pack(pending_[i], packed[i]); }, n_threads_);
+
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const std::vector<char> & data = packed[i].method == 0 ? pending_[i] : packed[i].data;
+    file_offset_.push_back(file_.tellp());
+    stream_offset_.push_back(written_);
+    vsl_chunked_write_le(file_, pending_[i].size(), 4);
+    vsl_chunked_write_le(file_, data.size(), 4);
+    vsl_chunked_write_le(file_, packed[i].method, 1);
+    vsl_chunked_write_le(file_, packed[i].checksum, 4);
+    file_.write(data.data(), data.size());
+    written_ += pending_[i].size();
+  }
+  pending_.clear();
+}
+
+//============================================================================
+// vsl_chunked_ifilebuf
+
+vsl_chunked_ifilebuf::vsl_chunked_ifilebuf(const char * filename)
+  : file_(filename, std::ios::in | std::ios::binary)
+{
+  if (!file_)
+    return;
+  char magic[4] = { 0, 0, 0, 0 };
+  file_.read(magic, 4);
+  const vxl_uint_64 version = vsl_chunked_read_le(file_, 4);
+  vsl_chunked_read_le(file_, 8); // chunk size
+  if (!file_ || std::memcmp(magic, vsl_chunked_file_magic, 4) != 0 || version != vsl_chunked_format_version)
+    return;
+
+  file_.seekg(0, std::ios::end);
+  const vxl_uint_64 file_size = file_.tellg();
+  if (file_size < 28)
+    return;
+  file_.seekg(file_size - 12);
+  const vxl_uint_64 index_pos = vsl_chunked_read_le(file_, 8);
+  file_.read(magic, 4);
+  if (!file_ || std::memcmp(magic, vsl_chunked_index_magic, 4) != 0 || index_pos >= file_size)
+    return;
+
+  file_.seekg(index_pos);
+  const vxl_uint_64 n = vsl_chunked_read_le(file_, 8);
+  if (!file_ || n > file_size / vsl_chunked_header_size)
+    return;
+  file_offset_.resize(n + 1);
+  stream_offset_.resize(n + 1);
+  for (std::size_t c = 0; c < n; ++c)
+  {
+    file_offset_[c] = vsl_chunked_read_le(file_, 8);
+    stream_offset_[c] = vsl_chunked_read_le(file_, 8);
+  }
+  file_offset_[n] = index_pos;
+  stream_offset_[n] = vsl_chunked_read_le(file_, 8);
+  const vxl_uint_64 n_marks = vsl_chunked_read_le(file_, 8);
+  if (!file_ || n_marks > file_size / 8)
+    return;
+  marks_.resize(n_marks);
+  for (vxl_uint_64 & m : marks_)
+    m = vsl_chunked_read_le(file_, 8);
+  if (!file_ || !std::is_sorted(stream_offset_.begin(), stream_offset_.end()))
+    return;
+
+  current_ = n;
+  good_ = true;
+}
+
+bool
+vsl_chunked_ifilebuf::load_chunk(std::size_t c)
+{
+  const std::size_t n = file_offset_.size() - 1;
+  current_ = n;
+  setg(nullptr, nullptr, nullptr);
+
+  file_.clear();
+  file_.seekg(file_offset_[c]);
+  const vxl_uint_64 raw_size = vsl_chunked_read_le(file_, 4);
+  const vxl_uint_64 stored_size = vsl_chunked_read_le(file_, 4);
+  const vxl_uint_64 method = vsl_chunked_read_le(file_, 1);
+  const vxl_uint_64 checksum = vsl_chunked_read_le(file_, 4);
+  if (!file_ || raw_size != stream_offset_[c + 1] - stream_offset_[c] ||
+      stored_size > file_offset_[c + 1] - file_offset_[c] || method > 1)
+    return false;
+
+  buffer_.resize(raw_size);
+  if (method == 0)
+  {
+    if (stored_size != raw_size || !file_.read(buffer_.data(), raw_size))
+      return false;
+  }
+  else
+  {
+    packed_.resize(stored_size);
+    if (!file_.read(packed_.data(), stored_size) ||
+        !vsl_lz_decompress(packed_.data(), stored_size, buffer_.data(), raw_size))
+      return false;
+  }
+  if (vsl_chunked_checksum(buffer_.data(), raw_size) != checksum)
+    return false;
+
+  current_ = c;
+  setg(buffer_.data(), buffer_.data(), buffer_.data() + raw_size);
+  return true;
+}
+
+void
+vsl_chunked_ifilebuf::close()
+{
+  file_.close();
+  good_ = false;
+  setg(nullptr, nullptr, nullptr);
+}
+
+std::streambuf::int_type
+vsl_chunked_ifilebuf::underflow()
+{
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+  if (!good_)
+    return traits_type::eof();
+  const std::size_t n = file_offset_.size() - 1;
+  const std::size_t next = current_ < n ? current_ + 1 : 0;
+  if (next >= n)
+    return traits_type::eof();
+  // The stream sets its badbit when the exception is thrown by its buffer
+  if (!load_chunk(next))
+    throw std::ios_base::failure("vsl_chunked_ifilebuf: corrupted chunk");
+  return traits_type::to_int_type(*gptr());
+}
+
+std::streambuf::pos_type
+vsl_chunked_ifilebuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if (!good_ || !(which & std::ios_base::in))
+    return pos_type(off_type(-1));
+  const std::size_t n = file_offset_.size() - 1;
+  const off_type cur = current_ < n ? off_type(stream_offset_[current_] + (gptr() - eback())) : 0;
+  if (dir == std::ios_base::cur && off == 0)
+    return pos_type(cur);
+  off_type target = off;
+  if (dir == std::ios_base::cur)
+    target += cur;
+  else if (dir == std::ios_base::end)
+    target += off_type(stream_size());
+  return seekpos(pos_type(target), which);
+}
+
+std::streambuf::pos_type
+vsl_chunked_ifilebuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  const off_type p = off_type(pos);
+  if (!good_ || !(which & std::ios_base::in) || p < 0 || vxl_uint_64(p) > stream_size() ||
+      file_offset_.size() < 2)
+    return pos_type(off_type(-1));
+  // the chunk containing p; the end of the stream is the end of the last chunk
+  const auto it = std::upper_bound(stream_offset_.begin(), stream_offset_.end() - 1, vxl_uint_64(p));
+  const std::size_t c = (it - stream_offset_.begin()) - 1;
+  if (c != current_ && !load_chunk(c))
+    return pos_type(off_type(-1));
+  setg(eback(), eback() + (p - off_type(stream_offset_[c])), egptr());
+  return pos;
+}
+
+//============================================================================
+// vsl_b_ochunked_fstream and vsl_b_ichunked_fstream
+
+static std::ostream *
+vsl_chunked_open_ostream(const std::string & filename, std::size_t chunk_size, unsigned n_threads)
+{
+  auto * buf = new vsl_chunked_ofilebuf(filename.c_str(), chunk_size, n_threads);
+  auto * os = new std::ostream(buf);
+  if (!buf->good())
+    os->setstate(std::ios::badbit);
+  return os;
+}
+
+static std::istream *
+vsl_chunked_open_istream(const std::string & filename)
+{
+  auto * buf = new vsl_chunked_ifilebuf(filename.c_str());
+  auto * is = new std::istream(buf);
+  if (!buf->good())
+    is->setstate(std::ios::badbit);
+  return is;
+}
+
+vsl_b_ochunked_fstream::vsl_b_ochunked_fstream(const std::string & filename,
+                                               std::size_t chunk_size,
+                                               unsigned n_threads)
+  : vsl_b_ostream(vsl_chunked_open_ostream(filename, chunk_size, n_threads))
+  , buf_(static_cast<vsl_chunked_ofilebuf *>(os_->rdbuf()))
+{}
+
+//: destructor.
+vsl_b_ochunked_fstream::~vsl_b_ochunked_fstream()
+{
+  buf_->close();
+  delete os_;
+  delete buf_;
+}
+
+std::size_t
+vsl_b_ochunked_fstream::mark()
+{
+  clear_serialisation_records();
+  return buf_->mark();
+}
+
+//: Close the stream
+void
+vsl_b_ochunked_fstream::close()
+{
+  buf_->close();
+  clear_serialisation_records();
+}
+
+vsl_b_ichunked_fstream::vsl_b_ichunked_fstream(const std::string & filename)
+  : vsl_b_istream(vsl_chunked_open_istream(filename))
+  , buf_(static_cast<vsl_chunked_ifilebuf *>(is_->rdbuf()))
+{}
+
+//: destructor.
+vsl_b_ichunked_fstream::~vsl_b_ichunked_fstream()
+{
+  delete is_;
+  delete buf_;
+}
+
+std::size_t
+vsl_b_ichunked_fstream::number_of_marks() const
+{
+  return buf_->number_of_marks();
+}
+
+void
+vsl_b_ichunked_fstream::seek_mark(std::size_t i)
+{
+  assert(i < buf_->number_of_marks());
+  is_->clear();
+  is_->seekg(std::streampos(std::streamoff(buf_->mark(i))));
+  clear_serialisation_records();
+}
+
+//: Close the stream
+void
+vsl_b_ichunked_fstream::close()
+{
+  buf_->close();
+  clear_serialisation_records();
+}
+
+//: Test to see if a file was written by vsl_b_ochunked_fstream.
+// \return false if the file can't be opened, or its index can't be read.
+bool
+vsl_chunked_fstream_test(const std::string & filename)
+{
+  vsl_chunked_ifilebuf buf(filename.c_str());
+  return buf.good();
+}
@@ -0,0 +1,215 @@
+// This is core/vsl/vsl_chunked_fstream.h
+#ifndef vsl_chunked_fstream_h_
+#define vsl_chunked_fstream_h_
+//:
+// \file
+// \brief Compressed binary file streams, with an index for random access
+//
+// vsl_b_ochunked_fstream and vsl_b_ichunked_fstream are used like
+// vsl_b_ofstream and vsl_b_ifstream, with the usual vsl_b_write() and
+// vsl_b_read() functions, but the file is a sequence of compressed chunks:
+//
+// - The byte stream written by vsl is cut into chunks of a fixed size
+//   (1 MiB by default), which are compressed on the threads of
+//   vnl_thread_pool::default_pool() with a fast LZ77 coder (the block
+//   format of LZ4) and written in order.
+//   A chunk which does not compress is stored as is.
+// - Each chunk carries a checksum of its contents, which is checked when
+//   it is read; a corrupted chunk sets the badbit of the stream.
+// - A trailing index gives the position of each chunk in the file and in
+//   the byte stream, so that the input stream can seek (seekg(), or the
+//   marks below) by decompressing only the chunk it lands in.
+//
+// To be able to load single top-level objects from a large archive, call
+// mark() on the output stream before writing each of them.  The marks are
+// stored in the index, and seek_mark() jumps to one of them.  Both clear
+// the serialisation records, so that each marked object is self contained.
+
+#include <cstddef>
+#include <fstream>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <vxl_config.h>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vsl/vsl_binary_io.h>
+
+//: Stream buffer which writes a chunked, compressed file.
+class vsl_chunked_ofilebuf : public std::streambuf
+{
+public:
+  //: Open filename for writing.
+  //  The chunks are compressed on at most n_threads threads of
+  //  vnl_thread_pool::default_pool() (0 = all of them).  chunk_size is
+  //  limited to 2^32-1 bytes, as the chunk sizes are stored in 32 bits.
+  vsl_chunked_ofilebuf(const char * filename, std::size_t chunk_size, unsigned n_threads);
+
+  ~vsl_chunked_ofilebuf() override;
+
+  //: False if the file could not be opened or written
+  bool
+  good() const
+  {
+    return file_.good();
+  }
+
+  //: Record the current position as a mark; returns the number of the mark
+  std::size_t
+  mark();
+
+  //: Write the remaining data and the index, and close the file
+  void
+  close();
+
+protected:
+  int_type
+  overflow(int_type c) override;
+  pos_type
+  seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+private:
+  //: Hand the put area over as a chunk, and compress and write the pending chunks if there are enough
+  void
+  end_chunk(bool flush_all);
+
+  std::ofstream file_;
+  std::size_t chunk_size_;
+  unsigned n_threads_;
+  std::vector<char> buffer_;
+  //: Full chunks waiting for compression
+  std::vector<std::vector<char>> pending_;
+  //: Position in the file and in the byte stream of each chunk written
+  std::vector<vxl_uint_64> file_offset_;
+  std::vector<vxl_uint_64> stream_offset_;
+  //: Size of the byte stream handed over as chunks, and of the part written to the file
+  vxl_uint_64 stream_pos_{ 0 };
+  vxl_uint_64 written_{ 0 };
+  std::vector<vxl_uint_64> marks_;
+  bool open_;
+};
+
+//: Stream buffer which reads a chunked, compressed file.
+class vsl_chunked_ifilebuf : public std::streambuf
+{
+public:
+  //: Open filename for reading, and read its index.
+  vsl_chunked_ifilebuf(const char * filename);
+
+  //: False if the file could not be opened, or its index could not be read
+  bool
+  good() const
+  {
+    return good_;
+  }
+
+  //: Number of marks recorded when the file was written
+  std::size_t
+  number_of_marks() const
+  {
+    return marks_.size();
+  }
+
+  //: Position of mark i in the byte stream
+  vxl_uint_64
+  mark(std::size_t i) const
+  {
+    return marks_[i];
+  }
+
+  //: Size of the byte stream
+  vxl_uint_64
+  stream_size() const
+  {
+    return stream_offset_.empty() ? 0 : stream_offset_.back();
+  }
+
+  //: Close the file
+  void
+  close();
+
+protected:
+  int_type
+  underflow() override;
+  pos_type
+  seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+  pos_type
+  seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+  //: Read, check and decompress chunk c into the get area
+  bool
+  load_chunk(std::size_t c);
+
+  std::ifstream file_;
+  bool good_{ false };
+  //: Position in the file and in the byte stream of each chunk, and the end of both
+  std::vector<vxl_uint_64> file_offset_;
+  std::vector<vxl_uint_64> stream_offset_;
+  std::vector<vxl_uint_64> marks_;
+  //: The chunk in the get area, or the number of chunks if none
+  std::size_t current_{ 0 };
+  std::vector<char> buffer_;
+  std::vector<char> packed_;
+};
+
+//: A vsl_b_ostream which writes a chunked, compressed file.
+class vsl_b_ochunked_fstream : public vsl_b_ostream
+{
+public:
+  //: Create this adaptor from a file.
+  //  The chunks are compressed by at most n_threads threads of the default
+  //  vnl_thread_pool (0 = all of them).  chunk_size is at most 2^32-1.
+  vsl_b_ochunked_fstream(const std::string & filename, std::size_t chunk_size = 1 << 20, unsigned n_threads = 0);
+
+  //: Virtual destructor. Closes the file if needed.
+  ~vsl_b_ochunked_fstream() override;
+
+  //: Record the current position, e.g. before writing a top-level object.
+  //  Returns the number of the mark, to be used with seek_mark() on input.
+  //  Clears the serialisation records.
+  std::size_t
+  mark();
+
+  //: Write the remaining data and the index, and close the file.
+  void
+  close();
+
+private:
+  vsl_chunked_ofilebuf * buf_;
+};
+
+//: A vsl_b_istream which reads a file written by vsl_b_ochunked_fstream.
+class vsl_b_ichunked_fstream : public vsl_b_istream
+{
+public:
+  //: Create this adaptor from a file.
+  vsl_b_ichunked_fstream(const std::string & filename);
+
+  //: Virtual destructor.
+  ~vsl_b_ichunked_fstream() override;
+
+  //: Number of marks recorded by vsl_b_ochunked_fstream::mark()
+  std::size_t
+  number_of_marks() const;
+
+  //: Move to mark i, decompressing only the chunk it is in.
+  //  Clears the serialisation records.
+  void
+  seek_mark(std::size_t i);
+
+  //: Close the stream
+  void
+  close();
+
+private:
+  vsl_chunked_ifilebuf * buf_;
+};
+
+//: Test to see if a file was written by vsl_b_ochunked_fstream.
+bool
+vsl_chunked_fstream_test(const std::string & filename);
+
+#endif // vsl_chunked_fstream_h_
@@ -0,0 +1,128 @@
+// This is core/vsl/vsl_mapped_fstream.cxx
+//:
+// \file
+// \brief Binary input stream reading from a memory mapping of a file
+
+#include <fstream>
+#include <istream>
+#include "vsl_mapped_fstream.h"
+
+#if !defined(_WIN32)
+#  define VSL_MAPPED_FSTREAM_POSIX 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+vsl_mapped_filebuf::vsl_mapped_filebuf(const char * filename)
+{
+#ifdef VSL_MAPPED_FSTREAM_POSIX
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    return;
+  }
+  size_ = std::size_t(st.st_size);
+  if (size_ == 0)
+    map_.reset(new char[1], std::default_delete<char[]>());
+  else
+  {
+    // Private and writable: pages written to are copied, the file is never changed
+    void * p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      const std::size_t size = size_;
+      ::madvise(p, size, MADV_SEQUENTIAL);
+      map_.reset(static_cast<char *>(p), [size](char * q) { ::munmap(q, size); });
+    }
+  }
+  ::close(fd); // the mapping keeps its own reference to the file
+#else
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file)
+    return;
+  file.seekg(0, std::ios::end);
+  size_ = std::size_t(file.tellg());
+  file.seekg(0);
+  map_.reset(new char[size_ + 1], std::default_delete<char[]>());
+  if (!file.read(map_.get(), size_))
+    map_.reset();
+#endif
+  if (map_)
+    setg(map_.get(), map_.get(), map_.get() + size_);
+  else
+    size_ = 0;
+}
+
+char *
+vsl_mapped_filebuf::take(std::size_t n)
+{
+  if (std::size_t(egptr() - gptr()) < n)
+    return nullptr;
+  char * p = gptr();
+  setg(eback(), p + n, egptr());
+  return p;
+}
+
+void
+vsl_mapped_filebuf::close()
+{
+  setg(nullptr, nullptr, nullptr);
+  map_.reset();
+  size_ = 0;
+}
+
+std::streambuf::pos_type
+vsl_mapped_filebuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if (dir == std::ios_base::cur)
+    off += gptr() - eback();
+  else if (dir == std::ios_base::end)
+    off += off_type(size_);
+  return seekpos(pos_type(off), which);
+}
+
+std::streambuf::pos_type
+vsl_mapped_filebuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  const off_type p = off_type(pos);
+  if (!map_ || !(which & std::ios_base::in) || p < 0 || std::size_t(p) > size_)
+    return pos_type(off_type(-1));
+  setg(eback(), eback() + p, egptr());
+  return pos;
+}
+
+static std::istream *
+vsl_mapped_open_istream(const std::string & filename)
+{
+  auto * buf = new vsl_mapped_filebuf(filename.c_str());
+  auto * is = new std::istream(buf);
+  if (!buf->good())
+    is->setstate(std::ios::badbit);
+  return is;
+}
+
+vsl_b_imapped_fstream::vsl_b_imapped_fstream(const std::string & filename)
+  : vsl_b_istream(vsl_mapped_open_istream(filename))
+  , buf_(static_cast<vsl_mapped_filebuf *>(is_->rdbuf()))
+{}
+
+//: destructor.
+vsl_b_imapped_fstream::~vsl_b_imapped_fstream()
+{
+  delete is_;
+  delete buf_;
+}
+
+//: Close the stream
+void
+vsl_b_imapped_fstream::close()
+{
+  buf_->close();
+  clear_serialisation_records();
+}
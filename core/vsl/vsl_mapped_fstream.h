@@ -0,0 +1,105 @@
+// This is core/vsl/vsl_mapped_fstream.h
+#ifndef vsl_mapped_fstream_h_
+#define vsl_mapped_fstream_h_
+//:
+// \file
+// \brief Binary input stream reading from a memory mapping of a file
+//
+// vsl_b_imapped_fstream is used like vsl_b_ifstream, but the whole file is
+// mapped into memory, and read from the page cache without system calls.
+// More importantly, large blocks of data which need no conversion can be
+// used where they are in the mapping, without being copied: see
+// vsl_block_binary_read_in_place().  The loaders of vil_image_view and
+// vnl_matrix use this, so that loading a large archive is bound by page
+// faults rather than by copying.
+//
+// The mapping is private and copy-on-write: data loaded in place can be
+// modified, without changing the file.  It stays alive as long as any
+// object loaded in place refers to it, even after the stream is closed.
+//
+// Memory mapping is implemented with mmap() on POSIX systems.  Elsewhere
+// the file is read into memory, so the stream works, but nothing is saved.
+
+#include <cstddef>
+#include <memory>
+#include <streambuf>
+#include <string>
+#ifdef _MSC_VER
+#  include <vcl_msvc_warnings.h>
+#endif
+#include <vsl/vsl_binary_io.h>
+
+//: Stream buffer whose get area is a memory mapping of a whole file.
+class vsl_mapped_filebuf : public std::streambuf
+{
+public:
+  //: Map filename
+  vsl_mapped_filebuf(const char * filename);
+
+  //: False if the file could not be mapped
+  bool
+  good() const
+  {
+    return map_ != nullptr;
+  }
+
+  //: The mapping; copies of this keep it alive
+  const std::shared_ptr<char> &
+  mapping() const
+  {
+    return map_;
+  }
+
+  //: Return a pointer to the next n bytes and skip them, or nullptr if fewer are left.
+  char *
+  take(std::size_t n);
+
+  //: Release this buffer's reference to the mapping
+  void
+  close();
+
+protected:
+  pos_type
+  seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+  pos_type
+  seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+  std::shared_ptr<char> map_;
+  std::size_t size_{ 0 };
+};
+
+//: A vsl_b_istream which reads from a memory mapping of a file.
+class vsl_b_imapped_fstream : public vsl_b_istream
+{
+public:
+  //: Create this adaptor from a file.
+  vsl_b_imapped_fstream(const std::string & filename);
+
+  //: Virtual destructor.
+  ~vsl_b_imapped_fstream() override;
+
+  //: The mapping; holding a copy of this keeps data loaded in place alive
+  const std::shared_ptr<char> &
+  mapping() const
+  {
+    return buf_->mapping();
+  }
+
+  //: Return a pointer to the next n bytes in the mapping and skip them.
+  //  Returns nullptr, and does not move, if fewer than n bytes are left.
+  char *
+  take(std::size_t n)
+  {
+    return buf_->take(n);
+  }
+
+  //: Close the stream
+  void
+  close();
+
+private:
+  vsl_mapped_filebuf * buf_;
+};
+
+#endif // vsl_mapped_fstream_h_